@@ -931,6 +931,7 @@ priv_glfs_statx(struct glfs *fs, const char *path, const unsigned int mask,
     struct iatt iatt = {
         0,
     };
+    dict_t *xdata = NULL;
     int reval = 0;
 
     DECLARE_OLD_THIS;
@@ -959,10 +960,24 @@ retry:
     ret = glfs_resolve(fs, subvol, path, &loc, &iatt, reval);
     ESTALE_RETRY(ret, errno, reval, &loc, retry);
 
+    /* The birth time is only returned by the bricks when it is asked for */
+    if (ret == 0 && (mask & GLFS_STAT_BTIME)) {
+        xdata = dict_new();
+        if (!xdata || dict_set_uint64(xdata, GF_REQUEST_IATT_MASK, IATT_ALL)) {
+            ret = -1;
+            errno = ENOMEM;
+            goto out;
+        }
+        ret = syncop_stat(subvol, &loc, &iatt, xdata, NULL);
+        DECODE_SYNCOP_ERR(ret);
+    }
+
     if (ret == 0 && statxbuf)
         glfs_iatt_to_statx(fs, &iatt, statxbuf);
 out:
     loc_wipe(&loc);
+    if (xdata)
+        dict_unref(xdata);
 
     glfs_subvol_done(fs, subvol);
 
@@ -2024,6 +2039,110 @@ invalid_fs:
     return ret;
 }
 
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_clone_file_range, 12.0)
+ssize_t
+pub_glfs_clone_file_range(struct glfs_fd *glfd_in, off64_t off_in,
+                          struct glfs_fd *glfd_out, off64_t off_out,
+                          size_t len)
+{
+    xlator_t *subvol = NULL;
+    ssize_t ret = -1;
+    fd_t *fd_in = NULL;
+    fd_t *fd_out = NULL;
+    struct iatt iattbuf = {
+        0,
+    };
+    struct iatt preiatt = {
+        0,
+    };
+    struct iatt postiatt = {
+        0,
+    };
+    dict_t *fop_attr = NULL;
+    dict_t *xdata = NULL;
+
+    DECLARE_OLD_THIS;
+    __GLFS_ENTRY_VALIDATE_FD(glfd_in, invalid_fs);
+    __GLFS_ENTRY_VALIDATE_FD(glfd_out, invalid_fs);
+
+    GF_REF_GET(glfd_in);
+    GF_REF_GET(glfd_out);
+
+    if (glfd_in->fs != glfd_out->fs) {
+        ret = -1;
+        errno = EXDEV;
+        goto out;
+    }
+
+    subvol = glfs_active_subvol(glfd_in->fs);
+    if (!subvol) {
+        ret = -1;
+        errno = EIO;
+        goto out;
+    }
+
+    fd_in = glfs_resolve_fd(glfd_in->fs, subvol, glfd_in);
+    if (!fd_in) {
+        ret = -1;
+        errno = EBADFD;
+        goto out;
+    }
+
+    fd_out = glfs_resolve_fd(glfd_out->fs, subvol, glfd_out);
+    if (!fd_out) {
+        ret = -1;
+        errno = EBADFD;
+        goto out;
+    }
+
+    ret = get_fop_attr_thrd_key(&fop_attr);
+    if (ret)
+        gf_msg_debug("gfapi", 0, "Getting leaseid from thread failed");
+
+    /* The clone request is only for this call, keep it off the attrs of
+     * the thread */
+    if (fop_attr)
+        xdata = dict_copy_with_ref(fop_attr, NULL);
+    else
+        xdata = dict_new();
+    if (!xdata || dict_set_int32_sizen(xdata, GLUSTERFS_CLONE_FILE_RANGE, 1)) {
+        ret = -1;
+        errno = ENOMEM;
+        goto out;
+    }
+
+    ret = syncop_copy_file_range(subvol, fd_in, off_in, fd_out, off_out, len,
+                                 0, &iattbuf, &preiatt, &postiatt, xdata,
+                                 NULL);
+    DECODE_SYNCOP_ERR(ret);
+
+    /* Translators which cannot keep the copy on the bricks (or older
+     * bricks) reject the fop instead of copying partially. */
+    if ((ret < 0) && ((errno == EOPNOTSUPP) || (errno == ENOSYS)))
+        errno = EXDEV;
+
+out:
+    if (fd_in)
+        fd_unref(fd_in);
+    if (fd_out)
+        fd_unref(fd_out);
+    if (glfd_in)
+        GF_REF_PUT(glfd_in);
+    if (glfd_out)
+        GF_REF_PUT(glfd_out);
+    if (fop_attr)
+        dict_unref(fop_attr);
+    if (xdata)
+        dict_unref(xdata);
+
+    glfs_subvol_done(glfd_in->fs, subvol);
+
+    __GLFS_EXIT_FS;
+
+invalid_fs:
+    return ret;
+}
+
 GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_pwritev, 3.4.0)
 ssize_t
 pub_glfs_pwritev(struct glfs_fd *glfd, const struct iovec *iovec, int iovcnt,
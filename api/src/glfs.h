@@ -789,6 +789,23 @@ glfs_copy_file_range(struct glfs_fd *glfd_in, off64_t *off_in,
                      struct glfs_stat *poststat) __THROW
     GFAPI_PUBLIC(glfs_copy_file_range, 6.0);
 
+/*
+ * Clone len bytes of glfd_in starting at off_in into glfd_out at off_out
+ * without moving the data through the client. A len of 0 clones up to the
+ * end of glfd_in. Bricks share the extents (reflink) when their filesystem
+ * supports it and copy them locally otherwise.
+ *
+ * Returns the number of bytes cloned, which is less than len only if
+ * glfd_in ended early. Fails with EXDEV when the volume cannot do the
+ * copy on the bricks (e.g. the files live on different subvolumes), in
+ * which case the caller is expected to copy the data itself.
+ */
+ssize_t
+glfs_clone_file_range(struct glfs_fd *glfd_in, off64_t off_in,
+                      struct glfs_fd *glfd_out, off64_t off_out,
+                      size_t len) __THROW
+    GFAPI_PUBLIC(glfs_clone_file_range, 12.0);
+
 int
 glfs_truncate(glfs_t *fs, const char *path, off_t length) __THROW
     GFAPI_PUBLIC(glfs_truncate, 3.7.15);
@@ -7912,6 +7912,9 @@ cmd_heal_volume_statistics_out(dict_t *dict, int brick)
     uint64_t healed_count = 0;
     uint64_t split_brain_count = 0;
     uint64_t heal_failed_count = 0;
+    uint64_t entry_compared_count = 0;
+    uint64_t entry_healed_count = 0;
+    uint64_t entry_heal_usec = 0;
     char *start_time_str = NULL;
     char *end_time_str = NULL;
     char *crawl_type = NULL;
@@ -7976,6 +7979,33 @@ cmd_heal_volume_statistics_out(dict_t *dict, int brick)
         cli_out("No. of entries healed: %" PRIu64, healed_count);
         cli_out("No. of entries in split-brain: %" PRIu64, split_brain_count);
         cli_out("No. of heal failed entries: %" PRIu64, heal_failed_count);
+
+        /* Totals since the self-heal daemon started, the same for every
+         * crawl, only shown with the last one. */
+        if (i + 1 < num_entries)
+            continue;
+        snprintf(key, sizeof key, "statistics_entry_compared-%d-%" PRIu64,
+                 brick, i);
+        if (dict_get_uint64(dict, key, &entry_compared_count))
+            continue;
+        snprintf(key, sizeof key, "statistics_entry_healed-%d-%" PRIu64,
+                 brick, i);
+        ret = dict_get_uint64(dict, key, &entry_healed_count);
+        if (ret)
+            goto out;
+        snprintf(key, sizeof key, "statistics_entry_usec-%d-%" PRIu64, brick,
+                 i);
+        ret = dict_get_uint64(dict, key, &entry_heal_usec);
+        if (ret)
+            goto out;
+
+        cli_out("\nNo. of names compared by entry heals: %" PRIu64,
+                entry_compared_count);
+        cli_out("No. of names healed by entry heals: %" PRIu64,
+                entry_healed_count);
+        if (entry_heal_usec)
+            cli_out("Names compared per second: %" PRIu64,
+                    entry_compared_count * 1000000 / entry_heal_usec);
     }
 
 out:
@@ -0,0 +1,207 @@
+/*
+   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+/* glfs-lookup-bm: measures the rate of lookup, stat and fstat calls on a
+ * set of small files, the metadata path served by posix_pstat() and
+ * friends on the bricks.
+ *
+ * gcc glfs-lookup-bm.c -lgfapi -o glfs-lookup-bm
+ * ./glfs-lookup-bm <volume> <host> [count]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <glusterfs/api/glfs.h>
+
+#define BM_DIR "/glfs-lookup-bm"
+
+static double
+bm_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static glfs_t *
+bm_init(const char *volume, const char *host)
+{
+    glfs_t *fs = NULL;
+
+    fs = glfs_new(volume);
+    if (!fs) {
+        fprintf(stderr, "glfs_new: %s\n", strerror(errno));
+        return NULL;
+    }
+
+    if (glfs_set_volfile_server(fs, "tcp", host, 24007) ||
+        glfs_set_logging(fs, "/dev/null", 0) || glfs_init(fs)) {
+        fprintf(stderr, "glfs_init: %s\n", strerror(errno));
+        glfs_fini(fs);
+        return NULL;
+    }
+
+    return fs;
+}
+
+static int
+bm_create(glfs_t *fs, long count)
+{
+    glfs_fd_t *fd = NULL;
+    char path[64];
+    long i;
+
+    if (glfs_mkdir(fs, BM_DIR, 0755) && errno != EEXIST) {
+        fprintf(stderr, "mkdir %s: %s\n", BM_DIR, strerror(errno));
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), BM_DIR "/file.%ld", i);
+        fd = glfs_creat(fs, path, O_RDWR, 0644);
+        if (!fd) {
+            fprintf(stderr, "creat %s: %s\n", path, strerror(errno));
+            return -1;
+        }
+        glfs_close(fd);
+    }
+
+    return 0;
+}
+
+static void
+bm_report(const char *name, long count, double start)
+{
+    double elapsed = bm_now() - start;
+
+    printf("%-16s %8ld ops %10.3f s %12.1f ops/s\n", name, count, elapsed,
+           elapsed > 0 ? count / elapsed : 0.0);
+}
+
+/* Every file is unknown to a new client, so each glfs_stat() sends a
+ * lookup to the bricks. */
+static int
+bm_lookup(const char *volume, const char *host, long count)
+{
+    glfs_t *fs = NULL;
+    struct stat st;
+    char path[64];
+    double start;
+    long i;
+
+    fs = bm_init(volume, host);
+    if (!fs)
+        return -1;
+
+    start = bm_now();
+    for (i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), BM_DIR "/file.%ld", i);
+        if (glfs_lstat(fs, path, &st)) {
+            fprintf(stderr, "lstat %s: %s\n", path, strerror(errno));
+            break;
+        }
+    }
+    bm_report("lookup", i, start);
+
+    glfs_fini(fs);
+    return (i == count) ? 0 : -1;
+}
+
+static int
+bm_stat(glfs_t *fs, long count)
+{
+    struct stat st;
+    char path[64];
+    double start;
+    long i;
+
+    start = bm_now();
+    for (i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), BM_DIR "/file.%ld", i);
+        if (glfs_stat(fs, path, &st)) {
+            fprintf(stderr, "stat %s: %s\n", path, strerror(errno));
+            break;
+        }
+    }
+    bm_report("stat", i, start);
+
+    return (i == count) ? 0 : -1;
+}
+
+static int
+bm_fstat(glfs_t *fs, long count)
+{
+    glfs_fd_t *fd = NULL;
+    struct stat st;
+    double start;
+    long i;
+
+    fd = glfs_open(fs, BM_DIR "/file.0", O_RDONLY);
+    if (!fd) {
+        fprintf(stderr, "open: %s\n", strerror(errno));
+        return -1;
+    }
+
+    start = bm_now();
+    for (i = 0; i < count; i++) {
+        if (glfs_fstat(fd, &st)) {
+            fprintf(stderr, "fstat: %s\n", strerror(errno));
+            break;
+        }
+    }
+    bm_report("fstat", i, start);
+
+    glfs_close(fd);
+    return (i == count) ? 0 : -1;
+}
+
+int
+main(int argc, char *argv[])
+{
+    glfs_t *fs = NULL;
+    long count = 10000;
+    int ret = -1;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <volume> <host> [count]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 3)
+        count = strtol(argv[3], NULL, 0);
+    if (count <= 0) {
+        fprintf(stderr, "invalid count\n");
+        return 1;
+    }
+
+    fs = bm_init(argv[1], argv[2]);
+    if (!fs)
+        return 1;
+
+    if (bm_create(fs, count))
+        goto out;
+
+    if (bm_lookup(argv[1], argv[2], count))
+        goto out;
+
+    if (bm_stat(fs, count))
+        goto out;
+
+    ret = bm_fstat(fs, count);
+out:
+    glfs_fini(fs);
+    return ret ? 1 : 0;
+}
@@ -14,6 +14,9 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "xxhash.h"
+#include "glusterfs/checksum.h"
+
 /*
  * The "weak" checksum required for the rsync algorithm.
  *
@@ -42,3 +45,22 @@ gf_rsync_md5_checksum(unsigned char *data, size_t len, unsigned char *md5)
 {
     MD5(data, len, md5);
 }
+
+/*
+ * Non-cryptographic "strong" checksum for block comparison during heal.
+ * The vendored xxhash has no 128-bit variant, so the digest is made of
+ * two XXH64 hashes with different seeds in canonical (big endian) form.
+ * This is done irrespective of the xxhash library found at build time so
+ * that bricks built against different libraries produce the same digest.
+ */
+void
+gf_rsync_xxhash_checksum(unsigned char *data, size_t len, unsigned char *sum)
+{
+    XXH64_canonical_t c_hash;
+
+    XXH64_canonicalFromHash(&c_hash, XXH64(data, len, 0));
+    memcpy(sum, &c_hash, sizeof(c_hash));
+
+    XXH64_canonicalFromHash(&c_hash, XXH64(data, len, GF_XXHASH_SEED2));
+    memcpy(sum + sizeof(c_hash), &c_hash, sizeof(c_hash));
+}
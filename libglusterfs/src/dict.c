@@ -1306,6 +1306,55 @@ fail:
     return new;
 }
 
+/* Returns a reference on @dict, or on a copy of it without @key when it has
+ * one, so that a request can be passed on without a key meant for this
+ * xlator only. */
+dict_t *
+dict_ref_without(dict_t *dict, const char *key)
+{
+    dict_t *new = NULL;
+
+    if (!dict)
+        return NULL;
+
+    if (!dict_get(dict, (char *)key))
+        return dict_ref(dict);
+
+    new = dict_copy_with_ref(dict, NULL);
+    if (new)
+        dict_del(new, (char *)key);
+
+    return new;
+}
+
+/* Like dict_ref_without() for GF_REQUEST_IATT_MASK, for xlators that compare,
+ * merge or cache the iatts of their subvolumes and so need all of them. The
+ * birth time is not part of a full iatt, so a request for it is kept by
+ * asking for all the attributes. */
+dict_t *
+dict_ref_iatt_mask_full(dict_t *dict)
+{
+    dict_t *new = NULL;
+    uint64_t mask = 0;
+
+    if (!dict || dict_get_uint64(dict, GF_REQUEST_IATT_MASK, &mask))
+        return dict ? dict_ref(dict) : NULL;
+
+    if (!(mask & IATT_BTIME))
+        return dict_ref_without(dict, GF_REQUEST_IATT_MASK);
+
+    if (mask == IATT_ALL)
+        return dict_ref(dict);
+
+    new = dict_copy_with_ref(dict, NULL);
+    if (new && dict_set_uint64(new, GF_REQUEST_IATT_MASK, IATT_ALL)) {
+        dict_unref(new);
+        new = NULL;
+    }
+
+    return new;
+}
+
 /*
  * !!!!!!! CLEANED UP CODE !!!!!!!
  */
@@ -11,6 +11,10 @@
 #ifndef __CHECKSUM_H__
 #define __CHECKSUM_H__
 
+/* Size of the digest produced by gf_rsync_xxhash_checksum(). */
+#define XXHASH_DIGEST_LENGTH 16
+#define GF_XXHASH_SEED2 0x9e3779b97f4a7c15ULL
+
 uint32_t
 gf_rsync_weak_checksum(unsigned char *buf, size_t len);
 
@@ -19,4 +23,7 @@ gf_rsync_strong_checksum(unsigned char *buf, size_t len, unsigned char *sum);
 
 void
 gf_rsync_md5_checksum(unsigned char *data, size_t len, unsigned char *md5);
+
+void
+gf_rsync_xxhash_checksum(unsigned char *data, size_t len, unsigned char *sum);
 #endif /* __CHECKSUM_H__ */
@@ -290,6 +290,10 @@ GF_MUST_CHECK dict_t *
 dict_new(void);
 dict_t *
 dict_copy_with_ref(dict_t *this, dict_t *new);
+dict_t *
+dict_ref_without(dict_t *dict, const char *key);
+dict_t *
+dict_ref_iatt_mask_full(dict_t *dict);
 
 GF_MUST_CHECK int
 dict_reset(dict_t *dict);
@@ -202,6 +202,14 @@ enum gf_internal_fop_indicator {
 
 #define GLUSTERFS_WRITE_IS_APPEND "glusterfs.write-is-append"
 #define GLUSTERFS_WRITE_UPDATE_ATOMIC "glusterfs.write-update-atomic"
+/* Requests (in xdata of copy_file_range) that the whole range be cloned,
+ * using reflink on the brick when possible. In the reply it is set to 1
+ * when the brick filesystem shared the extents instead of copying them. */
+#define GLUSTERFS_CLONE_FILE_RANGE "glusterfs.clone-file-range"
+/* uint64 mask of IATT_* flags (in xdata of lookup, stat and fstat) that the
+ * caller needs. The brick may skip fetching the others, the ia_flags of the
+ * reply tell which fields are valid. */
+#define GF_REQUEST_IATT_MASK "glusterfs.iatt-mask"
 #define GLUSTERFS_OPEN_FD_COUNT "glusterfs.open-fd-count"
 #define GLUSTERFS_ACTIVE_FD_COUNT "glusterfs.open-active-fd-count"
 #define GLUSTERFS_INODELK_COUNT "glusterfs.inodelk-count"
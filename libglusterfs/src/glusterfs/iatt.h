@@ -94,6 +94,7 @@ struct mdata_iatt {
 #define IATT_BLOCKS 0x0000000000000400U
 #define IATT_BTIME 0x0000000000000800U
 #define IATT_GFID 0x0000000000001000U
+#define IATT_ALL 0x0000000000001fffU
 
 /* Macros for checking validity of struct iatt members.*/
 #define IATT_TYPE_VALID(iaflags) (iaflags & IATT_TYPE)
@@ -0,0 +1,36 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __REGION_MAP_H
+#define __REGION_MAP_H
+
+#include <stdint.h>
+
+/* Regions of a file modified while some brick was missing the writes are
+ * recorded in a bitmap where each bit covers (1 << shift) bytes. The shift
+ * grows with the offsets being written, between GF_REGION_MIN_SHIFT and
+ * GF_REGION_MAX_SHIFT, and the last bit covers everything up to EOF. A
+ * shift of 0 means that the map is empty. */
+#define GF_REGION_MAP_BITS 2048
+#define GF_REGION_MAP_SIZE (GF_REGION_MAP_BITS / 8)
+#define GF_REGION_MIN_SHIFT 20
+#define GF_REGION_MAX_SHIFT 36
+#define GF_REGION_SHIFTS (GF_REGION_MAX_SHIFT - GF_REGION_MIN_SHIFT + 1)
+
+/* Value of a shift when the regions are unknown */
+#define GF_REGION_LOST UINT32_MAX
+
+void
+gf_region_mark(uint8_t *map, uint32_t *shift, uint64_t start, uint64_t end);
+
+uint64_t
+gf_region_next(const uint8_t *map, uint32_t shift, uint64_t offset);
+
+#endif /* __REGION_MAP_H */
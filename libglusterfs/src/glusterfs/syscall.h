@@ -75,6 +75,9 @@ sys_openat(int dirfd, const char *pathname, int flags, int mode);
 DIR *
 sys_opendir(const char *name);
 
+DIR *
+sys_fdopendir(int fd);
+
 struct dirent *
 sys_readdir(DIR *dir, struct dirent *de);
 
@@ -102,6 +105,9 @@ sys_unlinkat(int dfd, const char *pathname);
 int
 sys_rmdir(const char *pathname);
 
+int
+sys_rmdirat(int dfd, const char *pathname);
+
 int
 sys_symlink(const char *oldpath, const char *newpath);
 
@@ -277,6 +283,16 @@ ssize_t
 sys_copy_file_range(int fd_in, off64_t *off_in, int fd_out, off64_t *off_out,
                     size_t len, unsigned int flags);
 
+/*
+ * Share the extents of [off_in, off_in + len) of fd_in with fd_out at
+ * off_out (reflink). A len of 0 means up to the end of fd_in. Fails with
+ * EOPNOTSUPP when the platform or filesystem cannot clone, and with EXDEV
+ * when the files are not on the same filesystem.
+ */
+int
+sys_clone_file_range(int fd_in, off64_t off_in, int fd_out, off64_t off_out,
+                     size_t len);
+
 int
 sys_kill(pid_t pid, int sig);
 
@@ -0,0 +1,99 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include <limits.h>
+#include <string.h>
+
+#include "glusterfs/common-utils.h"
+#include "glusterfs/region-map.h"
+
+#define GF_REGION_SET(_map, _bit) ((_map)[(_bit) >> 3] |= 1 << ((_bit)&7))
+#define GF_REGION_ISSET(_map, _bit) (((_map)[(_bit) >> 3] >> ((_bit)&7)) & 1)
+
+static uint32_t
+gf_region_shift(uint64_t offset)
+{
+    uint32_t shift = GF_REGION_MIN_SHIFT;
+
+    while ((shift < GF_REGION_MAX_SHIFT) &&
+           ((offset >> shift) >= GF_REGION_MAP_BITS)) {
+        shift++;
+    }
+
+    return shift;
+}
+
+/* Makes each bit of the map cover (1 << shift) bytes. The last bit of a
+ * map covers everything up to the end of the file, so all the bits from
+ * its new position are set if it was set. */
+static void
+gf_region_resize(uint8_t *map, uint32_t old_shift, uint32_t shift)
+{
+    uint8_t tmp[GF_REGION_MAP_SIZE] = {0};
+    uint32_t i, delta = shift - old_shift;
+
+    for (i = 0; i < GF_REGION_MAP_BITS - 1; i++) {
+        if (GF_REGION_ISSET(map, i)) {
+            GF_REGION_SET(tmp, i >> delta);
+        }
+    }
+    if (GF_REGION_ISSET(map, GF_REGION_MAP_BITS - 1)) {
+        for (i = (GF_REGION_MAP_BITS - 1) >> delta; i < GF_REGION_MAP_BITS;
+             i++) {
+            GF_REGION_SET(tmp, i);
+        }
+    }
+
+    memcpy(map, tmp, sizeof(tmp));
+}
+
+/* Marks the bytes from start to end (both included) as modified. An end
+ * of LLONG_MAX means up to the end of the file. */
+void
+gf_region_mark(uint8_t *map, uint32_t *shift, uint64_t start, uint64_t end)
+{
+    uint64_t first, last;
+    uint32_t needed;
+
+    needed = gf_region_shift((end == LLONG_MAX) ? start : end);
+    if (*shift == 0) {
+        *shift = needed;
+    } else if (*shift < needed) {
+        gf_region_resize(map, *shift, needed);
+        *shift = needed;
+    }
+
+    last = GF_REGION_MAP_BITS - 1;
+    if (end != LLONG_MAX) {
+        last = min(end >> *shift, last);
+    }
+    first = min(start >> *shift, last);
+    while (first <= last) {
+        GF_REGION_SET(map, first);
+        first++;
+    }
+}
+
+/* Returns the first modified offset not below 'offset', or UINT64_MAX if
+ * there is none. */
+uint64_t
+gf_region_next(const uint8_t *map, uint32_t shift, uint64_t offset)
+{
+    uint64_t i;
+
+    for (i = min(offset >> shift, GF_REGION_MAP_BITS - 1);
+         i < GF_REGION_MAP_BITS; i++) {
+        if (GF_REGION_ISSET(map, i)) {
+            return max(offset, i << shift);
+        }
+    }
+
+    return UINT64_MAX;
+}
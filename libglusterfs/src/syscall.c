@@ -26,6 +26,10 @@
 #ifdef HAVE_COPY_FILE_RANGE_SYS
 #include <sys/syscall.h>
 #endif
+#ifdef HAVE_FICLONERANGE
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
 
 #define FS_ERROR_LOG(result)                                                   \
     do {                                                                       \
@@ -149,6 +153,12 @@ sys_opendir(const char *name)
     return opendir(name);
 }
 
+DIR *
+sys_fdopendir(int fd)
+{
+    return fdopendir(fd);
+}
+
 int
 sys_mkdirat(int dirfd, const char *pathname, mode_t mode)
 {
@@ -232,6 +242,12 @@ sys_rmdir(const char *pathname)
     return FS_RET_CHECK0(rmdir(pathname), errno);
 }
 
+int
+sys_rmdirat(int dfd, const char *pathname)
+{
+    return FS_RET_CHECK0(unlinkat(dfd, pathname, AT_REMOVEDIR), errno);
+}
+
 int
 sys_symlink(const char *oldpath, const char *newpath)
 {
@@ -875,6 +891,29 @@ sys_copy_file_range(int fd_in, off64_t *off_in, int fd_out, off64_t *off_out,
 #endif /* HAVE_COPY_FILE_RANGE */
 }
 
+int
+sys_clone_file_range(int fd_in, off64_t off_in, int fd_out, off64_t off_out,
+                     size_t len)
+{
+#ifdef HAVE_FICLONERANGE
+    struct file_clone_range fcr = {
+        .src_fd = fd_in,
+        .src_offset = off_in,
+        .src_length = len,
+        .dest_offset = off_out,
+    };
+
+    /* Whole file clone does not need the range variant. */
+    if (!off_in && !off_out && !len)
+        return ioctl(fd_out, FICLONE, fd_in);
+
+    return ioctl(fd_out, FICLONERANGE, &fcr);
+#else
+    errno = EOPNOTSUPP;
+    return -1;
+#endif /* HAVE_FICLONERANGE */
+}
+
 #ifdef __FreeBSD__
 int
 sys_kill(pid_t pid, int sig)
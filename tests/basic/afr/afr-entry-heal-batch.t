@@ -0,0 +1,60 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that a full entry heal that compares the directory
+# listings of the bricks creates, removes and relinks the names that differ
+# and reports the names it compared in the heal statistics.
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 cluster.granular-entry-heal off
+TEST $CLI volume set $V0 cluster.entry-self-heal-batch-size 32
+TEST ! $CLI volume set $V0 cluster.entry-self-heal-batch-size -1
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST mkdir $M0/dir
+for i in {1..300}; do
+        echo $i > $M0/dir/old$i
+done
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+
+# New files, directories and hardlinks, removed and renamed files
+for i in {1..100}; do
+        echo $i > $M0/dir/new$i
+        ln $M0/dir/new$i $M0/dir/link$i
+done
+TEST mkdir -p $M0/dir/subdir/deep
+for i in {1..50}; do
+        rm -f $M0/dir/old$i
+        mv $M0/dir/old$((i + 100)) $M0/dir/moved$i
+done
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 1
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+names=$(ls $B0/${V0}1/dir | md5sum | awk '{print $1}')
+EXPECT "$names" echo $(ls $B0/${V0}0/dir | md5sum | awk '{print $1}')
+EXPECT "2" stat -c %h $B0/${V0}0/dir/new7
+EXPECT "$(stat -c %i $B0/${V0}0/dir/new7)" stat -c %i $B0/${V0}0/dir/link7
+TEST [ -d $B0/${V0}0/dir/subdir/deep ]
+TEST ! [ -e $B0/${V0}0/dir/old7 ]
+
+compared=$($CLI volume heal $V0 statistics | \
+           awk -F': ' '/No. of names compared by entry heals/ {n += $2} END {print n + 0}')
+TEST [ $compared -gt 0 ]
+
+cleanup;
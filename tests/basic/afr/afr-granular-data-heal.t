@@ -0,0 +1,59 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that the regions written while a brick is down are
+# recorded on the good brick, that heal rebuilds the file from them and
+# that the records are removed once the bricks are in sync again.
+
+function region_xattr_count {
+        getfattr -d -m "trusted.afr.regions" -e hex $1 2>/dev/null | \
+                grep -c "^trusted.afr.regions"
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 cluster.granular-data-heal on
+TEST ! $CLI volume set $V0 cluster.granular-data-heal maybe
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=32
+EXPECT "0" region_xattr_count $B0/${V0}1/file
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+
+# Small writes in the middle and at the end of the file
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=1 seek=10 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/file bs=4k count=3 seek=8190 conv=notrunc
+# A file created while the brick is down gets a full heal
+TEST dd if=/dev/urandom of=$M0/new bs=1M count=2
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST [ $(region_xattr_count $B0/${V0}1/file) -ge 2 ]
+EXPECT "0" region_xattr_count $B0/${V0}0/file
+
+md5_file=$(md5sum $B0/${V0}1/file | awk '{print $1}')
+md5_new=$(md5sum $B0/${V0}1/new | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 1
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+EXPECT "$md5_file" echo $(md5sum $B0/${V0}0/file | awk '{print $1}')
+EXPECT "$md5_new" echo $(md5sum $B0/${V0}0/new | awk '{print $1}')
+
+# The records are removed once the file is healed
+EXPECT "0" region_xattr_count $B0/${V0}1/file
+EXPECT "0" region_xattr_count $B0/${V0}0/file
+
+cleanup;
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that files healed with several windows in flight are
+# rebuilt correctly and that the holes of sparse files are not copied.
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 cluster.self-heal-window-size 2
+TEST $CLI volume set $V0 cluster.data-self-heal-pipeline-depth 8
+TEST ! $CLI volume set $V0 cluster.data-self-heal-pipeline-depth 0
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST dd if=/dev/urandom of=$M0/diff bs=1M count=8
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+
+# A dense file bigger than a whole wave of windows
+TEST dd if=/dev/urandom of=$M0/dense bs=1M count=12
+# A sparse file with data at both ends and a large hole in between
+TEST dd if=/dev/urandom of=$M0/sparse bs=1M count=1
+TEST dd if=/dev/urandom of=$M0/sparse bs=1M count=1 seek=63 conv=notrunc
+# A file that is a hole from the beginning to the end
+TEST truncate -s 32M $M0/hole
+# A file healed with the diff algorithm
+TEST dd if=/dev/urandom of=$M0/diff bs=256k count=3 seek=13 conv=notrunc
+
+md5_dense=$(md5sum $M0/dense | awk '{print $1}')
+md5_sparse=$(md5sum $M0/sparse | awk '{print $1}')
+md5_hole=$(md5sum $M0/hole | awk '{print $1}')
+md5_diff=$(md5sum $M0/diff | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 1
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+EXPECT "$md5_dense" echo $(md5sum $B0/${V0}0/dense | awk '{print $1}')
+EXPECT "$md5_sparse" echo $(md5sum $B0/${V0}0/sparse | awk '{print $1}')
+EXPECT "$md5_hole" echo $(md5sum $B0/${V0}0/hole | awk '{print $1}')
+EXPECT "$md5_diff" echo $(md5sum $B0/${V0}0/diff | awk '{print $1}')
+
+# The holes are kept on the healed brick
+TEST [ $(du -k $B0/${V0}0/sparse | awk '{print $1}') -lt 16384 ]
+TEST [ $(du -k $B0/${V0}0/hole | awk '{print $1}') -lt 1024 ]
+
+cleanup;
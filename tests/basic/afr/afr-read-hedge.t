@@ -0,0 +1,53 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that reads also sent to a second replica, because the
+# first one did not answer in time, return the right data.
+
+function get_mount_afr {
+        local sd=$1
+        local field=$2
+        grep "^$field=" $sd | head -1 | cut -f2 -d'='
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST ! $CLI volume set $V0 cluster.read-hedge-percentile 101
+TEST $CLI volume start $V0
+
+TEST glusterfs --direct-io-mode=yes --entry-timeout=0 --attribute-timeout=0 -s $H0 --volfile-id $V0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=8
+md5=$(md5sum $M0/file | awk '{print $1}')
+
+# Reads are not hedged by default
+EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+statedump=$(generate_mount_statedump $V0)
+EXPECT "0" get_mount_afr $statedump "read-hedges-sent"
+
+# Without a minimum delay, almost every read goes to a second replica
+TEST $CLI volume set $V0 cluster.read-hedge-min-delay-usec 0
+TEST $CLI volume set $V0 cluster.read-hedge-percentile 1
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "1.00" mount_get_option_value $M0 $V0-replicate-0 read-hedge-percentile
+for i in {1..4}; do
+        EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+done
+statedump=$(generate_mount_statedump $V0)
+TEST [ $(get_mount_afr $statedump "read-hedges-sent") -gt 0 ]
+
+# Hedged reads still work when a replica is down
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "0" afr_child_up_status $V0 0
+EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+
+cleanup;
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that a client holding a read lease on a file keeps
+# reading it from the good bricks when a brick reconnects without looking
+# the file up again, and that a write from another client recalls the
+# lease so that the new data is read afterwards.
+
+function statedump_value {
+        grep "^$2=" $1 | cut -f2 -d'='
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 features.leases on
+TEST $CLI volume set $V0 cluster.read-lease on
+TEST ! $CLI volume set $V0 cluster.read-lease maybe
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume start $V0
+
+TEST kill_brick $V0 $H0 $B0/${V0}2
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --direct-io-mode=yes $M0;
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --direct-io-mode=yes $M1;
+
+# The file is stale on the brick that is down
+echo "old" > $M0/file
+exec 5<$M0/file
+EXPECT "old" cat $M0/file
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 2
+EXPECT "old" cat $M0/file
+
+statedump=$(generate_mount_statedump $V0 $M0)
+TEST [ $(statedump_value $statedump read-leases-granted) -ge 1 ]
+TEST [ $(statedump_value $statedump read-lease-refreshes-skipped) -ge 1 ]
+cleanup_statedump $(get_mount_process_pid $V0 $M0)
+
+# A write from the other client recalls the lease
+echo "new" > $M1/file
+EXPECT "new" cat $M0/file
+EXPECT "new" cat $M1/file
+
+statedump=$(generate_mount_statedump $V0 $M0)
+TEST [ $(statedump_value $statedump read-leases-recalled) -ge 1 ]
+cleanup_statedump $(get_mount_process_pid $V0 $M0)
+exec 5<&-
+
+cleanup;
@@ -0,0 +1,57 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that the self-heal daemon heals files, directories and
+# dirty files correctly when it sweeps the index directories in parallel.
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 cluster.shd-parallel-index-sweep on
+TEST ! $CLI volume set $V0 cluster.shd-parallel-index-sweep maybe
+TEST $CLI volume set $V0 cluster.shd-max-threads 4
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST mkdir $M0/dir
+for i in {1..20}; do
+        echo "old" > $M0/dir/file$i
+done
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+
+# Data heals of existing files, entry heals of new files and directories
+for i in {1..20}; do
+        echo "new" >> $M0/dir/file$i
+        echo "created" > $M0/dir/new$i
+done
+TEST mkdir -p $M0/dir/subdir/deep
+TEST dd if=/dev/urandom of=$M0/dir/subdir/deep/big bs=1M count=4
+
+md5_file=$(md5sum $M0/dir/file7 | awk '{print $1}')
+md5_big=$(md5sum $M0/dir/subdir/deep/big | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 1
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+EXPECT "$md5_file" echo $(md5sum $B0/${V0}0/dir/file7 | awk '{print $1}')
+EXPECT "$md5_big" echo $(md5sum $B0/${V0}0/dir/subdir/deep/big | awk '{print $1}')
+EXPECT "20" echo $(ls $B0/${V0}0/dir | grep -c "^new")
+
+# The sweep progress is reported in the statedump of the daemon
+statedump=$(generate_shd_statedump $V0)
+EXPECT "1" echo $(grep -c "^shd-parallel-index-sweep=1" $statedump)
+cleanup_statedump $(get_shd_process_pid $V0)
+
+cleanup;
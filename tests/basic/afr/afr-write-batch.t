@@ -0,0 +1,45 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that writes from two clients to the same file stay
+# consistent when each client batches its writes under one lock, and that
+# the size of the batches is reported in the statedump.
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 cluster.write-batch-delay-usec 500
+TEST $CLI volume set $V0 cluster.write-batch-size 16
+TEST ! $CLI volume set $V0 cluster.write-batch-size 0
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1;
+TEST dd if=/dev/zero of=$M0/file bs=1M count=8
+
+# Both clients write to their own half of the file at the same time
+dd if=/dev/urandom of=$M0/file bs=4k count=1024 conv=notrunc &
+pid0=$!
+dd if=/dev/urandom of=$M1/file bs=4k count=1024 seek=1024 conv=notrunc &
+pid1=$!
+TEST wait $pid0
+TEST wait $pid1
+
+md5=$(md5sum $M0/file | awk '{print $1}')
+EXPECT "$md5" echo $(md5sum $M1/file | awk '{print $1}')
+EXPECT "$md5" echo $(md5sum $B0/${V0}0/file | awk '{print $1}')
+EXPECT "$md5" echo $(md5sum $B0/${V0}1/file | awk '{print $1}')
+EXPECT "$md5" echo $(md5sum $B0/${V0}2/file | awk '{print $1}')
+EXPECT "^0$" get_pending_heal_count $V0
+
+statedump=$(generate_mount_statedump $V0 $M0)
+EXPECT "16" echo $(grep "^write-batch-size=" $statedump | cut -f2 -d'=')
+TEST [ $(grep -c "^write-batches\[" $statedump) -ge 1 ]
+cleanup_statedump $(get_mount_process_pid $V0 $M0)
+
+cleanup;
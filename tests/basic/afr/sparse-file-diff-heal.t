@@ -0,0 +1,62 @@
+#!/bin/bash
+
+#This file checks that "diff" self-heal of thin provisioned files skips the
+#holes common to source and sink, heals only the modified blocks and keeps
+#the sink sparse. It is run with both the default checksum and xxhash.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+#Prints "Y" if the file uses less than $2 KB on disk
+function disk_usage_below {
+        if [ $(du -k $1 | awk '{print $1}') -lt $2 ]; then
+                echo "Y"
+        else
+                echo "N"
+        fi
+}
+
+function heal_sparse_file {
+        local name=$1
+
+        TEST truncate -s 1G $M0/$name
+        TEST dd if=/dev/urandom of=$M0/$name bs=128k count=2 conv=notrunc
+        TEST dd if=/dev/urandom of=$M0/$name bs=128k count=2 seek=4096 conv=notrunc
+
+        TEST kill_brick $V0 $H0 $B0/${V0}0
+        TEST dd if=/dev/urandom of=$M0/$name bs=128k count=1 seek=1 conv=notrunc
+        TEST dd if=/dev/urandom of=$M0/$name bs=128k count=1 seek=6144 conv=notrunc
+        md5=$(md5sum $M0/$name | awk '{print $1}')
+
+        TEST $CLI volume start $V0 force
+        EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+        EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+        EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 1
+        TEST $CLI volume heal $V0
+        EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+
+        drop_cache $M0
+        EXPECT "$md5" echo $(md5sum $B0/${V0}0/$name | awk '{print $1}')
+        EXPECT "1" has_holes $B0/${V0}0/$name
+        #512K of data in a 1G file, the holes were not written as zeros
+        EXPECT "Y" disk_usage_below $B0/${V0}0/$name 8192
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 data-self-heal-algorithm diff
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+heal_sparse_file vm-image-default
+
+TEST $CLI volume set $V0 storage.fips-mode-rchecksum on
+TEST $CLI volume set $V0 cluster.data-self-heal-xxhash on
+heal_sparse_file vm-image-xxhash
+
+TEST force_umount $M0
+cleanup;
@@ -0,0 +1,93 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that the disk usage of the subvolumes is refreshed in the
+# background, and that files are still created when the hashed subvolume is
+# short of space and another one is picked by weighted placement.
+
+function du_stat_sum {
+        local field=$1
+        local statedump=$(generate_mount_statedump $V0 $M0)
+        local sum=$(grep "^du_stats\[[0-9]\].$field=" $statedump | \
+                    awk -F= '{n += $2} END {print n + 0}')
+        cleanup_statedump $(get_mount_process_pid $V0 $M0)
+        echo $sum
+}
+
+function du_refreshes_above {
+        if [ $(du_stat_sum refreshes) -gt $1 ]; then
+                echo "Y"
+        else
+                echo "N"
+        fi
+}
+
+function du_filled_count {
+        local statedump=$(generate_mount_statedump $V0 $M0)
+        local count=$(grep -c "^du_stats\[[0-9]\].filled=[1-9]" $statedump)
+        cleanup_statedump $(get_mount_process_pid $V0 $M0)
+        echo $count
+}
+
+# Files with data on a brick, leaving out the linkto files
+function data_file_count {
+        find $1 -type f -size +0 | wc -l
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+
+# One filesystem per brick, so that each one has its own free space
+TEST truncate -s 100M $B0/brick0
+TEST truncate -s 100M $B0/brick1
+TEST truncate -s 100M $B0/brick2
+TEST LO0=`SETUP_LOOP $B0/brick0`
+TEST MKFS_LOOP $LO0
+TEST LO1=`SETUP_LOOP $B0/brick1`
+TEST MKFS_LOOP $LO1
+TEST LO2=`SETUP_LOOP $B0/brick2`
+TEST MKFS_LOOP $LO2
+TEST mkdir -p $B0/${V0}{0..2}
+TEST MOUNT_LOOP $LO0 $B0/${V0}0
+TEST MOUNT_LOOP $LO1 $B0/${V0}1
+TEST MOUNT_LOOP $LO2 $B0/${V0}2
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 cluster.du-refresh-interval 2
+TEST ! $CLI volume set $V0 cluster.du-refresh-interval -1
+TEST $CLI volume set $V0 cluster.weighted-placement on
+TEST $CLI volume set $V0 cluster.min-free-disk 50%
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+
+# The usage keeps being refreshed without any create asking for it
+refreshes=$(du_stat_sum refreshes)
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "Y" du_refreshes_above $refreshes
+refreshes=$(du_stat_sum refreshes)
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "Y" du_refreshes_above $refreshes
+EXPECT "^0$" du_filled_count
+
+# Fill the first two bricks behind the volume's back. Only the last one
+# has space left, and the refresh notices it on its own.
+TEST dd if=/dev/zero of=$B0/${V0}0/.glusterfs/filler bs=1M count=80
+TEST dd if=/dev/zero of=$B0/${V0}1/.glusterfs/filler bs=1M count=80
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "^2$" du_filled_count
+
+TEST mkdir $M0/dir
+for i in {1..20}; do
+        TEST dd if=/dev/zero of=$M0/dir/file$i bs=4k count=1
+done
+EXPECT "^20$" echo $(ls $M0/dir | wc -l)
+EXPECT "^0$" data_file_count $B0/${V0}0/dir
+EXPECT "^0$" data_file_count $B0/${V0}1/dir
+EXPECT "^20$" data_file_count $B0/${V0}2/dir
+
+# Back to refreshing from the creates
+TEST $CLI volume set $V0 cluster.du-refresh-interval 0
+TEST touch $M0/dir/file{21..30}
+EXPECT "^30$" echo $(ls $M0/dir | wc -l)
+
+cleanup
@@ -0,0 +1,68 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that dht answers lookups of missing names and of names
+# behind linkto files from its entry cache, and that the entry ops of the
+# client drop what the cache holds about the names they change.
+
+function entry_cache_counter {
+        local statedump=$(generate_mount_statedump $V0 $M0)
+        local value=$(grep "^$1=" $statedump | cut -f2 -d'=')
+        cleanup_statedump $(get_mount_process_pid $V0 $M0)
+        echo $value
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..3}
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 cluster.lookup-optimize off
+TEST $CLI volume set $V0 cluster.entry-cache on
+TEST $CLI volume set $V0 cluster.entry-cache-timeout 60
+TEST ! $CLI volume set $V0 cluster.entry-cache-timeout 0
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+
+TEST mkdir $M0/d
+
+# Missing names are answered from the cache the second time
+for i in {1..10}; do
+        TEST ! stat $M0/d/missing$i
+        TEST ! stat $M0/d/missing$i
+done
+TEST [ $(entry_cache_counter entry-cache-missing-hits) -gt 0 ]
+
+# Creating a name that was found missing makes it visible
+TEST touch $M0/d/missing{1..10}
+EXPECT "^10$" echo $(ls $M0/d | wc -l)
+for i in {1..10}; do
+        TEST stat $M0/d/missing$i
+done
+
+# Renames leave linkto files behind, which are looked through
+TEST touch $M0/d/file{1..50}
+for i in {1..50}; do
+        TEST mv $M0/d/file$i $M0/d/moved$i
+done
+EXPECT "^60$" echo $(ls $M0/d | wc -l)
+
+# A new mount looks the moved names up fresh, twice
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+for i in {1..50}; do
+        TEST stat $M0/d/moved$i
+        TEST stat $M0/d/moved$i
+done
+TEST [ $(entry_cache_counter entry-cache-linkto-hits) -gt 0 ]
+
+# Removing a cached name is seen at once
+TEST rm -f $M0/d/moved1
+TEST ! stat $M0/d/moved1
+TEST mv $M0/d/moved2 $M0/d/moved1
+TEST stat $M0/d/moved1
+TEST ! stat $M0/d/moved2
+
+cleanup
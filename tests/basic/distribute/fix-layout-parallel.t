@@ -0,0 +1,95 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that a fix-layout crawled by several threads gives every
+# directory a layout range on the new brick, and that the files are still
+# found afterwards. It also checks that a fix-layout stopped half way
+# resumes from its checkpoint when started again.
+
+function dir_count {
+        echo $(cd $1 && find . -mindepth 1 -type d \
+               -not -path "./.glusterfs*" | wc -l)
+}
+
+function dirs_without_layout {
+        local count=0
+        for d in $(cd $1 && find . -mindepth 1 -type d \
+                   -not -path "./.glusterfs*"); do
+                if [ -z "$(dht_get_layout $1/$d)" ]; then
+                        count=$((count + 1))
+                fi
+        done
+        echo $count
+}
+
+function checkpoint_count {
+        echo $(ls $GLUSTERD_WORKDIR/vols/$V0/rebalance/ | grep -c checkpoint)
+}
+
+# Subtrees recorded as done, leaving out the commit hash line
+function checkpoint_has_entries {
+        local lines=$(cat $GLUSTERD_WORKDIR/vols/$V0/rebalance/*.checkpoint \
+                      2>/dev/null | wc -l)
+        if [ $lines -gt 1 ]; then
+                echo "Y"
+        else
+                echo "N"
+        fi
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 cluster.fix-layout-threads 4
+TEST ! $CLI volume set $V0 cluster.fix-layout-threads 0
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+
+for i in {1..10}; do
+        TEST mkdir -p $M0/dir$i/sub{1..10}/leaf
+        TEST touch $M0/dir$i/file
+done
+
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}3
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "4" online_brick_count
+TEST $CLI volume rebalance $V0 fix-layout start
+EXPECT_WITHIN $REBALANCE_TIMEOUT "fix-layout completed" fix-layout_status_field $V0
+
+# 10 + 100 + 100 directories, all healed to the new brick with a layout
+EXPECT "^210$" dir_count $B0/${V0}3
+EXPECT "^0$" dirs_without_layout $B0/${V0}3
+
+# Nothing is left to resume from once the crawl is complete
+EXPECT "^0$" checkpoint_count
+
+# Files are found again through the new layouts
+EXPECT "^10$" echo $(ls $M0/dir*/file | wc -l)
+
+# Stop a slower crawl once it has recorded some subtrees
+for i in {11..30}; do
+        TEST mkdir -p $M0/dir$i/sub{1..20}/leaf
+done
+TEST $CLI volume set $V0 cluster.fix-layout-threads 1
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}4
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "5" online_brick_count
+TEST $CLI volume rebalance $V0 fix-layout start
+EXPECT_WITHIN $REBALANCE_TIMEOUT "Y" checkpoint_has_entries
+TEST $CLI volume rebalance $V0 stop
+EXPECT_WITHIN $REBALANCE_TIMEOUT "stopped" fix-layout_status_field $V0
+EXPECT "^1$" checkpoint_count
+
+# Started again, it skips what was recorded and still fixes everything
+TEST $CLI volume rebalance $V0 fix-layout start
+EXPECT_WITHIN $REBALANCE_TIMEOUT "fix-layout completed" fix-layout_status_field $V0
+EXPECT_NOT "^0$" echo $(grep -c "fix-layout resumes" \
+                        $(gluster --print-logdir)/${V0}-rebalance.log)
+
+# 210 + 20 * (1 + 20 + 20) directories
+EXPECT "^1030$" dir_count $B0/${V0}4
+EXPECT "^0$" dirs_without_layout $B0/${V0}4
+EXPECT "^0$" checkpoint_count
+
+cleanup
@@ -0,0 +1,49 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that directory listings are complete and free of linkto
+# files and duplicates when dht reads the next subvolumes ahead.
+
+function readdirp_fanout {
+        grep "^readdirp-fanout =" $M0/.meta/graphs/active/$V0-dht/private | \
+                awk '{print $3}'
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..5}
+TEST $CLI volume set $V0 performance.readdir-ahead off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 cluster.readdirp-fanout 4
+TEST ! $CLI volume set $V0 cluster.readdirp-fanout -1
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+
+TEST mkdir $M0/d
+TEST touch $M0/d/file{1..1000}
+TEST mkdir $M0/d/dir{1..20}
+# Renames leave linkto files behind on the new hashed subvolumes
+for i in {1..100}; do
+        TEST mv $M0/d/file$i $M0/d/moved$i
+done
+
+EXPECT "^1020$" echo $(ls $M0/d | wc -l)
+EXPECT "^1020$" echo $(ls $M0/d | sort -u | wc -l)
+EXPECT "^100$" echo $(ls $M0/d | grep -c "^moved")
+EXPECT "^20$" echo $(ls -l $M0/d | grep -c "^d")
+listing=$(ls $M0/d | md5sum | awk '{print $1}')
+
+statedump=$(generate_mount_statedump $V0 $M0)
+EXPECT "4" echo $(grep "^readdirp-fanout=" $statedump | cut -f2 -d'=')
+TEST [ $(grep "^readdirp-fanout-hits=" $statedump | cut -f2 -d'=') -gt 0 ]
+cleanup_statedump $(get_mount_process_pid $V0 $M0)
+
+# The listing is the same without read ahead
+TEST $CLI volume set $V0 cluster.readdirp-fanout 0
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "^0$" readdirp_fanout
+EXPECT "$listing" echo $(ls $M0/d | md5sum | awk '{print $1}')
+
+cleanup
@@ -0,0 +1,84 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../dht.rc
+
+# This test checks that files migrated several blocks at a time, and under
+# a rate limit, have the same contents on their new subvolume, sparse files
+# included. It also checks it when the new subvolume writes only part of
+# some of the blocks.
+
+SCRIPT_TIMEOUT=300
+
+function checksums {
+        (cd $M0 && md5sum file* sparse*)
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..1}
+TEST $CLI volume set $V0 cluster.rebal-window 16
+TEST ! $CLI volume set $V0 cluster.rebal-window 0
+TEST $CLI volume set $V0 cluster.rebal-rate-limit 64MB
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --entry-timeout=0 $M0;
+
+for i in {1..10}; do
+        TEST dd if=/dev/urandom of=$M0/file$i bs=1M count=$i
+done
+# A file smaller than a block, and one that ends within a block
+TEST dd if=/dev/urandom of=$M0/file11 bs=1k count=3
+TEST dd if=/dev/urandom of=$M0/file12 bs=1k count=4500
+for i in {1..5}; do
+        TEST dd if=/dev/urandom of=$M0/sparse$i bs=1M count=1 seek=$((i * 4))
+        TEST dd if=/dev/urandom of=$M0/sparse$i bs=1M count=2 seek=1 \
+                conv=notrunc
+done
+before=$(checksums | md5sum)
+
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}2
+TEST $CLI volume rebalance $V0 start force
+EXPECT_WITHIN $REBALANCE_TIMEOUT "0" rebalance_completed
+EXPECT "^0$" rebalance_failed_field $V0
+
+# Some files moved to the new brick, and none of them changed
+TEST [ $(ls $B0/${V0}2 | grep -c -E "^(file|sparse)") -gt 0 ]
+EXPECT "$before" echo "$(checksums | md5sum)"
+
+# Half of the writes to the bricks are cut short. After a short block, the
+# migration goes on from there even when a later block of the same batch
+# found the end of the data.
+for i in {6..10}; do
+        TEST dd if=/dev/urandom of=$M0/sparse$i bs=1M count=1 seek=$((i * 4))
+        TEST dd if=/dev/urandom of=$M0/sparse$i bs=1M count=2 seek=1 \
+                conv=notrunc
+done
+before=$(checksums | md5sum)
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume set $V0 debug.error-gen posix
+TEST $CLI volume set $V0 debug.error-fops write
+TEST $CLI volume set $V0 debug.error-number GF_ERROR_SHORT_WRITE
+TEST $CLI volume set $V0 debug.error-failure 50
+TEST $CLI volume start $V0
+
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}3
+TEST $CLI volume rebalance $V0 start force
+EXPECT_WITHIN $REBALANCE_TIMEOUT "0" rebalance_completed
+EXPECT "^0$" rebalance_failed_field $V0
+
+TEST $CLI volume stop $V0
+TEST $CLI volume reset $V0 debug.error-gen
+TEST $CLI volume reset $V0 debug.error-fops
+TEST $CLI volume reset $V0 debug.error-number
+TEST $CLI volume reset $V0 debug.error-failure
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --entry-timeout=0 $M0;
+
+TEST [ $(ls $B0/${V0}3 | grep -c -E "^(file|sparse)") -gt 0 ]
+EXPECT "$before" echo "$(checksums | md5sum)"
+
+cleanup
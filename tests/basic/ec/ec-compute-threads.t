@@ -0,0 +1,61 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that data encoded and decoded by the compute threads is
+# the same as the data encoded and decoded inline, and that the number of
+# threads can be changed while the volume is in use.
+
+function get_mount_compute {
+        local sd=$1
+        local field=$2
+        grep -A3 "stats.compute" $sd | grep "^$field=" | cut -f2 -d'='
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 6 redundancy 2 $H0:$B0/${V0}{0..5}
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 disperse.compute-threads 4
+TEST ! $CLI volume set $V0 disperse.compute-threads 65
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "6" ec_child_up_count $V0 0
+
+TEST dd if=/dev/urandom of=$B0/src bs=1M count=4
+
+# Many small concurrent writes
+for i in {0..63}; do
+        dd if=$B0/src of=$M0/small bs=4k count=1 skip=$i seek=$i \
+           conv=notrunc 2>/dev/null &
+done
+wait
+TEST cp $B0/src $M0/big
+
+EXPECT "$(head -c 262144 $B0/src | md5sum)" echo "$(md5sum < $M0/small)"
+EXPECT "$(md5sum < $B0/src)" echo "$(md5sum < $M0/big)"
+
+statedump=$(generate_mount_statedump $V0)
+EXPECT "4" get_mount_compute $statedump "threads"
+TEST [ $(get_mount_compute $statedump "jobs") -gt 0 ]
+
+# Degraded reads are decoded by the compute threads too
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST kill_brick $V0 $H0 $B0/${V0}1
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "4" ec_child_up_count $V0 0
+EXPECT "$(md5sum < $B0/src)" echo "$(md5sum < $M0/big)"
+
+# Changing the number of threads while writing
+dd if=$B0/src of=$M0/resize bs=4k 2>/dev/null &
+TEST $CLI volume set $V0 disperse.compute-threads 0
+TEST $CLI volume set $V0 disperse.compute-threads 2
+wait
+EXPECT "$(md5sum < $B0/src)" echo "$(md5sum < $M0/resize)"
+
+cleanup
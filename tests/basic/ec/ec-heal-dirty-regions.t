@@ -0,0 +1,80 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that the regions written while a brick is down are
+# recorded on the other bricks, that heal rebuilds them correctly and that
+# the records are removed once all the bricks are in sync again.
+
+function region_map_count {
+        getfattr -d -m "trusted.ec.region-map" -e hex $1 2>/dev/null | \
+                grep -c "^trusted.ec.region-map"
+}
+
+function get_dirty_regions_stat {
+        local sd=$1
+        local field=$2
+        grep -A5 "stats.dirty_regions" $sd | grep "^$field=" | cut -f2 -d'='
+}
+
+# Heals may be done by the self-heal daemon or by the mount
+function partial_heal_count {
+        local shd=$(generate_shd_statedump $V0)
+        local mnt=$(generate_mount_statedump $V0)
+        echo $(( $(get_dirty_regions_stat $shd "partial-heals") + \
+                 $(get_dirty_regions_stat $mnt "partial-heals") ))
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 disperse.heal-dirty-regions on
+TEST ! $CLI volume set $V0 disperse.heal-dirty-regions maybe
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=32
+TEST dd if=/dev/urandom of=$M0/small bs=1k count=7
+EXPECT "0" region_map_count $B0/${V0}1/file
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+
+# Small writes in the middle and at the end of the file
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=1 seek=10 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/file bs=4k count=3 seek=8190 conv=notrunc
+TEST dd if=/dev/urandom of=$M0/small bs=1k count=2 seek=3 conv=notrunc
+EXPECT_WITHIN $IO_WAIT_TIMEOUT "1" region_map_count $B0/${V0}1/file
+EXPECT_WITHIN $IO_WAIT_TIMEOUT "1" region_map_count $B0/${V0}2/file
+EXPECT "0" region_map_count $B0/${V0}0/file
+
+md5_file=$(md5sum $M0/file | awk '{print $1}')
+md5_small=$(md5sum $M0/small | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+# The records are removed once the file is healed
+EXPECT "0" region_map_count $B0/${V0}1/file
+EXPECT "0" region_map_count $B0/${V0}2/file
+EXPECT "$(stat -c %s $B0/${V0}1/file)" stat -c %s $B0/${V0}0/file
+
+# Only the recorded regions have been rebuilt
+TEST [ $(partial_heal_count) -ge 1 ]
+cleanup_statedump
+
+# Read the files using the healed brick
+TEST kill_brick $V0 $H0 $B0/${V0}1
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+EXPECT "$md5_file" echo $(md5sum $M0/file | awk '{print $1}')
+EXPECT "$md5_small" echo $(md5sum $M0/small | awk '{print $1}')
+
+cleanup
@@ -0,0 +1,62 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that files healed with several windows in flight are
+# rebuilt correctly and that the holes of sparse files are not copied.
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 disperse.self-heal-window-size 1
+TEST $CLI volume set $V0 disperse.heal-pipeline-depth 8
+TEST $CLI volume set $V0 disperse.heal-bandwidth-limit 64MB
+TEST ! $CLI volume set $V0 disperse.heal-pipeline-depth 0
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+
+# A dense file bigger than a whole wave of windows
+TEST dd if=/dev/urandom of=$M0/dense bs=1M count=5
+# A sparse file with data at both ends and a large hole in between
+TEST dd if=/dev/urandom of=$M0/sparse bs=1M count=1
+TEST dd if=/dev/urandom of=$M0/sparse bs=1M count=1 seek=63 conv=notrunc
+# A file that is a hole from the beginning to the end
+TEST truncate -s 32M $M0/hole
+
+md5_dense=$(md5sum $M0/dense | awk '{print $1}')
+md5_sparse=$(md5sum $M0/sparse | awk '{print $1}')
+md5_hole=$(md5sum $M0/hole | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+# The windows of a wave were healed at the same time
+statedump=$(generate_shd_statedump $V0)
+TEST [ $(grep "^heal-windows-max=" $statedump | cut -f2 -d'=') -gt 1 ]
+cleanup_statedump
+
+# Fragments have the same size on all the bricks and the holes are kept
+EXPECT "$(stat -c %s $B0/${V0}1/sparse)" stat -c %s $B0/${V0}0/sparse
+EXPECT "$(stat -c %s $B0/${V0}1/hole)" stat -c %s $B0/${V0}0/hole
+TEST [ $(du -k $B0/${V0}0/sparse | awk '{print $1}') -lt 16384 ]
+TEST [ $(du -k $B0/${V0}0/hole | awk '{print $1}') -lt 1024 ]
+
+# Read the files using the healed brick
+TEST kill_brick $V0 $H0 $B0/${V0}1
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+EXPECT "$md5_dense" echo $(md5sum $M0/dense | awk '{print $1}')
+EXPECT "$md5_sparse" echo $(md5sum $M0/sparse | awk '{print $1}')
+EXPECT "$md5_hole" echo $(md5sum $M0/hole | awk '{print $1}')
+
+cleanup
@@ -0,0 +1,66 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that reads sent to extra bricks because the first ones
+# are slow return the right data, and that the least-load read policy
+# tracks the load of each brick.
+
+function get_mount_hedge {
+        local sd=$1
+        local field=$2
+        grep -A3 "stats.hedge" $sd | grep "^$field=" | cut -f2 -d'='
+}
+
+function get_mount_brick {
+        local sd=$1
+        local field=$2
+        grep "^brick\[0\].$field=" $sd | head -1 | cut -f2 -d'='
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 6 redundancy 2 $H0:$B0/${V0}{0..5}
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 disperse.read-policy least-load
+TEST ! $CLI volume set $V0 disperse.read-hedge-delay -1
+TEST $CLI volume start $V0
+
+TEST glusterfs --direct-io-mode=yes --entry-timeout=0 --attribute-timeout=0 -s $H0 --volfile-id $V0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "6" ec_child_up_count $V0 0
+EXPECT "least-load" mount_get_option_value $M0 $V0-disperse-0 read-policy
+
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=8
+md5=$(md5sum $M0/file | awk '{print $1}')
+
+# Reads are not hedged by default
+EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+statedump=$(generate_mount_statedump $V0)
+EXPECT "0" get_mount_hedge $statedump "sent"
+# All the bricks of the test are local
+EXPECT "1" get_mount_brick $statedump "local"
+TEST [ $(get_mount_brick $statedump "latency") -gt 0 ]
+
+# A 1 usec delay sends almost every read to an extra brick
+TEST $CLI volume set $V0 disperse.read-hedge-delay 1
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "1" mount_get_option_value $M0 $V0-disperse-0 read-hedge-delay
+for i in {1..4}; do
+        EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+done
+statedump=$(generate_mount_statedump $V0)
+TEST [ $(get_mount_hedge $statedump "sent") -gt 0 ]
+
+# Hedged reads still work when some bricks are down
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "5" ec_child_up_count $V0 0
+EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+TEST kill_brick $V0 $H0 $B0/${V0}1
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "4" ec_child_up_count $V0 0
+EXPECT "$md5" echo $(md5sum $M0/file | awk '{print $1}')
+
+cleanup
@@ -48,5 +48,25 @@ TEST dd if=$M0/1 of=/dev/null bs=1M count=4
 #TEST that reads are executed on all bricks
 gh_reads=$($CLI volume profile $V0 info cumulative| grep -w READ |  wc -l)
 EXPECT "^4$" echo $gh_reads
+TEST $CLI volume profile $V0 info clear
+
+TEST $CLI volume set $V0 disperse.read-policy min-decode
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "min-decode" mount_get_option_value $M0 $V0-disperse-0 read-policy
+
+#min-decode always reads from the same (num-bricks - redundancy) bricks
+TEST dd if=/dev/urandom of=$M0/2 bs=1M count=4
+md5=$(md5sum $M0/2 | awk '{print $1}')
+TEST dd if=$M0/2 of=/dev/null bs=1M count=4
+md_reads=$($CLI volume profile $V0 info cumulative| grep -w READ |  wc -l)
+EXPECT "^4$" echo $md_reads
+
+#Data is still decoded correctly when the remaining bricks must be used
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST kill_brick $V0 $H0 $B0/${V0}5
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "4" ec_child_up_count $V0 0
+EXPECT "$md5" echo $(md5sum $M0/2 | awk '{print $1}')
+
+statedump=$(generate_mount_statedump $V0)
+TEST [ $(grep -A5 "stats.matrix_cache" $statedump | grep "^misses=" | cut -f2 -d'=') -ge 1 ]
 
 cleanup;
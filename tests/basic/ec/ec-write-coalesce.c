@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <glusterfs/api/glfs.h>
+
+/* Sends <count> adjacent writes of <bs> bytes through a single fd without
+ * waiting for any of them to complete, then generates a statedump of the
+ * client so that the write coalescing stats can be checked. */
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static int pending = 0;
+static int failed = 0;
+
+static void
+write_cbk(glfs_fd_t *fd, ssize_t ret, struct glfs_stat *prestat,
+          struct glfs_stat *poststat, void *data)
+{
+    pthread_mutex_lock(&lock);
+    if (ret != (ssize_t)(long)data) {
+        failed++;
+    }
+    if (--pending == 0) {
+        pthread_cond_signal(&cond);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+int
+main(int argc, char *argv[])
+{
+    glfs_t *fs = NULL;
+    glfs_fd_t *fd = NULL;
+    char *buf = NULL;
+    int src = -1;
+    int count, bs, i;
+    int ret = 1;
+
+    if (argc != 7) {
+        fprintf(stderr,
+                "Syntax: %s <host> <volname> <file> <source> <count> <bs>\n",
+                argv[0]);
+        return 1;
+    }
+
+    count = atoi(argv[5]);
+    bs = atoi(argv[6]);
+    buf = malloc((size_t)count * bs);
+    if (buf == NULL) {
+        fprintf(stderr, "malloc: %s\n", strerror(errno));
+        return 1;
+    }
+
+    src = open(argv[4], O_RDONLY);
+    if ((src < 0) || (read(src, buf, (size_t)count * bs) != count * bs)) {
+        fprintf(stderr, "unable to read %s\n", argv[4]);
+        goto out;
+    }
+
+    fs = glfs_new(argv[2]);
+    if (!fs) {
+        fprintf(stderr, "glfs_new: returned NULL\n");
+        goto out;
+    }
+
+    ret = glfs_set_volfile_server(fs, "tcp", argv[1], 24007);
+    if (ret != 0) {
+        fprintf(stderr, "glfs_set_volfile_server: returned %d\n", ret);
+        goto out;
+    }
+    ret = glfs_set_logging(fs, "/tmp/ec-write-coalesce.log", 7);
+    if (ret != 0) {
+        fprintf(stderr, "glfs_set_logging: returned %d\n", ret);
+        goto out;
+    }
+    ret = glfs_init(fs);
+    if (ret != 0) {
+        fprintf(stderr, "glfs_init: returned %d\n", ret);
+        goto out;
+    }
+
+    ret = 1;
+    fd = glfs_creat(fs, argv[3], O_RDWR, 0644);
+    if (fd == NULL) {
+        fprintf(stderr, "glfs_creat: returned NULL\n");
+        goto out;
+    }
+
+    pending = count;
+    for (i = 0; i < count; i++) {
+        if (glfs_pwrite_async(fd, buf + (size_t)i * bs, bs, (off_t)i * bs, 0,
+                              write_cbk, (void *)(long)bs) != 0) {
+            fprintf(stderr, "glfs_pwrite_async: %s\n", strerror(errno));
+            pthread_mutex_lock(&lock);
+            failed++;
+            pending -= count - i;
+            pthread_mutex_unlock(&lock);
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&lock);
+    while (pending > 0) {
+        pthread_cond_wait(&cond, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+
+    if (failed != 0) {
+        fprintf(stderr, "%d writes failed\n", failed);
+        goto out;
+    }
+
+    if (glfs_close(fd) != 0) {
+        fprintf(stderr, "glfs_close: %s\n", strerror(errno));
+        fd = NULL;
+        goto out;
+    }
+    fd = NULL;
+
+    ret = glfs_sysrq(fs, GLFS_SYSRQ_STATEDUMP);
+    if (ret != 0) {
+        fprintf(stderr, "glfs_sysrq: returned %d\n", ret);
+    }
+
+out:
+    if (fd != NULL) {
+        glfs_close(fd);
+    }
+    if (src >= 0) {
+        close(src);
+    }
+    if (fs != NULL) {
+        glfs_fini(fs);
+    }
+    unlink("/tmp/ec-write-coalesce.log");
+    free(buf);
+
+    return ret;
+}
@@ -0,0 +1,60 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# This test checks that unaligned writes held by write-coalesce-timeout and
+# sent together produce the same contents as if they were sent one by one.
+
+function get_mount_write_coalesce {
+        local sd=$1
+        local field=$2
+        grep -A3 "stats.write_coalesce" $sd | grep "^$field=" | cut -f2 -d'='
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 disperse.write-coalesce-timeout 100000
+TEST ! $CLI volume set $V0 disperse.write-coalesce-timeout 2000000
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+TEST dd if=/dev/urandom of=$B0/src bs=700 count=32
+
+# Adjacent 700 bytes writes sent through a single fd without waiting for
+# each other, none of them aligned to the 1024 bytes stripe of this volume.
+# The helper leaves a statedump of its own client graph behind.
+cleanup_statedump
+TEST build_tester $(dirname $0)/ec-write-coalesce.c -lgfapi -lpthread -Wall -O2
+TEST $(dirname $0)/ec-write-coalesce $H0 $V0 /file $B0/src 32 700
+cleanup_tester $(dirname $0)/ec-write-coalesce
+
+EXPECT "$(md5sum < $B0/src)" echo "$(md5sum < $M0/file)"
+
+statedump=$(ls $statedumpdir/glusterdump.*.dump.* | head -1)
+EXPECT "100000" get_mount_write_coalesce $statedump "timeout"
+writes=$(get_mount_write_coalesce $statedump "writes")
+batches=$(get_mount_write_coalesce $statedump "batches")
+TEST [ $writes -eq 32 ]
+TEST [ $batches -lt $writes ]
+cleanup_statedump
+
+# Sequential writes are sent alone once the timeout expires
+TEST dd if=$B0/src of=$M0/seq bs=700 count=8
+EXPECT "$(head -c 5600 $B0/src | md5sum)" echo "$(md5sum < $M0/seq)"
+
+statedump=$(generate_mount_statedump $V0)
+EXPECT "100000" get_mount_write_coalesce $statedump "timeout"
+TEST [ $(get_mount_write_coalesce $statedump "writes") -ge 8 ]
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+EXPECT "$(md5sum < $B0/src)" echo "$(md5sum < $M0/file)"
+
+cleanup
@@ -0,0 +1,89 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+case $OSTYPE in
+Linux)
+        ;;
+*)
+        echo "Skip test: FICLONERANGE is specific to Linux" >&2
+        SKIP_TESTS
+        exit 0
+        ;;
+esac
+
+mkfs.xfs 2>&1 | grep reflink
+if [ $? -ne 0 ]; then
+    echo "Skip test: XFS reflink feature is not supported" >&2
+    SKIP_TESTS
+    exit
+fi
+
+TEST glusterd
+
+TEST truncate -s 2G $B0/xfs_image
+TEST mkfs.xfs -f -i size=512 -m reflink=1 $B0/xfs_image;
+
+TEST mkdir $B0/bricks
+TEST mount -t xfs -o loop $B0/xfs_image $B0/bricks
+
+# Both replicas live on the reflink capable filesystem, each of them
+# clones its own copy of the source file.
+TEST $CLI volume create $V0 replica 2 $H0:$B0/bricks/brick{1,2} force;
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume start $V0;
+EXPECT 'Started' volinfo_field $V0 'Status';
+
+TEST glusterfs --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=64;
+
+logdir=`gluster --print-logdir`
+
+TEST build_tester $(dirname $0)/glfs-clone-file-range.c -lgfapi
+
+TEST ./$(dirname $0)/glfs-clone-file-range $H0 $V0 $logdir/gfapi-clone-file-range.log /file /clone
+
+TEST stat $M0/clone
+EXPECT "$(md5sum < $M0/file)" echo "$(md5sum < $M0/clone)"
+EXPECT "$(md5sum < $B0/bricks/brick1/file)" echo "$(md5sum < $B0/bricks/brick1/clone)"
+EXPECT "$(md5sum < $B0/bricks/brick2/file)" echo "$(md5sum < $B0/bricks/brick2/clone)"
+
+# No pending heals are left behind by the clone.
+EXPECT "^0$" get_pending_heal_count $V0
+
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+# With an arbiter, only the data bricks hold the clone and none of them is
+# blamed for it.
+TEST $CLI volume create $V1 replica 3 arbiter 1 \
+        $H0:$B0/bricks/arb{1,2,3} force;
+TEST $CLI volume set $V1 performance.write-behind off
+TEST $CLI volume start $V1;
+EXPECT 'Started' volinfo_field $V1 'Status';
+
+TEST glusterfs --volfile-id=/$V1 --volfile-server=$H0 $M1
+
+TEST dd if=/dev/urandom of=$M1/file bs=1M count=64;
+
+TEST ./$(dirname $0)/glfs-clone-file-range $H0 $V1 $logdir/gfapi-clone-file-range.log /file /clone
+
+EXPECT "$(md5sum < $M1/file)" echo "$(md5sum < $M1/clone)"
+EXPECT "$(md5sum < $B0/bricks/arb1/file)" echo "$(md5sum < $B0/bricks/arb1/clone)"
+EXPECT "$(md5sum < $B0/bricks/arb2/file)" echo "$(md5sum < $B0/bricks/arb2/clone)"
+EXPECT "0" stat -c %s $B0/bricks/arb3/clone
+EXPECT "^0$" get_pending_heal_count $V1
+
+cleanup_tester $(dirname $0)/glfs-clone-file-range
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+TEST $CLI volume stop $V1
+TEST $CLI volume delete $V1
+
+UMOUNT_LOOP $B0/bricks;
+
+cleanup;
@@ -48,15 +48,18 @@ main(int argc, char *argv[])
     unsigned int mask;
     struct glfs_stat statx;
     bool bret;
+    bool btime = false;
 
-    if (argc != 3) {
+    if ((argc != 3) && (argc != 4)) {
         fprintf(stderr, "Invalid argument\n");
-        fprintf(stderr, "Usage: %s <volname> <logfile>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <volname> <logfile> [btime]\n", argv[0]);
         return 1;
     }
 
     volname = argv[1];
     logfile = argv[2];
+    /* The brick filesystem records birth times */
+    btime = (argc == 4) && (strcmp(argv[3], "btime") == 0);
 
     fs = glfs_new(volname);
     if (!fs)
@@ -173,6 +176,34 @@ main(int argc, char *argv[])
         ret = -1;
         goto out;
     }
+
+    /* TEST 4: The birth time is returned when asked for and the brick
+     * filesystem provides one. It can not be later than the last status
+     * change */
+    mask = GLFS_STAT_ALL;
+    ret = glfs_statx(fs, filename, mask, &statx);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_statx", ret, out);
+
+    if (btime) {
+        bret = GLFS_STAT_BTIME_VALID(statx.glfs_st_mask);
+        GOTO_LABEL_ON_FALSE("GLFS_STAT_BTIME_VALID(statx.glfs_st_mask)", bret,
+                            out);
+    }
+    if (GLFS_STAT_BTIME_VALID(statx.glfs_st_mask)) {
+        bret = (statx.glfs_st_btime.tv_sec != 0 &&
+                statx.glfs_st_btime.tv_sec <= statx.glfs_st_ctime.tv_sec);
+        GOTO_LABEL_ON_FALSE("(statx.glfs_st_btime <= statx.glfs_st_ctime)",
+                            bret, out);
+    }
+
+    /* TEST 5: It is not returned when not asked for */
+    mask = GLFS_STAT_BASIC_STATS;
+    ret = glfs_statx(fs, filename, mask, &statx);
+    VALIDATE_AND_GOTO_LABEL_ON_ERROR("glfs_statx", ret, out);
+
+    bret = !GLFS_STAT_BTIME_VALID(statx.glfs_st_mask);
+    GOTO_LABEL_ON_FALSE("!GLFS_STAT_BTIME_VALID(statx.glfs_st_mask)", bret,
+                        out);
 out:
     if (fd1 != NULL)
         glfs_close(fd1);
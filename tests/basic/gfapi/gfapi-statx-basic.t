@@ -23,7 +23,14 @@ logdir=`gluster --print-logdir`
 
 build_tester $(dirname $0)/gfapi-statx-basic.c -lgfapi
 
-TEST ./$(dirname $0)/gfapi-statx-basic $V0 $logdir/gfapi-statx-basic.log
+# Check the birth time only when the brick filesystem records it
+btime=""
+TEST touch $B0/btime-probe
+if [ "$(stat -c %W $B0/btime-probe)" != "0" ]; then
+        btime="btime"
+fi
+
+TEST ./$(dirname $0)/gfapi-statx-basic $V0 $logdir/gfapi-statx-basic.log $btime
 
 cleanup_tester $(dirname $0)/gfapi-statx-basic
 
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <glusterfs/api/glfs.h>
+#include <string.h>
+
+#define LOG_ERR(msg)                                                           \
+    do {                                                                       \
+        fprintf(stderr, "%s : Error (%s)\n", msg, strerror(errno));            \
+    } while (0)
+
+int
+main(int argc, char **argv)
+{
+    glfs_t *fs = NULL;
+    glfs_fd_t *glfd_in = NULL;
+    glfs_fd_t *glfd_out = NULL;
+    struct stat stbuf = {
+        0,
+    };
+    ssize_t ret = -1;
+
+    if (argc != 6) {
+        fprintf(stderr, "Usage: %s <host> <volume> <log file> <src> <dst>\n",
+                argv[0]);
+        return 1;
+    }
+
+    fs = glfs_new(argv[2]);
+    if (!fs) {
+        LOG_ERR("glfs_new failed");
+        return 1;
+    }
+
+    ret = glfs_set_volfile_server(fs, "tcp", argv[1], 24007);
+    if (ret < 0) {
+        LOG_ERR("glfs_set_volfile_server failed");
+        goto out;
+    }
+
+    ret = glfs_set_logging(fs, argv[3], 7);
+    if (ret < 0) {
+        LOG_ERR("glfs_set_logging failed");
+        goto out;
+    }
+
+    ret = glfs_init(fs);
+    if (ret < 0) {
+        LOG_ERR("glfs_init failed");
+        goto out;
+    }
+
+    ret = -1;
+    glfd_in = glfs_open(fs, argv[4], O_RDONLY);
+    if (!glfd_in) {
+        LOG_ERR("glfs_open failed");
+        goto out;
+    }
+
+    glfd_out = glfs_creat(fs, argv[5], O_RDWR, 0644);
+    if (!glfd_out) {
+        LOG_ERR("glfs_creat failed");
+        goto out;
+    }
+
+    if (glfs_fstat(glfd_in, &stbuf) < 0) {
+        LOG_ERR("glfs_fstat failed");
+        goto out;
+    }
+
+    /* A length of 0 clones the whole file. */
+    ret = glfs_clone_file_range(glfd_in, 0, glfd_out, 0, 0);
+    if (ret < 0) {
+        LOG_ERR("glfs_clone_file_range failed");
+        goto out;
+    }
+
+    if (ret != stbuf.st_size) {
+        fprintf(stderr, "cloned %zd bytes of %jd\n", ret,
+                (intmax_t)stbuf.st_size);
+        ret = -1;
+        goto out;
+    }
+
+    ret = 0;
+out:
+    if (glfd_in)
+        glfs_close(glfd_in);
+    if (glfd_out)
+        glfs_close(glfd_out);
+    glfs_fini(fs);
+
+    return ret ? 1 : 0;
+}
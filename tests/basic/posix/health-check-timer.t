@@ -0,0 +1,42 @@
+#!/bin/bash
+
+#Health checks are scheduled on the timer wheel of the brick process, no
+#thread is kept per brick. Check that they keep running and that a brick
+#whose backend goes away is still taken down.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function health_check_threads {
+        local pid=$(get_brick_pid $V0 $H0 $B0/${V0}$1)
+        cat /proc/$pid/task/*/comm | grep -c posixhc
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 storage.health-check-interval 1
+TEST $CLI volume start $V0
+
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" brick_up_status $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" brick_up_status $V0 $H0 $B0/${V0}1
+#A probe has a thread only while it runs
+EXPECT_WITHIN 5 "0" health_check_threads 0
+
+#The probe file is rewritten on every check
+TEST sleep 3
+TEST [ -f $B0/${V0}0/.glusterfs/health_check ]
+
+#Changing the interval reschedules the timer
+TEST $CLI volume set $V0 storage.health-check-interval 2
+TEST sleep 3
+EXPECT "1" brick_up_status $V0 $H0 $B0/${V0}0
+
+#A failing probe brings the brick down
+TEST rm -rf $B0/${V0}1/.glusterfs
+#The brick is sent SIGTERM 30 seconds after the failure
+EXPECT_WITHIN 45 "0" brick_up_status $V0 $H0 $B0/${V0}1
+EXPECT "1" brick_up_status $V0 $H0 $B0/${V0}0
+
+cleanup;
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+#Checks that the janitor empties the landfill directory with its pool of
+#workers, also when the purge rate is limited.
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function landfill_entries {
+        ls -A $B0/${V0}0/.glusterfs/landfill | wc -l
+}
+
+function fill_landfill {
+        local dir
+        for dir in {1..8}; do
+                mkdir -p $B0/${V0}0/.glusterfs/landfill/dir$dir/a/b/c
+                touch $B0/${V0}0/.glusterfs/landfill/dir$dir/file{1..50}
+                touch $B0/${V0}0/.glusterfs/landfill/dir$dir/a/b/c/file{1..50}
+        done
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 storage.janitor-purge-threads 4
+TEST $CLI volume start $V0
+
+TEST fill_landfill
+EXPECT_WITHIN 30 "0" landfill_entries
+
+#At 200 removals per second the ~850 entries take a few seconds
+TEST $CLI volume set $V0 storage.janitor-purge-rate 200
+TEST fill_landfill
+EXPECT_WITHIN 60 "0" landfill_entries
+
+TEST ! $CLI volume set $V0 storage.janitor-purge-threads 0
+
+cleanup;
@@ -766,6 +766,7 @@ afr_inode_ctx_destroy(afr_inode_ctx_t *ctx)
         GF_FREE(ctx->pre_op_done[i]);
     }
 
+    GF_FREE(ctx->region_map);
     GF_FREE(ctx);
 }
 
@@ -2132,6 +2133,7 @@ static int
 afr_lookup_xattr_req_prepare(afr_local_t *local, xlator_t *this,
                              dict_t *xattr_req, loc_t *loc)
 {
+    uint64_t mask = 0;
     int ret = -ENOMEM;
 
     if (!local->xattr_req)
@@ -2143,6 +2145,13 @@ afr_lookup_xattr_req_prepare(afr_local_t *local, xlator_t *this,
     if (xattr_req && (xattr_req != local->xattr_req))
         dict_copy(xattr_req, local->xattr_req);
 
+    /* The replies of the replicas are compared, they need full iatts */
+    if (dict_get_uint64(local->xattr_req, GF_REQUEST_IATT_MASK, &mask) ||
+        !(mask & IATT_BTIME))
+        dict_del_sizen(local->xattr_req, GF_REQUEST_IATT_MASK);
+    else if (dict_set_uint64(local->xattr_req, GF_REQUEST_IATT_MASK, IATT_ALL))
+        goto out;
+
     ret = afr_xattr_req_prepare(this, local->xattr_req);
 
     ret = dict_set_uint64(local->xattr_req, GLUSTERFS_INODELK_COUNT, 0);
@@ -2424,6 +2433,9 @@ afr_local_transaction_cleanup(afr_local_t *local, unsigned int child_count)
 
     GF_FREE(local->transaction.failed_subvols);
 
+    if (local->transaction.region_post_op)
+        dict_unref(local->transaction.region_post_op);
+
     GF_FREE(local->transaction.basename);
     GF_FREE(local->transaction.new_basename);
 
@@ -2684,6 +2696,12 @@ afr_local_cleanup(afr_local_t *local, xlator_t *this)
             dict_unref(local->cont.readdir.dict);
     }
 
+    { /* copy_file_range */
+        if (local->cont.copy_file_range.fd_in)
+            fd_unref(local->cont.copy_file_range.fd_in);
+        GF_FREE(local->cont.copy_file_range.stbufs);
+    }
+
     { /* inodelk */
         GF_FREE(local->cont.inodelk.volume);
         if (local->cont.inodelk.xdata)
@@ -4257,6 +4275,7 @@ afr_flush(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 {
     afr_local_t *local = NULL;
     call_stub_t *stub = NULL;
+    dict_t *lease_xdata = NULL;
     int op_errno = ENOMEM;
 
     AFR_ERROR_OUT_IF_FDCTX_INVALID(fd, this, op_errno, out);
@@ -4270,7 +4289,13 @@ afr_flush(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 
     local->fd = fd_ref(fd);
 
-    stub = fop_flush_stub(frame, afr_flush_wrapper, fd, xdata);
+    if (xdata)
+        lease_xdata = dict_ref(xdata);
+    afr_read_lease_xdata_set(this, fd->inode, &lease_xdata);
+
+    stub = fop_flush_stub(frame, afr_flush_wrapper, fd, lease_xdata);
+    if (lease_xdata)
+        dict_unref(lease_xdata);
     if (!stub)
         goto out;
 
@@ -5326,6 +5351,7 @@ afr_lk(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
         }
     }
 
+    afr_read_lease_xdata_set(this, fd->inode, &local->xdata_req);
     STACK_WIND_COOKIE(frame, afr_lk_cbk, (void *)(long)0, priv->children[i],
                       priv->children[i]->fops->lk, fd, cmd, flock,
                       local->xdata_req);
@@ -5653,6 +5679,38 @@ afr_priv_dump(xlator_t *this)
     gf_proc_dump_write("data_self_heal", "%d", priv->data_self_heal);
     gf_proc_dump_write("metadata_self_heal", "%d", priv->metadata_self_heal);
     gf_proc_dump_write("entry_self_heal", "%d", priv->entry_self_heal);
+    gf_proc_dump_write("data-self-heal-pipeline-depth", "%u",
+                       priv->data_self_heal_pipeline_depth);
+    gf_proc_dump_write("entry-self-heal-batch-size", "%u",
+                       priv->entry_heal_batch);
+    gf_proc_dump_write("entry-heal-names-compared", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->entry_heal_names_compared));
+    gf_proc_dump_write("entry-heal-names-healed", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->entry_heal_names_healed));
+    gf_proc_dump_write("entry-heal-usec", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->entry_heal_usec));
+    gf_proc_dump_write("granular-data-heal", "%d", priv->dsh_granular);
+    gf_proc_dump_write("read-hedge-percentile", "%.2f", priv->read_hedge_pct);
+    gf_proc_dump_write("read-hedge-min-delay-usec", "%u",
+                       priv->read_hedge_min_delay);
+    gf_proc_dump_write("read-hedges-sent", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->read_hedges_sent));
+    gf_proc_dump_write("read-hedges-won", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->read_hedges_won));
+    gf_proc_dump_write("read-lease", "%d", priv->read_lease);
+    gf_proc_dump_write("read-leases-granted", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->read_leases_granted));
+    gf_proc_dump_write("read-leases-recalled", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->read_leases_recalled));
+    gf_proc_dump_write("read-lease-refreshes-skipped", "%" PRIu64,
+                       GF_ATOMIC_GET(priv->read_lease_refreshes_skipped));
+    gf_proc_dump_write("write-batch-delay-usec", "%u", priv->write_batch_usec);
+    gf_proc_dump_write("write-batch-size", "%u", priv->write_batch_size);
+    for (i = 0; i < AFR_WRITE_BATCH_BUCKETS; i++) {
+        sprintf(key, "write-batches[%u]", 1U << i);
+        gf_proc_dump_write(key, "%" PRIu64,
+                           GF_ATOMIC_GET(priv->write_batches[i]));
+    }
     gf_proc_dump_write("read_child", "%d", priv->read_child);
     gf_proc_dump_write("wait_count", "%u", priv->wait_count);
     gf_proc_dump_write("heal-wait-queue-length", "%d", priv->heal_wait_qlen);
@@ -5671,6 +5729,7 @@ afr_priv_dump(xlator_t *this)
         gf_proc_dump_write("quorum-count", "%d", priv->quorum_count);
     }
     gf_proc_dump_write("up", "%u", afr_has_quorum(priv->child_up, priv, NULL));
+    afr_shd_dump_progress(this);
     if (priv->thin_arbiter_count) {
         gf_proc_dump_write("ta_child_up", "%d", priv->ta_child_up);
         gf_proc_dump_write("ta_bad_child_index", "%d",
@@ -6062,6 +6121,7 @@ __afr_handle_child_down_event(xlator_t *this, xlator_t *child_xlator, int idx,
      */
     if (priv->child_up[idx] == 1) {
         priv->event_generation++;
+        GF_ATOMIC_INC(priv->down_generation);
     }
 
     /*
@@ -6135,6 +6195,297 @@ afr_ta_lock_release_synctask(xlator_t *this)
     }
 }
 
+static int32_t
+afr_read_lease_release_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                           int32_t op_ret, int32_t op_errno,
+                           struct gf_lease *lease, dict_t *xdata)
+{
+    inode_t *inode = cookie;
+    afr_inode_ctx_t *ctx = NULL;
+
+    if (inode) {
+        LOCK(&inode->lock);
+        {
+            ctx = __afr_inode_ctx_get(this, inode);
+            if (ctx && ctx->read_lease == AFR_READ_LEASE_RELEASING)
+                ctx->read_lease = AFR_READ_LEASE_NONE;
+        }
+        UNLOCK(&inode->lock);
+        inode_unref(inode);
+    }
+
+    STACK_DESTROY(frame->root);
+    return 0;
+}
+
+/* The lease fop is wound to this xlator itself, so that afr_lease()
+ * takes care of taking it on the bricks and of the quorum. @cookie, when
+ * set, is the inode whose context tracks the lease. */
+static int
+afr_read_lease_wind(xlator_t *this, loc_t *loc, gf_lease_cmds_t cmd,
+                    fop_lease_cbk_t cbk, inode_t *cookie)
+{
+    afr_private_t *priv = this->private;
+    call_frame_t *frame = NULL;
+    struct gf_lease lease = {
+        0,
+    };
+
+    frame = create_frame(this, this->ctx->pool);
+    if (!frame)
+        return -1;
+
+    lease.cmd = cmd;
+    lease.lease_type = GF_RD_LEASE;
+    memcpy(lease.lease_id, priv->read_lease_id, LEASE_ID_SIZE);
+
+    STACK_WIND_COOKIE(frame, cbk, (cookie ? inode_ref(cookie) : NULL), this,
+                      this->fops->lease, loc, &lease, NULL);
+    return 0;
+}
+
+static void
+afr_read_lease_release(xlator_t *this, inode_t *inode, uuid_t gfid,
+                       gf_boolean_t tracked)
+{
+    afr_inode_ctx_t *ctx = NULL;
+    loc_t loc = {
+        0,
+    };
+
+    loc.inode = inode_ref(inode);
+    gf_uuid_copy(loc.gfid, gfid);
+    if (afr_read_lease_wind(this, &loc, GF_UNLK_LEASE,
+                            afr_read_lease_release_cbk,
+                            tracked ? inode : NULL) &&
+        tracked) {
+        LOCK(&inode->lock);
+        {
+            ctx = __afr_inode_ctx_get(this, inode);
+            if (ctx && ctx->read_lease == AFR_READ_LEASE_RELEASING)
+                ctx->read_lease = AFR_READ_LEASE_NONE;
+        }
+        UNLOCK(&inode->lock);
+    }
+    loc_wipe(&loc);
+}
+
+static int32_t
+afr_read_lease_acquire_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                           int32_t op_ret, int32_t op_errno,
+                           struct gf_lease *lease, dict_t *xdata)
+{
+    afr_private_t *priv = this->private;
+    inode_t *inode = cookie;
+    afr_inode_ctx_t *ctx = NULL;
+    gf_boolean_t release = _gf_false;
+
+    if (op_ret < 0 && op_errno == ENOSYS && !priv->read_lease_unsupported) {
+        priv->read_lease_unsupported = _gf_true;
+        gf_msg(this->name, GF_LOG_WARNING, op_errno, AFR_MSG_INVALID_ARG,
+               "Read leases are not supported by the bricks, enable "
+               "features.leases on the volume to use cluster.read-lease");
+    }
+
+    LOCK(&inode->lock);
+    {
+        ctx = __afr_inode_ctx_get(this, inode);
+        if (!ctx) {
+            release = (op_ret >= 0);
+        } else if (op_ret < 0) {
+            ctx->read_lease = AFR_READ_LEASE_NONE;
+        } else if (ctx->read_lease == AFR_READ_LEASE_ACQUIRING) {
+            ctx->read_lease = AFR_READ_LEASE_HELD;
+            /* Writes may have happened between the last refresh and
+             * the grant of the lease, revalidate the readable set once
+             * before trusting it. */
+            ctx->need_refresh = _gf_true;
+            GF_ATOMIC_INC(priv->read_leases_granted);
+        } else {
+            /* Recalled while it was being granted */
+            release = _gf_true;
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    if (op_ret < 0)
+        gf_msg_debug(this->name, op_errno, "%s: read lease not granted",
+                     uuid_utoa(inode->gfid));
+
+    if (release)
+        afr_read_lease_release(this, inode, inode->gfid, ctx != NULL);
+
+    inode_unref(inode);
+    STACK_DESTROY(frame->root);
+    return 0;
+}
+
+/* Takes a read lease on a file that was just opened read-only, unless one
+ * is already held or being changed. */
+void
+afr_read_lease_acquire(xlator_t *this, inode_t *inode)
+{
+    afr_private_t *priv = this->private;
+    afr_inode_ctx_t *ctx = NULL;
+    uint32_t down_gen = 0;
+    gf_boolean_t acquire = _gf_false;
+    loc_t loc = {
+        0,
+    };
+
+    if (!priv->read_lease || priv->read_lease_unsupported)
+        return;
+
+    down_gen = GF_ATOMIC_GET(priv->down_generation);
+    LOCK(&inode->lock);
+    {
+        ctx = __afr_inode_ctx_get(this, inode);
+        if (ctx && ctx->read_lease == AFR_READ_LEASE_NONE) {
+            ctx->read_lease = AFR_READ_LEASE_ACQUIRING;
+            ctx->read_lease_down_gen = down_gen;
+            acquire = _gf_true;
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    if (!acquire)
+        return;
+
+    loc.inode = inode_ref(inode);
+    gf_uuid_copy(loc.gfid, inode->gfid);
+    if (afr_read_lease_wind(this, &loc, GF_SET_LEASE,
+                            afr_read_lease_acquire_cbk, inode)) {
+        LOCK(&inode->lock);
+        {
+            ctx->read_lease = AFR_READ_LEASE_NONE;
+        }
+        UNLOCK(&inode->lock);
+    }
+    loc_wipe(&loc);
+}
+
+/* While the read lease is held no client can modify the file without the
+ * lease being recalled first, so a change of the event generation only
+ * means the connections to the bricks changed and the cached readable set
+ * is still valid. This no longer holds once a brick that may have granted
+ * the lease went down, the lease is given up then. */
+gf_boolean_t
+afr_read_lease_trusted(xlator_t *this, inode_t *inode)
+{
+    afr_private_t *priv = this->private;
+    afr_inode_ctx_t *ctx = NULL;
+    uint32_t down_gen = 0;
+    gf_boolean_t trusted = _gf_false;
+    gf_boolean_t release = _gf_false;
+
+    down_gen = GF_ATOMIC_GET(priv->down_generation);
+    LOCK(&inode->lock);
+    {
+        ctx = __afr_inode_ctx_get(this, inode);
+        if (!ctx || ctx->read_lease != AFR_READ_LEASE_HELD)
+            goto unlock;
+
+        if (priv->read_lease && ctx->read_lease_down_gen == down_gen) {
+            trusted = _gf_true;
+        } else {
+            ctx->read_lease = AFR_READ_LEASE_RELEASING;
+            release = _gf_true;
+        }
+    }
+unlock:
+    UNLOCK(&inode->lock);
+
+    if (release)
+        afr_read_lease_release(this, inode, inode->gfid, _gf_true);
+
+    return trusted;
+}
+
+/* The fops sent on a read-leased file carry the lease id, otherwise the
+ * bricks would recall the lease because of them. */
+void
+afr_read_lease_xdata_set(xlator_t *this, inode_t *inode, dict_t **xdata)
+{
+    afr_private_t *priv = this->private;
+    afr_inode_ctx_t *ctx = NULL;
+    dict_t *dict = NULL;
+    gf_boolean_t leased = _gf_false;
+
+    if (!inode || (*xdata && dict_get(*xdata, "lease-id")))
+        return;
+
+    LOCK(&inode->lock);
+    {
+        ctx = __afr_inode_ctx_get(this, inode);
+        leased = (ctx && ctx->read_lease != AFR_READ_LEASE_NONE);
+    }
+    UNLOCK(&inode->lock);
+
+    if (!leased)
+        return;
+
+    dict = *xdata ? dict_copy_with_ref(*xdata, NULL) : dict_new();
+    if (!dict)
+        return;
+
+    if (dict_set_static_bin(dict, "lease-id", priv->read_lease_id,
+                            LEASE_ID_SIZE)) {
+        dict_unref(dict);
+        return;
+    }
+
+    if (*xdata)
+        dict_unref(*xdata);
+    *xdata = dict;
+}
+
+static void
+afr_handle_lease_recall(xlator_t *this, struct gf_upcall *upcall)
+{
+    afr_private_t *priv = this->private;
+    afr_inode_ctx_t *ctx = NULL;
+    inode_table_t *itable = NULL;
+    inode_t *inode = NULL;
+    gf_boolean_t release = _gf_false;
+    gf_boolean_t tracked = _gf_true;
+
+    itable = ((xlator_t *)this->graph->top)->itable;
+    if (!itable)
+        return;
+
+    inode = inode_find(itable, upcall->gfid);
+    if (inode) {
+        LOCK(&inode->lock);
+        {
+            ctx = __afr_inode_ctx_get(this, inode);
+            if (ctx && (ctx->read_lease == AFR_READ_LEASE_HELD ||
+                        ctx->read_lease == AFR_READ_LEASE_ACQUIRING)) {
+                /* An acquiring lease is released by its callback */
+                release = (ctx->read_lease == AFR_READ_LEASE_HELD);
+                ctx->read_lease = AFR_READ_LEASE_RELEASING;
+                ctx->need_refresh = _gf_true;
+                GF_ATOMIC_INC(priv->read_leases_recalled);
+            }
+        }
+        UNLOCK(&inode->lock);
+    } else if (GF_ATOMIC_GET(priv->read_leases_granted)) {
+        /* The inode was forgotten while the bricks still hold the lease,
+         * release it so that the writer is not kept waiting until the
+         * recall times out. */
+        inode = inode_new(itable);
+        if (!inode)
+            return;
+        release = _gf_true;
+        tracked = _gf_false;
+    }
+
+    if (release)
+        afr_read_lease_release(this, inode, upcall->gfid, tracked);
+
+    if (inode)
+        inode_unref(inode);
+}
+
 static void
 afr_handle_inodelk_contention(xlator_t *this, struct gf_upcall *upcall)
 {
@@ -6185,6 +6536,9 @@ afr_handle_upcall_event(xlator_t *this, struct gf_upcall *upcall, const int idx)
         case GF_UPCALL_INODELK_CONTENTION:
             afr_handle_inodelk_contention(this, upcall);
             break;
+        case GF_UPCALL_RECALL_LEASE:
+            afr_handle_lease_recall(this, upcall);
+            break;
         case GF_UPCALL_CACHE_INVALIDATION:
             up_ci = (struct gf_upcall_cache_invalidation *)upcall->data;
 
@@ -6645,6 +6999,12 @@ afr_priv_destroy(afr_private_t *priv)
             GF_FREE(priv->pending_key[i]);
     }
 
+    if (priv->region_key) {
+        for (i = 0; i < priv->child_count; i++)
+            GF_FREE(priv->region_key[i]);
+    }
+    GF_FREE(priv->region_key);
+
     GF_FREE(priv->pending_reads);
     GF_FREE(priv->local);
     GF_FREE(priv->pending_key);
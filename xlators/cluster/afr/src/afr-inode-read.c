@@ -24,6 +24,8 @@
 #include <glusterfs/compat-errno.h>
 #include <glusterfs/compat.h>
 #include <glusterfs/quota-common-utils.h>
+#include <glusterfs/timer.h>
+#include <glusterfs/timespec.h>
 
 #include "afr-transaction.h"
 #include "afr-messages.h"
@@ -235,8 +237,8 @@ afr_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
 
     local->op = GF_FOP_STAT;
     loc_copy(&local->loc, loc);
-    if (xdata)
-        local->xdata_req = dict_ref(xdata);
+    /* Replicas answer in turn and are cached above, they need full iatts */
+    local->xdata_req = dict_ref_iatt_mask_full(xdata);
 
     afr_read_txn(frame, this, loc->inode, afr_stat_wind, AFR_DATA_TRANSACTION);
 
@@ -305,8 +307,7 @@ afr_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 
     local->op = GF_FOP_FSTAT;
     local->fd = fd_ref(fd);
-    if (xdata)
-        local->xdata_req = dict_ref(xdata);
+    local->xdata_req = dict_ref_iatt_mask_full(xdata);
 
     afr_fix_open(fd, this);
 
@@ -1725,6 +1726,321 @@ afr_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     return 0;
 }
 
+/* A readv sent to one brick, and to a second one if the first one is too
+ * slow to answer. Both reads use their own copy of the frame, so that the
+ * read can be answered while the other brick has not replied yet. */
+typedef struct {
+    gf_lock_t lock;
+    call_frame_t *frame; /* the readv, valid until answered */
+    call_frame_t *frames[2];
+    int subvols[2];
+    struct timespec start[2];
+    gf_timer_t *timer;
+    fd_t *fd;
+    dict_t *xdata;
+    size_t size;
+    off_t offset;
+    uint32_t flags;
+    int refs;
+    int winds;
+    int op_errno;
+    gf_boolean_t answered;
+} afr_read_hedge_t;
+
+static void
+afr_read_latency_account(afr_private_t *priv, struct timespec *start)
+{
+    struct timespec now;
+    struct timespec diff;
+    uint64_t usec = 0;
+    int bucket = 0;
+
+    timespec_now(&now);
+    timespec_sub(start, &now, &diff);
+    usec = diff.tv_sec * 1000000 + diff.tv_nsec / 1000;
+
+    while ((usec >>= 1) && (bucket < AFR_READ_LATENCY_BUCKETS - 1))
+        bucket++;
+    GF_ATOMIC_INC(priv->read_latency[bucket]);
+}
+
+/* Returns the time to wait before hedging a readv: the configured
+ * percentile of the recent latencies, rounded up to a power of two. */
+static gf_boolean_t
+afr_read_hedge_delay(afr_private_t *priv, struct timespec *delay)
+{
+    uint64_t count[AFR_READ_LATENCY_BUCKETS];
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t usec = 0;
+    int i = 0;
+
+    if (priv->read_hedge_pct <= 0)
+        return _gf_false;
+
+    for (i = 0; i < AFR_READ_LATENCY_BUCKETS; i++) {
+        count[i] = GF_ATOMIC_GET(priv->read_latency[i]);
+        total += count[i];
+    }
+
+    usec = priv->read_hedge_min_delay;
+    if (total >= 32) {
+        for (i = 0; i < AFR_READ_LATENCY_BUCKETS - 1; i++) {
+            sum += count[i];
+            if (sum * 100 >= total * priv->read_hedge_pct)
+                break;
+        }
+        if ((2ULL << i) > usec)
+            usec = 2ULL << i;
+    }
+
+    /* Forget old samples so that the delay follows the load. */
+    if (total >= 65536) {
+        for (i = 0; i < AFR_READ_LATENCY_BUCKETS; i++)
+            GF_ATOMIC_SUB(priv->read_latency[i], count[i] / 2);
+    }
+
+    delay->tv_sec = usec / 1000000;
+    delay->tv_nsec = (usec % 1000000) * 1000;
+
+    return _gf_true;
+}
+
+static int
+afr_read_hedge_subvol(afr_local_t *local, afr_private_t *priv)
+{
+    int i = 0;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (local->readable[i] && local->child_up[i] &&
+            !local->read_attempted[i])
+            return i;
+    }
+
+    return -1;
+}
+
+static void
+afr_read_hedge_unref(afr_read_hedge_t *hedge, int count)
+{
+    int refs = 0;
+
+    LOCK(&hedge->lock);
+    {
+        hedge->refs -= count;
+        refs = hedge->refs;
+    }
+    UNLOCK(&hedge->lock);
+
+    if (refs)
+        return;
+
+    LOCK_DESTROY(&hedge->lock);
+    fd_unref(hedge->fd);
+    if (hedge->xdata)
+        dict_unref(hedge->xdata);
+    GF_FREE(hedge);
+}
+
+/* Tries the next brick as a plain read once all the hedged ones failed. */
+static void
+afr_readv_hedge_fail(call_frame_t *frame, xlator_t *this, int op_errno,
+                     int subvol)
+{
+    afr_local_t *local = frame->local;
+
+    local->op_ret = -1;
+    local->op_errno = op_errno;
+    afr_read_txn_continue(frame, this, subvol);
+}
+
+static int
+afr_readv_hedge_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                    int32_t count, struct iatt *buf, struct iobref *iobref,
+                    dict_t *xdata)
+{
+    afr_private_t *priv = this->private;
+    afr_read_hedge_t *hedge = cookie;
+    call_frame_t *main_frame = NULL;
+    gf_boolean_t answer = _gf_false;
+    gf_boolean_t fail = _gf_false;
+    int idx = (frame == hedge->frames[1]);
+    int refs = 1;
+
+    if (op_ret >= 0)
+        afr_read_latency_account(priv, &hedge->start[idx]);
+    if (idx)
+        afr_pending_read_decrement(priv, hedge->subvols[1]);
+
+    LOCK(&hedge->lock);
+    {
+        hedge->winds--;
+        if (hedge->answered)
+            goto unlock;
+
+        if (op_ret < 0) {
+            hedge->op_errno = op_errno;
+            if (hedge->winds)
+                goto unlock;
+            fail = _gf_true;
+        } else {
+            answer = _gf_true;
+        }
+
+        if (hedge->timer) {
+            if (!gf_timer_call_cancel(this->ctx, hedge->timer)) {
+                refs++;
+            } else if (fail) {
+                /* The timer is running, it sends the read to another
+                 * brick or gives up. */
+                fail = _gf_false;
+                goto unlock;
+            }
+            hedge->timer = NULL;
+        }
+        hedge->answered = _gf_true;
+        main_frame = hedge->frame;
+        hedge->frame = NULL;
+    }
+unlock:
+    UNLOCK(&hedge->lock);
+
+    if (answer) {
+        if (idx)
+            GF_ATOMIC_INC(priv->read_hedges_won);
+        AFR_STACK_UNWIND(readv, main_frame, op_ret, op_errno, vector, count,
+                         buf, iobref, xdata);
+    } else if (fail) {
+        afr_readv_hedge_fail(main_frame, this, op_errno,
+                             hedge->subvols[idx]);
+    }
+
+    afr_read_hedge_unref(hedge, refs);
+    STACK_DESTROY(frame->root);
+
+    return 0;
+}
+
+static void
+afr_readv_hedge_timeout(void *data)
+{
+    afr_read_hedge_t *hedge = data;
+    xlator_t *this = NULL;
+    afr_private_t *priv = NULL;
+    afr_local_t *local = NULL;
+    call_frame_t *main_frame = NULL;
+    call_frame_t *hframe = NULL;
+    gf_boolean_t fail = _gf_false;
+    int subvol = -1;
+    int op_errno = 0;
+
+    LOCK(&hedge->lock);
+    {
+        hedge->timer = NULL;
+        if (hedge->answered)
+            goto unlock;
+
+        this = hedge->frame->this;
+        priv = this->private;
+        local = hedge->frame->local;
+        subvol = afr_read_hedge_subvol(local, priv);
+        if (subvol >= 0)
+            hframe = copy_frame(hedge->frame);
+
+        if (hframe) {
+            local->read_attempted[subvol] = 1;
+            hedge->frames[1] = hframe;
+            hedge->subvols[1] = subvol;
+            hedge->winds++;
+            hedge->refs++;
+        } else if (!hedge->winds) {
+            /* The first brick failed, and there is nothing to hedge
+             * with. */
+            hedge->answered = _gf_true;
+            main_frame = hedge->frame;
+            hedge->frame = NULL;
+            op_errno = hedge->op_errno;
+            fail = _gf_true;
+        }
+    }
+unlock:
+    UNLOCK(&hedge->lock);
+
+    if (hframe) {
+        GF_ATOMIC_INC(priv->read_hedges_sent);
+        afr_pending_read_increment(priv, subvol);
+        timespec_now(&hedge->start[1]);
+        STACK_WIND_COOKIE(hframe, afr_readv_hedge_cbk, hedge,
+                          priv->children[subvol],
+                          priv->children[subvol]->fops->readv, hedge->fd,
+                          hedge->size, hedge->offset, hedge->flags,
+                          hedge->xdata);
+    } else if (fail) {
+        afr_readv_hedge_fail(main_frame, this, op_errno, hedge->subvols[0]);
+    }
+
+    afr_read_hedge_unref(hedge, 1);
+}
+
+/* Returns -1 if the readv must be sent the usual way. */
+static int
+afr_readv_hedge(call_frame_t *frame, xlator_t *this, int subvol)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = frame->local;
+    afr_read_hedge_t *hedge = NULL;
+    call_frame_t *rframe = NULL;
+    struct timespec delay;
+
+    if (!afr_read_hedge_delay(priv, &delay))
+        return -1;
+
+    if (afr_read_hedge_subvol(local, priv) < 0)
+        return -1;
+
+    hedge = GF_CALLOC(1, sizeof(*hedge), gf_afr_mt_read_hedge_t);
+    if (!hedge)
+        return -1;
+
+    rframe = copy_frame(frame);
+    if (!rframe) {
+        GF_FREE(hedge);
+        return -1;
+    }
+
+    LOCK_INIT(&hedge->lock);
+    hedge->frame = frame;
+    hedge->frames[0] = rframe;
+    hedge->subvols[0] = subvol;
+    hedge->subvols[1] = -1;
+    hedge->fd = fd_ref(local->fd);
+    if (local->xdata_req)
+        hedge->xdata = dict_ref(local->xdata_req);
+    hedge->size = local->cont.readv.size;
+    hedge->offset = local->cont.readv.offset;
+    hedge->flags = local->cont.readv.flags;
+    hedge->winds = 1;
+    hedge->refs = 2;
+
+    LOCK(&hedge->lock);
+    {
+        hedge->timer = gf_timer_call_after(this->ctx, delay,
+                                           afr_readv_hedge_timeout, hedge);
+        if (!hedge->timer)
+            hedge->refs--;
+    }
+    UNLOCK(&hedge->lock);
+
+    timespec_now(&hedge->start[0]);
+    STACK_WIND_COOKIE(rframe, afr_readv_hedge_cbk, hedge,
+                      priv->children[subvol], priv->children[subvol]->fops->readv,
+                      hedge->fd, hedge->size, hedge->offset, hedge->flags,
+                      hedge->xdata);
+
+    return 0;
+}
+
 static int
 afr_readv_wind(call_frame_t *frame, xlator_t *this, int subvol)
 {
@@ -1740,6 +2056,9 @@ afr_readv_wind(call_frame_t *frame, xlator_t *this, int subvol)
         return 0;
     }
 
+    if (afr_readv_hedge(frame, this, subvol) == 0)
+        return 0;
+
     STACK_WIND_COOKIE(
         frame, afr_readv_cbk, (void *)(long)subvol, priv->children[subvol],
         priv->children[subvol]->fops->readv, local->fd, local->cont.readv.size,
@@ -1766,6 +2085,7 @@ afr_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     local->cont.readv.flags = flags;
     if (xdata)
         local->xdata_req = dict_ref(xdata);
+    afr_read_lease_xdata_set(this, fd->inode, &local->xdata_req);
 
     afr_fix_open(fd, this);
 
@@ -104,6 +104,9 @@ __afr_inode_write_finalize(call_frame_t *frame, xlator_t *this)
 
             local->cont.inode_wfop.prebuf = local->replies[i].prestat;
             local->cont.inode_wfop.postbuf = local->replies[i].poststat;
+            if (local->op == GF_FOP_COPY_FILE_RANGE)
+                local->cont.copy_file_range.stbuf =
+                    local->cont.copy_file_range.stbufs[i];
 
             if (local->replies[i].xdata) {
                 if (local->xdata_rsp)
@@ -2259,6 +2262,197 @@ out:
 
 /* }}} */
 
+/* {{{ copy_file_range */
+
+/* Every brick copies from its own copy of the source file, so the source
+ * must be readable on all the bricks that take part in the transaction.
+ * Otherwise EXDEV makes the caller fall back to read and write. */
+static gf_boolean_t
+afr_copy_file_range_source_is_good(xlator_t *this, afr_local_t *local,
+                                   inode_t *inode)
+{
+    afr_private_t *priv = this->private;
+    unsigned char *data = alloca0(priv->child_count);
+    int event = 0;
+    int i = 0;
+
+    if (afr_inode_read_subvol_get(inode, this, data, NULL, &event) < 0)
+        return _gf_false;
+
+    if (event != local->event_generation)
+        return _gf_false;
+
+    /* The arbiter holds no data, so it is never readable */
+    for (i = 0; i < priv->child_count; i++) {
+        if (AFR_IS_ARBITER_BRICK(priv, i))
+            continue;
+        if (local->child_up[i] && !data[i])
+            return _gf_false;
+    }
+
+    return _gf_true;
+}
+
+static int
+afr_copy_file_range_unwind(call_frame_t *frame, xlator_t *this)
+{
+    afr_local_t *local = NULL;
+    call_frame_t *main_frame = NULL;
+
+    local = frame->local;
+
+    main_frame = afr_transaction_detach_fop_frame(frame);
+    if (!main_frame)
+        return 0;
+
+    AFR_STACK_UNWIND(copy_file_range, main_frame, local->op_ret,
+                     local->op_errno, &local->cont.copy_file_range.stbuf,
+                     &local->cont.inode_wfop.prebuf,
+                     &local->cont.inode_wfop.postbuf, local->xdata_rsp);
+    return 0;
+}
+
+static int
+afr_copy_file_range_wind_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                             int32_t op_ret, int32_t op_errno,
+                             struct iatt *stbuf, struct iatt *prebuf,
+                             struct iatt *postbuf, dict_t *xdata)
+{
+    afr_local_t *local = frame->local;
+    afr_private_t *priv = this->private;
+    int child_index = (long)cookie;
+    int call_count = -1;
+
+    LOCK(&frame->lock);
+    {
+        __afr_inode_write_fill(local, priv, child_index, op_ret, op_errno,
+                               prebuf, postbuf, NULL, xdata);
+        if (op_ret >= 0 && stbuf)
+            local->cont.copy_file_range.stbufs[child_index] = *stbuf;
+        call_count = --local->call_count;
+    }
+    UNLOCK(&frame->lock);
+
+    if (call_count == 0) {
+        __afr_inode_write_finalize(frame, this);
+
+        /* Bricks that copied less than the best one are out of sync, just
+         * like short writes */
+        afr_writev_handle_short_writes(frame, this);
+
+        if (afr_txn_nothing_failed(frame, this)) {
+            if (priv->consistent_metadata && afr_needs_changelog_update(local))
+                afr_zero_fill_stat(local);
+            local->transaction.unwind(frame, this);
+        }
+
+        afr_transaction_resume(frame, this);
+    }
+
+    return 0;
+}
+
+static int
+afr_copy_file_range_wind(call_frame_t *frame, xlator_t *this, int subvol)
+{
+    afr_local_t *local = NULL;
+    afr_private_t *priv = NULL;
+
+    local = frame->local;
+    priv = this->private;
+
+    STACK_WIND_COOKIE(frame, afr_copy_file_range_wind_cbk,
+                      (void *)(long)subvol, priv->children[subvol],
+                      priv->children[subvol]->fops->copy_file_range,
+                      local->cont.copy_file_range.fd_in,
+                      local->cont.copy_file_range.off_in, local->fd,
+                      local->cont.copy_file_range.off_out,
+                      local->cont.copy_file_range.len,
+                      local->cont.copy_file_range.flags, local->xdata_req);
+    return 0;
+}
+
+int
+afr_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+    afr_private_t *priv = this->private;
+    call_frame_t *transaction_frame = NULL;
+    afr_local_t *local = NULL;
+    int ret = -1;
+    int op_errno = ENOMEM;
+
+    AFR_ERROR_OUT_IF_FDCTX_INVALID(fd_in, this, op_errno, out);
+    AFR_ERROR_OUT_IF_FDCTX_INVALID(fd_out, this, op_errno, out);
+    transaction_frame = copy_frame(frame);
+    if (!transaction_frame)
+        goto out;
+
+    local = AFR_FRAME_INIT(transaction_frame, op_errno);
+    if (!local)
+        goto out;
+
+    if (!afr_copy_file_range_source_is_good(this, local, fd_in->inode)) {
+        op_errno = EXDEV;
+        goto out;
+    }
+
+    local->cont.copy_file_range.stbufs = GF_CALLOC(
+        priv->child_count, sizeof(struct iatt), gf_afr_mt_iatt_t);
+    if (!local->cont.copy_file_range.stbufs)
+        goto out;
+
+    local->cont.copy_file_range.fd_in = fd_ref(fd_in);
+    local->cont.copy_file_range.off_in = off_in;
+    local->cont.copy_file_range.off_out = off_out;
+    local->cont.copy_file_range.len = len;
+    local->cont.copy_file_range.flags = flags;
+
+    local->fd = fd_ref(fd_out);
+    ret = afr_set_inode_local(this, local, fd_out->inode);
+    if (ret)
+        goto out;
+
+    if (xdata)
+        local->xdata_req = dict_copy_with_ref(xdata, NULL);
+    else
+        local->xdata_req = dict_new();
+
+    if (!local->xdata_req)
+        goto out;
+
+    local->op = GF_FOP_COPY_FILE_RANGE;
+
+    local->transaction.wind = afr_copy_file_range_wind;
+    local->transaction.unwind = afr_copy_file_range_unwind;
+
+    local->transaction.main_frame = frame;
+
+    local->transaction.start = local->cont.copy_file_range.off_out;
+    local->transaction.len = 0;
+
+    afr_fix_open(fd_in, this);
+    afr_fix_open(fd_out, this);
+
+    ret = afr_transaction(transaction_frame, this, AFR_DATA_TRANSACTION);
+    if (ret < 0) {
+        op_errno = -ret;
+        goto out;
+    }
+
+    return 0;
+out:
+    if (transaction_frame)
+        AFR_STACK_DESTROY(transaction_frame);
+
+    AFR_STACK_UNWIND(copy_file_range, frame, -1, op_errno, NULL, NULL, NULL,
+                     NULL);
+    return 0;
+}
+
+/* }}} */
+
 static int32_t
 afr_xattrop_wind_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                      int32_t op_ret, int32_t op_errno, dict_t *xattr,
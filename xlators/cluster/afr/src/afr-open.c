@@ -88,6 +88,8 @@ afr_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
             STACK_WIND(frame, afr_open_ftruncate_cbk, this,
                        this->fops->ftruncate, fd, 0, NULL);
         } else {
+            if ((fd_ctx->flags & O_ACCMODE) == O_RDONLY)
+                afr_read_lease_acquire(this, local->inode);
             AFR_STACK_UNWIND(open, frame, local->op_ret, local->op_errno,
                              local->cont.open.fd, local->xdata_rsp);
         }
@@ -169,6 +171,7 @@ afr_open(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
     fd_ctx->flags = flags;
     if (xdata)
         local->xdata_req = dict_ref(xdata);
+    afr_read_lease_xdata_set(this, local->inode, &local->xdata_req);
 
     local->cont.open.flags = flags;
     local->cont.open.fd = fd_ref(fd);
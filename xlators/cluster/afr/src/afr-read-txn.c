@@ -445,6 +445,16 @@ afr_read_txn(call_frame_t *frame, xlator_t *this, inode_t *inode,
         goto refresh;
     AFR_INTERSECT(local->readable, data, metadata, priv->child_count);
 
+    if ((local->event_generation != event_generation) &&
+        afr_read_lease_trusted(this, inode)) {
+        /* The file could not have been modified since the readable set
+         * was cached, only pick a readable brick that is still up. */
+        GF_ATOMIC_INC(priv->read_lease_refreshes_skipped);
+        event_generation = local->event_generation;
+        AFR_INTERSECT(local->readable, local->readable, local->child_up,
+                      priv->child_count);
+    }
+
     gf_msg_debug(this->name, 0,
                  "%s: generation now vs cached: %d, "
                  "%d",
@@ -726,6 +726,8 @@ afr_reply_copy(struct afr_reply *dst, struct afr_reply *src)
         memcpy(dst->checksum, src->checksum, MD5_DIGEST_LENGTH);
     }
     dst->fips_mode_rchecksum = src->fips_mode_rchecksum;
+    dst->xxhash_rchecksum = src->xxhash_rchecksum;
+    dst->buf_is_hole = src->buf_is_hole;
 }
 
 void
@@ -13,6 +13,8 @@
 #include "protocol-common.h"
 #include "afr-messages.h"
 #include <glusterfs/events.h>
+#include <glusterfs/checksum.h>
+#include <glusterfs/timespec.h>
 #include <openssl/md5.h>
 
 #define HAS_HOLES(i) ((i->ia_blocks * 512) < (i->ia_size))
@@ -35,9 +37,15 @@ __checksum_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
             xdata, "buf-has-zeroes", _gf_false);
         replies[i].fips_mode_rchecksum = dict_get_str_boolean(
             xdata, "fips-mode-rchecksum", _gf_false);
+        replies[i].xxhash_rchecksum = dict_get_str_boolean(
+            xdata, "rchecksum-xxhash", _gf_false);
+        replies[i].buf_is_hole = dict_get_str_boolean(xdata, "buf-is-hole",
+                                                      _gf_false);
     }
     if (strong) {
-        if (replies[i].fips_mode_rchecksum) {
+        if (replies[i].xxhash_rchecksum) {
+            memcpy(local->replies[i].checksum, strong, XXHASH_DIGEST_LENGTH);
+        } else if (replies[i].fips_mode_rchecksum) {
             memcpy(local->replies[i].checksum, strong, SHA256_DIGEST_LENGTH);
         } else {
             memcpy(local->replies[i].checksum, strong, MD5_DIGEST_LENGTH);
@@ -48,6 +56,31 @@ __checksum_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     return 0;
 }
 
+static gf_boolean_t
+__afr_rchecksum_match(struct afr_reply *source, struct afr_reply *sink)
+{
+    size_t len = MD5_DIGEST_LENGTH;
+
+    /* A hole matches a hole, and a block that reads back as zeroes. */
+    if (source->buf_is_hole || sink->buf_is_hole) {
+        if (source->buf_is_hole && sink->buf_is_hole)
+            return _gf_true;
+        return (source->buf_has_zeroes && sink->buf_has_zeroes);
+    }
+
+    /* Checksums computed with different hashes can't be compared. */
+    if (source->xxhash_rchecksum != sink->xxhash_rchecksum ||
+        source->fips_mode_rchecksum != sink->fips_mode_rchecksum)
+        return _gf_false;
+
+    if (source->xxhash_rchecksum)
+        len = XXHASH_DIGEST_LENGTH;
+    else if (source->fips_mode_rchecksum)
+        len = SHA256_DIGEST_LENGTH;
+
+    return (memcmp(source->checksum, sink->checksum, len) == 0);
+}
+
 static gf_boolean_t
 __afr_can_skip_data_block_heal(call_frame_t *frame, xlator_t *this, fd_t *fd,
                                int source, unsigned char *healed_sinks,
@@ -57,6 +90,7 @@ __afr_can_skip_data_block_heal(call_frame_t *frame, xlator_t *this, fd_t *fd,
     afr_local_t *local = NULL;
     unsigned char *wind_subvols = NULL;
     gf_boolean_t checksum_match = _gf_true;
+    gf_boolean_t all_holes = _gf_true;
     struct afr_reply *replies = NULL;
     dict_t *xdata = NULL;
     int i = 0;
@@ -68,7 +102,13 @@ __afr_can_skip_data_block_heal(call_frame_t *frame, xlator_t *this, fd_t *fd,
     xdata = dict_new();
     if (!xdata)
         goto out;
-    if (dict_set_int32_sizen(xdata, "check-zero-filled", 1)) {
+    if (dict_set_int32_sizen(xdata, "check-zero-filled", 1) ||
+        dict_set_int32_sizen(xdata, "check-extents", 1)) {
+        dict_unref(xdata);
+        goto out;
+    }
+    if (priv->data_self_heal_xxhash &&
+        dict_set_int32_sizen(xdata, "rchecksum-xxhash", 1)) {
         dict_unref(xdata);
         goto out;
     }
@@ -87,21 +127,25 @@ __afr_can_skip_data_block_heal(call_frame_t *frame, xlator_t *this, fd_t *fd,
     if (!replies[source].valid || replies[source].op_ret != 0)
         return _gf_false;
 
+    all_holes = replies[source].buf_is_hole;
     for (i = 0; i < priv->child_count; i++) {
         if (i == source)
             continue;
         if (replies[i].valid) {
-            if (memcmp(replies[source].checksum, replies[i].checksum,
-                       replies[source].fips_mode_rchecksum
-                           ? SHA256_DIGEST_LENGTH
-                           : MD5_DIGEST_LENGTH)) {
+            if (!__afr_rchecksum_match(&replies[source], &replies[i])) {
                 checksum_match = _gf_false;
                 break;
             }
+            if (!replies[i].buf_is_hole)
+                all_holes = _gf_false;
         }
     }
 
     if (checksum_match) {
+        /* Identical holes on source and sinks, nothing to read or write. */
+        if (all_holes)
+            return _gf_true;
+
         if (HAS_HOLES(poststat))
             return _gf_true;
 
@@ -331,16 +375,142 @@ afr_data_self_heal_type_get(afr_private_t *priv, unsigned char *healed_sinks,
     return type;
 }
 
+typedef struct {
+    call_frame_t *frame;
+    xlator_t *this;
+    fd_t *fd;
+    unsigned char *healed_sinks;
+    struct afr_reply *replies;
+    struct syncbarrier *barrier;
+    off_t offset;
+    size_t size;
+    int source;
+    int type;
+    int ret;
+} afr_data_block_t;
+
+static int
+afr_selfheal_data_block_task(void *opaque)
+{
+    afr_data_block_t *block = opaque;
+
+    block->ret = afr_selfheal_data_block(block->frame, block->this, block->fd,
+                                         block->source, block->healed_sinks,
+                                         block->offset, block->size,
+                                         block->type, block->replies);
+
+    return block->ret;
+}
+
+static int
+afr_selfheal_data_block_done(int ret, call_frame_t *frame, void *opaque)
+{
+    afr_data_block_t *block = opaque;
+
+    syncbarrier_wake(block->barrier);
+
+    return 0;
+}
+
+/* Returns the first offset at or after @offset where the source or any of
+ * the sinks has data, @size if there is none, or a negative error if the
+ * bricks can't tell. Ranges that are holes everywhere don't need a heal. */
+static off_t
+afr_selfheal_data_seek(xlator_t *this, fd_t *fd, int source,
+                       unsigned char *healed_sinks, off_t offset, off_t size)
+{
+    afr_private_t *priv = this->private;
+    off_t next = size;
+    off_t data = 0;
+    int ret = 0;
+    int i = 0;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (i != source && !healed_sinks[i])
+            continue;
+
+        ret = syncop_seek(priv->children[i], fd, offset, GF_SEEK_DATA, NULL,
+                          &data);
+        if (ret == -ENXIO)
+            continue;
+        if (ret < 0)
+            return ret;
+
+        if (data < next)
+            next = data;
+        if (next <= offset)
+            break;
+    }
+
+    return next;
+}
+
+/* Adapts the number of blocks in flight to the time the last full wave
+ * took. The fastest wave seen gives the time needed when nothing waits in
+ * the queues of the bricks. The depth grows while less than one block's
+ * worth of that time is spent queued and shrinks when more than two are. */
+static uint32_t
+afr_selfheal_data_adapt_depth(uint32_t depth, uint32_t max, int64_t elapsed,
+                              int64_t *base)
+{
+    int64_t queued = 0;
+
+    if (elapsed <= 0)
+        return depth;
+
+    if ((*base == 0) || (elapsed < *base))
+        *base = elapsed;
+
+    queued = (int64_t)depth * (elapsed - *base);
+    if ((queued < elapsed) && (depth < max))
+        depth++;
+    else if ((queued > 2 * elapsed) && (depth > 1))
+        depth--;
+
+    return min(depth, max);
+}
+
+/* Returns the first offset not below @offset written while the sinks were
+ * down, or UINT64_MAX. */
+static uint64_t
+afr_selfheal_data_next_region(uint8_t *regions, uint64_t offset)
+{
+    uint64_t next = UINT64_MAX;
+    uint32_t shift = 0;
+
+    for (shift = AFR_REGION_MIN_SHIFT; shift <= AFR_REGION_MAX_SHIFT;
+         shift++) {
+        next = min(next, gf_region_next(regions, shift, offset));
+        regions += AFR_REGION_MAP_SIZE;
+    }
+
+    return next;
+}
+
 static int
 afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
-                     unsigned char *healed_sinks, struct afr_reply *replies)
+                     unsigned char *healed_sinks, struct afr_reply *replies,
+                     uint8_t *regions)
 {
     afr_private_t *priv = NULL;
+    afr_data_block_t *blocks = NULL;
+    unsigned char *block_sinks = NULL;
+    struct syncbarrier barrier;
+    struct timespec start, end;
     off_t off = 0;
+    off_t next = 0;
+    off_t size = 0;
     size_t block = 0;
+    uint32_t max_depth = 0;
+    uint32_t depth = 1;
+    uint32_t count = 0;
+    uint32_t i = 0;
+    int64_t base = 0;
     int type = AFR_SELFHEAL_DATA_FULL;
     int ret = -1;
-    call_frame_t *iter_frame = NULL;
+    int j = 0;
+    gf_boolean_t seek = _gf_true;
+    gf_boolean_t barrier_inited = _gf_false;
     unsigned char arbiter_sink_status = 0;
 
     gf_msg(this->name, GF_LOG_INFO, 0, AFR_MSG_SELF_HEAL_INFO,
@@ -353,37 +523,114 @@ afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
     }
 
     block = 128 * 1024 * priv->data_self_heal_window_size;
-    if (HAS_HOLES((&replies[source].poststat))) {
-        /*Reduce the possibility of data-block allocations in case of files
-         * with holes. Correct way to fix it would be to use seek fop while
-         * healing data*/
-        block = 128 * 1024;
-    }
+    size = replies[source].poststat.ia_size;
+    max_depth = priv->data_self_heal_pipeline_depth;
 
     type = afr_data_self_heal_type_get(priv, healed_sinks, source, replies);
 
-    iter_frame = afr_copy_frame(frame);
-    if (!iter_frame) {
+    blocks = alloca0(sizeof(*blocks) * max_depth);
+    block_sinks = alloca0(priv->child_count * max_depth);
+
+    ret = syncbarrier_init(&barrier);
+    if (ret) {
         ret = -ENOMEM;
         goto out;
     }
-
-    for (off = 0; off < replies[source].poststat.ia_size; off += block) {
+    barrier_inited = _gf_true;
+
+    /* Blocks are healed in waves of up to @depth blocks. Each block takes its
+     * own lock and runs in its own synctask, so that the checksums, reads
+     * and writes of different blocks overlap. All the locks of a wave are
+     * released before the next one starts. */
+    off = 0;
+    while (off < size) {
         if (AFR_COUNT(healed_sinks, priv->child_count) == 0) {
             ret = -ENOTCONN;
             goto out;
         }
 
-        ret = afr_selfheal_data_block(iter_frame, this, fd, source,
-                                      healed_sinks, off, block, type, replies);
+        if (seek) {
+            next = afr_selfheal_data_seek(this, fd, source, healed_sinks, off,
+                                          size);
+            if (next < 0) {
+                gf_msg_debug(this->name, -next,
+                             "%s: seek failed, healing holes too",
+                             uuid_utoa(fd->inode->gfid));
+                seek = _gf_false;
+                if (HAS_HOLES((&replies[source].poststat))) {
+                    /*Reduce the possibility of data-block allocations in
+                     * case of files with holes.*/
+                    block = 128 * 1024;
+                }
+            } else if (next >= size) {
+                break;
+            } else if (next > off) {
+                off = next - (next % block);
+            }
+        }
+
+        ret = 0;
+        count = 0;
+        for (i = 0; (i < depth) && (off < size); i++) {
+            if (regions) {
+                /* Only the regions written while the sinks were down. */
+                next = min(afr_selfheal_data_next_region(regions, off), size);
+                if (next >= size) {
+                    off = size;
+                    break;
+                }
+                off = max(off, next - (next % block));
+            }
+            blocks[i].frame = afr_copy_frame(frame);
+            if (!blocks[i].frame) {
+                ret = -ENOMEM;
+                break;
+            }
+            blocks[i].this = this;
+            blocks[i].fd = fd;
+            blocks[i].healed_sinks = &block_sinks[i * priv->child_count];
+            memcpy(blocks[i].healed_sinks, healed_sinks, priv->child_count);
+            blocks[i].replies = replies;
+            blocks[i].barrier = &barrier;
+            blocks[i].offset = off;
+            blocks[i].size = block;
+            blocks[i].source = source;
+            blocks[i].type = type;
+            blocks[i].ret = 0;
+            count++;
+            off += block;
+        }
+
+        timespec_now(&start);
+
+        for (i = 0; i < count; i++) {
+            if ((count == 1) ||
+                synctask_new(this->ctx->env, afr_selfheal_data_block_task,
+                             afr_selfheal_data_block_done, blocks[i].frame,
+                             &blocks[i]) != 0) {
+                afr_selfheal_data_block_task(&blocks[i]);
+                syncbarrier_wake(&barrier);
+            }
+        }
+        syncbarrier_wait(&barrier, count);
+
+        timespec_now(&end);
+
+        for (i = 0; i < count; i++) {
+            AFR_STACK_DESTROY(blocks[i].frame);
+            if ((blocks[i].ret < 0) && (ret >= 0))
+                ret = blocks[i].ret;
+            /* A sink that failed any block of the wave is not healed. */
+            for (j = 0; j < priv->child_count; j++)
+                if (!blocks[i].healed_sinks[j])
+                    healed_sinks[j] = 0;
+        }
         if (ret < 0)
             goto out;
 
-        AFR_STACK_RESET(iter_frame);
-        if (iter_frame->local == NULL) {
-            ret = -ENOTCONN;
-            goto out;
-        }
+        if (count == depth)
+            depth = afr_selfheal_data_adapt_depth(
+                depth, max_depth, gf_tsdiff(&start, &end), &base);
     }
 
     ret = afr_selfheal_data_fsync(frame, this, fd, healed_sinks);
@@ -392,8 +639,8 @@ out:
     if (arbiter_sink_status)
         healed_sinks[ARBITER_BRICK_INDEX] = arbiter_sink_status;
 
-    if (iter_frame)
-        AFR_STACK_DESTROY(iter_frame);
+    if (barrier_inited)
+        syncbarrier_destroy(&barrier);
     return ret;
 }
 
@@ -658,6 +905,211 @@ __afr_selfheal_data_prepare(call_frame_t *frame, xlator_t *this, inode_t *inode,
     return source;
 }
 
+static int
+afr_selfheal_regions_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                         int op_ret, int op_errno, dict_t *xattr, dict_t *xdata)
+{
+    afr_local_t *local = frame->local;
+    int i = (long)cookie;
+
+    local->replies[i].valid = 1;
+    local->replies[i].op_ret = op_ret;
+    local->replies[i].op_errno = op_errno;
+    if (xattr)
+        local->replies[i].xattr = dict_ref(xattr);
+
+    syncbarrier_wake(&local->barrier);
+
+    return 0;
+}
+
+static int
+afr_selfheal_regions_removed_cbk(call_frame_t *frame, void *cookie,
+                                 xlator_t *this, int op_ret, int op_errno,
+                                 dict_t *xdata)
+{
+    afr_local_t *local = frame->local;
+    int i = (long)cookie;
+
+    local->replies[i].valid = 1;
+    local->replies[i].op_ret = op_ret;
+    local->replies[i].op_errno = op_errno;
+
+    syncbarrier_wake(&local->barrier);
+
+    return 0;
+}
+
+static int32_t
+afr_selfheal_region_count(afr_private_t *priv, dict_t *xattr, int child)
+{
+    void *count = NULL;
+
+    if (!xattr || dict_get_ptr(xattr, priv->region_key[child], &count) ||
+        !count)
+        return 0;
+
+    return be32toh(*(int32_t *)count);
+}
+
+/*
+ * __afr_selfheal_data_regions:
+ *
+ * Reads the regions recorded on the bricks while the sinks were down.
+ * Returns true if they cover every post-op that blames the sinks, leaving
+ * in @regions the union of the maps of the sources, one map per shift.
+ * @present gets a bit for each map shift found on any brick, and bit
+ * AFR_REGION_SHIFTS if any brick counts recorded post-ops.
+ */
+static gf_boolean_t
+__afr_selfheal_data_regions(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                            unsigned char *locked_on, unsigned char *sources,
+                            unsigned char *healed_sinks,
+                            struct afr_reply *replies, uint8_t *regions,
+                            uint32_t *present)
+{
+    static uint8_t zero[AFR_REGION_MAP_SIZE];
+    afr_private_t *priv = this->private;
+    afr_local_t *local = frame->local;
+    dict_t *xattr = NULL;
+    int *dirty = NULL;
+    int **matrix = NULL;
+    void *map = NULL;
+    int32_t count = 0;
+    int blamed = 0;
+    uint32_t shift = 0;
+    int i = 0;
+    int j = 0;
+    int k = 0;
+    char key[64];
+    gf_boolean_t covered = _gf_true;
+
+    xattr = dict_new();
+    if (!xattr)
+        return _gf_false;
+
+    for (shift = AFR_REGION_MIN_SHIFT; shift <= AFR_REGION_MAX_SHIFT;
+         shift++) {
+        snprintf(key, sizeof(key), "%s.%u", AFR_REGION_MAP_XATTR, shift);
+        if (dict_set_static_bin(xattr, key, zero, sizeof(zero)))
+            goto out;
+    }
+    for (i = 0; i < priv->child_count; i++) {
+        if (dict_set_static_bin(xattr, priv->region_key[i], zero,
+                                sizeof(int32_t)))
+            goto out;
+    }
+
+    AFR_ONLIST(locked_on, frame, afr_selfheal_regions_cbk, fxattrop, fd,
+               GF_XATTROP_ADD_ARRAY, xattr, NULL);
+
+    dirty = alloca0(priv->child_count * sizeof(int));
+    matrix = ALLOC_MATRIX(priv->child_count, int);
+    afr_selfheal_extract_xattr(this, replies, AFR_DATA_TRANSACTION, dirty,
+                               matrix);
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (!locked_on[i])
+            continue;
+
+        if (!local->replies[i].valid || (local->replies[i].op_ret < 0)) {
+            if (sources[i] || healed_sinks[i])
+                covered = _gf_false;
+            continue;
+        }
+
+        /* A pending pre-op may have written anywhere. */
+        if (dirty[i])
+            covered = _gf_false;
+
+        for (j = 0; j < priv->child_count; j++) {
+            if (afr_selfheal_region_count(priv, local->replies[i].xattr, j))
+                *present |= (1 << AFR_REGION_SHIFTS);
+        }
+
+        for (shift = AFR_REGION_MIN_SHIFT; shift <= AFR_REGION_MAX_SHIFT;
+             shift++) {
+            snprintf(key, sizeof(key), "%s.%u", AFR_REGION_MAP_XATTR, shift);
+            if (dict_get_ptr(local->replies[i].xattr, key, &map) || !map ||
+                !memcmp(map, zero, sizeof(zero)))
+                continue;
+
+            *present |= (1 << (shift - AFR_REGION_MIN_SHIFT));
+            if (!sources[i])
+                continue;
+            for (k = 0; k < AFR_REGION_MAP_SIZE; k++)
+                regions[(shift - AFR_REGION_MIN_SHIFT) * AFR_REGION_MAP_SIZE +
+                        k] |= ((uint8_t *)map)[k];
+        }
+    }
+
+    /* Every post-op of a source blaming a sink must have recorded its
+     * regions. Sinks not blamed by anyone need a full heal. */
+    for (j = 0; j < priv->child_count; j++) {
+        if (!healed_sinks[j])
+            continue;
+
+        blamed = 0;
+        for (i = 0; i < priv->child_count; i++) {
+            if (!sources[i] || !locked_on[i] || !local->replies[i].valid ||
+                (local->replies[i].op_ret < 0))
+                continue;
+
+            count = afr_selfheal_region_count(priv, local->replies[i].xattr,
+                                              j);
+            if (count != matrix[i][j])
+                covered = _gf_false;
+            blamed += matrix[i][j];
+        }
+        if (blamed <= 0)
+            covered = _gf_false;
+    }
+
+out:
+    dict_unref(xattr);
+    if (i < priv->child_count)
+        return _gf_false;
+
+    return covered;
+}
+
+/* Forgets the regions recorded on the bricks once they are in sync. The
+ * counts go first, so that no map is trusted if this fails halfway. */
+static void
+__afr_selfheal_data_clear_regions(call_frame_t *frame, xlator_t *this,
+                                  fd_t *fd, unsigned char *locked_on,
+                                  uint32_t present)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = frame->local;
+    uint32_t shift = 0;
+    int i = 0;
+    int j = 0;
+    char key[64];
+
+    if (present & (1 << AFR_REGION_SHIFTS)) {
+        for (j = 0; j < priv->child_count; j++) {
+            AFR_ONLIST(locked_on, frame, afr_selfheal_regions_removed_cbk,
+                       fremovexattr, fd, priv->region_key[j], NULL);
+            for (i = 0; i < priv->child_count; i++) {
+                if (locked_on[i] && (local->replies[i].op_ret < 0) &&
+                    (local->replies[i].op_errno != ENODATA))
+                    return;
+            }
+        }
+    }
+
+    for (shift = AFR_REGION_MIN_SHIFT; shift <= AFR_REGION_MAX_SHIFT;
+         shift++) {
+        if (!(present & (1 << (shift - AFR_REGION_MIN_SHIFT))))
+            continue;
+
+        snprintf(key, sizeof(key), "%s.%u", AFR_REGION_MAP_XATTR, shift);
+        AFR_ONLIST(locked_on, frame, afr_selfheal_regions_removed_cbk,
+                   fremovexattr, fd, key, NULL);
+    }
+}
+
 static int
 __afr_selfheal_data(call_frame_t *frame, xlator_t *this, fd_t *fd,
                     unsigned char *locked_on)
@@ -670,10 +1122,13 @@ __afr_selfheal_data(call_frame_t *frame, xlator_t *this, fd_t *fd,
     unsigned char *healed_sinks = NULL;
     unsigned char *undid_pending = NULL;
     struct afr_reply *locked_replies = NULL;
+    uint8_t *regions = NULL;
+    uint32_t present = 0;
     int source = -1;
     gf_boolean_t did_sh = _gf_true;
     gf_boolean_t is_arbiter_the_only_sink = _gf_false;
     gf_boolean_t empty_file = _gf_false;
+    gf_boolean_t partial = _gf_false;
 
     priv = this->private;
 
@@ -722,6 +1177,18 @@ __afr_selfheal_data(call_frame_t *frame, xlator_t *this, fd_t *fd,
             goto unlock;
         }
 
+        if (priv->dsh_granular) {
+            regions = GF_CALLOC(AFR_REGION_SHIFTS, AFR_REGION_MAP_SIZE,
+                                gf_afr_mt_region_map_t);
+            if (regions)
+                partial = __afr_selfheal_data_regions(
+                    frame, this, fd, data_lock, sources, healed_sinks,
+                    locked_replies, regions, &present);
+            gf_msg_debug(this->name, 0, "%s: %s data heal",
+                         uuid_utoa(fd->inode->gfid),
+                         partial ? "granular" : "full");
+        }
+
         ret = __afr_selfheal_truncate_sinks(
             frame, this, fd, healed_sinks,
             locked_replies[source].poststat.ia_size);
@@ -745,7 +1212,7 @@ unlock:
         goto out;
 
     ret = afr_selfheal_data_do(frame, this, fd, source, healed_sinks,
-                               locked_replies);
+                               locked_replies, partial ? regions : NULL);
     if (ret)
         goto out;
 restore_time:
@@ -764,6 +1231,9 @@ restore_time:
     ret = afr_selfheal_undo_pending(
         frame, this, fd->inode, sources, sinks, healed_sinks, undid_pending,
         AFR_DATA_TRANSACTION, locked_replies, data_lock);
+    if (present && !ret && !is_arbiter_the_only_sink && !empty_file)
+        __afr_selfheal_data_clear_regions(frame, this, fd, data_lock,
+                                          present);
 skip_undo_pending:
     afr_selfheal_uninodelk(frame, this, fd->inode, this->name, 0, 0, data_lock);
 out:
@@ -777,6 +1247,8 @@ out:
     if (locked_replies)
         afr_replies_wipe(locked_replies, priv->child_count);
 
+    GF_FREE(regions);
+
     return ret;
 }
 
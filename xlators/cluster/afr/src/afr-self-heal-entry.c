@@ -14,6 +14,7 @@
 #include "afr-messages.h"
 #include <glusterfs/syncop-utils.h>
 #include <glusterfs/events.h>
+#include <glusterfs/timespec.h>
 
 static int
 afr_selfheal_entry_anon_inode(xlator_t *this, inode_t *dir, const char *name,
@@ -751,6 +752,75 @@ __afr_selfheal_entry_prepare(call_frame_t *frame, xlator_t *this,
     return ret;
 }
 
+/* Looks @name up on the locked bricks and heals it. Must be called with
+ * the entry lock of the parent held. */
+static int
+__afr_selfheal_entry_name(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                          char *name, int source, unsigned char *sources,
+                          unsigned char *healed_sinks, unsigned char *locked_on,
+                          dict_t *xattr, inode_t *parent_idx_inode,
+                          xlator_t *subvol)
+{
+    int ret = 0;
+    inode_t *inode = NULL;
+    struct afr_reply *replies = NULL;
+    unsigned char *name_sources = NULL;
+    afr_private_t *priv = NULL;
+
+    priv = this->private;
+
+    replies = alloca0(priv->child_count * sizeof(*replies));
+
+    /* Merging a dirent updates the sources for that name only, and several
+     * names of a batch may be healed at the same time. */
+    name_sources = alloca(priv->child_count);
+    memcpy(name_sources, sources, priv->child_count);
+
+    inode = afr_selfheal_unlocked_lookup_on(frame, fd->inode, name, replies,
+                                            locked_on, xattr);
+    if (!inode) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    ret = __afr_selfheal_entry_dirent(frame, this, fd, name, inode, source,
+                                      name_sources, healed_sinks, locked_on,
+                                      replies);
+
+    if ((ret == 0) && (priv->esh_granular) && parent_idx_inode) {
+        ret = afr_shd_entry_purge(subvol, parent_idx_inode, name,
+                                  inode->ia_type);
+        /* Why is ret force-set to 0? We do not care about
+         * index purge failing for full heal as it is quite
+         * possible during replace-brick that not all files
+         * and directories have their name indices present in
+         * entry-changes/.
+         */
+        ret = 0;
+    }
+
+    inode_unref(inode);
+out:
+    afr_replies_wipe(replies, priv->child_count);
+    return ret;
+}
+
+static dict_t *
+afr_selfheal_entry_lookup_xattr(void)
+{
+    dict_t *xattr = NULL;
+
+    xattr = dict_new();
+    if (!xattr)
+        return NULL;
+    if (dict_set_int32_sizen(xattr, GF_GFIDLESS_LOOKUP, 1)) {
+        dict_unref(xattr);
+        return NULL;
+    }
+
+    return xattr;
+}
+
 static int
 afr_selfheal_entry_dirent(call_frame_t *frame, xlator_t *this, fd_t *fd,
                           char *name, inode_t *parent_idx_inode,
@@ -762,8 +832,6 @@ afr_selfheal_entry_dirent(call_frame_t *frame, xlator_t *this, fd_t *fd,
     unsigned char *sources = NULL;
     unsigned char *sinks = NULL;
     unsigned char *healed_sinks = NULL;
-    inode_t *inode = NULL;
-    struct afr_reply *replies = NULL;
     struct afr_reply *par_replies = NULL;
     afr_private_t *priv = NULL;
     dict_t *xattr = NULL;
@@ -775,21 +843,15 @@ afr_selfheal_entry_dirent(call_frame_t *frame, xlator_t *this, fd_t *fd,
         return 0;
     }
 
-    xattr = dict_new();
+    xattr = afr_selfheal_entry_lookup_xattr();
     if (!xattr)
         return -ENOMEM;
-    ret = dict_set_int32_sizen(xattr, GF_GFIDLESS_LOOKUP, 1);
-    if (ret) {
-        dict_unref(xattr);
-        return -1;
-    }
 
     sources = alloca0(priv->child_count);
     sinks = alloca0(priv->child_count);
     healed_sinks = alloca0(priv->child_count);
     locked_on = alloca0(priv->child_count);
 
-    replies = alloca0(priv->child_count * sizeof(*replies));
     par_replies = alloca0(priv->child_count * sizeof(*par_replies));
 
     ret = afr_selfheal_entrylk(frame, this, fd->inode, this->name, NULL,
@@ -811,37 +873,14 @@ afr_selfheal_entry_dirent(call_frame_t *frame, xlator_t *this, fd_t *fd,
         if (ret < 0)
             goto unlock;
 
-        inode = afr_selfheal_unlocked_lookup_on(frame, fd->inode, name, replies,
-                                                locked_on, xattr);
-        if (!inode) {
-            ret = -ENOMEM;
-            goto unlock;
-        }
-
-        ret = __afr_selfheal_entry_dirent(frame, this, fd, name, inode, source,
-                                          sources, healed_sinks, locked_on,
-                                          replies);
-
-        if ((ret == 0) && (priv->esh_granular) && parent_idx_inode) {
-            ret = afr_shd_entry_purge(subvol, parent_idx_inode, name,
-                                      inode->ia_type);
-            /* Why is ret force-set to 0? We do not care about
-             * index purge failing for full heal as it is quite
-             * possible during replace-brick that not all files
-             * and directories have their name indices present in
-             * entry-changes/.
-             */
-            ret = 0;
-        }
+        ret = __afr_selfheal_entry_name(frame, this, fd, name, source, sources,
+                                        healed_sinks, locked_on, xattr,
+                                        parent_idx_inode, subvol);
     }
 
 unlock:
     afr_selfheal_unentrylk(frame, this, fd->inode, this->name, NULL, locked_on,
                            NULL);
-    if (inode)
-        inode_unref(inode);
-    if (replies)
-        afr_replies_wipe(replies, priv->child_count);
     if (par_replies)
         afr_replies_wipe(par_replies, priv->child_count);
     if (xattr)
@@ -985,6 +1024,396 @@ afr_selfheal_entry_do_subvol(call_frame_t *frame, xlator_t *this, fd_t *fd,
     return ret;
 }
 
+typedef struct {
+    char *name;
+    uuid_t gfid;
+    ia_type_t type;
+    int child;
+} afr_entry_name_t;
+
+typedef struct {
+    afr_entry_name_t *names;
+    int count;
+    int size;
+} afr_entry_listing_t;
+
+typedef struct {
+    xlator_t *this;
+    call_frame_t *frame;
+    fd_t *fd;
+    char **names;
+    int *rets;
+    int count;
+    int next;
+    int source;
+    unsigned char *sources;
+    unsigned char *healed_sinks;
+    unsigned char *locked_on;
+    dict_t *xattr;
+    gf_lock_t lock;
+    syncbarrier_t barrier;
+} afr_entry_batch_t;
+
+static void
+afr_entry_listing_wipe(afr_entry_listing_t *listing)
+{
+    int i = 0;
+
+    for (i = 0; i < listing->count; i++)
+        GF_FREE(listing->names[i].name);
+    GF_FREE(listing->names);
+    listing->names = NULL;
+    listing->count = listing->size = 0;
+}
+
+static int
+afr_entry_listing_add(afr_entry_listing_t *listing, gf_dirent_t *entry,
+                      int child)
+{
+    afr_entry_name_t *names = NULL;
+    afr_entry_name_t *name = NULL;
+    int size = 0;
+
+    if (listing->count == listing->size) {
+        size = listing->size ? listing->size * 2 : 1024;
+        names = GF_REALLOC(listing->names, size * sizeof(*names));
+        if (!names)
+            return -ENOMEM;
+        listing->names = names;
+        listing->size = size;
+    }
+
+    name = &listing->names[listing->count];
+    name->name = gf_strdup(entry->d_name);
+    if (!name->name)
+        return -ENOMEM;
+    gf_uuid_copy(name->gfid, entry->d_stat.ia_gfid);
+    name->type = entry->d_stat.ia_type;
+    name->child = child;
+    listing->count++;
+
+    return 0;
+}
+
+static int
+afr_entry_name_cmp(const void *a, const void *b)
+{
+    const afr_entry_name_t *n1 = a;
+    const afr_entry_name_t *n2 = b;
+    int ret = 0;
+
+    ret = strcmp(n1->name, n2->name);
+    if (ret)
+        return ret;
+    return n1->child - n2->child;
+}
+
+/* Reads the whole directory from @child, with the gfid and type of every
+ * name, into @listing. */
+static int
+afr_selfheal_entry_list_subvol(xlator_t *this, fd_t *fd, int child,
+                               afr_entry_listing_t *listing)
+{
+    afr_private_t *priv = this->private;
+    gf_dirent_t entries;
+    gf_dirent_t *entry = NULL;
+    off_t offset = 0;
+    int ret = 0;
+
+    INIT_LIST_HEAD(&entries.list);
+
+    while ((ret = syncop_readdirp(priv->children[child], fd, 131072, offset,
+                                  &entries, NULL, NULL))) {
+        if (ret < 0)
+            break;
+        ret = 0;
+        list_for_each_entry(entry, &entries.list, list)
+        {
+            offset = entry->d_off;
+            if (inode_dir_or_parentdir(entry))
+                continue;
+            if (__is_root_gfid(fd->inode->gfid) &&
+                afr_is_private_directory(priv, entry->d_name,
+                                         GF_CLIENT_PID_SELF_HEALD))
+                continue;
+            ret = afr_entry_listing_add(listing, entry, child);
+            if (ret)
+                break;
+        }
+        gf_dirent_free(&entries);
+        if (ret)
+            break;
+    }
+
+    return ret;
+}
+
+/* A name needs no heal when all of @bricks have it, with the same gfid
+ * and type. */
+static gf_boolean_t
+afr_entry_name_in_sync(afr_entry_name_t *names, int count, int brick_count)
+{
+    int i = 0;
+
+    if (count != brick_count || gf_uuid_is_null(names[0].gfid))
+        return _gf_false;
+
+    for (i = 1; i < count; i++) {
+        if (gf_uuid_compare(names[i].gfid, names[0].gfid) ||
+            names[i].type != names[0].type)
+            return _gf_false;
+    }
+
+    return _gf_true;
+}
+
+static int
+afr_selfheal_entry_batch_worker(void *opaque)
+{
+    afr_entry_batch_t *batch = opaque;
+    xlator_t *this = batch->this;
+    call_frame_t *frame = NULL;
+    int i = 0;
+    int ret = 0;
+
+    frame = afr_copy_frame(batch->frame);
+    if (!frame)
+        return -ENOMEM;
+
+    for (;;) {
+        LOCK(&batch->lock);
+        {
+            i = batch->next++;
+        }
+        UNLOCK(&batch->lock);
+        if (i >= batch->count)
+            break;
+
+        ret = __afr_selfheal_entry_name(frame, this, batch->fd,
+                                        batch->names[i], batch->source,
+                                        batch->sources, batch->healed_sinks,
+                                        batch->locked_on, batch->xattr, NULL,
+                                        NULL);
+        AFR_STACK_RESET(frame);
+        if (frame->local == NULL)
+            ret = -ENOTCONN;
+        batch->rets[i] = ret;
+    }
+
+    AFR_STACK_DESTROY(frame);
+    return 0;
+}
+
+static int
+afr_selfheal_entry_batch_worker_done(int ret, call_frame_t *frame,
+                                     void *opaque)
+{
+    afr_entry_batch_t *batch = opaque;
+
+    syncbarrier_wake(&batch->barrier);
+    return 0;
+}
+
+/* Heals @batch->names in parallel, under the entry lock held by the
+ * caller. The names that failed, typically hardlinks of the same gfid
+ * created at the same time, are retried one by one. */
+static int
+__afr_selfheal_entry_batch_heal(afr_entry_batch_t *batch,
+                                gf_boolean_t *mismatch)
+{
+    xlator_t *this = batch->this;
+    afr_private_t *priv = this->private;
+    int workers = 0;
+    int ret = 0;
+    int i = 0;
+
+    if (syncbarrier_init(&batch->barrier) == 0) {
+        for (workers = 0;
+             workers < min(batch->count, AFR_ENTRY_HEAL_MAX_WORKERS);
+             workers++) {
+            if (synctask_new(this->ctx->env, afr_selfheal_entry_batch_worker,
+                             afr_selfheal_entry_batch_worker_done, NULL,
+                             batch) < 0)
+                break;
+        }
+        if (workers)
+            syncbarrier_wait(&batch->barrier, workers);
+        syncbarrier_destroy(&batch->barrier);
+    }
+
+    for (i = 0; i < batch->count; i++) {
+        if (i >= batch->next || (batch->rets[i] < 0 && batch->rets[i] != -EIO))
+            batch->rets[i] = __afr_selfheal_entry_name(
+                batch->frame, this, batch->fd, batch->names[i], batch->source,
+                batch->sources, batch->healed_sinks, batch->locked_on,
+                batch->xattr, NULL, NULL);
+
+        if (batch->rets[i] == -EIO) {
+            /* gfid or type mismatch. */
+            *mismatch = _gf_true;
+            continue;
+        }
+        if (batch->rets[i] < 0) {
+            ret = batch->rets[i];
+            break;
+        }
+        GF_ATOMIC_INC(priv->entry_heal_names_healed);
+    }
+
+    return ret;
+}
+
+static int
+afr_selfheal_entry_batch(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                         char **names, int count, gf_boolean_t *mismatch)
+{
+    afr_private_t *priv = this->private;
+    afr_entry_batch_t batch = {
+        0,
+    };
+    unsigned char *sinks = NULL;
+    struct afr_reply *par_replies = NULL;
+    int ret = 0;
+
+    batch.this = this;
+    batch.frame = frame;
+    batch.fd = fd;
+    batch.names = names;
+    batch.count = count;
+    batch.source = -1;
+    batch.sources = alloca0(priv->child_count);
+    batch.healed_sinks = alloca0(priv->child_count);
+    batch.locked_on = alloca0(priv->child_count);
+    sinks = alloca0(priv->child_count);
+    par_replies = alloca0(priv->child_count * sizeof(*par_replies));
+
+    batch.rets = GF_CALLOC(count, sizeof(*batch.rets), gf_afr_mt_int32_t);
+    batch.xattr = afr_selfheal_entry_lookup_xattr();
+    if (!batch.rets || !batch.xattr) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    LOCK_INIT(&batch.lock);
+
+    ret = afr_selfheal_entrylk(frame, this, fd->inode, this->name, NULL,
+                               batch.locked_on);
+    {
+        if (ret < priv->child_count) {
+            gf_msg_debug(this->name, 0,
+                         "%s: Skipping "
+                         "entry self-heal as only %d sub-volumes "
+                         " could be locked in %s domain",
+                         uuid_utoa(fd->inode->gfid), ret, this->name);
+            ret = -ENOTCONN;
+            goto unlock;
+        }
+
+        ret = __afr_selfheal_entry_prepare(
+            frame, this, fd->inode, batch.locked_on, batch.sources, sinks,
+            batch.healed_sinks, par_replies, &batch.source, NULL);
+        if (ret < 0)
+            goto unlock;
+
+        ret = __afr_selfheal_entry_batch_heal(&batch, mismatch);
+    }
+
+unlock:
+    afr_selfheal_unentrylk(frame, this, fd->inode, this->name, NULL,
+                           batch.locked_on, NULL);
+    afr_replies_wipe(par_replies, priv->child_count);
+    LOCK_DESTROY(&batch.lock);
+out:
+    if (batch.xattr)
+        dict_unref(batch.xattr);
+    GF_FREE(batch.rets);
+    return ret;
+}
+
+/* Full entry heal in bulk: the listings of the source and the sinks are
+ * read with readdirp, sorted and compared, and only the names that differ
+ * are healed, entry_heal_batch of them under each entry lock. */
+static int
+afr_selfheal_entry_bulk(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                        int source, unsigned char *healed_sinks)
+{
+    afr_private_t *priv = this->private;
+    afr_entry_listing_t listing = {
+        0,
+    };
+    afr_entry_name_t *names = NULL;
+    char **heal = NULL;
+    gf_boolean_t mismatch = _gf_false;
+    struct timespec start = {
+        0,
+    };
+    struct timespec end = {
+        0,
+    };
+    int brick_count = 0;
+    int heal_count = 0;
+    int count = 0;
+    int ret = 0;
+    int i = 0;
+    int j = 0;
+
+    timespec_now(&start);
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (!healed_sinks[i] && i != source)
+            continue;
+        brick_count++;
+        ret = afr_selfheal_entry_list_subvol(this, fd, i, &listing);
+        if (ret < 0)
+            goto out;
+    }
+
+    if (!listing.count)
+        goto out;
+
+    qsort(listing.names, listing.count, sizeof(*listing.names),
+          afr_entry_name_cmp);
+
+    heal = GF_CALLOC(listing.count, sizeof(*heal), gf_afr_mt_char);
+    if (!heal) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    for (i = 0; i < listing.count; i = j) {
+        names = &listing.names[i];
+        for (j = i + 1; j < listing.count; j++) {
+            if (strcmp(listing.names[j].name, names->name))
+                break;
+        }
+        GF_ATOMIC_INC(priv->entry_heal_names_compared);
+        if (!afr_entry_name_in_sync(names, j - i, brick_count))
+            heal[heal_count++] = names->name;
+    }
+
+    gf_msg_debug(this->name, 0, "%s: %d of %d names need heal",
+                 uuid_utoa(fd->inode->gfid), heal_count, listing.count);
+
+    for (i = 0; i < heal_count; i += count) {
+        count = min(heal_count - i, (int)priv->entry_heal_batch);
+        ret = afr_selfheal_entry_batch(frame, this, fd, &heal[i], count,
+                                       &mismatch);
+        if (ret)
+            break;
+    }
+
+out:
+    timespec_now(&end);
+    timespec_sub(&start, &end, &start);
+    GF_ATOMIC_ADD(priv->entry_heal_usec,
+                  start.tv_sec * 1000000 + start.tv_nsec / 1000);
+    GF_FREE(heal);
+    afr_entry_listing_wipe(&listing);
+    if (!ret && mismatch)
+        /* undo pending will be skipped */
+        ret = -1;
+    return ret;
+}
+
 static int
 afr_selfheal_entry_granular_dirent(xlator_t *subvol, gf_dirent_t *entry,
                                    loc_t *parent, void *data)
@@ -1080,6 +1509,9 @@ afr_selfheal_entry_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
            (local->need_full_crawl ? "full" : "granular"),
            uuid_utoa(fd->inode->gfid));
 
+    if (local->need_full_crawl && priv->entry_heal_batch)
+        return afr_selfheal_entry_bulk(frame, this, fd, source, healed_sinks);
+
     for (i = 0; i < priv->child_count; i++) {
         /* Expunge */
         if (!healed_sinks[i])
@@ -13,10 +13,19 @@
 #include "afr-self-heald.h"
 #include "protocol-common.h"
 #include <glusterfs/syncop-utils.h>
+#include <glusterfs/statedump.h>
 #include "afr-messages.h"
 
 #define AFR_EH_SPLIT_BRAIN_LIMIT 1024
 #define AFR_STATISTICS_HISTORY_SIZE 50
+#define AFR_SHD_INDEX_DIRS 3
+
+struct afr_shd_index_sweep_args {
+    struct subvol_healer *healer;
+    char *vgfid;
+    pthread_t thread;
+    int ret;
+};
 
 #define ASSERT_LOCAL(this, healer)                                             \
     if (!afr_shd_is_subvol_local(this, healer->subvol)) {                      \
@@ -369,6 +378,8 @@ afr_shd_sweep_prepare(struct subvol_healer *healer)
     event->healed_count = 0;
     event->split_brain_count = 0;
     event->heal_failed_count = 0;
+    event->scanned_count = 0;
+    event->skipped_count = 0;
 
     event->start_time = gf_time();
     event->end_time = 0;
@@ -406,6 +417,8 @@ afr_shd_index_heal(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
     uuid_t gfid = {0};
     int ret = 0;
     uint64_t val = IA_INVAL;
+    gf_boolean_t busy = _gf_false;
+    gf_boolean_t tracked = _gf_false;
 
     priv = healer->this->private;
     if (!priv->shd.enabled)
@@ -418,10 +431,29 @@ afr_shd_index_heal(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
     if (ret)
         return 0;
 
+    /* The same gfid can be listed in several index directories, and those
+     * can be swept in parallel. Leave it to the worker already on it. */
+    LOCK(&priv->lock);
+    {
+        healer->crawl_event.scanned_count++;
+        busy = (dict_get(priv->shd.healing, entry->d_name) != NULL);
+        if (busy)
+            healer->crawl_event.skipped_count++;
+        else
+            tracked = !dict_set_int8(priv->shd.healing, entry->d_name, 1);
+    }
+    UNLOCK(&priv->lock);
+
+    if (busy)
+        return 0;
+
     inode_ctx_get2(parent->inode, subvol, NULL, &val);
 
     ret = afr_shd_selfheal(healer, healer->subvol, gfid);
 
+    if (tracked)
+        dict_del(priv->shd.healing, entry->d_name);
+
     if (ret == -ENOENT || ret == -ESTALE)
         afr_shd_entry_purge(subvol, parent->inode, entry->d_name, val);
 
@@ -487,12 +519,83 @@ out:
     return ret;
 }
 
+static void *
+afr_shd_index_sweep_thread(void *data)
+{
+    struct afr_shd_index_sweep_args *args = data;
+    gf_lkowner_t lkowner;
+    pid_t pid = GF_CLIENT_PID_SELF_HEALD;
+
+    THIS = args->healer->this;
+
+    syncopctx_setfspid(&pid);
+    set_lk_owner_from_ptr(&lkowner, &lkowner);
+    syncopctx_setfslkowner(&lkowner);
+
+    args->ret = afr_shd_index_sweep(args->healer, args->vgfid);
+
+    return NULL;
+}
+
+/* Sweeps the index directories of the brick at the same time, so that a
+ * huge xattrop index does not hold back the heal of the dirty and entry
+ * indices. Each sweep has its own readdir stream and pool of workers. */
+static int
+afr_shd_index_sweep_parallel(struct subvol_healer *healer)
+{
+    struct afr_shd_index_sweep_args args[AFR_SHD_INDEX_DIRS] = {
+        {.vgfid = GF_XATTROP_INDEX_GFID},
+        {.vgfid = GF_XATTROP_DIRTY_GFID},
+        {.vgfid = GF_XATTROP_ENTRY_CHANGES_GFID},
+    };
+    gf_boolean_t started[AFR_SHD_INDEX_DIRS] = {0};
+    afr_private_t *priv = healer->this->private;
+    int ret = 0;
+    int i = 0;
+
+    for (i = 0; i < AFR_SHD_INDEX_DIRS; i++)
+        args[i].healer = healer;
+
+    for (i = 1; i < AFR_SHD_INDEX_DIRS; i++) {
+        if (gf_thread_create(&args[i].thread, NULL,
+                             afr_shd_index_sweep_thread, &args[i],
+                             "shdsweep") == 0)
+            started[i] = _gf_true;
+    }
+
+    args[0].ret = afr_shd_index_sweep(healer, args[0].vgfid);
+
+    for (i = 1; i < AFR_SHD_INDEX_DIRS; i++) {
+        if (started[i])
+            pthread_join(args[i].thread, NULL);
+        else
+            args[i].ret = afr_shd_index_sweep(healer, args[i].vgfid);
+    }
+
+    for (i = 0; i < AFR_SHD_INDEX_DIRS; i++) {
+        if (args[i].ret < 0)
+            return args[i].ret;
+    }
+
+    LOCK(&priv->lock);
+    {
+        ret = healer->crawl_event.healed_count;
+    }
+    UNLOCK(&priv->lock);
+
+    return ret;
+}
+
 static int
 afr_shd_index_sweep_all(struct subvol_healer *healer)
 {
+    afr_private_t *priv = healer->this->private;
     int ret = 0;
     int count = 0;
 
+    if (priv->shd.parallel_sweep)
+        return afr_shd_index_sweep_parallel(healer);
+
     ret = afr_shd_index_sweep(healer, GF_XATTROP_INDEX_GFID);
     if (ret < 0)
         goto out;
@@ -1197,6 +1300,7 @@ static int
 afr_shd_dict_add_crawl_event(xlator_t *this, dict_t *output,
                              crawl_event_t *crawl_event)
 {
+    afr_private_t *priv = this->private;
     int ret = 0;
     uint64_t count = 0;
     char key[128] = {0};
@@ -1305,6 +1409,26 @@ afr_shd_dict_add_crawl_event(xlator_t *this, dict_t *output,
         goto out;
     }
 
+    /* Totals of the entry heals done by this process */
+    snprintf(key, sizeof(key), "statistics_entry_compared-%s", suffix);
+    ret = dict_set_uint64(output, key,
+                          GF_ATOMIC_GET(priv->entry_heal_names_compared));
+    if (ret)
+        goto entry_stats_out;
+    snprintf(key, sizeof(key), "statistics_entry_healed-%s", suffix);
+    ret = dict_set_uint64(output, key,
+                          GF_ATOMIC_GET(priv->entry_heal_names_healed));
+    if (ret)
+        goto entry_stats_out;
+    snprintf(key, sizeof(key), "statistics_entry_usec-%s", suffix);
+    ret = dict_set_uint64(output, key, GF_ATOMIC_GET(priv->entry_heal_usec));
+entry_stats_out:
+    if (ret) {
+        gf_msg(this->name, GF_LOG_ERROR, -ret, AFR_MSG_DICT_SET_FAILED,
+               "Could not add entry heal statistics to output");
+        goto out;
+    }
+
     snprintf(key, sizeof(key), "statistics-%d-%d-count", xl_id, child);
     ret = dict_set_uint64(output, key, count + 1);
     if (ret) {
@@ -1371,6 +1495,10 @@ afr_selfheal_daemon_init(xlator_t *this)
             goto out;
     }
 
+    shd->healing = dict_new();
+    if (!shd->healing)
+        goto out;
+
     shd->split_brain = eh_new(AFR_EH_SPLIT_BRAIN_LIMIT, _gf_false,
                               afr_destroy_shd_event_data);
     if (!shd->split_brain)
@@ -1397,6 +1525,52 @@ out:
     return ret;
 }
 
+void
+afr_shd_dump_progress(xlator_t *this)
+{
+    afr_private_t *priv = this->private;
+    struct subvol_healer *healer = NULL;
+    crawl_event_t event;
+    char key[GF_DUMP_MAX_BUF_LEN];
+    time_t elapsed = 0;
+    int i = 0;
+
+    if (!priv->shd.iamshd || !priv->shd.index_healers)
+        return;
+
+    gf_proc_dump_write("shd-parallel-index-sweep", "%d",
+                       priv->shd.parallel_sweep);
+    for (i = 0; i < priv->child_count; i++) {
+        healer = NTH_INDEX_HEALER(this, i);
+        if (!healer->local)
+            continue;
+
+        LOCK(&priv->lock);
+        {
+            event = healer->crawl_event;
+        }
+        UNLOCK(&priv->lock);
+
+        if (!event.start_time)
+            continue;
+
+        elapsed = gf_time() - event.start_time;
+        sprintf(key, "index-sweep[%d].scanned", i);
+        gf_proc_dump_write(key, "%" PRIu64, event.scanned_count);
+        sprintf(key, "index-sweep[%d].healed", i);
+        gf_proc_dump_write(key, "%" PRIu64, event.healed_count);
+        sprintf(key, "index-sweep[%d].failed", i);
+        gf_proc_dump_write(key, "%" PRIu64, event.heal_failed_count);
+        sprintf(key, "index-sweep[%d].skipped", i);
+        gf_proc_dump_write(key, "%" PRIu64, event.skipped_count);
+        sprintf(key, "index-sweep[%d].seconds", i);
+        gf_proc_dump_write(key, "%ld", (long)elapsed);
+        sprintf(key, "index-sweep[%d].healed-per-sec", i);
+        gf_proc_dump_write(key, "%" PRIu64,
+                           event.healed_count / (elapsed ? elapsed : 1));
+    }
+}
+
 void
 afr_selfheal_childup(xlator_t *this, afr_private_t *priv)
 {
@@ -22,6 +22,10 @@ typedef struct {
     uint64_t healed_count;
     uint64_t split_brain_count;
     uint64_t heal_failed_count;
+    /* Index entries seen, and skipped because another worker of this
+       daemon was already healing the same gfid */
+    uint64_t scanned_count;
+    uint64_t skipped_count;
 
     /* If start_time is 0, it means crawler is not in progress
        and stats are not valid */
@@ -51,12 +55,15 @@ typedef struct {
 
     eh_t *split_brain;
     eh_t **statistics;
+    /* gfids being healed by the index healers, protected by priv->lock */
+    dict_t *healing;
     time_t timeout;
     uint32_t max_threads;
     uint32_t wait_qlength;
     uint32_t halo_max_latency_msec;
     gf_boolean_t iamshd;
     gf_boolean_t enabled;
+    gf_boolean_t parallel_sweep;
 } afr_self_heald_t;
 
 int
@@ -65,6 +72,9 @@ afr_selfheal_daemon_init(xlator_t *this);
 int
 afr_xl_op(xlator_t *this, dict_t *input, dict_t *output);
 
+void
+afr_shd_dump_progress(xlator_t *this);
+
 int
 afr_shd_entry_purge(xlator_t *subvol, inode_t *inode, char *name,
                     ia_type_t type);
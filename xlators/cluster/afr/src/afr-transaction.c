@@ -341,6 +341,19 @@ afr_transaction_fop(call_frame_t *frame, xlator_t *this)
     return 0;
 }
 
+static void
+afr_write_batch_account(afr_private_t *priv, uint32_t count)
+{
+    int bucket = 0;
+
+    if (!count)
+        return;
+
+    while ((count >>= 1) && (bucket < AFR_WRITE_BATCH_BUCKETS - 1))
+        bucket++;
+    GF_ATOMIC_INC(priv->write_batches[bucket]);
+}
+
 static int
 afr_transaction_done(call_frame_t *frame, xlator_t *this)
 {
@@ -367,6 +380,9 @@ afr_transaction_done(call_frame_t *frame, xlator_t *this)
         lock = &local->inode_ctx->lock[local->transaction.type];
         LOCK(&local->inode->lock);
         {
+            if (local->transaction.type == AFR_DATA_TRANSACTION)
+                afr_write_batch_account(priv, lock->batch_count);
+            lock->batch_count = 0;
             lock->acquired = _gf_false;
             lock->release = _gf_false;
             list_splice_init(&lock->frozen, &lock->waiting);
@@ -376,6 +392,7 @@ afr_transaction_done(call_frame_t *frame, xlator_t *this)
                                     transaction.wait_list);
             list_del_init(&lock_local->transaction.wait_list);
             list_add(&lock_local->transaction.owner_list, &lock->owners);
+            lock->batch_count++;
         }
     unlock:
         UNLOCK(&local->inode->lock);
@@ -1375,6 +1392,210 @@ afr_handle_failure_using_thin_arbiter(call_frame_t *frame, xlator_t *this)
     afr_ta_decide_post_op_state(frame, this);
 }
 
+/* Remembers the range written by a data fop that some brick missed. It is
+ * recorded on the other bricks by the post-op that blames that brick. */
+static void
+afr_changelog_mark_regions(call_frame_t *frame, xlator_t *this)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = frame->local;
+    afr_inode_ctx_t *ctx = local->inode_ctx;
+    uint64_t end = LLONG_MAX;
+
+    if (!priv->dsh_granular ||
+        (local->transaction.type != AFR_DATA_TRANSACTION) || !ctx ||
+        !AFR_COUNT(local->transaction.failed_subvols, priv->child_count))
+        return;
+
+    if (local->transaction.len)
+        end = local->transaction.start + local->transaction.len - 1;
+
+    LOCK(&local->inode->lock);
+    {
+        if (!ctx->region_map && (ctx->region_shift != AFR_REGION_LOST))
+            ctx->region_map = GF_CALLOC(1, AFR_REGION_MAP_SIZE,
+                                        gf_afr_mt_region_map_t);
+        if (!ctx->region_map)
+            /* Every post-op from now on misses this write. */
+            ctx->region_shift = AFR_REGION_LOST;
+        else
+            gf_region_mark(ctx->region_map, &ctx->region_shift,
+                            local->transaction.start, end);
+        ctx->region_gen++;
+    }
+    UNLOCK(&local->inode->lock);
+}
+
+/* Returns the regions to merge with the ones recorded on the bricks, or NULL
+ * if they are not known. */
+static dict_t *
+afr_changelog_regions_dict(call_frame_t *frame, xlator_t *this)
+{
+    afr_local_t *local = frame->local;
+    afr_inode_ctx_t *ctx = local->inode_ctx;
+    dict_t *regions = NULL;
+    uint8_t *map = NULL;
+    uint32_t shift = 0;
+    char key[64];
+
+    map = GF_MALLOC(AFR_REGION_MAP_SIZE, gf_afr_mt_region_map_t);
+    if (!map)
+        return NULL;
+
+    LOCK(&local->inode->lock);
+    {
+        shift = ctx->region_shift;
+        if (shift && (shift != AFR_REGION_LOST))
+            memcpy(map, ctx->region_map, AFR_REGION_MAP_SIZE);
+        local->transaction.region_gen = ctx->region_gen;
+    }
+    UNLOCK(&local->inode->lock);
+
+    if (!shift || (shift == AFR_REGION_LOST))
+        goto err;
+
+    regions = dict_new();
+    if (!regions)
+        goto err;
+
+    snprintf(key, sizeof(key), "%s.%u", AFR_REGION_MAP_XATTR, shift);
+    if (dict_set_bin(regions, key, map, AFR_REGION_MAP_SIZE))
+        goto err;
+
+    return regions;
+
+err:
+    if (regions)
+        dict_unref(regions);
+    GF_FREE(map);
+    return NULL;
+}
+
+static void
+afr_changelog_post_op_regions_done(call_frame_t *frame, xlator_t *this)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = frame->local;
+    afr_inode_ctx_t *ctx = local->inode_ctx;
+    dict_t *xattr = NULL;
+    int32_t *count = NULL;
+    int i = 0;
+
+    xattr = local->transaction.region_post_op;
+    local->transaction.region_post_op = NULL;
+
+    if (local->transaction.region_failed)
+        goto post_op;
+
+    /* Count this post-op as covered by the recorded regions for every
+     * brick that it blames. */
+    for (i = 0; i < priv->child_count; i++) {
+        if (!local->transaction.failed_subvols[i])
+            continue;
+
+        count = GF_MALLOC(sizeof(*count), gf_afr_mt_int32_t);
+        if (!count)
+            goto post_op;
+        *count = htobe32(1);
+        if (dict_set_bin(xattr, priv->region_key[i], count, sizeof(*count))) {
+            GF_FREE(count);
+            goto post_op;
+        }
+    }
+
+    LOCK(&local->inode->lock);
+    {
+        if (ctx->region_gen == local->transaction.region_gen) {
+            memset(ctx->region_map, 0, AFR_REGION_MAP_SIZE);
+            ctx->region_shift = 0;
+        }
+    }
+    UNLOCK(&local->inode->lock);
+
+post_op:
+    if (local->transaction.region_failed || (i < priv->child_count)) {
+        for (i = 0; i < priv->child_count; i++)
+            dict_del(xattr, priv->region_key[i]);
+        gf_msg_debug(this->name, 0,
+                     "%s: unable to record the dirty regions, a full data "
+                     "heal will be needed",
+                     uuid_utoa(local->inode->gfid));
+    }
+
+    afr_changelog_do(frame, this, xattr, afr_changelog_post_op_done,
+                     AFR_TRANSACTION_POST_OP);
+    dict_unref(xattr);
+}
+
+static int
+afr_changelog_regions_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                          int op_ret, int op_errno, dict_t *xattr,
+                          dict_t *xdata)
+{
+    afr_local_t *local = frame->local;
+
+    if (op_ret < 0)
+        local->transaction.region_failed = _gf_true;
+
+    if (afr_frame_return(frame) == 0)
+        afr_changelog_post_op_regions_done(frame, this);
+
+    return 0;
+}
+
+/* Merges the regions written by this client with the ones recorded on the
+ * bricks, and then sends the post-op in @xattr. */
+static void
+afr_changelog_post_op_regions(call_frame_t *frame, xlator_t *this,
+                              dict_t *xattr)
+{
+    afr_private_t *priv = this->private;
+    afr_local_t *local = frame->local;
+    dict_t *regions = NULL;
+    int call_count = 0;
+    int i = 0;
+
+    call_count = afr_changelog_call_count(
+        local->transaction.type, local->transaction.pre_op,
+        local->transaction.failed_subvols, priv->child_count);
+
+    regions = afr_changelog_regions_dict(frame, this);
+    if (!regions || !call_count) {
+        local->transaction.region_failed = _gf_true;
+        local->transaction.region_post_op = dict_ref(xattr);
+        afr_changelog_post_op_regions_done(frame, this);
+        goto out;
+    }
+
+    local->transaction.region_failed = _gf_false;
+    local->transaction.region_post_op = dict_ref(xattr);
+    local->call_count = call_count;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (!local->transaction.pre_op[i] ||
+            local->transaction.failed_subvols[i])
+            continue;
+
+        if (!local->fd)
+            STACK_WIND_COOKIE(frame, afr_changelog_regions_cbk,
+                              (void *)(long)i, priv->children[i],
+                              priv->children[i]->fops->xattrop, &local->loc,
+                              GF_XATTROP_OR_ARRAY, regions, NULL);
+        else
+            STACK_WIND_COOKIE(frame, afr_changelog_regions_cbk,
+                              (void *)(long)i, priv->children[i],
+                              priv->children[i]->fops->fxattrop, local->fd,
+                              GF_XATTROP_OR_ARRAY, regions, NULL);
+
+        if (!--call_count)
+            break;
+    }
+
+out:
+    if (regions)
+        dict_unref(regions);
+}
+
 static void
 afr_changelog_post_op_do(call_frame_t *frame, xlator_t *this)
 {
@@ -1386,6 +1607,7 @@ afr_changelog_post_op_do(call_frame_t *frame, xlator_t *this)
     int idx = 0;
     int nothing_failed = 1;
     gf_boolean_t need_undirty = _gf_false;
+    gf_boolean_t blames = _gf_false;
     uint32_t hton32_1;
 
     afr_handle_quorum(frame, this);
@@ -1428,8 +1650,10 @@ afr_changelog_post_op_do(call_frame_t *frame, xlator_t *this)
     }
 
     for (i = 0; i < priv->child_count; i++) {
-        if (local->transaction.failed_subvols[i])
+        if (local->transaction.failed_subvols[i]) {
             local->pending[i][idx] = hton32_1;
+            blames = _gf_true;
+        }
     }
 
     ret = afr_set_pending_dict(priv, xattr, local->pending);
@@ -1451,6 +1675,12 @@ set_dirty:
         goto out;
     }
 
+    if (blames && priv->dsh_granular &&
+        (local->transaction.type == AFR_DATA_TRANSACTION)) {
+        afr_changelog_post_op_regions(frame, this, xattr);
+        goto out;
+    }
+
     afr_changelog_do(frame, this, xattr, afr_changelog_post_op_done,
                      AFR_TRANSACTION_POST_OP);
 out:
@@ -2214,6 +2444,7 @@ __afr_transaction_wake_shared(afr_local_t *local, struct list_head *shared)
                               each->transaction.frame->this, 0);
         list_move_tail(&each->transaction.wait_list, shared);
         list_add_tail(&each->transaction.owner_list, &lock->owners);
+        lock->batch_count++;
     }
 }
 
@@ -2283,9 +2514,26 @@ afr_are_conflicting_ops_waiting(afr_local_t *local, xlator_t *this)
     return _gf_false;
 }
 
+/* Whether more writes can still join the current acquisition of a lock
+ * that other clients are waiting for. */
+static gf_boolean_t
+afr_write_batch_open(afr_local_t *local, xlator_t *this)
+{
+    afr_private_t *priv = this->private;
+    afr_lock_t *lock = &local->inode_ctx->lock[local->transaction.type];
+
+    if (local->transaction.type != AFR_DATA_TRANSACTION)
+        return _gf_false;
+
+    if (!priv->write_batch_usec)
+        return _gf_false;
+
+    return (lock->batch_count < priv->write_batch_size);
+}
+
 static gf_boolean_t
 afr_is_delayed_changelog_post_op_needed(call_frame_t *frame, xlator_t *this,
-                                        int delay)
+                                        int delay, gf_boolean_t *batching)
 {
     afr_local_t *local = NULL;
     afr_lock_t *lock = NULL;
@@ -2300,8 +2548,11 @@ afr_is_delayed_changelog_post_op_needed(call_frame_t *frame, xlator_t *this,
     }
 
     if (afr_are_conflicting_ops_waiting(local, this)) {
-        lock->release = _gf_true;
-        goto out;
+        if (!afr_write_batch_open(local, this)) {
+            lock->release = _gf_true;
+            goto out;
+        }
+        *batching = _gf_true;
     }
 
     if (!list_empty(&lock->owners))
@@ -2313,7 +2564,7 @@ afr_is_delayed_changelog_post_op_needed(call_frame_t *frame, xlator_t *this,
         goto out;
     }
 
-    if (!delay) {
+    if (!delay && !*batching) {
         goto out;
     }
 
@@ -2558,6 +2809,7 @@ afr_changelog_post_op(call_frame_t *frame, xlator_t *this)
     afr_local_t *local = frame->local;
     afr_lock_t *lock = NULL;
     gf_boolean_t post_op = _gf_true;
+    gf_boolean_t batching = _gf_false;
     struct list_head shared;
 
     priv = this->private;
@@ -2576,12 +2828,19 @@ afr_changelog_post_op(call_frame_t *frame, xlator_t *this)
         __afr_transaction_wake_shared(local, &shared);
 
         if (!afr_is_delayed_changelog_post_op_needed(frame, this,
-                                                     delta.tv_sec)) {
+                                                     delta.tv_sec, &batching)) {
             if (list_empty(&lock->owners))
                 lock->release = _gf_true;
             goto unlock;
         }
 
+        if (batching) {
+            /* Other clients are waiting for the lock, only wait for the
+             * writes that are about to come. */
+            delta.tv_sec = priv->write_batch_usec / 1000000;
+            delta.tv_nsec = (priv->write_batch_usec % 1000000) * 1000;
+        }
+
         GF_ASSERT(lock->delay_timer == NULL);
         lock->delay_timer = gf_timer_call_after(
             this->ctx, delta, afr_delayed_changelog_wake_up_cbk, local);
@@ -2619,6 +2878,8 @@ afr_transaction_resume(call_frame_t *frame, xlator_t *this)
 
     afr_handle_symmetric_errors(frame, this);
 
+    afr_changelog_mark_regions(frame, this);
+
     if (!local->pre_op_compat)
         /* new mode, pre-op was done along
            with OP */
@@ -2659,11 +2920,19 @@ __afr_eager_lock_handle(afr_local_t *local, gf_boolean_t *take_lock,
     afr_lock_t *lock = NULL;
     afr_local_t *owner_local = NULL;
     xlator_t *this = local->transaction.frame->this;
+    afr_private_t *priv = this->private;
 
     local->transaction.eager_lock_on = _gf_true;
     afr_set_lk_owner(local->transaction.frame, this, local->inode);
 
     lock = &local->inode_ctx->lock[local->transaction.type];
+    if (priv->write_batch_usec && lock->acquired &&
+        afr_are_conflicting_ops_waiting(local, this) &&
+        !afr_write_batch_open(local, this)) {
+        /* Let the clients waiting for the lock have it after this batch. */
+        lock->release = _gf_true;
+    }
+
     if (__need_previous_lock_unlocked(local)) {
         if (!list_empty(&lock->owners)) {
             lock->release = _gf_true;
@@ -2698,6 +2967,7 @@ __afr_eager_lock_handle(afr_local_t *local, gf_boolean_t *take_lock,
             lock->delay_timer = NULL;
             *do_pre_op = _gf_true;
             list_add_tail(&local->transaction.owner_list, &lock->owners);
+            lock->batch_count++;
         }
         goto out;
     }
@@ -2719,6 +2989,7 @@ __afr_eager_lock_handle(afr_local_t *local, gf_boolean_t *take_lock,
     if (lock->acquired)
         GF_ASSERT(!(*take_lock));
     list_add_tail(&local->transaction.owner_list, &lock->owners);
+    lock->batch_count++;
 out:
     return;
 }
@@ -200,10 +200,19 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("data-self-heal-window-size",
                      priv->data_self_heal_window_size, options, uint32, out);
 
+    GF_OPTION_RECONF("data-self-heal-pipeline-depth",
+                     priv->data_self_heal_pipeline_depth, options, uint32, out);
+
+    GF_OPTION_RECONF("entry-self-heal-batch-size", priv->entry_heal_batch,
+                     options, uint32, out);
+
     GF_OPTION_RECONF("data-self-heal-algorithm", data_self_heal_algorithm,
                      options, str, out);
     set_data_self_heal_algorithm(priv, data_self_heal_algorithm);
 
+    GF_OPTION_RECONF("data-self-heal-xxhash", priv->data_self_heal_xxhash,
+                     options, bool, out);
+
     GF_OPTION_RECONF("halo-enabled", priv->halo_enabled, options, bool, out);
 
     GF_OPTION_RECONF("halo-shd-max-latency", priv->shd.halo_max_latency_msec,
@@ -234,6 +243,13 @@ reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("read-hash-mode", priv->hash_mode, options, uint32, out);
 
+    GF_OPTION_RECONF("read-hedge-percentile", priv->read_hedge_pct, options,
+                     percent, out);
+    GF_OPTION_RECONF("read-hedge-min-delay-usec", priv->read_hedge_min_delay,
+                     options, uint32, out);
+    GF_OPTION_RECONF("read-lease", priv->read_lease, options, bool, out);
+    priv->read_lease_unsupported = _gf_false;
+
     if (read_subvol) {
         index = xlator_subvolume_index(this, read_subvol);
         if (index == -1) {
@@ -264,6 +280,9 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("granular-entry-heal", priv->esh_granular, options, bool,
                      out);
 
+    GF_OPTION_RECONF("granular-data-heal", priv->dsh_granular, options, bool,
+                     out);
+
     GF_OPTION_RECONF("eager-lock", priv->eager_lock, options, bool, out);
     GF_OPTION_RECONF("optimistic-change-log", priv->optimistic_change_log,
                      options, bool, out);
@@ -277,6 +296,11 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("post-op-delay-secs", priv->post_op_delay_secs, options,
                      uint32, out);
 
+    GF_OPTION_RECONF("write-batch-delay-usec", priv->write_batch_usec, options,
+                     uint32, out);
+    GF_OPTION_RECONF("write-batch-size", priv->write_batch_size, options,
+                     uint32, out);
+
     /* Reset this so we re-discover in case the topology changed.  */
     GF_OPTION_RECONF("ensure-durability", priv->ensure_durability, options,
                      bool, out);
@@ -299,6 +323,9 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("shd-wait-qlength", priv->shd.wait_qlength, options,
                      uint32, out);
 
+    GF_OPTION_RECONF("shd-parallel-index-sweep", priv->shd.parallel_sweep,
+                     options, bool, out);
+
     GF_OPTION_RECONF("favorite-child-policy", fav_child_policy, options, str,
                      out);
     if (afr_set_favorite_child_policy(priv, fav_child_policy) == -1)
@@ -393,6 +420,29 @@ out:
     return ret;
 }
 
+/* The dirty regions are counted per brick under the same name as its
+ * pending xattr. */
+static int
+afr_region_xattrs_init(afr_private_t *priv)
+{
+    int i = 0;
+    int ret = 0;
+
+    priv->region_key = GF_CALLOC(sizeof(*priv->region_key), priv->child_count,
+                                 gf_afr_mt_char);
+    if (!priv->region_key)
+        return -ENOMEM;
+
+    for (i = 0; i < priv->child_count; i++) {
+        ret = gf_asprintf(&priv->region_key[i], "%s.%s", AFR_REGION_XATTR,
+                          priv->pending_key[i] + SLEN(AFR_XATTR_PREFIX "."));
+        if (ret == -1)
+            return -ENOMEM;
+    }
+
+    return 0;
+}
+
 void
 afr_ta_init(afr_private_t *priv)
 {
@@ -495,6 +545,21 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("read-hash-mode", priv->hash_mode, uint32, out);
 
+    GF_OPTION_INIT("read-hedge-percentile", priv->read_hedge_pct, percent, out);
+    GF_OPTION_INIT("read-hedge-min-delay-usec", priv->read_hedge_min_delay,
+                   uint32, out);
+    for (i = 0; i < AFR_READ_LATENCY_BUCKETS; i++)
+        GF_ATOMIC_INIT(priv->read_latency[i], 0);
+    GF_ATOMIC_INIT(priv->read_hedges_sent, 0);
+    GF_ATOMIC_INIT(priv->read_hedges_won, 0);
+
+    GF_OPTION_INIT("read-lease", priv->read_lease, bool, out);
+    gf_uuid_generate(priv->read_lease_id);
+    GF_ATOMIC_INIT(priv->down_generation, 0);
+    GF_ATOMIC_INIT(priv->read_leases_granted, 0);
+    GF_ATOMIC_INIT(priv->read_leases_recalled, 0);
+    GF_ATOMIC_INIT(priv->read_lease_refreshes_skipped, 0);
+
     priv->favorite_child = -1;
 
     GF_OPTION_INIT("favorite-child-policy", fav_child_policy, str, out);
@@ -505,6 +570,9 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("shd-wait-qlength", priv->shd.wait_qlength, uint32, out);
 
+    GF_OPTION_INIT("shd-parallel-index-sweep", priv->shd.parallel_sweep, bool,
+                   out);
+
     GF_OPTION_INIT("background-self-heal-count",
                    priv->background_self_heal_count, uint32, out);
 
@@ -521,6 +589,18 @@ init(xlator_t *this)
     GF_OPTION_INIT("data-self-heal-window-size",
                    priv->data_self_heal_window_size, uint32, out);
 
+    GF_OPTION_INIT("data-self-heal-pipeline-depth",
+                   priv->data_self_heal_pipeline_depth, uint32, out);
+
+    GF_OPTION_INIT("entry-self-heal-batch-size", priv->entry_heal_batch, uint32,
+                   out);
+    GF_ATOMIC_INIT(priv->entry_heal_names_compared, 0);
+    GF_ATOMIC_INIT(priv->entry_heal_names_healed, 0);
+    GF_ATOMIC_INIT(priv->entry_heal_usec, 0);
+
+    GF_OPTION_INIT("data-self-heal-xxhash", priv->data_self_heal_xxhash, bool,
+                   out);
+
     GF_OPTION_INIT("metadata-self-heal", priv->metadata_self_heal, bool, out);
 
     GF_OPTION_INIT("entry-self-heal", priv->entry_self_heal, bool, out);
@@ -549,12 +629,19 @@ init(xlator_t *this)
     GF_OPTION_INIT("full-lock", priv->full_lock, bool, out);
     GF_OPTION_INIT("granular-entry-heal", priv->esh_granular, bool, out);
 
+    GF_OPTION_INIT("granular-data-heal", priv->dsh_granular, bool, out);
+
     GF_OPTION_INIT("eager-lock", priv->eager_lock, bool, out);
     GF_OPTION_INIT("quorum-type", qtype, str, out);
     GF_OPTION_INIT("quorum-count", priv->quorum_count, uint32, out);
     fix_quorum_options(this, priv, qtype, this->options);
 
     GF_OPTION_INIT("post-op-delay-secs", priv->post_op_delay_secs, uint32, out);
+    GF_OPTION_INIT("write-batch-delay-usec", priv->write_batch_usec, uint32,
+                   out);
+    GF_OPTION_INIT("write-batch-size", priv->write_batch_size, uint32, out);
+    for (i = 0; i < AFR_WRITE_BATCH_BUCKETS; i++)
+        GF_ATOMIC_INIT(priv->write_batches[i], 0);
     GF_OPTION_INIT("ensure-durability", priv->ensure_durability, bool, out);
 
     GF_OPTION_INIT("self-heal-daemon", priv->shd.enabled, bool, out);
@@ -610,6 +697,10 @@ init(xlator_t *this)
     if (ret)
         goto out;
 
+    ret = afr_region_xattrs_init(priv);
+    if (ret)
+        goto out;
+
     trav = this->children;
     i = 0;
     while (i < child_count) {
@@ -718,6 +809,8 @@ afr_selfheal_daemon_fini(xlator_t *this)
     GF_FREE(shd->statistics);
     if (shd->split_brain)
         eh_destroy(shd->split_brain);
+    if (shd->healing)
+        dict_unref(shd->healing);
 }
 void
 fini(xlator_t *this)
@@ -787,6 +880,7 @@ struct xlator_fops fops = {
     .fallocate = afr_fallocate,
     .discard = afr_discard,
     .zerofill = afr_zerofill,
+    .copy_file_range = afr_copy_file_range,
     .xattrop = afr_xattrop,
     .fxattrop = afr_fxattrop,
     .fsync = afr_fsync,
@@ -862,6 +956,38 @@ struct volume_options options[] = {
          "4 = brick having the least network ping latency.\n"
          "5 = Hybrid mode between 3 and 4, ie least value among "
          "network-latency multiplied by outstanding-read-requests."},
+    {.key = {"read-hedge-percentile"},
+     .type = GF_OPTION_TYPE_PERCENT,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "If a read has not been answered by its brick within "
+                    "this percentile of the recent read latencies, it is "
+                    "also sent to another readable brick and the first "
+                    "good answer is returned. 0 disables hedged reads."},
+    {.key = {"read-hedge-min-delay-usec"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 60000000,
+     .default_value = "1000",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC |
+              OPT_FLAG_RANGE,
+     .tags = {"replicate"},
+     .description = "Minimum time in microseconds a read waits for its "
+                    "brick before it is hedged."},
+    {.key = {"read-lease"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "Take a read lease on the files opened read-only and, "
+                    "while it is held, keep using the cached readable "
+                    "bricks of the file when bricks reconnect instead of "
+                    "looking them up again. Requires features.leases to "
+                    "be enabled on the volume."},
     {
         .key = {"choose-local"},
         .type = GF_OPTION_TYPE_BOOL,
@@ -997,6 +1123,42 @@ struct volume_options options[] = {
      .tags = {"replicate"},
      .description = "Maximum number of 128KB blocks per file for which "
                     "self-heal process would be applied simultaneously."},
+    {.key = {"data-self-heal-pipeline-depth"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 16,
+     .default_value = "4",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC |
+              OPT_FLAG_RANGE,
+     .tags = {"replicate"},
+     .description = "Maximum number of self-heal-window-size windows of a "
+                    "file that are healed in parallel. The number actually "
+                    "used grows and shrinks with the response time of the "
+                    "bricks."},
+    {.key = {"entry-self-heal-batch-size"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 65536,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC |
+              OPT_FLAG_RANGE,
+     .tags = {"replicate"},
+     .description = "If non-zero, a full entry self-heal compares the "
+                    "listings of the directory on the bricks and heals only "
+                    "the names that differ, this many of them in parallel "
+                    "under one entry lock. 0 heals every name on its own."},
+    {.key = {"data-self-heal-xxhash"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "Ask bricks to compare blocks with xxhash instead of "
+                    "SHA256 during \"diff\" self-heal. Only bricks with "
+                    "storage.fips-mode-rchecksum enabled honour this, other "
+                    "bricks keep using their default checksum."},
     {.key = {"metadata-self-heal"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "off",
@@ -1173,6 +1335,36 @@ struct volume_options options[] = {
                        "post-operation phase of the transaction to "
                        "enhance overlap of adjacent write operations.",
     },
+    {
+        .key = {"write-batch-delay-usec"},
+        .type = GF_OPTION_TYPE_INT,
+        .min = 0,
+        .max = 1000000,
+        .default_value = "0",
+        .op_version = {GD_OP_VERSION_12_0},
+        .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC |
+                 OPT_FLAG_RANGE,
+        .tags = {"replicate"},
+        .description = "When other clients are waiting for the lock of a "
+                       "file, keep it for up to this many microseconds "
+                       "after a write so that the writes issued meanwhile "
+                       "share its pre-op and post-op. 0 releases the lock "
+                       "as soon as the in-flight writes complete.",
+    },
+    {
+        .key = {"write-batch-size"},
+        .type = GF_OPTION_TYPE_INT,
+        .min = 1,
+        .max = 65536,
+        .default_value = "64",
+        .op_version = {GD_OP_VERSION_12_0},
+        .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC |
+                 OPT_FLAG_RANGE,
+        .tags = {"replicate"},
+        .description = "Maximum number of writes that share one lock of a "
+                       "file other clients are waiting for, when "
+                       "write-batch-delay-usec is set.",
+    },
     {
         .key = {"self-heal-readdir-size"},
         .type = GF_OPTION_TYPE_SIZET,
@@ -1275,6 +1467,18 @@ struct volume_options options[] = {
         .description = "This option can be used to control number of heals"
                        " that can wait in SHD per subvolume.",
     },
+    {
+        .key = {"shd-parallel-index-sweep"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .op_version = {GD_OP_VERSION_12_0},
+        .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+        .tags = {"replicate"},
+        .description = "If this option is enabled, SHD sweeps the xattrop, "
+                       "dirty and entry-changes indices of a brick at the "
+                       "same time, each with up to shd-max-threads heals "
+                       "in flight.",
+    },
     {
         .key = {"locking-scheme"},
         .type = GF_OPTION_TYPE_STR,
@@ -1306,6 +1510,18 @@ struct volume_options options[] = {
                        "granular way of recording changelogs and doing entry "
                        "self-heal.",
     },
+    {
+        .key = {"granular-data-heal"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "no",
+        .op_version = {GD_OP_VERSION_12_0},
+        .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+        .tags = {"replicate"},
+        .description = "If this option is enabled, the regions of a file "
+                       "written while a brick is down are recorded on the "
+                       "other bricks, and data self-heal copies only those "
+                       "regions to it.",
+    },
     {
         .key = {"favorite-child-policy"},
         .type = GF_OPTION_TYPE_STR,
@@ -16,6 +16,7 @@
 #include "afr-mem-types.h"
 
 #include <glusterfs/syncop.h>
+#include <glusterfs/region-map.h>
 
 #include "afr-self-heald.h"
 #include "afr-messages.h"
@@ -38,11 +39,31 @@
 #define AFR_LK_HEAL_DOM "afr.lock-heal.domain"
 
 #define AFR_HALO_MAX_LATENCY 99999
+/* Histogram of the writes per eager-lock acquisition, in powers of two */
+#define AFR_WRITE_BATCH_BUCKETS 8
+/* Histogram of the readv latencies, in powers of two of microseconds */
+#define AFR_READ_LATENCY_BUCKETS 24
+/* Names of a bulk entry heal batch that are healed at the same time */
+#define AFR_ENTRY_HEAL_MAX_WORKERS 16
 #define AFR_ANON_DIR_PREFIX ".glusterfs-anonymous-inode"
 
 #define PFLAG_PENDING (1 << 0)
 #define PFLAG_SBRAIN (1 << 1)
 
+/* Regions of a file written while some brick missed the writes, kept in
+ * AFR_REGION_MAP_XATTR.<shift> as a bitmap where each bit covers
+ * (1 << shift) bytes. The last bit covers everything up to EOF.
+ * AFR_REGION_XATTR.<brick> counts the post-ops blaming that brick whose
+ * regions were recorded. */
+#define AFR_REGION_XATTR AFR_XATTR_PREFIX ".regions"
+#define AFR_REGION_MAP_XATTR AFR_REGION_XATTR ".map"
+#define AFR_REGION_MAP_BITS GF_REGION_MAP_BITS
+#define AFR_REGION_MAP_SIZE GF_REGION_MAP_SIZE
+#define AFR_REGION_MIN_SHIFT GF_REGION_MIN_SHIFT
+#define AFR_REGION_MAX_SHIFT GF_REGION_MAX_SHIFT
+#define AFR_REGION_SHIFTS GF_REGION_SHIFTS
+#define AFR_REGION_LOST GF_REGION_LOST
+
 typedef int (*afr_lock_cbk_t)(call_frame_t *frame, xlator_t *this);
 
 typedef int (*afr_read_txn_wind_t)(call_frame_t *frame, xlator_t *this,
@@ -196,6 +217,15 @@ typedef struct _afr_private {
     afr_data_self_heal_type_t data_self_heal_algorithm;
     unsigned int data_self_heal_window_size; /* max number of pipelined
                                                 read/writes */
+    uint32_t data_self_heal_pipeline_depth; /* max number of windows healed
+                                               at the same time */
+    gf_boolean_t data_self_heal_xxhash; /* use xxhash for diff heal
+                                           block checksums */
+    uint32_t entry_heal_batch; /* names healed under one entry lock in bulk
+                                  full entry heals, 0 heals name by name */
+    gf_atomic_t entry_heal_names_compared;
+    gf_atomic_t entry_heal_names_healed;
+    gf_atomic_t entry_heal_usec;
 
     struct list_head heal_waiting; /*queue for files that need heal*/
     uint32_t heal_wait_qlen; /*configurable queue length for heal_waiting*/
@@ -226,6 +256,30 @@ typedef struct _afr_private {
     gf_boolean_t eager_lock;
     gf_boolean_t pre_op_compat; /* on/off */
     uint32_t post_op_delay_secs;
+    /* Under contention, keep the eager-lock for up to write_batch_usec
+       after a write so that up to write_batch_size writes share the lock,
+       the pre-op and the post-op. */
+    uint32_t write_batch_usec;
+    uint32_t write_batch_size;
+    gf_atomic_t write_batches[AFR_WRITE_BATCH_BUCKETS];
+    /* A readv not answered within the read_hedge_pct percentile of the
+       recent readv latencies, and at least read_hedge_min_delay usecs, is
+       also sent to another readable brick. */
+    double read_hedge_pct;
+    uint32_t read_hedge_min_delay;
+    gf_atomic_t read_latency[AFR_READ_LATENCY_BUCKETS];
+    gf_atomic_t read_hedges_sent;
+    gf_atomic_t read_hedges_won;
+    /* Files opened read-only are read-leased with read_lease_id, and their
+       cached readable set is trusted across connection events as long as
+       the lease is held and no brick went down since it was granted. */
+    gf_boolean_t read_lease;
+    gf_boolean_t read_lease_unsupported; /* the bricks answered ENOSYS */
+    uuid_t read_lease_id;
+    gf_atomic_t down_generation; /* Number of CHILD_DOWN events */
+    gf_atomic_t read_leases_granted;
+    gf_atomic_t read_leases_recalled;
+    gf_atomic_t read_lease_refreshes_skipped;
     unsigned int quorum_count;
 
     off_t ta_notify_dom_lock_offset;
@@ -270,6 +324,8 @@ typedef struct _afr_private {
 
     gf_boolean_t full_lock;
     gf_boolean_t esh_granular;
+    gf_boolean_t dsh_granular; /* record the regions to data heal */
+    char **region_key;
     gf_boolean_t consistent_io;
     gf_boolean_t data_self_heal; /* on/off */
 
@@ -371,7 +427,9 @@ struct afr_reply {
     /* For rchecksum */
     uint8_t checksum[SHA256_DIGEST_LENGTH];
     gf_boolean_t buf_has_zeroes;
+    gf_boolean_t buf_is_hole;
     gf_boolean_t fips_mode_rchecksum;
+    gf_boolean_t xxhash_rchecksum;
     /* For lookup */
     int8_t need_heal;
 };
@@ -419,10 +477,19 @@ typedef struct _afr_inode_lock_t {
                                *conflicting transactions to complete*/
     struct list_head frozen;  /*Transactions that need to go as part of
                                * next batch of eager-lock*/
+    /* Transactions that shared the current acquisition of the lock */
+    uint32_t batch_count;
     gf_boolean_t release;
     gf_boolean_t acquired;
 } afr_lock_t;
 
+typedef enum {
+    AFR_READ_LEASE_NONE,
+    AFR_READ_LEASE_ACQUIRING,
+    AFR_READ_LEASE_HELD,
+    AFR_READ_LEASE_RELEASING,
+} afr_read_lease_state_t;
+
 typedef struct _afr_inode_ctx {
     uint64_t read_subvol;
     uint64_t write_subvol;
@@ -447,6 +514,17 @@ typedef struct _afr_inode_ctx {
        (i.e, without O_SYNC or O_DSYNC)
     */
     gf_boolean_t witnessed_unstable_write;
+
+    /* Regions written while some brick missed the writes, not yet
+     * recorded on the bricks. */
+    uint8_t *region_map;
+    uint32_t region_shift;
+    uint32_t region_gen;
+
+    /* State of the read lease taken by this client, and the number of
+     * CHILD_DOWN events seen when it was requested. */
+    afr_read_lease_state_t read_lease;
+    uint32_t read_lease_down_gen;
 } afr_inode_ctx_t;
 
 typedef struct _afr_local {
@@ -738,6 +816,16 @@ typedef struct _afr_local {
             off_t len;
         } zerofill;
 
+        struct {
+            fd_t *fd_in;
+            off64_t off_in;
+            off64_t off_out;
+            size_t len;
+            uint32_t flags;
+            struct iatt stbuf;
+            struct iatt *stbufs; /* per child */
+        } copy_file_range;
+
         struct {
             char *volume;
             int32_t cmd;
@@ -871,6 +959,14 @@ typedef struct _afr_local {
         gf_boolean_t uninherit_value;
 
         gf_boolean_t disable_delayed_post_op;
+
+        /* @region_post_op: post-op xattrs waiting for the dirty regions
+           of the inode to be recorded on the bricks.
+           @region_gen: generation of the regions being recorded.
+        */
+        dict_t *region_post_op;
+        uint32_t region_gen;
+        gf_boolean_t region_failed;
     } transaction;
 
     syncbarrier_t barrier;
@@ -947,6 +1043,15 @@ afr_inode_read_subvol_get(inode_t *inode, xlator_t *this,
 int
 afr_inode_need_refresh_set(inode_t *inode, xlator_t *this);
 
+void
+afr_read_lease_acquire(xlator_t *this, inode_t *inode);
+
+gf_boolean_t
+afr_read_lease_trusted(xlator_t *this, inode_t *inode);
+
+void
+afr_read_lease_xdata_set(xlator_t *this, inode_t *inode, dict_t **xdata);
+
 int
 afr_read_subvol_select_by_policy(inode_t *inode, xlator_t *this,
                                  unsigned char *readable,
@@ -2440,6 +2440,10 @@ dht_lookup_everywhere_done(call_frame_t *frame, xlator_t *this)
                          "unlink on hashed is not skipped %s",
                          local->loc.path);
 
+            /* Unless some subvolume could not tell */
+            if (local->op_errno == ENOENT)
+                dht_entry_cache_missing(this, local);
+
             DHT_STACK_UNWIND(lookup, frame, -1, ENOENT, NULL, NULL, NULL, NULL);
         }
         return 0;
@@ -2870,6 +2874,8 @@ dht_lookup_everywhere(call_frame_t *frame, xlator_t *this, loc_t *loc)
     if (!local->inode)
         local->inode = inode_ref(loc->inode);
 
+    GF_ATOMIC_INC(conf->lookup_everywhere_cnt);
+
     gf_msg_debug(this->name, 0, "winding lookup call to %d subvols", call_cnt);
 
     for (i = 0; i < call_cnt; i++) {
@@ -2974,6 +2980,9 @@ dht_lookup_linkfile_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         dht_inode_ctx_time_update(local->loc.parent, this, NULL, postparent);
     }
 
+    if (!op_ret)
+        dht_entry_cache_linkto(this, local, prev, stbuf->ia_gfid);
+
 unwind:
     DHT_STRIP_PHASE1_FLAGS(stbuf);
     dht_set_fixed_dir_stat(postparent);
@@ -2983,6 +2992,8 @@ unwind:
     return 0;
 
 err:
+    if (local->entry_cache_lookup)
+        dht_entry_cache_invalidate(this, loc->parent, loc->name);
     dht_lookup_everywhere(frame, this, loc);
 out:
     return 0;
@@ -3183,6 +3194,9 @@ out:
         dht_inode_ctx_time_update(local->loc.parent, this, NULL, postparent);
     }
 
+    if ((op_ret == -1) && (op_errno == ENOENT) && local)
+        dht_entry_cache_missing(this, local);
+
     DHT_STRIP_PHASE1_FLAGS(stbuf);
     dht_set_fixed_dir_stat(postparent);
     DHT_STACK_UNWIND(lookup, frame, op_ret, op_errno, inode, stbuf, xattr,
@@ -3277,6 +3291,8 @@ dht_do_fresh_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc)
     int ret = -1;
     dht_conf_t *conf = NULL;
     xlator_t *hashed_subvol = NULL;
+    xlator_t *cached_subvol = NULL;
+    int cache_errno = 0;
     dht_local_t *local = NULL;
     int op_errno = -1;
     int call_cnt = 0;
@@ -3355,6 +3371,23 @@ dht_do_fresh_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc)
         return 0;
     }
 
+    cached_subvol = dht_entry_cache_lookup(this, local, &cache_errno);
+    if (cache_errno == ENOENT) {
+        gf_msg_debug(this->name, 0, "%s: known to be missing", loc->path);
+        DHT_STACK_UNWIND(lookup, frame, -1, ENOENT, NULL, NULL, NULL, NULL);
+        return 0;
+    }
+
+    if (cached_subvol) {
+        /* The hashed subvolume only has a linkto file to it */
+        gf_msg_debug(this->name, 0, "%s: Calling lookup on cached %s",
+                     loc->path, cached_subvol->name);
+        STACK_WIND_COOKIE(frame, dht_lookup_linkfile_cbk, cached_subvol,
+                          cached_subvol, cached_subvol->fops->lookup, loc,
+                          local->xattr_req);
+        return 0;
+    }
+
     /* if the hashed_subvol is non-null, send the lookup there first so
      * as to see whether we have a file or a directory */
     gf_msg_debug(this->name, 0, "%s: Calling fresh lookup on %s", loc->path,
@@ -3532,11 +3565,16 @@ dht_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xattr_req)
         }
     }
 
+    /* The replies of the subvolumes are merged, they need full iatts */
     if (xattr_req) {
-        local->xattr_req = dict_ref(xattr_req);
+        local->xattr_req = dict_ref_iatt_mask_full(xattr_req);
     } else {
         local->xattr_req = dict_new();
     }
+    if (!local->xattr_req) {
+        op_errno = ENOMEM;
+        goto err;
+    }
 
     /* Nameless lookup */
 
@@ -6368,6 +6406,11 @@ dht_statfs_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
         }
     }
 
+    /* Unless quota made it up, this is the usage of the subvolume and
+     * saves the disk usage refresh from asking for it */
+    if ((op_ret == 0) && statvfs && !event && !simple_quota)
+        dht_du_update(this, (xlator_t *)cookie, statvfs);
+
     LOCK(&frame->lock);
     {
         if (simple_quota) {
@@ -6549,8 +6592,9 @@ dht_statfs(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
     local->call_cnt = conf->subvolume_cnt;
 
     for (i = 0; i < conf->subvolume_cnt; i++) {
-        STACK_WIND(frame, dht_statfs_cbk, conf->subvolumes[i],
-                   conf->subvolumes[i]->fops->statfs, loc, xdata);
+        STACK_WIND_COOKIE(frame, dht_statfs_cbk, conf->subvolumes[i],
+                          conf->subvolumes[i],
+                          conf->subvolumes[i]->fops->statfs, loc, xdata);
     }
     return 0;
 
@@ -6749,6 +6793,297 @@ dht_queue_readdir(call_frame_t *frame, xlator_t *xl, off_t offset,
     }
 }
 
+static int
+dht_readdirp_fanout_idx(dht_conf_t *conf, dht_readdirp_fanout_t *fanout,
+                        xlator_t *subvol)
+{
+    int i = 0;
+
+    for (i = 0; i < fanout->cnt; i++) {
+        if (conf->subvolumes[i] == subvol)
+            return i;
+    }
+
+    return -1;
+}
+
+/* Linkto files are dropped as soon as they arrive so that they don't take
+ * room in the slots. If a whole chunk was made of them, the subvolume is
+ * read on before the slot is marked ready. */
+static int
+dht_readdirp_prefetch_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                          int op_ret, int op_errno, gf_dirent_t *orig_entries,
+                          dict_t *xdata)
+{
+    dht_local_t *local = NULL;
+    dht_conf_t *conf = NULL;
+    dht_readdirp_fanout_t *fanout = NULL;
+    dht_readdirp_slot_t *slot = NULL;
+    gf_dirent_t *orig_entry = NULL;
+    gf_dirent_t *tmp = NULL;
+    xlator_t *prev = NULL;
+    off_t next_offset = 0;
+    int count = 0;
+    gf_boolean_t read_on = _gf_false;
+
+    prev = cookie;
+    local = frame->local;
+    conf = this->private;
+    fanout = local->fanout;
+    slot = &fanout->slots[local->fanout_idx];
+
+    if (op_ret > 0) {
+        list_for_each_entry_safe(orig_entry, tmp, &orig_entries->list, list)
+        {
+            next_offset = orig_entry->d_off;
+
+            if (check_is_linkfile(NULL, (&orig_entry->d_stat),
+                                  orig_entry->dict, conf->link_xattr_name)) {
+                gf_dirent_entry_free(orig_entry);
+                continue;
+            }
+            count++;
+        }
+
+        if ((count == 0) && (next_offset != 0) && (op_errno != ENOENT))
+            read_on = _gf_true;
+    }
+
+    LOCK(&fanout->lock);
+    {
+        /* The slot may have been dropped and read again meanwhile */
+        if ((slot->state != DHT_READDIRP_INFLIGHT) ||
+            (slot->offset != local->queue_offset)) {
+            read_on = _gf_false;
+            goto unlock;
+        }
+
+        if (read_on)
+            goto unlock;
+
+        if (op_ret < 0) {
+            slot->state = DHT_READDIRP_IDLE;
+            goto unlock;
+        }
+
+        list_splice_init(&orig_entries->list, &slot->entries.list);
+        slot->count = count;
+        slot->next = next_offset;
+        slot->op_errno = op_errno;
+        slot->state = DHT_READDIRP_READY;
+    }
+unlock:
+    UNLOCK(&fanout->lock);
+
+    if (read_on) {
+        STACK_WIND_COOKIE(frame, dht_readdirp_prefetch_cbk, prev, prev,
+                          prev->fops->readdirp, local->fd, local->size,
+                          next_offset, local->xattr);
+        return 0;
+    }
+
+    DHT_STACK_DESTROY(frame);
+
+    return 0;
+}
+
+/* Reads the entries of the subvolume at @idx from @offset into its slot,
+ * unless the slot is already busy. */
+static void
+dht_readdirp_prefetch(call_frame_t *frame, xlator_t *this, int idx,
+                      off_t offset)
+{
+    dht_local_t *local = NULL;
+    dht_local_t *prefetch_local = NULL;
+    dht_conf_t *conf = NULL;
+    dht_readdirp_fanout_t *fanout = NULL;
+    dht_readdirp_slot_t *slot = NULL;
+    call_frame_t *prefetch_frame = NULL;
+    xlator_t *subvol = NULL;
+    gf_boolean_t busy = _gf_false;
+
+    local = frame->local;
+    conf = this->private;
+    fanout = local->fanout;
+    slot = &fanout->slots[idx];
+    subvol = conf->subvolumes[idx];
+
+    if (!conf->subvolume_status[idx])
+        return;
+
+    LOCK(&fanout->lock);
+    {
+        if (slot->state != DHT_READDIRP_IDLE) {
+            busy = _gf_true;
+        } else {
+            slot->state = DHT_READDIRP_INFLIGHT;
+            slot->offset = offset;
+            slot->size = local->size;
+        }
+    }
+    UNLOCK(&fanout->lock);
+
+    if (busy)
+        return;
+
+    prefetch_frame = copy_frame(frame);
+    if (!prefetch_frame)
+        goto err;
+
+    prefetch_local = dht_local_init(prefetch_frame, NULL, local->fd,
+                                    GF_FOP_READDIRP);
+    if (!prefetch_local)
+        goto err;
+
+    prefetch_local->fanout = fanout;
+    prefetch_local->fanout_idx = idx;
+    prefetch_local->size = local->size;
+    prefetch_local->queue_offset = offset;
+    prefetch_local->xattr = dict_copy_with_ref(local->xattr, NULL);
+    if (!prefetch_local->xattr)
+        goto err;
+
+    if (conf->readdir_optimize == _gf_true) {
+        if (subvol != local->first_up_subvol) {
+            if (dict_set_int32(prefetch_local->xattr, GF_READDIR_SKIP_DIRS,
+                               1))
+                goto err;
+        } else {
+            dict_del(prefetch_local->xattr, GF_READDIR_SKIP_DIRS);
+        }
+    }
+
+    STACK_WIND_COOKIE(prefetch_frame, dht_readdirp_prefetch_cbk, subvol,
+                      subvol, subvol->fops->readdirp, prefetch_local->fd,
+                      prefetch_local->size, offset, prefetch_local->xattr);
+    return;
+
+err:
+    LOCK(&fanout->lock);
+    {
+        slot->state = DHT_READDIRP_IDLE;
+    }
+    UNLOCK(&fanout->lock);
+
+    if (prefetch_frame)
+        DHT_STACK_DESTROY(prefetch_frame);
+}
+
+/* Starts reading the subvolumes that will be listed after the one at @idx.
+ * Their first entries are always requested at offset 0. */
+static void
+dht_readdirp_prefetch_ahead(call_frame_t *frame, xlator_t *this, int idx)
+{
+    dht_conf_t *conf = NULL;
+    dht_local_t *local = NULL;
+    int i = 0;
+
+    conf = this->private;
+    local = frame->local;
+
+    for (i = idx + 1;
+         (i < local->fanout->cnt) && (i <= idx + conf->readdirp_fanout); i++)
+        dht_readdirp_prefetch(frame, this, i, 0);
+}
+
+/* Drops the entries read ahead, when the directory is read again from the
+ * beginning. */
+static void
+dht_readdirp_fanout_reset(dht_readdirp_fanout_t *fanout)
+{
+    gf_dirent_t entries;
+    int i = 0;
+
+    INIT_LIST_HEAD(&entries.list);
+
+    LOCK(&fanout->lock);
+    {
+        for (i = 0; i < fanout->cnt; i++) {
+            if (fanout->slots[i].state != DHT_READDIRP_READY)
+                continue;
+            list_splice_init(&fanout->slots[i].entries.list, &entries.list);
+            fanout->slots[i].state = DHT_READDIRP_IDLE;
+        }
+    }
+    UNLOCK(&fanout->lock);
+
+    gf_dirent_free(&entries);
+}
+
+/* Sends a READDIRP to @xl, or answers it with the entries read ahead for
+ * it. In the latter case @cbk is called before returning, like it happens
+ * when parallel-readdir has the entries cached. The cookie and the d_off
+ * of the entries are the ones the subvolume returned, so the order of the
+ * listing and the offsets handed out are the same as without read ahead. */
+static void
+dht_readdirp_wind(call_frame_t *frame, xlator_t *xl, off_t offset,
+                  fop_readdirp_cbk_t cbk)
+{
+    dht_local_t *local = NULL;
+    dht_conf_t *conf = NULL;
+    dht_readdirp_fanout_t *fanout = NULL;
+    dht_readdirp_slot_t *slot = NULL;
+    xlator_t *this = NULL;
+    gf_dirent_t entries;
+    off_t next_offset = 0;
+    int op_ret = 0;
+    int op_errno = 0;
+    int idx = -1;
+    gf_boolean_t hit = _gf_false;
+
+    local = frame->local;
+    this = frame->this;
+    conf = this->private;
+    fanout = local->fanout;
+
+    if (fanout)
+        idx = dht_readdirp_fanout_idx(conf, fanout, xl);
+
+    if (idx < 0) {
+        STACK_WIND_COOKIE(frame, cbk, xl, xl, xl->fops->readdirp, local->fd,
+                          local->size, offset, local->xattr);
+        return;
+    }
+
+    INIT_LIST_HEAD(&entries.list);
+
+    LOCK(&fanout->lock);
+    {
+        slot = &fanout->slots[idx];
+        if (slot->state == DHT_READDIRP_READY) {
+            if ((slot->offset == offset) && (slot->size <= local->size)) {
+                hit = _gf_true;
+                op_ret = slot->count;
+                op_errno = slot->op_errno;
+                next_offset = slot->next;
+            }
+            /* Entries that don't answer this request are stale */
+            list_splice_init(&slot->entries.list, &entries.list);
+            slot->state = DHT_READDIRP_IDLE;
+        }
+    }
+    UNLOCK(&fanout->lock);
+
+    if (!hit) {
+        gf_dirent_free(&entries);
+        GF_ATOMIC_INC(conf->readdirp_fanout_misses);
+        dht_readdirp_prefetch_ahead(frame, this, idx);
+        STACK_WIND_COOKIE(frame, cbk, xl, xl, xl->fops->readdirp, local->fd,
+                          local->size, offset, local->xattr);
+        return;
+    }
+
+    GF_ATOMIC_INC(conf->readdirp_fanout_hits);
+
+    if ((op_ret > 0) && (next_offset != 0) && (op_errno != ENOENT))
+        dht_readdirp_prefetch(frame, this, idx, next_offset);
+    dht_readdirp_prefetch_ahead(frame, this, idx);
+
+    cbk(frame, xl, this, op_ret, op_errno, &entries, NULL);
+
+    gf_dirent_free(&entries);
+}
+
 /* Execute a READDIRP request if no other request is in progress. Otherwise
  * queue it to be executed when the current one finishes. */
 static void
@@ -6766,9 +7101,8 @@ dht_queue_readdirp(call_frame_t *frame, xlator_t *xl, off_t offset,
     /* Check dht_queue_readdir() comments for an explanation of this. */
     if (uatomic_add_return(&local->queue, 1) == 1) {
         do {
-            STACK_WIND_COOKIE(frame, cbk, local->queue_xl, local->queue_xl,
-                              local->queue_xl->fops->readdirp, local->fd,
-                              local->size, local->queue_offset, local->xattr);
+            dht_readdirp_wind(frame, local->queue_xl, local->queue_offset,
+                              cbk);
         } while ((queue = uatomic_sub_return(&local->queue, 1)) > 0);
 
         if (queue < 0) {
@@ -7299,6 +7633,13 @@ dht_do_readdir(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
             }
         }
 
+        if (local->xattr && (conf->readdirp_fanout > 0) &&
+            (conf->subvolume_cnt > 1)) {
+            local->fanout = dht_fd_ctx_readdirp_get(this, fd);
+            if (local->fanout && (yoff == 0))
+                dht_readdirp_fanout_reset(local->fanout);
+        }
+
         dht_queue_readdirp(frame, xvol, yoff, dht_readdirp_cbk);
     } else {
         dht_queue_readdir(frame, xvol, yoff, dht_readdir_cbk);
@@ -8477,6 +8818,8 @@ dht_link(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
         op_errno = ENOMEM;
         goto err;
     }
+    if (local->entry_cache_inval)
+        dht_entry_cache_invalidate(this, newloc->parent, newloc->name);
     if (xdata)
         local->xattr_req = dict_ref(xdata);
 
@@ -10985,6 +11328,7 @@ dht_forget(xlator_t *this, inode_t *inode)
     layout = ctx->layout;
     ctx->layout = NULL;
     dht_layout_unref(layout);
+    dht_entry_cache_free(ctx->entry_cache);
     GF_FREE(ctx);
 
     return 0;
@@ -11052,6 +11396,7 @@ dht_notify(xlator_t *this, int event, void *data, ...)
 
             /* one of the node came back up, do a stat update */
             dht_get_du_info_for_subvol(this, cnt);
+            dht_du_refresh_start(this);
 
             break;
 
@@ -11174,6 +11519,8 @@ dht_notify(xlator_t *this, int event, void *data, ...)
                 break;
             up_ci = (struct gf_upcall_cache_invalidation *)up_data->data;
 
+            dht_entry_cache_upcall(this, up_data);
+
             /* Since md-cache will be aggressively filtering lookups,
              * the stale layout issue will be more pronounced. Hence
              * when a layout xattr is changed by the rebalance process
@@ -11187,6 +11534,10 @@ dht_notify(xlator_t *this, int event, void *data, ...)
             if (IS_DHT_LINKFILE_MODE(&up_ci->stat))
                 up_ci->flags |= UP_EXPLICIT_LOOKUP;
 
+            propagate = 1;
+            break;
+        case GF_EVENT_PARENT_DOWN:
+            dht_du_refresh_stop(this);
             propagate = 1;
             break;
         default:
@@ -11432,6 +11783,12 @@ dht_release(xlator_t *this, fd_t *fd)
     return dht_fd_ctx_destroy(this, fd);
 }
 
+int32_t
+dht_releasedir(xlator_t *this, fd_t *fd)
+{
+    return dht_fd_ctx_destroy(this, fd);
+}
+
 static int
 dht_pt_mkdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
                  int op_errno, inode_t *inode, struct iatt *stbuf,
@@ -75,6 +75,22 @@ struct dht_layout_entry {
 
 typedef struct dht_layout_entry dht_layout_entry_t;
 
+/* Layouts with at least this many entries are searched through a sorted
+ * copy of their ranges instead of a linear scan. */
+#define DHT_LAYOUT_INDEX_MIN_CNT 64
+
+struct dht_layout_range {
+    uint32_t start;
+    uint32_t stop;
+    int idx; /* position of the range in layout->list[] */
+};
+
+struct dht_layout_index {
+    int cnt; /* 0 if the ranges overlap and cannot be searched */
+    struct dht_layout_range range[];
+};
+typedef struct dht_layout_index dht_layout_index_t;
+
 struct dht_layout {
     int spread_cnt; /* layout spread count per directory,
                        is controlled by 'setxattr()' with
@@ -99,6 +115,8 @@ struct dht_layout {
     int type;
     gf_atomic_t ref; /* use with dht_conf_t->layout_lock */
     uint32_t search_unhashed;
+    /* Built on the first search, once the layout is in use. */
+    dht_layout_index_t *index;
     dht_layout_entry_t list[];
 };
 typedef struct dht_layout dht_layout_t;
@@ -114,11 +132,37 @@ struct dht_stat_time {
 
 typedef struct dht_stat_time dht_stat_time_t;
 
+#define DHT_ENTRY_CACHE_SLOTS 64
+
+typedef enum {
+    DHT_ENTRY_CACHE_NONE,
+    DHT_ENTRY_CACHE_MISSING,
+    DHT_ENTRY_CACHE_LINKTO,
+} dht_entry_cache_state_t;
+
+struct dht_entry_cache_slot {
+    char *name;
+    uint32_t name_hash;
+    uint32_t commit_hash; /* of the directory layout when recorded */
+    time_t expire;
+    dht_entry_cache_state_t state;
+    xlator_t *cached; /* holds the data file of a LINKTO entry */
+    uuid_t gfid;
+};
+
+/* Names of a directory known to be missing, or whose data file is known
+ * to be on another subvolume than the hashed one */
+typedef struct dht_entry_cache {
+    gf_lock_t lock;
+    struct dht_entry_cache_slot slots[DHT_ENTRY_CACHE_SLOTS];
+} dht_entry_cache_t;
+
 struct dht_inode_ctx {
     dht_layout_t *layout;
     dht_stat_time_t time;
     xlator_t *lock_subvol;
     xlator_t *mds_subvol; /* This is only used for directories */
+    dht_entry_cache_t *entry_cache; /* This is only used for directories */
 };
 
 typedef struct dht_inode_ctx dht_inode_ctx_t;
@@ -345,6 +389,16 @@ struct dht_local {
     off_t queue_offset;
     int32_t queue;
 
+    /* readdirp entries read ahead on the other subvolumes */
+    struct dht_readdirp_fanout *fanout;
+    int fanout_idx;
+
+    /* entry cache generation when a fresh lookup started */
+    uint64_t entry_cache_gen;
+    gf_boolean_t entry_cache_lookup;
+    /* the entry op changes the names in loc/loc2 */
+    gf_boolean_t entry_cache_inval;
+
     int32_t mds_heal_fresh_lookup;
 
     /* inodelks during filerename for backward compatibility */
@@ -393,9 +447,20 @@ struct dht_du {
     uint32_t total_blocks;
     uint32_t avail_blocks;
     uint32_t frsize; /*fragment size*/
+
+    /* DHT_DU_FILLED_* as of the last refresh, read without the lock */
+    gf_atomic_t filled;
+    uint64_t latency;   /* average statfs round trip, in usecs */
+    uint64_t refreshes; /* refreshes answered so far */
+    struct timespec sent;
+    time_t next_refresh;
+    gf_boolean_t refreshing;
 };
 typedef struct dht_du dht_du_t;
 
+#define DHT_DU_FILLED_SPACE 0x1
+#define DHT_DU_FILLED_INODES 0x2
+
 typedef struct gf_defrag_pattern_list gf_defrag_pattern_list_t;
 
 struct gf_defrag_pattern_list {
@@ -478,6 +543,13 @@ struct gf_defrag_info_ {
     gf_boolean_t stats;
     /* lock migration flag */
     gf_boolean_t lock_migration_enabled;
+
+    /* fix-layout crawl */
+    int32_t fix_layout_threads;
+    char *fix_layout_checkpoint;
+    void *fix_layout_crawl;
+    gf_atomic_t fix_layout_dirs_found;
+    gf_atomic_t fix_layout_dirs_done;
 };
 
 typedef struct gf_defrag_info_ gf_defrag_info_t;
@@ -522,6 +594,8 @@ struct dht_conf {
     /* Support regex-based name reinterpretation. */
     regex_t rsync_regex;
     regex_t extra_regex;
+    /* Changed with the regexes, invalidates the cached name hashes. */
+    gf_atomic_t hash_cookie;
 
     /* Support variable xattr names. */
     char *xattr_name;
@@ -567,6 +641,14 @@ struct dht_conf {
 
     gf_boolean_t force_migration;
 
+    /* Most blocks of a file migrated at once, and the rate in bytes per
+     * second all the migrations of this process are kept under */
+    int32_t rebal_window;
+    uint64_t rebal_rate_limit;
+    gf_lock_t rebal_rate_lock;
+    double rebal_rate_tokens;
+    struct timespec rebal_rate_stamp;
+
     gf_boolean_t lookup_optimize;
 
     gf_boolean_t rmdir_optimize;
@@ -580,6 +662,30 @@ struct dht_conf {
     /* Request to filter directory entries in readdir request */
     gf_boolean_t readdir_optimize;
 
+    /* Number of subvolumes read ahead of the one being listed */
+    int32_t readdirp_fanout;
+    gf_atomic_t readdirp_fanout_hits;
+    gf_atomic_t readdirp_fanout_misses;
+
+    gf_boolean_t entry_cache;
+    int32_t entry_cache_timeout;
+    /* bumped on every invalidation, so that a lookup that raced with an
+     * entry op does not record what it saw */
+    gf_atomic_t entry_cache_gen;
+    gf_atomic_t entry_cache_missing_hits;
+    gf_atomic_t entry_cache_linkto_hits;
+    gf_atomic_t entry_cache_misses;
+    gf_atomic_t entry_cache_invalidations;
+    gf_atomic_t lookup_everywhere_cnt;
+
+    /* Refreshes the disk usage of the subvolumes in the background when
+     * refresh_interval is set */
+    gf_timer_t *du_timer;
+    gf_boolean_t du_timer_stopped;
+    /* Spread files over the subvolumes with free space by their free
+     * space and latency instead of using the one with the most */
+    gf_boolean_t du_weighted_placement;
+
     gf_boolean_t rsync_regex_valid;
 
     gf_boolean_t extra_regex_valid;
@@ -626,8 +732,32 @@ typedef struct dht_migrate_info {
     GF_REF_DECL;
 } dht_migrate_info_t;
 
+enum dht_readdirp_slot_state {
+    DHT_READDIRP_IDLE = 0,
+    DHT_READDIRP_INFLIGHT,
+    DHT_READDIRP_READY,
+};
+
+/* The next entries of one subvolume of a directory, read ahead. */
+typedef struct dht_readdirp_slot {
+    gf_dirent_t entries;
+    off_t offset; /* offset of the readdirp the entries answer */
+    off_t next;   /* offset the subvolume is read on from */
+    size_t size;
+    int count;
+    int op_errno;
+    int state;
+} dht_readdirp_slot_t;
+
+typedef struct dht_readdirp_fanout {
+    gf_lock_t lock;
+    int cnt;
+    dht_readdirp_slot_t slots[];
+} dht_readdirp_fanout_t;
+
 typedef struct dht_fd_ctx {
     uint64_t opened_on_dst;
+    dht_readdirp_fanout_t *readdirp; /* directory fds only */
     GF_REF_DECL;
 } dht_fd_ctx_t;
 
@@ -676,6 +806,8 @@ typedef struct dht_fd_ctx {
             __local = frame->local;                                            \
             frame->local = NULL;                                               \
         }                                                                      \
+        if (__local && __local->entry_cache_inval)                             \
+            dht_entry_cache_fop_done(frame->this, __local);                    \
         STACK_UNWIND_STRICT(fop, frame, params);                               \
         dht_local_wipe(__local);                                               \
     } while (0)
@@ -787,6 +919,9 @@ dht_subvol_cnt(xlator_t *this, xlator_t *subvol);
 int
 dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p);
 
+void
+dht_hash_cache_reset(dht_conf_t *conf);
+
 int
 dht_linkfile_create(call_frame_t *frame, fop_mknod_cbk_t linkfile_cbk,
                     xlator_t *this, xlator_t *tovol, xlator_t *fromvol,
@@ -815,6 +950,14 @@ dht_free_disk_available_subvol(xlator_t *this, xlator_t *subvol,
                                dht_local_t *layout);
 int
 dht_get_du_info_for_subvol(xlator_t *this, int subvol_idx);
+void
+dht_du_update(xlator_t *this, xlator_t *subvol, struct statvfs *statvfs);
+void
+dht_du_update_filled(xlator_t *this);
+void
+dht_du_refresh_start(xlator_t *this);
+void
+dht_du_refresh_stop(xlator_t *this);
 
 int
 dht_layout_preset(xlator_t *this, xlator_t *subvol, inode_t *inode);
@@ -1044,6 +1187,10 @@ int32_t
 dht_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
              off_t len, dict_t *xdata);
 int32_t
+dht_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata);
+int32_t
 dht_ipc(call_frame_t *frame, xlator_t *this, int32_t op, dict_t *xdata);
 
 int
@@ -1136,6 +1283,8 @@ dht_subvol_with_free_space_inodes(xlator_t *this, xlator_t *subvol,
 xlator_t *
 dht_subvol_maxspace_nonzeroinode(xlator_t *this, xlator_t *subvol,
                                  dht_layout_t *layout);
+xlator_t *
+dht_subvol_weighted_free_space(xlator_t *this, dht_layout_t *layout);
 int
 dht_dir_has_layout(dict_t *xattr, char *name);
 int
@@ -1198,6 +1347,30 @@ dht_fd_ctx_destroy(xlator_t *this, fd_t *fd);
 int32_t
 dht_release(xlator_t *this, fd_t *fd);
 
+int32_t
+dht_releasedir(xlator_t *this, fd_t *fd);
+
+dht_readdirp_fanout_t *
+dht_fd_ctx_readdirp_get(xlator_t *this, fd_t *fd);
+
+void
+dht_entry_cache_free(dht_entry_cache_t *ecache);
+void
+dht_entry_cache_invalidate(xlator_t *this, inode_t *parent, const char *name);
+void
+dht_entry_cache_fop_init(xlator_t *this, dht_local_t *local);
+void
+dht_entry_cache_fop_done(xlator_t *this, dht_local_t *local);
+xlator_t *
+dht_entry_cache_lookup(xlator_t *this, dht_local_t *local, int *op_errno);
+void
+dht_entry_cache_missing(xlator_t *this, dht_local_t *local);
+void
+dht_entry_cache_linkto(xlator_t *this, dht_local_t *local, xlator_t *cached,
+                       uuid_t gfid);
+void
+dht_entry_cache_upcall(xlator_t *this, void *data);
+
 int32_t
 dht_set_fixed_dir_stat(struct iatt *stat);
 
@@ -1245,6 +1418,12 @@ dht_fallocate_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
                   int op_errno, struct iatt *prebuf, struct iatt *postbuf,
                   dict_t *xdata);
 
+int
+dht_copy_file_range_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                        int op_ret, int op_errno, struct iatt *stbuf,
+                        struct iatt *prebuf, struct iatt *postbuf,
+                        dict_t *xdata);
+
 int
 dht_truncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
                  int op_errno, struct iatt *prebuf, struct iatt *postbuf,
@@ -15,13 +15,36 @@
 #include <sys/time.h>
 #include <glusterfs/events.h>
 
+/* Called with conf->subvolume_lock held */
 static int
-dht_du_info_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
-                int op_errno, struct statvfs *statvfs, dict_t *xdata)
+__dht_du_filled(dht_conf_t *conf, dht_du_t *du)
+{
+    int filled = 0;
+
+    if (conf->disk_unit_percent) {
+        if (du->avail_percent < conf->min_free_disk)
+            filled |= DHT_DU_FILLED_SPACE;
+    } else {
+        if (du->avail_space < conf->min_free_disk)
+            filled |= DHT_DU_FILLED_SPACE;
+    }
+
+    if (du->avail_inodes < conf->min_free_inodes)
+        filled |= DHT_DU_FILLED_INODES;
+
+    return filled;
+}
+
+/* Records the usage @subvol reported, and the time it took when it was
+ * asked for by the refresh. */
+static void
+dht_du_record(xlator_t *this, xlator_t *subvol, struct statvfs *statvfs,
+              gf_boolean_t refresh)
 {
     dht_conf_t *conf = NULL;
-    xlator_t *prev = NULL;
-    int this_call_cnt = 0;
+    dht_du_t *du = NULL;
+    struct timespec now;
+    uint64_t latency = 0;
     int i = 0;
     double percent = 0;
     double percent_inodes = 0;
@@ -30,16 +53,8 @@ dht_du_info_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     uint32_t chunks = 0;
 
     conf = this->private;
-    prev = cookie;
-
-    if (op_ret == -1 || !statvfs) {
-        gf_msg(this->name, GF_LOG_WARNING, op_errno,
-               DHT_MSG_GET_DISK_INFO_ERROR, "failed to get disk info from %s",
-               prev->name);
-        goto out;
-    }
 
-    if (statvfs->f_blocks) {
+    if (statvfs && statvfs->f_blocks) {
         percent = (statvfs->f_bavail * 100) / statvfs->f_blocks;
         bytes = (statvfs->f_bavail * statvfs->f_frsize);
         /*
@@ -54,7 +69,7 @@ dht_du_info_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
         chunks = (statvfs->f_blocks + bpc - 1) / bpc;
     }
 
-    if (statvfs->f_files) {
+    if (statvfs && statvfs->f_files) {
         percent_inodes = (statvfs->f_ffree * 100) / statvfs->f_files;
     } else {
         /*
@@ -67,33 +82,100 @@ dht_du_info_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
         percent_inodes = 100;
     }
 
+    if (refresh)
+        timespec_now(&now);
+
     LOCK(&conf->subvolume_lock);
     {
-        for (i = 0; i < conf->subvolume_cnt; i++)
-            if (prev == conf->subvolumes[i]) {
-                conf->du_stats[i].avail_percent = percent;
-                conf->du_stats[i].avail_space = bytes;
-                conf->du_stats[i].avail_inodes = percent_inodes;
-                conf->du_stats[i].chunks = chunks;
-                conf->du_stats[i].total_blocks = statvfs->f_blocks;
-                conf->du_stats[i].avail_blocks = statvfs->f_bavail;
-                conf->du_stats[i].frsize = statvfs->f_frsize;
-
-                gf_msg_debug(this->name, 0,
-                             "subvolume '%s': avail_percent "
-                             "is: %.2f and avail_space "
-                             "is: %" PRIu64
-                             " and avail_inodes"
-                             " is: %.2f",
-                             prev->name, conf->du_stats[i].avail_percent,
-                             conf->du_stats[i].avail_space,
-                             conf->du_stats[i].avail_inodes);
-                break; /* no point in looping further */
+        for (i = 0; i < conf->subvolume_cnt; i++) {
+            if (subvol != conf->subvolumes[i])
+                continue;
+
+            du = &conf->du_stats[i];
+            if (refresh) {
+                du->refreshing = _gf_false;
+                du->refreshes++;
+                if (du->sent.tv_sec) {
+                    latency = gf_tsdiff(&du->sent, &now) / 1000;
+                    /* Smooth out the odd slow reply */
+                    du->latency = du->latency
+                                      ? (du->latency * 7 + latency) / 8
+                                      : latency;
+                }
             }
+
+            if (!statvfs)
+                break;
+
+            du->avail_percent = percent;
+            du->avail_space = bytes;
+            du->avail_inodes = percent_inodes;
+            du->chunks = chunks;
+            du->total_blocks = statvfs->f_blocks;
+            du->avail_blocks = statvfs->f_bavail;
+            du->frsize = statvfs->f_frsize;
+            GF_ATOMIC_INIT(du->filled, __dht_du_filled(conf, du));
+
+            gf_msg_debug(this->name, 0,
+                         "subvolume '%s': avail_percent "
+                         "is: %.2f and avail_space "
+                         "is: %" PRIu64
+                         " and avail_inodes"
+                         " is: %.2f",
+                         subvol->name, du->avail_percent, du->avail_space,
+                         du->avail_inodes);
+            break; /* no point in looping further */
+        }
     }
     UNLOCK(&conf->subvolume_lock);
+}
+
+/* Takes the usage from a statfs reply that went through dht anyway */
+void
+dht_du_update(xlator_t *this, xlator_t *subvol, struct statvfs *statvfs)
+{
+    dht_du_record(this, subvol, statvfs, _gf_false);
+}
+
+/* Works the filled state of every subvolume out again when the limits
+ * change */
+void
+dht_du_update_filled(xlator_t *this)
+{
+    dht_conf_t *conf = NULL;
+    int i = 0;
+
+    conf = this->private;
+    if (!conf->du_stats)
+        return;
+
+    LOCK(&conf->subvolume_lock);
+    {
+        for (i = 0; i < conf->subvolume_cnt; i++)
+            GF_ATOMIC_INIT(conf->du_stats[i].filled,
+                           __dht_du_filled(conf, &conf->du_stats[i]));
+    }
+    UNLOCK(&conf->subvolume_lock);
+}
+
+static int
+dht_du_info_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
+                int op_errno, struct statvfs *statvfs, dict_t *xdata)
+{
+    xlator_t *prev = NULL;
+    int this_call_cnt = 0;
+
+    prev = cookie;
+
+    if (op_ret == -1 || !statvfs) {
+        gf_msg(this->name, GF_LOG_WARNING, op_errno,
+               DHT_MSG_GET_DISK_INFO_ERROR, "failed to get disk info from %s",
+               prev->name);
+        statvfs = NULL;
+    }
+
+    dht_du_record(this, prev, statvfs, _gf_true);
 
-out:
     this_call_cnt = dht_frame_return(frame);
     if (is_last_call(this_call_cnt))
         DHT_STACK_DESTROY(frame);
@@ -101,6 +183,14 @@ out:
     return 0;
 }
 
+/* Called with conf->subvolume_lock held */
+static void
+__dht_du_sent(dht_conf_t *conf, int subvol_idx)
+{
+    timespec_now(&conf->du_stats[subvol_idx].sent);
+    conf->du_stats[subvol_idx].refreshing = _gf_true;
+}
+
 int
 dht_get_du_info_for_subvol(xlator_t *this, int subvol_idx)
 {
@@ -126,14 +216,32 @@ dht_get_du_info_for_subvol(xlator_t *this, int subvol_idx)
         goto err;
     }
 
+    statfs_local->params = dict_new();
+    if (!statfs_local->params)
+        goto err;
+
+    if (dict_set_int8(statfs_local->params, GF_INTERNAL_IGNORE_DEEM_STATFS,
+                      1)) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_DICT_SET_FAILED,
+               "Failed to set " GF_INTERNAL_IGNORE_DEEM_STATFS " in dict");
+        goto err;
+    }
+
     /* make it root gfid, should be enough to get the proper info back */
     tmp_loc.gfid[15] = 1;
 
+    LOCK(&conf->subvolume_lock);
+    {
+        __dht_du_sent(conf, subvol_idx);
+    }
+    UNLOCK(&conf->subvolume_lock);
+
     statfs_local->call_cnt = 1;
     STACK_WIND_COOKIE(
         statfs_frame, dht_du_info_cbk, conf->subvolumes[subvol_idx],
         conf->subvolumes[subvol_idx],
-        conf->subvolumes[subvol_idx]->fops->statfs, &tmp_loc, NULL);
+        conf->subvolumes[subvol_idx]->fops->statfs, &tmp_loc,
+        statfs_local->params);
 
     return 0;
 err:
@@ -157,6 +265,11 @@ dht_get_du_info(call_frame_t *frame, xlator_t *this, loc_t *loc)
     time_t now;
 
     conf = this->private;
+
+    /* Kept up to date by the background refresh */
+    if (conf->refresh_interval)
+        return 0;
+
     now = gf_time();
     /* make it root gfid, should be enough to get the proper
        info back */
@@ -186,6 +299,13 @@ dht_get_du_info(call_frame_t *frame, xlator_t *this, loc_t *loc)
             goto err;
         }
 
+        LOCK(&conf->subvolume_lock);
+        {
+            for (i = 0; i < conf->subvolume_cnt; i++)
+                __dht_du_sent(conf, i);
+        }
+        UNLOCK(&conf->subvolume_lock);
+
         statfs_local->call_cnt = conf->subvolume_cnt;
         for (i = 0; i < conf->subvolume_cnt; i++) {
             STACK_WIND_COOKIE(statfs_frame, dht_du_info_cbk,
@@ -204,6 +324,135 @@ err:
     return -1;
 }
 
+/* Background refresh.
+ *
+ * With refresh_interval set, the usage of each subvolume is refreshed on
+ * its own schedule, every refresh_interval seconds give or take an eighth,
+ * so that the statfs calls of many clients and subvolumes do not line up.
+ * Creates then only read what was last recorded and never wait for, nor
+ * trigger, a refresh.
+ */
+
+static void
+dht_du_refresh_timer(void *data);
+
+/* Called with conf->lock held */
+static void
+__dht_du_refresh_arm(xlator_t *this)
+{
+    dht_conf_t *conf = this->private;
+    struct timespec delay = {
+        1,
+    };
+
+    if (conf->du_timer || conf->du_timer_stopped || !conf->refresh_interval)
+        return;
+
+    conf->du_timer = gf_timer_call_after(this->ctx, delay,
+                                         dht_du_refresh_timer, this);
+    if (!conf->du_timer)
+        gf_msg(this->name, GF_LOG_WARNING, ENOMEM, 0,
+               "failed to schedule the disk usage refresh");
+}
+
+static time_t
+dht_du_refresh_next(dht_conf_t *conf, time_t now)
+{
+    int32_t interval = conf->refresh_interval;
+    int32_t jitter = interval / 8;
+
+    if (jitter)
+        interval += (random() % (2 * jitter + 1)) - jitter;
+
+    return now + interval;
+}
+
+static void
+dht_du_refresh_timer(void *data)
+{
+    xlator_t *this = data;
+    dht_conf_t *conf = NULL;
+    time_t now = 0;
+    int i = 0;
+
+    conf = this->private;
+    if (!conf)
+        return;
+
+    LOCK(&conf->lock);
+    {
+        conf->du_timer = NULL;
+    }
+    UNLOCK(&conf->lock);
+
+    if (conf->du_timer_stopped || !conf->refresh_interval)
+        return;
+
+    now = gf_time();
+    for (i = 0; i < conf->subvolume_cnt; i++) {
+        if (!conf->subvolume_status[i])
+            continue;
+
+        /* A refresh still in flight counts as one being done */
+        if ((conf->du_stats[i].next_refresh > now) ||
+            conf->du_stats[i].refreshing)
+            continue;
+
+        conf->du_stats[i].next_refresh = dht_du_refresh_next(conf, now);
+        dht_get_du_info_for_subvol(this, i);
+    }
+
+    LOCK(&conf->lock);
+    {
+        __dht_du_refresh_arm(this);
+    }
+    UNLOCK(&conf->lock);
+}
+
+void
+dht_du_refresh_start(xlator_t *this)
+{
+    dht_conf_t *conf = NULL;
+    time_t now = 0;
+    int i = 0;
+
+    conf = this->private;
+    if (!conf->refresh_interval)
+        return;
+
+    LOCK(&conf->lock);
+    {
+        if (!conf->du_timer && !conf->du_timer_stopped) {
+            /* Spread the first refreshes over the interval */
+            now = gf_time();
+            for (i = 0; i < conf->subvolume_cnt; i++)
+                conf->du_stats[i].next_refresh = now +
+                                                 (random() %
+                                                  conf->refresh_interval);
+            __dht_du_refresh_arm(this);
+        }
+    }
+    UNLOCK(&conf->lock);
+}
+
+void
+dht_du_refresh_stop(xlator_t *this)
+{
+    dht_conf_t *conf = NULL;
+
+    conf = this->private;
+
+    LOCK(&conf->lock);
+    {
+        conf->du_timer_stopped = _gf_true;
+        if (conf->du_timer) {
+            gf_timer_call_cancel(this->ctx, conf->du_timer);
+            conf->du_timer = NULL;
+        }
+    }
+    UNLOCK(&conf->lock);
+}
+
 gf_boolean_t
 dht_is_subvol_filled(xlator_t *this, xlator_t *subvol)
 {
@@ -214,34 +463,21 @@ dht_is_subvol_filled(xlator_t *this, xlator_t *subvol)
     gf_boolean_t subvol_filled_space = _gf_false;
     gf_boolean_t is_subvol_filled = _gf_false;
     double usage = 0;
+    int filled = 0;
 
     conf = this->private;
 
-    /* Check for values above specified percent or free disk */
-    LOCK(&conf->subvolume_lock);
-    {
-        for (i = 0; i < conf->subvolume_cnt; i++) {
-            if (subvol == conf->subvolumes[i]) {
-                if (conf->disk_unit_percent) {
-                    if (conf->du_stats[i].avail_percent < conf->min_free_disk) {
-                        subvol_filled_space = _gf_true;
-                        break;
-                    }
-
-                } else {
-                    if (conf->du_stats[i].avail_space < conf->min_free_disk) {
-                        subvol_filled_space = _gf_true;
-                        break;
-                    }
-                }
-                if (conf->du_stats[i].avail_inodes < conf->min_free_inodes) {
-                    subvol_filled_inodes = _gf_true;
-                    break;
-                }
-            }
+    /* The filled state is worked out whenever the usage is recorded, so
+     * that creates do not need the lock to check it */
+    for (i = 0; i < conf->subvolume_cnt; i++) {
+        if (subvol == conf->subvolumes[i]) {
+            filled = GF_ATOMIC_GET(conf->du_stats[i].filled);
+            subvol_filled_space = !!(filled & DHT_DU_FILLED_SPACE);
+            subvol_filled_inodes = !subvol_filled_space &&
+                                   (filled & DHT_DU_FILLED_INODES);
+            break;
         }
     }
-    UNLOCK(&conf->subvolume_lock);
 
     if (subvol_filled_space && conf->subvolume_status[i]) {
         if (!(conf->du_stats[i].log++ % (GF_UNIVERSAL_ANSWER * 10))) {
@@ -312,8 +548,11 @@ dht_free_disk_available_subvol(xlator_t *this, xlator_t *subvol,
 
     LOCK(&conf->subvolume_lock);
     {
-        avail_subvol = dht_subvol_with_free_space_inodes(this, subvol, NULL,
-                                                         layout, 0);
+        if (conf->du_weighted_placement)
+            avail_subvol = dht_subvol_weighted_free_space(this, layout);
+        if (!avail_subvol)
+            avail_subvol = dht_subvol_with_free_space_inodes(this, subvol, NULL,
+                                                             layout, 0);
         if (!avail_subvol) {
             avail_subvol = dht_subvol_maxspace_nonzeroinode(this, subvol,
                                                             layout);
@@ -449,6 +688,52 @@ dht_subvol_with_free_space_inodes(xlator_t *this, xlator_t *subvol,
     return avail_subvol;
 }
 
+/* Get a subvolume which has both space and inodes more than the min
+ * criteria, picked at random with a weight of its free space divided by its
+ * statfs latency. Latencies below a millisecond are all alike. */
+xlator_t *
+dht_subvol_weighted_free_space(xlator_t *this, dht_layout_t *layout)
+{
+    int i = 0;
+    double total = 0;
+    double pick = 0;
+    double *weights = NULL;
+    dht_conf_t *conf = NULL;
+    xlator_t *avail_subvol = NULL;
+
+    conf = this->private;
+
+    weights = alloca0(conf->subvolume_cnt * sizeof(double));
+
+    for (i = 0; i < conf->subvolume_cnt; i++) {
+        if (dht_subvol_has_err(conf, conf->subvolumes[i], NULL, layout))
+            continue;
+
+        if (GF_ATOMIC_GET(conf->du_stats[i].filled))
+            continue;
+
+        weights[i] = (double)conf->du_stats[i].avail_space /
+                     (1.0 + conf->du_stats[i].latency / 1000.0);
+        total += weights[i];
+    }
+
+    if (total <= 0)
+        goto out;
+
+    pick = total * ((double)random() / ((double)RAND_MAX + 1));
+    for (i = 0; i < conf->subvolume_cnt; i++) {
+        if (!weights[i])
+            continue;
+
+        avail_subvol = conf->subvolumes[i];
+        if (pick < weights[i])
+            break;
+        pick -= weights[i];
+    }
+out:
+    return avail_subvol;
+}
+
 /* Get subvol which has at least one inode and maximum space */
 xlator_t *
 dht_subvol_maxspace_nonzeroinode(xlator_t *this, xlator_t *subvol,
@@ -0,0 +1,382 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "dht-common.h"
+#include <glusterfs/hashfn.h>
+#include <glusterfs/upcall-utils.h>
+
+/* Entry cache.
+ *
+ * A fresh lookup of a name that is not on its hashed subvolume costs a
+ * lookup on every subvolume, or a second lookup on the subvolume a linkto
+ * file points to. The entry cache of a directory remembers, for a few
+ * seconds at most, the names found missing and the subvolume holding the
+ * data file of names found behind a linkto file. A missing name is then
+ * answered without any lookup, and a linkto name with a single lookup on
+ * the subvolume of its data file.
+ *
+ * Entries are only used while the directory keeps the layout commit hash
+ * they were recorded with. The entry ops of this client drop the names they
+ * change when they start and when they complete, and upcalls drop the whole
+ * cache of the directories they name. Every drop bumps a generation number
+ * that lookups sample when they start, so that a lookup which raced with an
+ * entry op does not record what it saw.
+ */
+
+void
+dht_entry_cache_free(dht_entry_cache_t *ecache)
+{
+    int i = 0;
+
+    if (!ecache)
+        return;
+
+    for (i = 0; i < DHT_ENTRY_CACHE_SLOTS; i++)
+        GF_FREE(ecache->slots[i].name);
+
+    LOCK_DESTROY(&ecache->lock);
+    GF_FREE(ecache);
+}
+
+/* The cache lives as long as the inode ctx of the directory, which callers
+ * keep through their reference on the inode. */
+static dht_entry_cache_t *
+dht_entry_cache_get(xlator_t *this, inode_t *parent, gf_boolean_t create)
+{
+    dht_inode_ctx_t *ctx = NULL;
+    dht_entry_cache_t *ecache = NULL;
+    uint64_t ctx_int = 0;
+
+    LOCK(&parent->lock);
+    {
+        if (__inode_ctx_get(parent, this, &ctx_int) || !ctx_int)
+            goto unlock;
+
+        ctx = (dht_inode_ctx_t *)(uintptr_t)ctx_int;
+        if (!ctx->entry_cache && create) {
+            ecache = GF_CALLOC(1, sizeof(*ecache), gf_dht_mt_entry_cache_t);
+            if (!ecache)
+                goto unlock;
+            LOCK_INIT(&ecache->lock);
+            ctx->entry_cache = ecache;
+        }
+        ecache = ctx->entry_cache;
+    }
+unlock:
+    UNLOCK(&parent->lock);
+
+    return ecache;
+}
+
+static void
+__dht_entry_cache_slot_clear(struct dht_entry_cache_slot *slot)
+{
+    GF_FREE(slot->name);
+    memset(slot, 0, sizeof(*slot));
+}
+
+static struct dht_entry_cache_slot *
+__dht_entry_cache_slot(dht_entry_cache_t *ecache, const char *name,
+                       uint32_t name_hash)
+{
+    struct dht_entry_cache_slot *slot = NULL;
+
+    slot = &ecache->slots[name_hash % DHT_ENTRY_CACHE_SLOTS];
+    if ((slot->state == DHT_ENTRY_CACHE_NONE) ||
+        (slot->name_hash != name_hash) || strcmp(slot->name, name))
+        return NULL;
+
+    return slot;
+}
+
+static void
+dht_entry_cache_clear(xlator_t *this, inode_t *dir)
+{
+    dht_entry_cache_t *ecache = NULL;
+    int i = 0;
+
+    ecache = dht_entry_cache_get(this, dir, _gf_false);
+    if (!ecache)
+        return;
+
+    LOCK(&ecache->lock);
+    {
+        for (i = 0; i < DHT_ENTRY_CACHE_SLOTS; i++)
+            __dht_entry_cache_slot_clear(&ecache->slots[i]);
+    }
+    UNLOCK(&ecache->lock);
+}
+
+void
+dht_entry_cache_invalidate(xlator_t *this, inode_t *parent, const char *name)
+{
+    dht_conf_t *conf = this->private;
+    dht_entry_cache_t *ecache = NULL;
+    struct dht_entry_cache_slot *slot = NULL;
+    uint32_t name_hash = 0;
+
+    if (!parent || !name)
+        return;
+
+    GF_ATOMIC_INC(conf->entry_cache_gen);
+    GF_ATOMIC_INC(conf->entry_cache_invalidations);
+
+    ecache = dht_entry_cache_get(this, parent, _gf_false);
+    if (!ecache)
+        return;
+
+    name_hash = gf_dm_hashfn(name, strlen(name));
+
+    LOCK(&ecache->lock);
+    {
+        slot = __dht_entry_cache_slot(ecache, name, name_hash);
+        if (slot)
+            __dht_entry_cache_slot_clear(slot);
+    }
+    UNLOCK(&ecache->lock);
+}
+
+static gf_boolean_t
+dht_entry_cache_changes_names(glusterfs_fop_t fop)
+{
+    switch (fop) {
+        case GF_FOP_CREATE:
+        case GF_FOP_MKNOD:
+        case GF_FOP_MKDIR:
+        case GF_FOP_SYMLINK:
+        case GF_FOP_LINK:
+        case GF_FOP_UNLINK:
+        case GF_FOP_RMDIR:
+        case GF_FOP_RENAME:
+            return _gf_true;
+        default:
+            return _gf_false;
+    }
+}
+
+/* Called from dht_local_init(). The new name of a rename or link is only
+ * known to the fop itself, which drops it. */
+void
+dht_entry_cache_fop_init(xlator_t *this, dht_local_t *local)
+{
+    dht_conf_t *conf = this->private;
+
+    if (!conf || !conf->entry_cache ||
+        !dht_entry_cache_changes_names(local->fop))
+        return;
+
+    local->entry_cache_inval = _gf_true;
+    dht_entry_cache_invalidate(this, local->loc.parent, local->loc.name);
+}
+
+/* Called before an entry op unwinds */
+void
+dht_entry_cache_fop_done(xlator_t *this, dht_local_t *local)
+{
+    dht_entry_cache_invalidate(this, local->loc.parent, local->loc.name);
+    dht_entry_cache_invalidate(this, local->loc2.parent, local->loc2.name);
+}
+
+/* Looks the name of a fresh lookup up in the cache of its directory.
+ * Returns the subvolume to look the data file up on, or NULL with
+ * *op_errno set to ENOENT when the name is known to be missing, or to 0
+ * when the cache knows nothing. */
+xlator_t *
+dht_entry_cache_lookup(xlator_t *this, dht_local_t *local, int *op_errno)
+{
+    dht_conf_t *conf = this->private;
+    dht_entry_cache_t *ecache = NULL;
+    struct dht_entry_cache_slot *slot = NULL;
+    dht_layout_t *layout = NULL;
+    xlator_t *cached = NULL;
+    loc_t *loc = &local->loc;
+    uint32_t name_hash = 0;
+
+    *op_errno = 0;
+
+    if (!conf->entry_cache || conf->defrag || !loc->parent || !loc->name)
+        return NULL;
+
+    local->entry_cache_lookup = _gf_true;
+    local->entry_cache_gen = GF_ATOMIC_GET(conf->entry_cache_gen);
+
+    ecache = dht_entry_cache_get(this, loc->parent, _gf_false);
+    if (!ecache)
+        goto miss;
+
+    layout = dht_layout_get(this, loc->parent);
+    if (!layout)
+        goto miss;
+
+    name_hash = gf_dm_hashfn(loc->name, strlen(loc->name));
+
+    LOCK(&ecache->lock);
+    {
+        slot = __dht_entry_cache_slot(ecache, loc->name, name_hash);
+        if (!slot)
+            goto unlock;
+
+        if ((slot->commit_hash != layout->commit_hash) ||
+            (slot->expire < gf_time())) {
+            __dht_entry_cache_slot_clear(slot);
+            slot = NULL;
+            goto unlock;
+        }
+
+        if (slot->state == DHT_ENTRY_CACHE_MISSING) {
+            *op_errno = ENOENT;
+        } else {
+            cached = slot->cached;
+            gf_uuid_copy(local->gfid, slot->gfid);
+        }
+    }
+unlock:
+    UNLOCK(&ecache->lock);
+
+    dht_layout_unref(layout);
+
+    if (*op_errno == ENOENT) {
+        GF_ATOMIC_INC(conf->entry_cache_missing_hits);
+        return NULL;
+    }
+
+    if (cached) {
+        GF_ATOMIC_INC(conf->entry_cache_linkto_hits);
+        return cached;
+    }
+miss:
+    GF_ATOMIC_INC(conf->entry_cache_misses);
+    return NULL;
+}
+
+static void
+dht_entry_cache_record(xlator_t *this, dht_local_t *local,
+                       dht_entry_cache_state_t state, xlator_t *cached,
+                       uuid_t gfid)
+{
+    dht_conf_t *conf = this->private;
+    dht_entry_cache_t *ecache = NULL;
+    struct dht_entry_cache_slot *slot = NULL;
+    dht_layout_t *layout = NULL;
+    loc_t *loc = &local->loc;
+    uint32_t name_hash = 0;
+    char *name = NULL;
+
+    if (!conf->entry_cache || !local->entry_cache_lookup || !loc->parent ||
+        !loc->name)
+        return;
+
+    layout = dht_layout_get(this, loc->parent);
+    if (!layout)
+        return;
+
+    ecache = dht_entry_cache_get(this, loc->parent, _gf_true);
+    if (!ecache)
+        goto out;
+
+    name = gf_strdup(loc->name);
+    if (!name)
+        goto out;
+
+    name_hash = gf_dm_hashfn(loc->name, strlen(loc->name));
+
+    LOCK(&ecache->lock);
+    {
+        /* An entry op ran while this lookup was on the wire */
+        if (GF_ATOMIC_GET(conf->entry_cache_gen) != local->entry_cache_gen)
+            goto unlock;
+
+        slot = &ecache->slots[name_hash % DHT_ENTRY_CACHE_SLOTS];
+        __dht_entry_cache_slot_clear(slot);
+
+        slot->name = name;
+        name = NULL;
+        slot->name_hash = name_hash;
+        slot->commit_hash = layout->commit_hash;
+        slot->expire = gf_time() + conf->entry_cache_timeout;
+        slot->state = state;
+        slot->cached = cached;
+        if (gfid)
+            gf_uuid_copy(slot->gfid, gfid);
+    }
+unlock:
+    UNLOCK(&ecache->lock);
+out:
+    GF_FREE(name);
+    dht_layout_unref(layout);
+}
+
+/* Only when every subvolume could answer is a name known to be missing */
+void
+dht_entry_cache_missing(xlator_t *this, dht_local_t *local)
+{
+    dht_conf_t *conf = this->private;
+    int i = 0;
+
+    for (i = 0; i < conf->subvolume_cnt; i++) {
+        if (!conf->subvolume_status[i])
+            return;
+    }
+
+    dht_entry_cache_record(this, local, DHT_ENTRY_CACHE_MISSING, NULL, NULL);
+}
+
+void
+dht_entry_cache_linkto(xlator_t *this, dht_local_t *local, xlator_t *cached,
+                       uuid_t gfid)
+{
+    dht_entry_cache_record(this, local, DHT_ENTRY_CACHE_LINKTO, cached, gfid);
+}
+
+/* Drops the cache of the directories another client changed */
+void
+dht_entry_cache_upcall(xlator_t *this, void *data)
+{
+    dht_conf_t *conf = this->private;
+    struct gf_upcall *up_data = data;
+    struct gf_upcall_cache_invalidation *up_ci = NULL;
+    inode_table_t *itable = NULL;
+    inode_t *inode = NULL;
+    uuid_t *gfids[3] = {
+        NULL,
+    };
+    int i = 0;
+
+    if (!conf->entry_cache || !this->graph || !this->graph->top)
+        return;
+
+    up_ci = (struct gf_upcall_cache_invalidation *)up_data->data;
+    if (!(up_ci->flags & (UP_PARENT_DENTRY_FLAGS | UP_TIMES)))
+        return;
+
+    itable = ((xlator_t *)this->graph->top)->itable;
+    if (!itable)
+        return;
+
+    GF_ATOMIC_INC(conf->entry_cache_gen);
+    GF_ATOMIC_INC(conf->entry_cache_invalidations);
+
+    gfids[0] = &up_data->gfid;
+    gfids[1] = &up_ci->p_stat.ia_gfid;
+    gfids[2] = &up_ci->oldp_stat.ia_gfid;
+
+    for (i = 0; i < 3; i++) {
+        if (gf_uuid_is_null(*gfids[i]))
+            continue;
+
+        inode = inode_find(itable, *gfids[i]);
+        if (!inode)
+            continue;
+
+        if (inode->ia_type == IA_IFDIR)
+            dht_entry_cache_clear(this, inode);
+        inode_unref(inode);
+    }
+}
@@ -11,6 +11,45 @@
 #include "dht-common.h"
 #include <glusterfs/hashfn.h>
 
+/* The same name is usually hashed several times in a row (lookup, then
+ * create, mkdir or rename of the same entry), and every computation runs
+ * the hash regexes under conf->lock. Each thread keeps the last few hashes
+ * it computed. Entries are tagged with the cookie of the configuration
+ * that produced them, which changes whenever the regexes change. */
+#define DHT_HASH_CACHE_SIZE 8
+
+struct dht_hash_cache_entry {
+    uint64_t cookie;
+    int type;
+    uint32_t hash;
+    size_t len;
+    char name[NAME_MAX + 1];
+};
+
+static __thread struct dht_hash_cache_entry
+    dht_hash_cache[DHT_HASH_CACHE_SIZE];
+
+static gf_atomic_t dht_hash_cookies;
+
+void
+dht_hash_cache_reset(dht_conf_t *conf)
+{
+    GF_ATOMIC_INIT(conf->hash_cookie, GF_ATOMIC_INC(dht_hash_cookies));
+}
+
+static struct dht_hash_cache_entry *
+dht_hash_cache_slot(const char *name, size_t len)
+{
+    uint32_t key = len;
+
+    key = key * 31 + (unsigned char)name[0];
+    key = key * 31 + (unsigned char)name[len - 1];
+    if (len > 1)
+        key = key * 31 + (unsigned char)name[len - 2];
+
+    return &dht_hash_cache[key % DHT_HASH_CACHE_SIZE];
+}
+
 static int
 dht_hash_compute_internal(int type, const char *name, const int len,
                           uint32_t *hash_p)
@@ -71,17 +110,30 @@ dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p)
 {
     char *rsync_friendly_name = NULL;
     dht_conf_t *priv = NULL;
+    struct dht_hash_cache_entry *entry = NULL;
+    uint64_t cookie = 0;
     size_t len = 0;
     int munged = 0;
+    int ret = 0;
 
     if (caa_unlikely(name == NULL))
         return -1;
 
     len = strlen(name) + 1;
-    rsync_friendly_name = alloca(len);
-
     priv = this->private;
 
+    cookie = GF_ATOMIC_GET(priv->hash_cookie);
+    if (cookie && (len > 1) && (len <= sizeof(dht_hash_cache[0].name))) {
+        entry = dht_hash_cache_slot(name, len - 1);
+        if ((entry->cookie == cookie) && (entry->type == type) &&
+            (entry->len == len) && !memcmp(entry->name, name, len)) {
+            *hash_p = entry->hash;
+            return 0;
+        }
+    }
+
+    rsync_friendly_name = alloca(len);
+
     LOCK(&priv->lock);
     {
         if (priv->extra_regex_valid) {
@@ -103,6 +155,15 @@ dht_hash_compute(xlator_t *this, int type, const char *name, uint32_t *hash_p)
         rsync_friendly_name = (char *)name;
     }
 
-    return dht_hash_compute_internal(type, rsync_friendly_name, len - 1,
-                                     hash_p);
+    ret = dht_hash_compute_internal(type, rsync_friendly_name, len - 1,
+                                    hash_p);
+    if ((ret == 0) && entry) {
+        entry->cookie = cookie;
+        entry->type = type;
+        entry->hash = *hash_p;
+        entry->len = strlen(name) + 1;
+        memcpy(entry->name, name, entry->len);
+    }
+
+    return ret;
 }
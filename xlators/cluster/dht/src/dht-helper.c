@@ -12,9 +12,24 @@
 #include "dht-lock.h"
 #include "glusterfs/compat-errno.h"  // for ENODATA on BSD
 
+static void
+dht_readdirp_fanout_free(dht_readdirp_fanout_t *fanout)
+{
+    int i = 0;
+
+    for (i = 0; i < fanout->cnt; i++)
+        gf_dirent_free(&fanout->slots[i].entries);
+
+    LOCK_DESTROY(&fanout->lock);
+    GF_FREE(fanout);
+}
+
 static void
 dht_free_fd_ctx(dht_fd_ctx_t *fd_ctx)
 {
+    if (fd_ctx->readdirp)
+        dht_readdirp_fanout_free(fd_ctx->readdirp);
+
     GF_FREE(fd_ctx);
 }
 
@@ -125,6 +140,53 @@ out:
     return fd_ctx;
 }
 
+/* Returns the read ahead state of a directory fd, creating it if needed.
+ * It lives as long as the fd. */
+dht_readdirp_fanout_t *
+dht_fd_ctx_readdirp_get(xlator_t *this, fd_t *fd)
+{
+    dht_conf_t *conf = NULL;
+    dht_fd_ctx_t *fd_ctx = NULL;
+    dht_readdirp_fanout_t *fanout = NULL;
+    int i = 0;
+
+    conf = this->private;
+
+    LOCK(&fd->lock);
+    {
+        fd_ctx = __fd_ctx_get_ptr(fd, this);
+        if (!fd_ctx) {
+            if (__dht_fd_ctx_set(this, fd, NULL) < 0)
+                goto unlock;
+            fd_ctx = __fd_ctx_get_ptr(fd, this);
+            if (!fd_ctx)
+                goto unlock;
+        }
+
+        if (!fd_ctx->readdirp) {
+            fanout = GF_CALLOC(1,
+                               sizeof(*fanout) + conf->subvolume_cnt *
+                                                     sizeof(fanout->slots[0]),
+                               gf_dht_mt_readdirp_fanout_t);
+            if (!fanout)
+                goto unlock;
+
+            LOCK_INIT(&fanout->lock);
+            fanout->cnt = conf->subvolume_cnt;
+            for (i = 0; i < fanout->cnt; i++)
+                INIT_LIST_HEAD(&fanout->slots[i].entries.list);
+
+            fd_ctx->readdirp = fanout;
+        }
+
+        fanout = fd_ctx->readdirp;
+    }
+unlock:
+    UNLOCK(&fd->lock);
+
+    return fanout;
+}
+
 gf_boolean_t
 dht_fd_open_on_dst(xlator_t *this, fd_t *fd, xlator_t *dst)
 {
@@ -830,6 +892,9 @@ dht_local_init(call_frame_t *frame, loc_t *loc, fd_t *fd, glusterfs_fop_t fop)
     local->op_errno = EUCLEAN;
     local->fop = fop;
 
+    if (loc)
+        dht_entry_cache_fop_init(frame->this, local);
+
     if (inode) {
         local->layout = dht_layout_get(frame->this, inode);
         if (local->layout) {
@@ -1172,6 +1237,7 @@ dht_init_subvolumes(xlator_t *this, dht_conf_t *conf)
 {
     xlator_list_t *subvols = NULL;
     int cnt = 0;
+    int i = 0;
 
     if (!conf)
         return -1;
@@ -1219,6 +1285,9 @@ dht_init_subvolumes(xlator_t *this, dht_conf_t *conf)
         return -1;
     }
 
+    for (i = 0; i < conf->subvolume_cnt; i++)
+        GF_ATOMIC_INIT(conf->du_stats[i].filled, 0);
+
     conf->decommissioned_bricks = GF_CALLOC(cnt, sizeof(xlator_t *),
                                             gf_dht_mt_xlator_t);
     if (!conf->decommissioned_bricks) {
@@ -328,8 +328,9 @@ dht_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
         op_errno = EINVAL;
         goto err;
     }
-    if (xdata)
-        local->xattr_req = dict_ref(xdata);
+    /* Directory attributes are merged from all the subvolumes, and files
+     * may be looked up again during migration: full iatts are needed */
+    local->xattr_req = dict_ref_iatt_mask_full(xdata);
 
     if (IA_ISREG(loc->inode->ia_type)) {
         local->call_cnt = 1;
@@ -337,7 +338,7 @@ dht_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
         subvol = local->cached_subvol;
 
         STACK_WIND_COOKIE(frame, dht_file_attr_cbk, subvol, subvol,
-                          subvol->fops->stat, loc, xdata);
+                          subvol->fops->stat, loc, local->xattr_req);
 
         return 0;
     }
@@ -348,7 +349,7 @@ dht_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
         subvol = layout->list[i].xlator;
 
         STACK_WIND_COOKIE(frame, dht_attr_cbk, subvol, subvol,
-                          subvol->fops->stat, loc, xdata);
+                          subvol->fops->stat, loc, local->xattr_req);
     }
 
     return 0;
@@ -386,8 +387,7 @@ dht_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
         op_errno = EINVAL;
         goto err;
     }
-    if (xdata)
-        local->xattr_req = dict_ref(xdata);
+    local->xattr_req = dict_ref_iatt_mask_full(xdata);
 
     if (IA_ISREG(fd->inode->ia_type)) {
         local->call_cnt = 1;
@@ -395,7 +395,7 @@ dht_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
         subvol = local->cached_subvol;
 
         STACK_WIND_COOKIE(frame, dht_file_attr_cbk, subvol, subvol,
-                          subvol->fops->fstat, fd, xdata);
+                          subvol->fops->fstat, fd, local->xattr_req);
         return 0;
     }
 
@@ -404,7 +404,7 @@ dht_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
     for (i = 0; i < call_cnt; i++) {
         subvol = layout->list[i].xlator;
         STACK_WIND_COOKIE(frame, dht_attr_cbk, subvol, subvol,
-                          subvol->fops->fstat, fd, xdata);
+                          subvol->fops->fstat, fd, local->xattr_req);
     }
 
     return 0;
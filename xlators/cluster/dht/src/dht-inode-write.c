@@ -993,6 +993,98 @@ err:
     return 0;
 }
 
+int
+dht_copy_file_range_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                        int op_ret, int op_errno, struct iatt *stbuf,
+                        struct iatt *prebuf, struct iatt *postbuf,
+                        dict_t *xdata)
+{
+    xlator_t *prev = cookie;
+
+    if (op_ret == -1) {
+        gf_msg_debug(this->name, op_errno, "subvolume %s returned -1",
+                     prev->name);
+        goto out;
+    }
+
+    /* The destination started migrating while the copy was in flight.
+     * The data may have only reached the source of the migration, so let
+     * the caller redo the range through writev, which handles migration. */
+    if (IS_DHT_MIGRATION_PHASE1(postbuf) || IS_DHT_MIGRATION_PHASE2(postbuf)) {
+        op_ret = -1;
+        op_errno = EXDEV;
+    }
+
+out:
+    DHT_STRIP_PHASE1_FLAGS(postbuf);
+    DHT_STRIP_PHASE1_FLAGS(prebuf);
+    DHT_STRIP_PHASE1_FLAGS(stbuf);
+
+    DHT_STACK_UNWIND(copy_file_range, frame, op_ret, op_errno, stbuf, prebuf,
+                     postbuf, xdata);
+    return 0;
+}
+
+/* copy_file_range can only be offloaded when both files live on the same
+ * subvolume and neither of them is being migrated. EXDEV tells the caller
+ * to fall back to read and write. */
+int
+dht_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+    xlator_t *subvol = NULL;
+    xlator_t *src_subvol = NULL;
+    int op_errno = -1;
+    dht_local_t *local = NULL;
+
+    VALIDATE_OR_GOTO(frame, err);
+    VALIDATE_OR_GOTO(this, err);
+    VALIDATE_OR_GOTO(fd_in, err);
+    VALIDATE_OR_GOTO(fd_out, err);
+
+    local = dht_local_init(frame, NULL, fd_out, GF_FOP_COPY_FILE_RANGE);
+    if (!local) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+
+    subvol = local->cached_subvol;
+    if (!subvol) {
+        gf_msg_debug(this->name, 0, "no cached subvolume for fd=%p", fd_out);
+        op_errno = EINVAL;
+        goto err;
+    }
+
+    src_subvol = dht_subvol_get_cached(this, fd_in->inode);
+    if (src_subvol != subvol) {
+        op_errno = EXDEV;
+        goto err;
+    }
+
+    if ((dht_inode_ctx_get_mig_info(this, fd_in->inode, NULL, NULL) == 0) ||
+        (dht_inode_ctx_get_mig_info(this, fd_out->inode, NULL, NULL) == 0)) {
+        op_errno = EXDEV;
+        goto err;
+    }
+
+    if (xdata)
+        local->xattr_req = dict_ref(xdata);
+
+    STACK_WIND_COOKIE(frame, dht_copy_file_range_cbk, subvol, subvol,
+                      subvol->fops->copy_file_range, fd_in, off_in, fd_out,
+                      off_out, len, flags, local->xattr_req);
+
+    return 0;
+
+err:
+    op_errno = (op_errno == -1) ? errno : op_errno;
+    DHT_STACK_UNWIND(copy_file_range, frame, -1, op_errno, NULL, NULL, NULL,
+                     NULL);
+
+    return 0;
+}
+
 /* handle cases of migration here for 'setattr()' calls */
 int
 dht_file_setattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
@@ -10,6 +10,7 @@
 
 #include "dht-common.h"
 #include "unittest/unittest.h"
+#include <urcu/uatomic.h>
 
 #define layout_base_size (sizeof(dht_layout_t))
 
@@ -87,8 +88,10 @@ dht_layout_unref(dht_layout_t *layout)
 
     ref = GF_ATOMIC_DEC(layout->ref);
 
-    if (!ref)
+    if (!ref) {
+        GF_FREE(layout->index);
         GF_FREE(layout);
+    }
 }
 
 dht_layout_t *
@@ -102,9 +105,132 @@ dht_layout_ref(dht_layout_t *layout)
     return layout;
 }
 
+static int
+dht_layout_range_cmp(const void *a, const void *b)
+{
+    const struct dht_layout_range *r1 = a;
+    const struct dht_layout_range *r2 = b;
+
+    if (r1->start < r2->start)
+        return -1;
+
+    return (r1->start > r2->start);
+}
+
+/* Copies the ranges of the layout into an array sorted by start so that
+ * they can be searched by bisection. Empty entries (0-0, as left by
+ * errored or decommissioned subvolumes) are not copied. If the remaining
+ * ranges overlap, an index without ranges is returned: such a layout is
+ * always scanned linearly so that the first matching entry wins, like it
+ * always did. */
+static dht_layout_index_t *
+dht_layout_index_build(dht_layout_t *layout)
+{
+    dht_layout_index_t *index = NULL;
+    int i = 0;
+    int cnt = 0;
+
+    index = GF_CALLOC(1,
+                      sizeof(*index) + layout->cnt * sizeof(index->range[0]),
+                      gf_dht_mt_layout_index_t);
+    if (!index)
+        return NULL;
+
+    for (i = 0; i < layout->cnt; i++) {
+        if (layout->list[i].start > layout->list[i].stop)
+            continue;
+        if ((layout->list[i].start == 0) && (layout->list[i].stop == 0))
+            continue;
+
+        index->range[cnt].start = layout->list[i].start;
+        index->range[cnt].stop = layout->list[i].stop;
+        index->range[cnt].idx = i;
+        cnt++;
+    }
+
+    qsort(index->range, cnt, sizeof(index->range[0]), dht_layout_range_cmp);
+
+    for (i = 1; i < cnt; i++) {
+        if (index->range[i].start <= index->range[i - 1].stop) {
+            cnt = 0;
+            break;
+        }
+    }
+
+    index->cnt = cnt;
+
+    return index;
+}
+
+/* Returns the index of the layout, building it the first time. A layout
+ * may be searched by several threads at once: the first index published
+ * is kept and the others are dropped. */
+static dht_layout_index_t *
+dht_layout_index_get(dht_layout_t *layout)
+{
+    dht_layout_index_t *index = NULL;
+    dht_layout_index_t *old = NULL;
+
+    index = uatomic_read(&layout->index);
+    if (index)
+        return index;
+
+    index = dht_layout_index_build(layout);
+    if (!index)
+        return NULL;
+
+    old = uatomic_cmpxchg(&layout->index, NULL, index);
+    if (old) {
+        GF_FREE(index);
+        index = old;
+    }
+
+    return index;
+}
+
+/* Looks for the entry holding @hash in the sorted ranges. The entry found
+ * is checked against the layout itself, as entries can still be changed
+ * after the index has been built (e.g. by a layout refresh). -1 is
+ * returned if the index has no answer and the layout must be scanned. */
+static int
+dht_layout_index_search(dht_layout_t *layout, dht_layout_index_t *index,
+                        uint32_t hash)
+{
+    int lo = 0;
+    int hi = index->cnt - 1;
+    int mid = 0;
+    int found = -1;
+    int i = 0;
+
+    /* Empty entries, which are not indexed, also match 0. */
+    if (hash == 0)
+        return -1;
+
+    while (lo <= hi) {
+        mid = lo + (hi - lo) / 2;
+        if (index->range[mid].start <= hash) {
+            found = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    if ((found < 0) || (index->range[found].stop < hash))
+        return -1;
+
+    i = index->range[found].idx;
+    if ((layout->list[i].start != index->range[found].start) ||
+        (layout->list[i].stop != index->range[found].stop))
+        return -1;
+
+    return i;
+}
+
 xlator_t *
 dht_layout_search(xlator_t *this, dht_layout_t *layout, const char *name)
 {
+    dht_layout_index_t *index = NULL;
     uint32_t hash = 0;
     xlator_t *subvol = NULL;
     int i = 0;
@@ -117,6 +243,17 @@ dht_layout_search(xlator_t *this, dht_layout_t *layout, const char *name)
         goto out;
     }
 
+    if ((layout->cnt >= DHT_LAYOUT_INDEX_MIN_CNT) && !layout->preset) {
+        index = dht_layout_index_get(layout);
+        if (index && (index->cnt > 0)) {
+            i = dht_layout_index_search(layout, index, hash);
+            if (i >= 0) {
+                subvol = layout->list[i].xlator;
+                goto out;
+            }
+        }
+    }
+
     for (i = 0; i < layout->cnt; i++) {
         if (layout->list[i].start <= hash && layout->list[i].stop >= hash) {
             subvol = layout->list[i].xlator;
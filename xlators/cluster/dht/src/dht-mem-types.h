@@ -33,6 +33,11 @@ enum gf_dht_mem_types_ {
     gf_dht_mt_fd_ctx_t,
     gf_dht_ret_cache_t,
     gf_dht_nodeuuids_t,
+    gf_dht_mt_layout_index_t,
+    gf_dht_mt_readdirp_fanout_t,
+    gf_dht_mt_fix_layout_dir_t,
+    gf_dht_mt_entry_cache_t,
+    gf_dht_mt_migrate_batch_t,
     gf_dht_mt_end
 };
 #endif
@@ -18,6 +18,7 @@
 #define GF_DISK_SECTOR_SIZE 512
 #define DHT_REBALANCE_PID 4242        /* Change it if required */
 #define DHT_REBALANCE_BLKSIZE 1048576 /* 1 MB */
+#define DHT_REBALANCE_MAX_WINDOW 64
 #define MAX_MIGRATE_QUEUE_COUNT 500
 #define MIN_MIGRATE_QUEUE_COUNT 200
 #define MAX_REBAL_TYPE_SIZE 16
@@ -1028,125 +1029,314 @@ dht_rebalance_sparse_segment(xlator_t *subvol, fd_t *fd, off_t *offset,
     return 1;
 }
 
+/* Blocks of a file that are migrated at once. Each block is read from the
+ * source and written to the destination on its own, so that the reads of
+ * later blocks overlap with the writes of earlier ones. */
+typedef struct dht_migrate_block {
+    struct dht_migrate_batch *batch;
+    off_t offset;
+    size_t size;
+    ssize_t done; /* bytes written, or -errno */
+} dht_migrate_block_t;
+
+typedef struct dht_migrate_batch {
+    syncbarrier_t barrier;
+    xlator_t *to;
+    fd_t *dst;
+    dict_t *xdata;
+    int cnt;
+    dht_migrate_block_t blocks[DHT_REBALANCE_MAX_WINDOW];
+} dht_migrate_batch_t;
+
+static int32_t
+dht_migrate_block_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                             int32_t op_ret, int32_t op_errno,
+                             struct iatt *prebuf, struct iatt *postbuf,
+                             dict_t *xdata)
+{
+    dht_migrate_block_t *block = cookie;
+
+    block->done = (op_ret < 0) ? -op_errno : op_ret;
+    syncbarrier_wake(&block->batch->barrier);
+
+    return 0;
+}
+
+static int32_t
+dht_migrate_block_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno,
+                            struct iovec *vector, int32_t count,
+                            struct iatt *stbuf, struct iobref *iobref,
+                            dict_t *xdata)
+{
+    dht_migrate_block_t *block = cookie;
+    dht_migrate_batch_t *batch = block->batch;
+
+    if (op_ret <= 0) {
+        /* Nothing read: the file was probably truncated */
+        block->done = (op_ret < 0) ? -op_errno : -ENOSPC;
+        syncbarrier_wake(&batch->barrier);
+        return 0;
+    }
+
+    STACK_WIND_COOKIE(frame, dht_migrate_block_writev_cbk, block, batch->to,
+                      batch->to->fops->writev, batch->dst, vector, count,
+                      block->offset, 0, iobref, batch->xdata);
+
+    return 0;
+}
+
+/* Reads and writes all the blocks of @batch in parallel */
+static int
+dht_migrate_batch_run(xlator_t *this, xlator_t *from, fd_t *src,
+                      dht_migrate_batch_t *batch)
+{
+    struct synctask *task = NULL;
+    call_frame_t *frame = NULL;
+    int i = 0;
+
+    task = synctask_get();
+    if (task) {
+        frame = copy_frame(task->opframe);
+        if (frame) {
+            frame->root->uid = task->uid;
+            frame->root->gid = task->gid;
+        }
+    } else {
+        frame = syncop_create_frame(this);
+    }
+    if (!frame)
+        return -ENOMEM;
+
+    for (i = 0; i < batch->cnt; i++) {
+        batch->blocks[i].batch = batch;
+        STACK_WIND_COOKIE(frame, dht_migrate_block_readv_cbk,
+                          &batch->blocks[i], from, from->fops->readv, src,
+                          batch->blocks[i].size, batch->blocks[i].offset, 0,
+                          NULL);
+    }
+
+    syncbarrier_wait(&batch->barrier, batch->cnt);
+    STACK_DESTROY(frame->root);
+
+    return 0;
+}
+
+/* Keeps all the migrations of this process under rebal-rate-limit bytes
+ * per second, with at most a second worth of bytes in a burst. */
+static void
+dht_rebalance_throttle(xlator_t *this, uint64_t bytes)
+{
+    dht_conf_t *conf = this->private;
+    gf_defrag_info_t *defrag = conf->defrag;
+    struct timespec now;
+    uint64_t rate = conf->rebal_rate_limit;
+    int64_t wait = 0;
+    int64_t slice = 0;
+    double tokens = 0;
+
+    if (!rate)
+        return;
+
+    timespec_now(&now);
+
+    LOCK(&conf->rebal_rate_lock);
+    {
+        tokens = conf->rebal_rate_tokens +
+                 (double)gf_tsdiff(&conf->rebal_rate_stamp, &now) * rate /
+                     GF_SEC_IN_NS;
+        if (tokens > rate)
+            tokens = rate;
+        tokens -= bytes;
+        conf->rebal_rate_tokens = tokens;
+        conf->rebal_rate_stamp = now;
+    }
+    UNLOCK(&conf->rebal_rate_lock);
+
+    if (tokens >= 0)
+        return;
+
+    /* Wait for the debt to be paid, a second at most at a time so that a
+     * stopped rebalance does not linger */
+    wait = (int64_t)(-tokens * GF_SEC_IN_NS / rate) / GF_US_IN_NS;
+    while (wait > 0) {
+        slice = min(wait, GF_SEC_IN_NS / GF_US_IN_NS);
+        synctask_usleep(slice);
+        wait -= slice;
+        if (defrag && (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED))
+            break;
+    }
+}
+
 static int
 __dht_rebalance_migrate_data(xlator_t *this, xlator_t *from, xlator_t *to,
                              fd_t *src, fd_t *dst, uint64_t ia_size,
                              int hole_exists, int *fop_errno)
 {
     int ret = 0;
-    int count = 0;
+    int seek_ret = 1;
+    int i = 0;
+    int window = 1;
     off_t offset = 0;
-    struct iovec *vector = NULL;
-    struct iobref *iobref = NULL;
     uint64_t total = 0;
+    uint64_t batch_size = 0;
+    uint64_t rate = 0;
+    uint64_t last_rate = 0;
     size_t read_size = 0;
     size_t data_block_size = 0;
+    struct timespec start;
+    struct timespec end;
+    dht_migrate_block_t *block = NULL;
+    dht_migrate_batch_t *batch = NULL;
     dict_t *xdata = NULL;
     dht_conf_t *conf = NULL;
 
     conf = this->private;
 
-    /* if file size is '0', no need to enter this loop */
-    while (total < ia_size) {
-        /* This is a regular file - read it sequentially */
-        if (!hole_exists) {
-            data_block_size = ia_size - total;
-        } else {
-            /* This is a sparse file - read only the data segments in the file
-             */
-
-            /* If the previous data block is fully copied, find the next data
-             * segment starting at the offset of the last read and written
-             * byte. */
-            if (data_block_size <= 0) {
-                ret = dht_rebalance_sparse_segment(from, src, &offset,
-                                                   &data_block_size);
-                if (ret <= 0) {
-                    *fop_errno = -ret;
-                    break;
-                }
-            }
-        }
-
-        /* Calculate how much data needs to be read and written. If the data
-         * segment's length is bigger than DHT_REBALANCE_BLKSIZE, read and
-         * write DHT_REBALANCE_BLKSIZE data length and the rest in the
-         * next iteration(s) */
-        read_size = ((data_block_size > DHT_REBALANCE_BLKSIZE)
-                         ? DHT_REBALANCE_BLKSIZE
-                         : data_block_size);
+    /* if file size is '0', no need to do anything */
+    if (!ia_size)
+        return 0;
 
-        /* Calculate the remaining size of the data block - maybe there's no
-         * need to seek for data in the next iteration */
-        data_block_size -= read_size;
+    batch = GF_CALLOC(1, sizeof(*batch), gf_dht_mt_migrate_batch_t);
+    if (!batch) {
+        *fop_errno = ENOMEM;
+        return -1;
+    }
 
-        ret = syncop_readv(from, src, read_size, offset, 0, &vector, &count,
-                           &iobref, NULL, NULL, NULL);
+    if (syncbarrier_init(&batch->barrier)) {
+        GF_FREE(batch);
+        *fop_errno = ENOMEM;
+        return -1;
+    }
 
-        if (!ret || (ret < 0)) {
-            if (!ret) {
-                /* File was probably truncated*/
-                ret = -1;
-                *fop_errno = ENOSPC;
-            } else {
-                *fop_errno = -ret;
-            }
-            break;
+    if (!conf->force_migration) {
+        xdata = dict_new();
+        if (!xdata) {
+            gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_MIGRATE_FILE_FAILED,
+                   "insufficient memory");
+            ret = -1;
+            *fop_errno = ENOMEM;
+            goto out;
         }
 
-        if (!conf->force_migration) {
-            if (!xdata) {
-                xdata = dict_new();
-                if (!xdata) {
-                    gf_msg(this->name, GF_LOG_ERROR, 0,
-                           DHT_MSG_MIGRATE_FILE_FAILED, "insufficient memory");
-                    ret = -1;
-                    *fop_errno = ENOMEM;
-                    break;
-                }
+        /* Fail this write and abort rebalance if we
+         * detect a write from client since migration of
+         * this file started. This is done to avoid
+         * potential data corruption due to out of order
+         * writes from rebalance and client to the same
+         * region (as compared between src and dst
+         * files). See
+         * https://github.com/gluster/glusterfs/issues/308
+         * for more details.
+         */
+        ret = dict_set_int32_sizen(xdata, GF_AVOID_OVERWRITE, 1);
+        if (ret) {
+            gf_msg(this->name, GF_LOG_ERROR, 0, ENOMEM, "failed to set dict");
+            ret = -1;
+            *fop_errno = ENOMEM;
+            goto out;
+        }
+    }
 
-                /* Fail this write and abort rebalance if we
-                 * detect a write from client since migration of
-                 * this file started. This is done to avoid
-                 * potential data corruption due to out of order
-                 * writes from rebalance and client to the same
-                 * region (as compared between src and dst
-                 * files). See
-                 * https://github.com/gluster/glusterfs/issues/308
-                 * for more details.
-                 */
-                ret = dict_set_int32_sizen(xdata, GF_AVOID_OVERWRITE, 1);
-                if (ret) {
-                    gf_msg(this->name, GF_LOG_ERROR, 0, ENOMEM,
-                           "failed to set dict");
-                    ret = -1;
-                    *fop_errno = ENOMEM;
+    batch->to = to;
+    batch->dst = dst;
+    batch->xdata = xdata;
+
+    while ((total < ia_size) && (seek_ret > 0)) {
+        batch->cnt = 0;
+        batch_size = 0;
+        window = min(window, conf->rebal_window);
+
+        while ((batch->cnt < window) && (total + batch_size < ia_size)) {
+            /* This is a regular file - read it sequentially */
+            if (!hole_exists) {
+                data_block_size = ia_size - total - batch_size;
+            } else if (data_block_size <= 0) {
+                /* This is a sparse file - read only the data segments in
+                 * the file. If the previous data block is fully queued,
+                 * find the next data segment starting at the offset of
+                 * the last queued byte. */
+                seek_ret = dht_rebalance_sparse_segment(from, src, &offset,
+                                                        &data_block_size);
+                if (seek_ret <= 0) {
+                    *fop_errno = -seek_ret;
                     break;
                 }
             }
+
+            /* Calculate how much data needs to be read and written. If the
+             * data segment's length is bigger than DHT_REBALANCE_BLKSIZE,
+             * read and write DHT_REBALANCE_BLKSIZE data length and the rest
+             * in the next block(s) */
+            read_size = ((data_block_size > DHT_REBALANCE_BLKSIZE)
+                             ? DHT_REBALANCE_BLKSIZE
+                             : data_block_size);
+
+            /* Calculate the remaining size of the data block - maybe there's
+             * no need to seek for data for the next block */
+            data_block_size -= read_size;
+
+            block = &batch->blocks[batch->cnt++];
+            block->offset = offset;
+            block->size = read_size;
+            block->done = 0;
+
+            offset += read_size;
+            batch_size += read_size;
         }
 
-        ret = syncop_writev(to, dst, vector, count, offset, iobref, 0, NULL,
-                            NULL, xdata, NULL);
+        if (!batch->cnt)
+            break;
+
+        dht_rebalance_throttle(this, batch_size);
+
+        timespec_now(&start);
+        ret = dht_migrate_batch_run(this, from, src, batch);
         if (ret < 0) {
             *fop_errno = -ret;
             break;
         }
+        timespec_now(&end);
 
-        offset += ret;
-        total += ret;
+        for (i = 0; i < batch->cnt; i++) {
+            block = &batch->blocks[i];
+            if (block->done < 0) {
+                ret = block->done;
+                *fop_errno = -ret;
+                break;
+            }
+
+            total += block->done;
+            if ((size_t)block->done < block->size) {
+                /* Short read or write: go on right after what was written,
+                 * the blocks after this one are done again. A later block
+                 * may have found the end of the data, which no longer
+                 * holds. */
+                offset = block->offset + block->done;
+                data_block_size = 0;
+                seek_ret = 1;
+                break;
+            }
+        }
 
-        GF_FREE(vector);
-        if (iobref)
-            iobref_unref(iobref);
-        iobref = NULL;
-        vector = NULL;
+        if (ret < 0)
+            break;
+
+        /* Grow the window while it makes the copy faster, shrink it when
+         * it makes it clearly slower. */
+        rate = batch_size * GF_SEC_IN_NS / max(gf_tsdiff(&start, &end), 1);
+        if (rate >= last_rate) {
+            window = min(window * 2, conf->rebal_window);
+        } else if (rate < last_rate * 3 / 4) {
+            window = max(window / 2, 1);
+        }
+        last_rate = rate;
     }
 
-    if (iobref)
-        iobref_unref(iobref);
-    GF_FREE(vector);
+    if (seek_ret < 0)
+        ret = seek_ret;
 
+out:
     if (ret >= 0)
         ret = 0;
     else
@@ -1156,6 +1346,9 @@ __dht_rebalance_migrate_data(xlator_t *this, xlator_t *from, xlator_t *to,
         dict_unref(xdata);
     }
 
+    syncbarrier_destroy(&batch->barrier);
+    GF_FREE(batch);
+
     return ret;
 }
 
@@ -1523,6 +1716,7 @@ dht_migrate_file(xlator_t *this, loc_t *loc, xlator_t *cached_subvol,
     xlator_t *old_target = NULL;
     fd_t *linkto_fd = NULL;
     dict_t *xdata = NULL;
+    dict_t *stat_xdata = NULL;
 
     gf_log(this->name, log_level, "%s: attempting to move from %s to %s",
            loc->path, cached_subvol->name, hashed_subvol->name);
@@ -2133,7 +2327,16 @@ dht_migrate_file(xlator_t *this, loc_t *loc, xlator_t *cached_subvol,
      * failure because of ENOENT should  not be treated as error
      */
 
-    ret = syncop_stat(cached_subvol, loc, &empty_iatt, NULL, NULL);
+    /* Only the gfid is compared, the bricks need not fetch the rest */
+    stat_xdata = dict_new();
+    if (stat_xdata && dict_set_uint64(stat_xdata, GF_REQUEST_IATT_MASK,
+                                      IATT_TYPE | IATT_GFID)) {
+        dict_unref(stat_xdata);
+        stat_xdata = NULL;
+    }
+    ret = syncop_stat(cached_subvol, loc, &empty_iatt, stat_xdata, NULL);
+    if (stat_xdata)
+        dict_unref(stat_xdata);
     if (ret) {
         gf_msg(this->name, GF_LOG_WARNING, -ret, DHT_MSG_MIGRATE_FILE_FAILED,
                "%s: failed to do a stat on %s", loc->path, cached_subvol->name);
@@ -3584,29 +3787,35 @@ gf_defrag_settle_hash(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     return 0;
 }
 
+/* Failures counted by this thread, so that a fix-layout worker can tell
+ * whether the directory it just handled had any. */
+static __thread uint64_t gf_defrag_thread_failures;
+
+static void
+gf_defrag_failure_inc(gf_defrag_info_t *defrag)
+{
+    LOCK(&defrag->lock);
+    {
+        defrag->total_failures++;
+    }
+    UNLOCK(&defrag->lock);
+
+    gf_defrag_thread_failures++;
+}
+
+/* Looks @loc up, links its inode and opens it. *fd_p is left NULL when
+ * there is nothing to do with the directory. */
 static int
-gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
-                     dict_t *fix_layout, dict_t *migrate_data)
+gf_defrag_fix_layout_opendir(xlator_t *this, gf_defrag_info_t *defrag,
+                             loc_t *loc, fd_t **fd_p)
 {
     int ret = -1;
-    loc_t entry_loc = {
-        0,
-    };
     fd_t *fd = NULL;
-    gf_dirent_t entries;
-    gf_dirent_t *tmp = NULL;
-    gf_dirent_t *entry = NULL;
-    gf_boolean_t free_entries = _gf_false;
-    off_t offset = 0;
     struct iatt iatt = {
         0,
     };
-    struct iatt entry_iatt = {
-        0,
-    };
     inode_t *linked_inode = NULL, *inode = NULL;
     dht_conf_t *conf = NULL;
-    int perrno = 0;
 
     conf = this->private;
     ret = syncop_lookup(this, loc, &iatt, NULL, NULL, NULL);
@@ -3617,14 +3826,14 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                    "Skipping",
                    loc->path);
             if (conf->decommission_subvols_cnt) {
-                defrag->total_failures++;
+                gf_defrag_failure_inc(defrag);
             }
             ret = 0;
         } else {
             gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_DIR_LOOKUP_FAILED,
                    "lookup failed for:%s", loc->path);
 
-            defrag->total_failures++;
+            gf_defrag_failure_inc(defrag);
 
             if (conf->decommission_in_progress) {
                 defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
@@ -3644,7 +3853,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     if (!fd) {
         gf_log(this->name, GF_LOG_ERROR, "Failed to create fd");
 
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -3653,7 +3862,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     if (ret) {
         if (-ret == ENOENT || -ret == ESTALE) {
             if (conf->decommission_subvols_cnt) {
-                defrag->total_failures++;
+                gf_defrag_failure_inc(defrag);
             }
             ret = 0;
             goto out;
@@ -3664,12 +3873,47 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                "err:%d",
                loc->path, -ret);
 
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
 
     fd_bind(fd);
+    *fd_p = fd;
+    fd = NULL;
+    ret = 0;
+out:
+    if (fd)
+        fd_unref(fd);
+
+    return ret;
+}
+
+typedef int (*gf_defrag_subdir_fn_t)(xlator_t *this, gf_defrag_info_t *defrag,
+                                     loc_t *loc, void *data);
+
+/* Calls @fn on every subdirectory of the directory open on @fd. @fn returns
+ * -1 to stop the listing. */
+static int
+gf_defrag_fix_layout_subdirs(xlator_t *this, gf_defrag_info_t *defrag,
+                             loc_t *loc, fd_t *fd, gf_defrag_subdir_fn_t fn,
+                             void *data)
+{
+    int ret = -1;
+    loc_t entry_loc = {
+        0,
+    };
+    gf_dirent_t entries;
+    gf_dirent_t *tmp = NULL;
+    gf_dirent_t *entry = NULL;
+    gf_boolean_t free_entries = _gf_false;
+    off_t offset = 0;
+    struct iatt entry_iatt = {
+        0,
+    };
+    dht_conf_t *conf = NULL;
+
+    conf = this->private;
     INIT_LIST_HEAD(&entries.list);
 
     while ((ret = syncop_readdir(this, fd, 131072, offset, &entries, NULL,
@@ -3677,7 +3921,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
         if (ret < 0) {
             if (-ret == ENOENT || -ret == ESTALE) {
                 if (conf->decommission_subvols_cnt) {
-                    defrag->total_failures++;
+                    gf_defrag_failure_inc(defrag);
                 }
                 ret = 0;
                 goto out;
@@ -3688,7 +3932,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                    "path %s. Aborting fix-layout",
                    loc->path);
 
-            defrag->total_failures++;
+            gf_defrag_failure_inc(defrag);
             ret = -1;
             goto out;
         }
@@ -3722,7 +3966,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                        " build failed for entry: %s",
                        entry->d_name);
 
-                defrag->total_failures++;
+                gf_defrag_failure_inc(defrag);
 
                 if (conf->decommission_in_progress) {
                     defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
@@ -3745,30 +3989,11 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                  * such a filesystem is found.*/
             }
 
-            /* A return value of 2 means, either process_dir or
-             * lookup of a dir failed. Hence, don't commit hash
-             * for the current directory*/
-
-            ret = gf_defrag_fix_layout(this, defrag, &entry_loc, fix_layout,
-                                       migrate_data);
-
-            if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
-                goto out;
-            }
+            GF_ATOMIC_INC(defrag->fix_layout_dirs_found);
 
+            ret = fn(this, defrag, &entry_loc, data);
             if (ret) {
-                gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_LAYOUT_FIX_FAILED,
-                       "Fix layout failed for %s", entry_loc.path);
-
-                if (conf->decommission_in_progress) {
-                    defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
-
-                    goto out;
-                } else {
-                    /* Let's not commit-hash if
-                     * gf_defrag_fix_layout failed*/
-                    continue;
-                }
+                goto out;
             }
         }
 
@@ -3777,6 +4002,28 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
         INIT_LIST_HEAD(&entries.list);
     }
 
+out:
+    if (free_entries)
+        gf_dirent_free(&entries);
+
+    loc_wipe(&entry_loc);
+
+    return ret;
+}
+
+/* Writes the new layout of @loc once its subdirectories are done, then
+ * migrates its files if this is a full rebalance. */
+static int
+gf_defrag_fix_layout_commit(xlator_t *this, gf_defrag_info_t *defrag,
+                            loc_t *loc, dict_t *fix_layout,
+                            dict_t *migrate_data)
+{
+    int ret = -1;
+    dht_conf_t *conf = NULL;
+    int perrno = 0;
+
+    conf = this->private;
+
     /* A directory layout is fixed only after its subdirs are healed to
      * any newly added bricks. If the layout is fixed before subdirs are
      * healed, the newly added brick will get a non-null layout.
@@ -3803,7 +4050,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                    "renamed or removed",
                    loc->path);
             if (conf->decommission_subvols_cnt) {
-                defrag->total_failures++;
+                gf_defrag_failure_inc(defrag);
             }
             ret = 0;
             goto out;
@@ -3811,7 +4058,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
             gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_LAYOUT_FIX_FAILED,
                    "Setxattr failed for %s", loc->path);
 
-            defrag->total_failures++;
+            gf_defrag_failure_inc(defrag);
 
             if (conf->decommission_in_progress) {
                 defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
@@ -3833,7 +4080,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                 ret = 0;
                 goto out;
             } else {
-                defrag->total_failures++;
+                gf_defrag_failure_inc(defrag);
 
                 gf_msg(this->name, GF_LOG_ERROR, 0,
                        DHT_MSG_DEFRAG_PROCESS_DIR_FAILED,
@@ -3851,7 +4098,7 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
     gf_msg_trace(this->name, 0, "fix layout called on %s", loc->path);
 
     if (gf_defrag_settle_hash(this, defrag, loc, fix_layout) != 0) {
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
 
         gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_SETTLE_HASH_FAILED,
                "Settle hash failed for %s", loc->path);
@@ -3866,14 +4113,524 @@ gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
 
     ret = 0;
 out:
-    if (free_entries)
-        gf_dirent_free(&entries);
+    GF_ATOMIC_INC(defrag->fix_layout_dirs_done);
 
-    loc_wipe(&entry_loc);
+    return ret;
+}
+
+struct gf_defrag_fix_layout_args {
+    dict_t *fix_layout;
+    dict_t *migrate_data;
+};
+
+static int
+gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
+                     dict_t *fix_layout, dict_t *migrate_data);
+
+static int
+gf_defrag_fix_layout_subdir(xlator_t *this, gf_defrag_info_t *defrag,
+                            loc_t *loc, void *data)
+{
+    struct gf_defrag_fix_layout_args *args = data;
+    dht_conf_t *conf = NULL;
+    int ret = 0;
+
+    conf = this->private;
+
+    ret = gf_defrag_fix_layout(this, defrag, loc, args->fix_layout,
+                               args->migrate_data);
 
+    if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
+        return -1;
+    }
+
+    if (ret) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_LAYOUT_FIX_FAILED,
+               "Fix layout failed for %s", loc->path);
+
+        if (conf->decommission_in_progress) {
+            defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
+            return -1;
+        }
+        /* Let's not commit-hash if gf_defrag_fix_layout failed */
+    }
+
+    return 0;
+}
+
+static int
+gf_defrag_fix_layout(xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
+                     dict_t *fix_layout, dict_t *migrate_data)
+{
+    struct gf_defrag_fix_layout_args args = {
+        .fix_layout = fix_layout,
+        .migrate_data = migrate_data,
+    };
+    fd_t *fd = NULL;
+    int ret = -1;
+
+    ret = gf_defrag_fix_layout_opendir(this, defrag, loc, &fd);
+    if (ret || !fd)
+        goto out;
+
+    ret = gf_defrag_fix_layout_subdirs(this, defrag, loc, fd,
+                                       gf_defrag_fix_layout_subdir, &args);
+
+    if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED) {
+        ret = 0;
+        goto out;
+    }
+
+    if (ret)
+        goto out;
+
+    ret = gf_defrag_fix_layout_commit(this, defrag, loc, fix_layout,
+                                      migrate_data);
+out:
+    if (fd)
+        fd_unref(fd);
+
+    return ret;
+}
+
+/* Parallel fix-layout crawl.
+ *
+ * Directories are queued and looked up, listed and fixed by a pool of
+ * threads. The layout of a directory is still written only after all its
+ * subdirectories are done: each directory counts its own listing and its
+ * unfinished subdirectories, and whoever brings the count to zero commits
+ * it and then releases its parent. The queue is used as a stack so that
+ * the crawl goes depth first and the number of queued directories stays
+ * close to what the serial crawl keeps on its stack. When the queue is
+ * full anyway, a thread fixes the subdirectory itself with the serial
+ * crawl.
+ *
+ * Subtrees close to the root are recorded in the checkpoint file once
+ * done without any failure. A crawl started again with the same commit
+ * hash skips them and retries the rest. The file is removed when the
+ * crawl completes cleanly.
+ */
+
+#define GF_FIX_LAYOUT_MAX_QUEUED 65536
+#define GF_FIX_LAYOUT_CHECKPOINT_DEPTH 2
+
+typedef struct gf_fix_layout_dir gf_fix_layout_dir_t;
+
+struct gf_fix_layout_dir {
+    struct list_head list;
+    loc_t loc;
+    gf_fix_layout_dir_t *parent;
+    gf_atomic_t pending; /* own listing and unfinished subdirectories */
+    gf_atomic_t failed;  /* failures in this subtree */
+    int depth;
+};
+
+typedef struct gf_fix_layout_crawl {
+    xlator_t *this;
+    gf_defrag_info_t *defrag;
+    struct gf_defrag_fix_layout_args args;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct list_head queue;
+    int queued;
+    int busy;
+    int root_ret;
+    gf_boolean_t root_failed;
+    FILE *checkpoint;
+    dict_t *completed; /* gfids read from the checkpoint */
+} gf_fix_layout_crawl_t;
+
+static void
+gf_fix_layout_dir_free(gf_fix_layout_dir_t *dir)
+{
+    loc_wipe(&dir->loc);
+    GF_FREE(dir);
+}
+
+static gf_fix_layout_dir_t *
+gf_fix_layout_dir_new(loc_t *loc, gf_fix_layout_dir_t *parent)
+{
+    gf_fix_layout_dir_t *dir = NULL;
+
+    dir = GF_CALLOC(1, sizeof(*dir), gf_dht_mt_fix_layout_dir_t);
+    if (!dir)
+        return NULL;
+
+    if (loc_copy(&dir->loc, loc)) {
+        GF_FREE(dir);
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&dir->list);
+    GF_ATOMIC_INIT(dir->pending, 1);
+    GF_ATOMIC_INIT(dir->failed, 0);
+    dir->parent = parent;
+    dir->depth = parent ? parent->depth + 1 : 0;
+
+    return dir;
+}
+
+static void
+gf_fix_layout_checkpoint_open(gf_fix_layout_crawl_t *crawl)
+{
+    gf_defrag_info_t *defrag = crawl->defrag;
+    xlator_t *this = crawl->this;
+    char line[64] = {
+        0,
+    };
+    uint32_t hash = 0;
+    FILE *fp = NULL;
+    size_t len = 0;
+
+    if (!defrag->fix_layout_checkpoint)
+        return;
+
+    crawl->completed = dict_new();
+    if (!crawl->completed)
+        return;
+
+    fp = fopen(defrag->fix_layout_checkpoint, "r");
+    if (fp) {
+        if (fgets(line, sizeof(line), fp) &&
+            (sscanf(line, "commit-hash %u", &hash) == 1) &&
+            (hash == defrag->new_commit_hash)) {
+            while (fgets(line, sizeof(line), fp)) {
+                len = strlen(line);
+                if (len && (line[len - 1] == '\n'))
+                    line[len - 1] = '\0';
+                if (dict_set_int32(crawl->completed, line, 1))
+                    break;
+            }
+        }
+        fclose(fp);
+    }
+
+    if (crawl->completed->count) {
+        gf_msg(this->name, GF_LOG_INFO, 0, 0,
+               "fix-layout resumes from %s, skipping %d directories",
+               defrag->fix_layout_checkpoint, crawl->completed->count);
+        crawl->checkpoint = fopen(defrag->fix_layout_checkpoint, "a");
+    } else {
+        crawl->checkpoint = fopen(defrag->fix_layout_checkpoint, "w");
+        if (crawl->checkpoint) {
+            fprintf(crawl->checkpoint, "commit-hash %u\n",
+                    defrag->new_commit_hash);
+            fflush(crawl->checkpoint);
+        }
+    }
+
+    if (!crawl->checkpoint)
+        gf_msg(this->name, GF_LOG_WARNING, errno, 0,
+               "failed to open fix-layout checkpoint %s",
+               defrag->fix_layout_checkpoint);
+}
+
+static void
+gf_fix_layout_checkpoint_close(gf_fix_layout_crawl_t *crawl, int ret)
+{
+    gf_defrag_info_t *defrag = crawl->defrag;
+
+    if (crawl->checkpoint) {
+        fclose(crawl->checkpoint);
+        if ((ret == 0) && !crawl->root_failed &&
+            (defrag->defrag_status == GF_DEFRAG_STATUS_STARTED))
+            sys_unlink(defrag->fix_layout_checkpoint);
+    }
+
+    if (crawl->completed)
+        dict_unref(crawl->completed);
+}
+
+static gf_boolean_t
+gf_fix_layout_checkpoint_done(gf_fix_layout_crawl_t *crawl,
+                              gf_fix_layout_dir_t *dir)
+{
+    if (!crawl->completed || !crawl->completed->count || !dir->depth ||
+        (dir->depth > GF_FIX_LAYOUT_CHECKPOINT_DEPTH))
+        return _gf_false;
+
+    return (dict_get(crawl->completed, uuid_utoa(dir->loc.inode->gfid)) !=
+            NULL);
+}
+
+/* Called with crawl->mutex held */
+static void
+__gf_fix_layout_checkpoint_add(gf_fix_layout_crawl_t *crawl,
+                               gf_fix_layout_dir_t *dir)
+{
+    if (!crawl->checkpoint || !dir->depth ||
+        (dir->depth > GF_FIX_LAYOUT_CHECKPOINT_DEPTH) ||
+        gf_uuid_is_null(dir->loc.inode->gfid))
+        return;
+
+    fprintf(crawl->checkpoint, "%s\n", uuid_utoa(dir->loc.inode->gfid));
+    fflush(crawl->checkpoint);
+}
+
+/* Drops one pending count from @dir. The last one commits the directory
+ * and goes on with its parent. A directory is recorded in the checkpoint
+ * only if neither it nor anything below it failed, and a failure is
+ * passed on to the parent before the parent's count is dropped. */
+static void
+gf_fix_layout_dir_release(gf_fix_layout_crawl_t *crawl,
+                          gf_fix_layout_dir_t *dir, gf_boolean_t commit)
+{
+    gf_defrag_info_t *defrag = crawl->defrag;
+    xlator_t *this = crawl->this;
+    gf_fix_layout_dir_t *parent = NULL;
+    dht_conf_t *conf = NULL;
+    uint64_t failures = 0;
+    int ret = 0;
+
+    conf = this->private;
+
+    while (dir && (GF_ATOMIC_DEC(dir->pending) == 0)) {
+        if (commit && (defrag->defrag_status == GF_DEFRAG_STATUS_STARTED)) {
+            failures = gf_defrag_thread_failures;
+            ret = gf_defrag_fix_layout_commit(this, defrag, &dir->loc,
+                                              crawl->args.fix_layout,
+                                              crawl->args.migrate_data);
+            if (ret) {
+                gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_LAYOUT_FIX_FAILED,
+                       "Fix layout failed for %s", dir->loc.path);
+                if (conf->decommission_in_progress)
+                    defrag->defrag_status = GF_DEFRAG_STATUS_FAILED;
+            }
+
+            /* The commit counts most of its errors as failures and
+             * still returns 0 */
+            if (ret || (gf_defrag_thread_failures != failures))
+                GF_ATOMIC_INC(dir->failed);
+
+            if (GF_ATOMIC_GET(dir->failed) == 0) {
+                pthread_mutex_lock(&crawl->mutex);
+                {
+                    __gf_fix_layout_checkpoint_add(crawl, dir);
+                }
+                pthread_mutex_unlock(&crawl->mutex);
+            }
+        }
+
+        parent = dir->parent;
+        if (!parent) {
+            crawl->root_ret = commit ? ret : -1;
+            crawl->root_failed = (GF_ATOMIC_GET(dir->failed) != 0);
+        } else if (GF_ATOMIC_GET(dir->failed)) {
+            GF_ATOMIC_INC(parent->failed);
+        }
+
+        gf_fix_layout_dir_free(dir);
+        dir = parent;
+        /* A directory that could not be listed is not committed, but its
+         * parent still is, like in the serial crawl. */
+        commit = _gf_true;
+    }
+}
+
+static int
+gf_fix_layout_queue_subdir(xlator_t *this, gf_defrag_info_t *defrag,
+                           loc_t *loc, void *data)
+{
+    gf_fix_layout_dir_t *parent = data;
+    gf_fix_layout_crawl_t *crawl = NULL;
+    gf_fix_layout_dir_t *dir = NULL;
+    gf_boolean_t inline_fix = _gf_false;
+
+    crawl = defrag->fix_layout_crawl;
+
+    pthread_mutex_lock(&crawl->mutex);
+    {
+        if (crawl->queued >= GF_FIX_LAYOUT_MAX_QUEUED)
+            inline_fix = _gf_true;
+    }
+    pthread_mutex_unlock(&crawl->mutex);
+
+    if (inline_fix)
+        return gf_defrag_fix_layout_subdir(this, defrag, loc, &crawl->args);
+
+    dir = gf_fix_layout_dir_new(loc, parent);
+    if (!dir) {
+        gf_defrag_failure_inc(defrag);
+        return 0;
+    }
+
+    GF_ATOMIC_INC(parent->pending);
+
+    pthread_mutex_lock(&crawl->mutex);
+    {
+        list_add(&dir->list, &crawl->queue);
+        crawl->queued++;
+        pthread_cond_signal(&crawl->cond);
+    }
+    pthread_mutex_unlock(&crawl->mutex);
+
+    return 0;
+}
+
+static void
+gf_fix_layout_dir_crawl(gf_fix_layout_crawl_t *crawl, gf_fix_layout_dir_t *dir)
+{
+    gf_defrag_info_t *defrag = crawl->defrag;
+    xlator_t *this = crawl->this;
+    uint64_t failures = gf_defrag_thread_failures;
+    fd_t *fd = NULL;
+    int ret = -1;
+
+    if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED)
+        goto out;
+
+    ret = gf_defrag_fix_layout_opendir(this, defrag, &dir->loc, &fd);
+    if (ret || !fd) {
+        /* Nothing to retry for a directory that is gone */
+        if (ret)
+            GF_ATOMIC_INC(dir->failed);
+        ret = -1;
+        goto out;
+    }
+
+    if (gf_fix_layout_checkpoint_done(crawl, dir)) {
+        gf_msg_debug(this->name, 0, "%s already fixed, skipping",
+                     dir->loc.path);
+        GF_ATOMIC_INC(defrag->fix_layout_dirs_done);
+        /* Neither committed nor recorded again */
+        ret = -1;
+        goto out;
+    }
+
+    ret = gf_defrag_fix_layout_subdirs(this, defrag, &dir->loc, fd,
+                                       gf_fix_layout_queue_subdir, dir);
+    /* Also catches the subdirectories that could not be queued or were
+     * fixed right here */
+    if (ret || (gf_defrag_thread_failures != failures))
+        GF_ATOMIC_INC(dir->failed);
+out:
     if (fd)
         fd_unref(fd);
 
+    gf_fix_layout_dir_release(crawl, dir, (ret == 0));
+}
+
+static void *
+gf_fix_layout_worker(void *opaque)
+{
+    gf_fix_layout_crawl_t *crawl = opaque;
+    gf_fix_layout_dir_t *dir = NULL;
+    pid_t pid = GF_CLIENT_PID_DEFRAG;
+    gf_lkowner_t lkowner;
+
+    THIS = crawl->this;
+    syncopctx_setfspid(&pid);
+    set_lk_owner_from_ptr(&lkowner, &lkowner);
+    syncopctx_setfslkowner(&lkowner);
+
+    for (;;) {
+        pthread_mutex_lock(&crawl->mutex);
+        {
+            while (list_empty(&crawl->queue) && crawl->busy)
+                pthread_cond_wait(&crawl->cond, &crawl->mutex);
+
+            if (list_empty(&crawl->queue)) {
+                /* Nothing queued and nobody left to queue more */
+                pthread_cond_broadcast(&crawl->cond);
+                pthread_mutex_unlock(&crawl->mutex);
+                break;
+            }
+
+            dir = list_first_entry(&crawl->queue, gf_fix_layout_dir_t, list);
+            list_del_init(&dir->list);
+            crawl->queued--;
+            crawl->busy++;
+        }
+        pthread_mutex_unlock(&crawl->mutex);
+
+        gf_fix_layout_dir_crawl(crawl, dir);
+
+        pthread_mutex_lock(&crawl->mutex);
+        {
+            crawl->busy--;
+            if (!crawl->busy)
+                pthread_cond_broadcast(&crawl->cond);
+        }
+        pthread_mutex_unlock(&crawl->mutex);
+    }
+
+    return NULL;
+}
+
+static int
+gf_defrag_fix_layout_parallel(xlator_t *this, gf_defrag_info_t *defrag,
+                              loc_t *loc, dict_t *fix_layout,
+                              dict_t *migrate_data)
+{
+    gf_fix_layout_crawl_t crawl = {
+        0,
+    };
+    gf_fix_layout_dir_t *root = NULL;
+    pthread_t *tid = NULL;
+    int count = 0;
+    int i = 0;
+    int ret = -1;
+
+    crawl.this = this;
+    crawl.defrag = defrag;
+    crawl.args.fix_layout = fix_layout;
+    crawl.args.migrate_data = migrate_data;
+    crawl.root_ret = -1;
+    INIT_LIST_HEAD(&crawl.queue);
+    pthread_mutex_init(&crawl.mutex, NULL);
+    pthread_cond_init(&crawl.cond, NULL);
+
+    root = gf_fix_layout_dir_new(loc, NULL);
+    if (!root)
+        goto out;
+
+    tid = GF_CALLOC(defrag->fix_layout_threads, sizeof(pthread_t),
+                    gf_common_mt_pthread_t);
+    if (!tid) {
+        gf_fix_layout_dir_free(root);
+        goto out;
+    }
+
+    gf_fix_layout_checkpoint_open(&crawl);
+    defrag->fix_layout_crawl = &crawl;
+
+    list_add(&root->list, &crawl.queue);
+    crawl.queued = 1;
+
+    for (i = 0; i < defrag->fix_layout_threads; i++) {
+        if (gf_thread_create(&tid[i], NULL, gf_fix_layout_worker, &crawl,
+                             "dhtfix%d", (i + 1) & 0x3ff) != 0) {
+            gf_msg(this->name, GF_LOG_WARNING, 0, 0,
+                   "Failed to create fix-layout thread %d of %d", i,
+                   defrag->fix_layout_threads);
+            break;
+        }
+        count++;
+    }
+
+    if (count == 0) {
+        /* Crawl from here then */
+        gf_fix_layout_worker(&crawl);
+    }
+
+    gf_msg(this->name, GF_LOG_INFO, 0, 0, "fix-layout crawl uses %d threads",
+           count ? count : 1);
+
+    for (i = 0; i < count; i++)
+        pthread_join(tid[i], NULL);
+
+    defrag->fix_layout_crawl = NULL;
+
+    ret = crawl.root_ret;
+    if (defrag->defrag_status != GF_DEFRAG_STATUS_STARTED)
+        ret = 0;
+
+    gf_fix_layout_checkpoint_close(&crawl, crawl.root_ret);
+    GF_FREE(tid);
+out:
+    pthread_cond_destroy(&crawl.cond);
+    pthread_mutex_destroy(&crawl.mutex);
+
     return ret;
 }
 
@@ -4278,7 +5035,7 @@ gf_defrag_start_crawl(void *data)
     if (ret) {
         gf_log(this->name, GF_LOG_ERROR, "Failed to set %s",
                conf->commithash_xattr_name);
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -4289,7 +5046,7 @@ gf_defrag_start_crawl(void *data)
                "Failed to set commit hash on %s. "
                "Rebalance cannot proceed.",
                loc.path);
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -4302,7 +5059,7 @@ gf_defrag_start_crawl(void *data)
                "Failed to start rebalance:"
                "Failed to set dictionary value: key = %s",
                GF_XATTR_FIX_LAYOUT_KEY);
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -4313,7 +5070,7 @@ gf_defrag_start_crawl(void *data)
     if (ret) {
         gf_msg(this->name, GF_LOG_ERROR, -ret, DHT_MSG_REBALANCE_FAILED,
                "fix layout on %s failed", loc.path);
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -4323,7 +5080,7 @@ gf_defrag_start_crawl(void *data)
 
         migrate_data = dict_new();
         if (!migrate_data) {
-            defrag->total_failures++;
+            gf_defrag_failure_inc(defrag);
             ret = -1;
             goto out;
         }
@@ -4331,7 +5088,7 @@ gf_defrag_start_crawl(void *data)
             migrate_data, GF_XATTR_FILE_MIGRATE_KEY,
             (defrag->cmd == GF_DEFRAG_CMD_START_FORCE) ? "force" : "non-force");
         if (ret) {
-            defrag->total_failures++;
+            gf_defrag_failure_inc(defrag);
             ret = -1;
             goto out;
         }
@@ -4359,14 +5116,22 @@ gf_defrag_start_crawl(void *data)
         }
     }
 
-    ret = gf_defrag_fix_layout(this, defrag, &loc, fix_layout, migrate_data);
+    GF_ATOMIC_INC(defrag->fix_layout_dirs_found);
+
+    if ((defrag->cmd == GF_DEFRAG_CMD_START_LAYOUT_FIX) &&
+        (defrag->fix_layout_threads > 1))
+        ret = gf_defrag_fix_layout_parallel(this, defrag, &loc, fix_layout,
+                                            migrate_data);
+    else
+        ret = gf_defrag_fix_layout(this, defrag, &loc, fix_layout,
+                                   migrate_data);
     if (ret) {
         ret = -1;
         goto out;
     }
 
     if (gf_defrag_settle_hash(this, defrag, &loc, fix_layout) != 0) {
-        defrag->total_failures++;
+        gf_defrag_failure_inc(defrag);
         ret = -1;
         goto out;
     }
@@ -4544,6 +5309,8 @@ gf_defrag_status_get(xlator_t *this, dht_conf_t *conf, dict_t *dict,
     time_t elapsed = 0;
     time_t time_to_complete = 0;
     time_t time_left = 0;
+    uint64_t dirs_found = 0;
+    uint64_t dirs_done = 0;
     gf_defrag_info_t *defrag = conf->defrag;
 
     if (!defrag)
@@ -4558,6 +5325,8 @@ gf_defrag_status_get(xlator_t *this, dht_conf_t *conf, dict_t *dict,
     lookup = defrag->num_files_lookedup;
     failures = defrag->total_failures;
     skipped = defrag->skipped;
+    dirs_found = GF_ATOMIC_GET(defrag->fix_layout_dirs_found);
+    dirs_done = GF_ATOMIC_GET(defrag->fix_layout_dirs_done);
 
     elapsed = gf_time() - defrag->start_time;
 
@@ -4573,6 +5342,18 @@ gf_defrag_status_get(xlator_t *this, dht_conf_t *conf, dict_t *dict,
                "TIME: Estimated total time to complete (size)= %ld"
                " seconds, seconds left = %ld",
                time_to_complete, time_left);
+
+        /* A fix-layout migrates nothing, so estimate from the directories
+         * found so far. More are found as the crawl goes on. */
+        if ((defrag->cmd == GF_DEFRAG_CMD_START_LAYOUT_FIX) && dirs_done &&
+            (dirs_found > dirs_done) && (elapsed > 0)) {
+            time_left = (dirs_found - dirs_done) * elapsed / dirs_done;
+
+            gf_log(this->name, GF_LOG_INFO,
+                   "fix-layout: %" PRIu64 " of %" PRIu64
+                   " directories done, seconds left = %ld",
+                   dirs_done, dirs_found, time_left);
+        }
     }
 
     if (!dict)
@@ -4610,6 +5391,16 @@ gf_defrag_status_get(xlator_t *this, dht_conf_t *conf, dict_t *dict,
     if (ret)
         gf_log(this->name, GF_LOG_WARNING, "failed to set time-left");
 
+    ret = dict_set_uint64(dict, "fix-layout-dirs", dirs_found);
+    if (ret)
+        gf_log(this->name, GF_LOG_WARNING,
+               "failed to set fix-layout directory count");
+
+    ret = dict_set_uint64(dict, "fix-layout-dirs-done", dirs_done);
+    if (ret)
+        gf_log(this->name, GF_LOG_WARNING,
+               "failed to set fix-layout done directory count");
+
 log:
     if (log_status) {
         switch (defrag->defrag_status) {
@@ -1976,6 +1976,9 @@ dht_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
         goto err;
     }
 
+    if (local->entry_cache_inval)
+        dht_entry_cache_invalidate(this, newloc->parent, newloc->name);
+
     local->src_hashed = src_hashed;
     local->src_cached = src_cached;
     local->dst_hashed = dst_hashed;
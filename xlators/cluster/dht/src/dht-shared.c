@@ -111,8 +111,28 @@ dht_priv_dump(xlator_t *this)
     gf_proc_dump_write("min_free_inodes", "%lf", conf->min_free_inodes);
     gf_proc_dump_write("disk_unit percentage", "%d", conf->disk_unit_percent);
     gf_proc_dump_write("refresh_interval", "%d", conf->refresh_interval);
+    gf_proc_dump_write("weighted_placement", "%d",
+                       conf->du_weighted_placement);
     gf_proc_dump_write("unhashed_sticky_bit", "%d", conf->unhashed_sticky_bit);
     gf_proc_dump_write("use-readdirp", "%d", conf->use_readdirp);
+    gf_proc_dump_write("readdirp-fanout", "%d", conf->readdirp_fanout);
+    gf_proc_dump_write("readdirp-fanout-hits", "%" PRId64,
+                       GF_ATOMIC_GET(conf->readdirp_fanout_hits));
+    gf_proc_dump_write("readdirp-fanout-misses", "%" PRId64,
+                       GF_ATOMIC_GET(conf->readdirp_fanout_misses));
+    gf_proc_dump_write("entry-cache", "%d", conf->entry_cache);
+    gf_proc_dump_write("entry-cache-missing-hits", "%" PRId64,
+                       GF_ATOMIC_GET(conf->entry_cache_missing_hits));
+    gf_proc_dump_write("entry-cache-linkto-hits", "%" PRId64,
+                       GF_ATOMIC_GET(conf->entry_cache_linkto_hits));
+    gf_proc_dump_write("entry-cache-misses", "%" PRId64,
+                       GF_ATOMIC_GET(conf->entry_cache_misses));
+    gf_proc_dump_write("entry-cache-invalidations", "%" PRId64,
+                       GF_ATOMIC_GET(conf->entry_cache_invalidations));
+    gf_proc_dump_write("lookup-everywhere", "%" PRId64,
+                       GF_ATOMIC_GET(conf->lookup_everywhere_cnt));
+    gf_proc_dump_write("rebal-window", "%d", conf->rebal_window);
+    gf_proc_dump_write("rebal-rate-limit", "%" PRIu64, conf->rebal_rate_limit);
 
     if (conf->du_stats && conf->subvolume_status) {
         for (i = 0; i < conf->subvolume_cnt; i++) {
@@ -133,6 +153,16 @@ dht_priv_dump(xlator_t *this)
 
             snprintf(key, sizeof(key), "du_stats[%d].log", i);
             gf_proc_dump_write(key, "%" PRIu32, conf->du_stats[i].log);
+
+            snprintf(key, sizeof(key), "du_stats[%d].filled", i);
+            gf_proc_dump_write(key, "%" PRId64,
+                               GF_ATOMIC_GET(conf->du_stats[i].filled));
+
+            snprintf(key, sizeof(key), "du_stats[%d].latency_usec", i);
+            gf_proc_dump_write(key, "%" PRIu64, conf->du_stats[i].latency);
+
+            snprintf(key, sizeof(key), "du_stats[%d].refreshes", i);
+            gf_proc_dump_write(key, "%" PRIu64, conf->du_stats[i].refreshes);
         }
     }
 
@@ -180,6 +210,8 @@ dht_fini(xlator_t *this)
     GF_VALIDATE_OR_GOTO("dht", this, out);
 
     conf = this->private;
+    if (conf)
+        dht_du_refresh_stop(this);
     this->private = NULL;
     if (conf) {
         if (conf->file_layouts) {
@@ -315,6 +347,8 @@ dht_init_regex(xlator_t *this, dict_t *odict, char *name, regex_t *re,
 
     LOCK(&conf->lock);
     {
+        dht_hash_cache_reset(conf);
+
         if (*re_valid) {
             regfree(re);
             *re_valid = _gf_false;
@@ -434,12 +468,24 @@ dht_reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("min-free-inodes", conf->min_free_inodes, options, percent,
                      out);
+    dht_du_update_filled(this);
+
+    GF_OPTION_RECONF("du-refresh-interval", conf->refresh_interval, options,
+                     int32, out);
+    dht_du_refresh_start(this);
+    GF_OPTION_RECONF("weighted-placement", conf->du_weighted_placement,
+                     options, bool, out);
 
     GF_OPTION_RECONF("directory-layout-spread", conf->dir_spread_cnt, options,
                      uint32, out);
 
     GF_OPTION_RECONF("readdir-optimize", conf->readdir_optimize, options, bool,
                      out);
+    GF_OPTION_RECONF("readdirp-fanout", conf->readdirp_fanout, options, int32,
+                     out);
+    GF_OPTION_RECONF("entry-cache", conf->entry_cache, options, bool, out);
+    GF_OPTION_RECONF("entry-cache-timeout", conf->entry_cache_timeout, options,
+                     int32, out);
     GF_OPTION_RECONF("randomize-hash-range-by-gfid", conf->randomize_by_gfid,
                      options, bool, out);
 
@@ -448,6 +494,9 @@ dht_reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("force-migration", conf->force_migration, options, bool,
                      out);
+    GF_OPTION_RECONF("rebal-window", conf->rebal_window, options, int32, out);
+    GF_OPTION_RECONF("rebal-rate-limit", conf->rebal_rate_limit, options,
+                     size_uint64, out);
 
     GF_OPTION_RECONF("ensure-durability", conf->ensure_durability, options,
                      bool, out);
@@ -467,6 +516,8 @@ dht_reconfigure(xlator_t *this, dict_t *options)
     if (conf->defrag) {
         GF_OPTION_RECONF("rebalance-stats", conf->defrag->stats, options, bool,
                          out);
+        GF_OPTION_RECONF("fix-layout-threads",
+                         conf->defrag->fix_layout_threads, options, int32, out);
     }
 
     if (dict_get_str(options, "decommissioned-bricks", &temp_str) == 0) {
@@ -606,6 +657,8 @@ dht_init(xlator_t *this)
 
     LOCK_INIT(&conf->subvolume_lock);
     LOCK_INIT(&conf->lock);
+    LOCK_INIT(&conf->rebal_rate_lock);
+    GF_ATOMIC_INIT(conf->hash_cookie, 0);
     synclock_init(&conf->link_lock, SYNC_LOCK_DEFAULT);
 
     /* We get the commit-hash to set only for rebalance process */
@@ -669,6 +722,9 @@ dht_init(xlator_t *this)
         pthread_cond_init(&defrag->fc_wakeup_cond, 0);
 
         defrag->global_error = 0;
+
+        GF_ATOMIC_INIT(defrag->fix_layout_dirs_found, 0);
+        GF_ATOMIC_INIT(defrag->fix_layout_dirs_done, 0);
     }
 
     conf->use_fallocate = 1;
@@ -701,6 +757,10 @@ dht_init(xlator_t *this)
 
     GF_OPTION_INIT("min-free-inodes", conf->min_free_inodes, percent, err);
 
+    GF_OPTION_INIT("du-refresh-interval", conf->refresh_interval, int32, err);
+    GF_OPTION_INIT("weighted-placement", conf->du_weighted_placement, bool,
+                   err);
+
     conf->dir_spread_cnt = conf->subvolume_cnt;
     GF_OPTION_INIT("directory-layout-spread", conf->dir_spread_cnt, uint32,
                    err);
@@ -710,9 +770,26 @@ dht_init(xlator_t *this)
 
     GF_OPTION_INIT("readdir-optimize", conf->readdir_optimize, bool, err);
 
+    GF_OPTION_INIT("readdirp-fanout", conf->readdirp_fanout, int32, err);
+    GF_ATOMIC_INIT(conf->readdirp_fanout_hits, 0);
+    GF_ATOMIC_INIT(conf->readdirp_fanout_misses, 0);
+
+    GF_OPTION_INIT("entry-cache", conf->entry_cache, bool, err);
+    GF_OPTION_INIT("entry-cache-timeout", conf->entry_cache_timeout, int32,
+                   err);
+    GF_ATOMIC_INIT(conf->entry_cache_gen, 0);
+    GF_ATOMIC_INIT(conf->entry_cache_missing_hits, 0);
+    GF_ATOMIC_INIT(conf->entry_cache_linkto_hits, 0);
+    GF_ATOMIC_INIT(conf->entry_cache_misses, 0);
+    GF_ATOMIC_INIT(conf->entry_cache_invalidations, 0);
+    GF_ATOMIC_INIT(conf->lookup_everywhere_cnt, 0);
+
     GF_OPTION_INIT("lock-migration", conf->lock_migration_enabled, bool, err);
 
     GF_OPTION_INIT("force-migration", conf->force_migration, bool, err);
+    GF_OPTION_INIT("rebal-window", conf->rebal_window, int32, err);
+    GF_OPTION_INIT("rebal-rate-limit", conf->rebal_rate_limit, size_uint64,
+                   err);
 
     GF_OPTION_INIT("ensure-durability", conf->ensure_durability, bool, err);
 
@@ -720,6 +797,10 @@ dht_init(xlator_t *this)
         defrag->lock_migration_enabled = conf->lock_migration_enabled;
 
         GF_OPTION_INIT("rebalance-stats", defrag->stats, bool, err);
+        GF_OPTION_INIT("fix-layout-threads", defrag->fix_layout_threads, int32,
+                       err);
+        GF_OPTION_INIT("rebalance-checkpoint", defrag->fix_layout_checkpoint,
+                       str, err);
         if (dict_get_str(this->options, "rebalance-filter", &temp_str) == 0) {
             if (gf_defrag_pattern_list_fill(this, defrag, temp_str) == -1) {
                 gf_msg(this->name, GF_LOG_ERROR, 0, DHT_MSG_INVALID_OPTION,
@@ -906,6 +987,30 @@ struct volume_options dht_options[] = {
      .op_version = {1},
      .level = OPT_STATUS_BASIC,
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"du-refresh-interval"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 3600,
+     .default_value = "0",
+     .description =
+         "Interval in seconds at which the disk usage of every subvolume is "
+         "refreshed in the background, each on its own slightly randomized "
+         "schedule. Creates then never ask for it. 0 refreshes it from the "
+         "creates, at most once a second.",
+     .op_version = {GD_OP_VERSION_12_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"weighted-placement"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description =
+         "When the hashed subvolume of a new file is short of space or "
+         "inodes, pick another subvolume at random, weighted by its free "
+         "space and how fast it answers, instead of the one with the most "
+         "free space.",
+     .op_version = {GD_OP_VERSION_12_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {
         .key = {"unhashed-sticky-bit"},
         .type = GF_OPTION_TYPE_BOOL,
@@ -954,6 +1059,10 @@ struct volume_options dht_options[] = {
         .key = {"node-uuid"},
         .type = GF_OPTION_TYPE_STR,
     },
+    {
+        .key = {"rebalance-checkpoint"},
+        .type = GF_OPTION_TYPE_STR,
+    },
     {
         .key = {"rebalance-stats"},
         .type = GF_OPTION_TYPE_BOOL,
@@ -966,6 +1075,18 @@ struct volume_options dht_options[] = {
         .op_version = {2},
         .level = OPT_STATUS_BASIC,
     },
+    {.key = {"fix-layout-threads"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 64,
+     .default_value = "1",
+     .description =
+         "Number of threads that crawl the directories during a "
+         "fix-layout. The layout of a directory is still written only "
+         "after all its subdirectories are done.",
+     .op_version = {GD_OP_VERSION_12_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"readdir-optimize"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "off",
@@ -976,6 +1097,41 @@ struct volume_options dht_options[] = {
      .op_version = {1},
      .level = OPT_STATUS_ADVANCED,
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"readdirp-fanout"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 1024,
+     .default_value = "0",
+     .description =
+         "Number of subvolumes DHT reads ahead of the one being listed "
+         "during a readdirp, so that the entries of the next subvolumes "
+         "are ready when the listing reaches them. At most one readdirp "
+         "worth of entries is kept per subvolume. 0 disables it.",
+     .op_version = {GD_OP_VERSION_12_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"entry-cache"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description =
+         "Remember for a while the names a lookup found missing, and the "
+         "subvolume holding the data file of names whose hashed subvolume "
+         "only has a linkto file. Lookups of such names then need no "
+         "lookup, or a single one, instead of a lookup on every "
+         "subvolume. Enable features.cache-invalidation so that changes "
+         "made by other clients are seen at once.",
+     .op_version = {GD_OP_VERSION_12_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"entry-cache-timeout"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 600,
+     .default_value = "1",
+     .description = "Seconds for which the entry cache remembers a name.",
+     .op_version = {GD_OP_VERSION_12_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"rsync-hash-regex"},
      .type = GF_OPTION_TYPE_STR,
      /* Setting a default here doesn't work.  See dht_init_regex. */
@@ -1074,6 +1230,30 @@ struct volume_options dht_options[] = {
      .level = OPT_STATUS_ADVANCED,
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
 
+    {.key = {"rebal-window"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 64,
+     .default_value = "8",
+     .description =
+         "Most 1MB blocks of a file read and written at once while it is "
+         "migrated. The number of blocks grows up to this value as long "
+         "as it makes the copy faster.",
+     .op_version = {GD_OP_VERSION_12_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
+    {.key = {"rebal-rate-limit"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .default_value = "0",
+     .description =
+         "Bytes per second that the file migrations of a rebalance process "
+         "are kept under, on top of the number of migrations allowed by "
+         "rebal-throttle. 0 means no limit.",
+     .op_version = {GD_OP_VERSION_12_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
     {.key = {"ensure-durability"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
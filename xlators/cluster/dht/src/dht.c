@@ -89,6 +89,7 @@ struct xlator_fops fops = {
     .fallocate = dht_fallocate,
     .discard = dht_discard,
     .zerofill = dht_zerofill,
+    .copy_file_range = dht_copy_file_range,
 };
 
 struct xlator_dumpops dumpops = {
@@ -98,7 +99,7 @@ struct xlator_dumpops dumpops = {
 
 struct xlator_cbks cbks = {
     .release = dht_release,
-    //      .releasedir = dht_releasedir,
+    .releasedir = dht_releasedir,
     .forget = dht_forget,
 };
 
@@ -630,7 +630,11 @@ struct xlator_fops fops = {
     .setattr = dht_setattr,
 };
 
-struct xlator_cbks cbks = {.forget = dht_forget};
+struct xlator_cbks cbks = {
+    .release = dht_release,
+    .releasedir = dht_releasedir,
+    .forget = dht_forget,
+};
 extern int32_t
 mem_acct_init(xlator_t *this);
 
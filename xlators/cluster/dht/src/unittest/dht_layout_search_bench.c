@@ -0,0 +1,232 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "dht-common.h"
+#include <glusterfs/logging.h>
+#include <glusterfs/xlator.h>
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+/*
+ * Compares the cost of dht_layout_search() on the indexed layout with the
+ * linear scan it replaces, for layouts of growing subvolume counts. Preset
+ * layouts are never indexed, which gives the linear scan. The mocked
+ * dht_hash_compute() takes the hash from the name, so both searches are
+ * given exactly the same hashes.
+ */
+
+#define BENCH_LOOKUPS 1000000
+
+static const int bench_counts[] = {1, 2, 8, 32, 64, 128, 256, 512};
+
+/*
+ * Helper functions
+ */
+
+static uint64_t
+helper_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Builds a layout of @cnt equal ranges like a fresh directory gets, with
+ * the ranges rotated so that the entries are not sorted by start. The
+ * xlator of each entry is only used as a tag. */
+static dht_layout_t *
+helper_layout_new(xlator_t *xl, int cnt)
+{
+    dht_layout_t *layout;
+    uint32_t chunk;
+    int i, pos;
+
+    layout = dht_layout_new(xl, cnt);
+    assert_non_null(layout);
+
+    chunk = 0xffffffff / cnt;
+    for (i = 0; i < cnt; i++) {
+        pos = (i + cnt / 2) % cnt;
+        layout->list[pos].start = i * chunk;
+        layout->list[pos].stop = (i == cnt - 1) ? 0xffffffff
+                                                : (i + 1) * chunk - 1;
+        layout->list[pos].xlator = (xlator_t *)(uintptr_t)(pos + 1);
+    }
+
+    return layout;
+}
+
+static xlator_t *
+helper_linear_search(dht_layout_t *layout, uint32_t hash)
+{
+    int i;
+
+    for (i = 0; i < layout->cnt; i++) {
+        if (layout->list[i].start <= hash && layout->list[i].stop >= hash)
+            return layout->list[i].xlator;
+    }
+
+    return NULL;
+}
+
+static void
+helper_layout_free(dht_layout_t *layout)
+{
+    test_free(layout->index);
+    test_free(layout);
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_dht_layout_search_matches_linear(void **state)
+{
+    xlator_t xl = {
+        .name = "dht-bench",
+    };
+    dht_layout_t *layout;
+    char name[16];
+    uint32_t hash;
+    int i, j;
+
+    for (i = 0; i < sizeof(bench_counts) / sizeof(bench_counts[0]); i++) {
+        layout = helper_layout_new(&xl, bench_counts[i]);
+
+        for (j = 0; j < 100000; j++) {
+            hash = (uint32_t)random() ^ ((uint32_t)random() << 16);
+            snprintf(name, sizeof(name), "%x", hash);
+            assert_ptr_equal(dht_layout_search(&xl, layout, name),
+                             helper_linear_search(layout, hash));
+        }
+
+        /* The bounds of every range */
+        for (j = 0; j < layout->cnt; j++) {
+            snprintf(name, sizeof(name), "%x", layout->list[j].start);
+            assert_ptr_equal(dht_layout_search(&xl, layout, name),
+                             layout->list[j].xlator);
+            snprintf(name, sizeof(name), "%x", layout->list[j].stop);
+            assert_ptr_equal(dht_layout_search(&xl, layout, name),
+                             layout->list[j].xlator);
+        }
+
+        helper_layout_free(layout);
+    }
+}
+
+static void
+test_dht_layout_search_holes(void **state)
+{
+    xlator_t xl = {
+        .name = "dht-bench",
+    };
+    dht_layout_t *layout;
+    char name[16];
+
+    /* An errored subvolume gets an empty range, and the range it held
+     * is not served by anyone. */
+    layout = helper_layout_new(&xl, 128);
+    layout->list[30].start = 0;
+    layout->list[30].stop = 0;
+    layout->list[30].err = ENOTCONN;
+
+    snprintf(name, sizeof(name), "%x", layout->list[40].start);
+    assert_ptr_equal(dht_layout_search(&xl, layout, name),
+                     layout->list[40].xlator);
+
+    /* Changing a range after the index is built is still honoured */
+    layout->list[40].start++;
+    snprintf(name, sizeof(name), "%x", layout->list[40].start - 1);
+    assert_null(dht_layout_search(&xl, layout, name));
+
+    helper_layout_free(layout);
+
+    /* Overlapping ranges are searched in list order */
+    layout = helper_layout_new(&xl, 128);
+    layout->list[70].start = layout->list[2].start;
+    layout->list[70].stop = layout->list[2].stop;
+    snprintf(name, sizeof(name), "%x", layout->list[2].start);
+    assert_ptr_equal(dht_layout_search(&xl, layout, name),
+                     layout->list[2].xlator);
+    helper_layout_free(layout);
+}
+
+static void
+test_dht_layout_search_bench(void **state)
+{
+    xlator_t xl = {
+        .name = "dht-bench",
+    };
+    dht_layout_t *layout;
+    uintptr_t sink = 0;
+    uint32_t hash;
+    char(*names)[16];
+    uint64_t start, linear, indexed;
+    int i, j, n = 4096;
+
+    names = test_calloc(n, sizeof(*names));
+    assert_non_null(names);
+
+    for (j = 0; j < n; j++) {
+        hash = (uint32_t)random() ^ ((uint32_t)random() << 16);
+        snprintf(names[j], sizeof(names[j]), "%x", hash);
+    }
+
+    print_message("%10s %14s %14s\n", "subvols", "linear ns/op",
+                  "indexed ns/op");
+
+    for (i = 0; i < sizeof(bench_counts) / sizeof(bench_counts[0]); i++) {
+        layout = helper_layout_new(&xl, bench_counts[i]);
+
+        layout->preset = 1;
+        start = helper_now_ns();
+        for (j = 0; j < BENCH_LOOKUPS; j++)
+            sink += (uintptr_t)dht_layout_search(&xl, layout,
+                                                 names[j & (n - 1)]);
+        linear = helper_now_ns() - start;
+
+        layout->preset = 0;
+        start = helper_now_ns();
+        for (j = 0; j < BENCH_LOOKUPS; j++)
+            sink += (uintptr_t)dht_layout_search(&xl, layout,
+                                                 names[j & (n - 1)]);
+        indexed = helper_now_ns() - start;
+
+        print_message("%10d %14.1f %14.1f\n", bench_counts[i],
+                      (double)linear / BENCH_LOOKUPS,
+                      (double)indexed / BENCH_LOOKUPS);
+
+        helper_layout_free(layout);
+    }
+
+    assert_true(sink != 0);
+
+    test_free(names);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest xlator_dht_layout_search_tests[] = {
+        unit_test(test_dht_layout_search_matches_linear),
+        unit_test(test_dht_layout_search_holes),
+        unit_test(test_dht_layout_search_bench),
+    };
+
+    return cmocka_run_group_tests(xlator_dht_layout_search_tests, NULL, NULL);
+}
@@ -12,6 +12,7 @@
 
 #include "libxlator.h"
 
+#include "ec.h"
 #include "ec-types.h"
 #include "ec-helpers.h"
 #include "ec-common.h"
@@ -246,6 +247,8 @@ ec_value_ignore(char *key)
         (strcmp(key, GLUSTERFS_ENTRYLK_COUNT) == 0) ||
         (strncmp(key, GF_XATTR_CLRLK_CMD, SLEN(GF_XATTR_CLRLK_CMD)) == 0) ||
         (strcmp(key, DHT_IATT_IN_XDATA_KEY) == 0) ||
+        (strncmp(key, EC_XATTR_REGION_MAP, SLEN(EC_XATTR_REGION_MAP)) == 0) ||
+        (strcmp(key, EC_XATTR_REGION_VERSION) == 0) ||
         (strncmp(key, EC_QUOTA_PREFIX, SLEN(EC_QUOTA_PREFIX)) == 0) ||
         (fnmatch(MARKER_XATTR_PREFIX ".*." XTIME, key, 0) == 0) ||
         (fnmatch(GF_XATTR_MARKER_KEY ".*", key, 0) == 0) ||
@@ -952,6 +955,14 @@ ec_combine(ec_cbk_data_t *newcbk, ec_combine_f combine)
 
     LOCK(&fop->lock);
 
+    /* Late answers of a read that has already been answered using extra
+     * bricks are ignored. */
+    if ((fop->hedged != 0) && (fop->answer != NULL)) {
+        UNLOCK(&fop->lock);
+
+        return;
+    }
+
     fop->received |= newcbk->mask;
 
     item = fop->cbk_list.prev;
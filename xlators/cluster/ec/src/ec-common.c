@@ -535,9 +535,11 @@ ec_is_recoverable_error(int32_t op_errno)
 void
 ec_complete(ec_fop_data_t *fop)
 {
+    ec_t *ec = fop->xl->private;
     ec_cbk_data_t *cbk = NULL;
     int32_t resume = 0, update = 0;
     int healing_count = 0;
+    uintptr_t good = 0;
 
     LOCK(&fop->lock);
 
@@ -552,6 +554,7 @@ ec_complete(ec_fop_data_t *fop)
                  * successful on at least fop->minimum good copies*/
                 if ((cbk->count - healing_count) >= fop->minimum) {
                     fop->answer = cbk;
+                    good = cbk->mask;
 
                     update = 1;
                 }
@@ -559,6 +562,23 @@ ec_complete(ec_fop_data_t *fop)
 
             resume = 1;
         }
+    } else if ((fop->hedged != 0) && (fop->answer == NULL) &&
+               !list_empty(&fop->cbk_list)) {
+        /* Extra bricks have been queried because some were slow. As soon
+         * as enough of them agree, don't wait for the others. Their
+         * answers are ignored, so they are not considered bad. */
+        cbk = list_entry(fop->cbk_list.next, ec_cbk_data_t, list);
+        healing_count = gf_bits_count(cbk->mask & fop->healing);
+        if ((cbk->op_ret >= 0) &&
+            ((cbk->count - healing_count) >= fop->minimum)) {
+            fop->answer = cbk;
+            good = cbk->mask |
+                   ((fop->mask ^ fop->remaining) & ~fop->received);
+
+            update = 1;
+            resume = 1;
+            GF_ATOMIC_INC(ec->stats.hedge.early);
+        }
     }
 
     UNLOCK(&fop->lock);
@@ -568,7 +588,7 @@ ec_complete(ec_fop_data_t *fop)
        be called more than once for each fop, it can be called from outside
        the fop->lock locked region. */
     if (update) {
-        ec_update_good(fop, cbk->mask);
+        ec_update_good(fop, good);
     }
 
     if (resume) {
@@ -771,11 +791,13 @@ ec_dispatch_next(ec_fop_data_t *fop, uint32_t idx)
 
         fop->winds++;
         fop->refs++;
+        fop->dispatch_time = ec_time_usec();
     }
 
     UNLOCK(&fop->lock);
 
     if (i < EC_MAX_NODES) {
+        GF_ATOMIC_INC(ec->child_load[idx].pending);
         fop->wind(ec, fop, idx);
     }
 }
@@ -796,12 +818,14 @@ ec_dispatch_mask(ec_fop_data_t *fop, uintptr_t mask)
 
     fop->winds += count;
     fop->refs += count;
+    fop->dispatch_time = ec_time_usec();
 
     UNLOCK(&fop->lock);
 
     idx = 0;
     while (mask != 0) {
         if ((mask & 1) != 0) {
+            GF_ATOMIC_INC(ec->child_load[idx].pending);
             fop->wind(ec, fop, idx);
         }
         idx++;
@@ -888,6 +912,125 @@ ec_dispatch_all(ec_fop_data_t *fop)
     }
 }
 
+/* Estimated time to get an answer from a brick: its average latency (or
+ * the ping time if it hasn't answered any request yet) times the number of
+ * requests waiting in front. Local bricks count as half as loaded. */
+static uint64_t
+ec_child_load_score(ec_t *ec, uint32_t idx)
+{
+    ec_child_load_t *load = &ec->child_load[idx];
+    uint64_t latency;
+
+    latency = load->latency;
+    if ((latency == 0) && (load->ping > 0)) {
+        latency = load->ping * 1000;
+    }
+    latency = (latency + 1) * (GF_ATOMIC_GET(load->pending) + 1);
+    if (load->local) {
+        latency /= 2;
+    }
+
+    return latency;
+}
+
+/* Returns the mask of the 'count' bricks in 'avail' with the lowest
+ * score. */
+static uintptr_t
+ec_select_least_load(ec_t *ec, uintptr_t avail, int32_t count)
+{
+    uint64_t score[ec->nodes];
+    uint64_t best_score;
+    uintptr_t mask = 0;
+    int32_t i, best;
+
+    for (i = 0; i < ec->nodes; i++) {
+        if (((avail >> i) & 1) != 0) {
+            score[i] = ec_child_load_score(ec, i);
+        }
+    }
+
+    while ((count-- > 0) && (avail != mask)) {
+        best = -1;
+        best_score = 0;
+        for (i = 0; i < ec->nodes; i++) {
+            if ((((avail & ~mask) >> i) & 1) == 0) {
+                continue;
+            }
+            if ((best < 0) || (score[i] < best_score)) {
+                best = i;
+                best_score = score[i];
+            }
+        }
+        mask |= 1ULL << best;
+    }
+
+    return mask;
+}
+
+/* Sends the request to one more brick because the ones already queried
+ * are taking too long to answer. */
+static void
+ec_dispatch_hedge(ec_fop_data_t *fop)
+{
+    ec_t *ec = fop->xl->private;
+    uintptr_t mask = 0;
+    int32_t idx;
+
+    LOCK(&fop->lock);
+
+    if ((fop->answer == NULL) && (fop->winds > 0) && (fop->remaining != 0)) {
+        mask = ec_select_least_load(ec, fop->remaining, 1);
+
+        fop->remaining ^= mask;
+        fop->hedged |= mask;
+
+        ec_trace("HEDGE", fop, "mask=%lX", mask);
+
+        fop->winds++;
+        fop->refs++;
+    }
+
+    UNLOCK(&fop->lock);
+
+    if (mask != 0) {
+        idx = gf_bits_index(mask);
+        GF_ATOMIC_INC(ec->child_load[idx].pending);
+        GF_ATOMIC_INC(ec->stats.hedge.sent);
+        fop->wind(ec, fop, idx);
+    }
+}
+
+static void
+ec_dispatch_hedge_timeout(void *data)
+{
+    ec_fop_data_t *fop = data;
+
+    ec_dispatch_hedge(fop);
+    ec_fop_data_release(fop);
+}
+
+/* If the read is not complete after read-hedge-delay, another brick is
+ * queried. The timer is never cancelled, it keeps a reference to the fop
+ * and does nothing if all answers have already been received. */
+static void
+ec_dispatch_hedge_schedule(ec_fop_data_t *fop)
+{
+    ec_t *ec = fop->xl->private;
+    struct timespec delay;
+
+    delay.tv_sec = ec->read_hedge_delay / 1000000;
+    delay.tv_nsec = (ec->read_hedge_delay % 1000000) * 1000;
+
+    LOCK(&fop->lock);
+    fop->refs++;
+    UNLOCK(&fop->lock);
+
+    if (gf_timer_call_after(fop->xl->ctx, delay, ec_dispatch_hedge_timeout,
+                            fop) == NULL) {
+        ec_fop_data_release(fop);
+    }
+}
+
 void
 ec_dispatch_min(ec_fop_data_t *fop)
 {
@@ -905,6 +1048,17 @@ ec_dispatch_min(ec_fop_data_t *fop)
         fop->first = ec_select_first_by_read_policy(fop->xl->private, fop);
         idx = fop->first - 1;
         mask = 0;
+        if (ec->read_policy == EC_MIN_DECODE) {
+            /* Use the fragments that are cheapest to decode. If there are
+             * too many combinations, fall back to the normal selection. */
+            mask = ec_method_select(&ec->matrix, fop->remaining);
+            if (mask != 0) {
+                count = 0;
+            }
+        } else if (ec->read_policy == EC_LEAST_LOAD) {
+            mask = ec_select_least_load(ec, fop->remaining, count);
+            count = 0;
+        }
         while (count-- > 0) {
             idx = ec_child_next(ec, fop, idx + 1);
             if (idx < EC_MAX_NODES)
@@ -912,6 +1066,11 @@ ec_dispatch_min(ec_fop_data_t *fop)
         }
 
         ec_dispatch_mask(fop, mask);
+
+        if ((fop->id == GF_FOP_READ) && (ec->read_hedge_delay != 0) &&
+            (fop->remaining != 0)) {
+            ec_dispatch_hedge_schedule(fop);
+        }
     }
 }
 
@@ -1700,6 +1859,11 @@ ec_clear_inode_info(ec_fop_data_t *fop, inode_t *inode)
     ctx->pre_size = ctx->post_size = 0;
     memset(ctx->dirty, 0, sizeof(ctx->dirty));
 
+    if (ctx->region_map != NULL) {
+        memset(ctx->region_map, 0, EC_REGION_MAP_SIZE);
+    }
+    ctx->region_shift = 0;
+
 unlock:
     UNLOCK(&inode->lock);
 }
@@ -1841,6 +2005,36 @@ ec_lock_wake_shared(ec_lock_t *lock, struct list_head *list)
     }
 }
 
+/* Data fops record the regions they modify while they own the lock, so that
+ * they can be stored in the bricks if some of them miss the update. */
+static void
+ec_lock_mark_regions(ec_lock_link_t *link)
+{
+    ec_t *ec = link->fop->xl->private;
+    ec_lock_t *lock = link->lock;
+    ec_inode_t *ctx = lock->ctx;
+
+    if (!ec->dirty_regions || !link->update[EC_DATA_TXN]) {
+        return;
+    }
+
+    LOCK(&lock->loc.inode->lock);
+
+    if ((ctx->region_map == NULL) && (ctx->region_shift == 0)) {
+        ctx->region_map = GF_CALLOC(1, EC_REGION_MAP_SIZE,
+                                    ec_mt_ec_region_map_t);
+    }
+    if (ctx->region_map == NULL) {
+        /* The regions of this lock can't be recorded anymore. */
+        ctx->region_shift = EC_REGION_LOST;
+    } else if (ctx->region_shift != EC_REGION_LOST) {
+        gf_region_mark(ctx->region_map, &ctx->region_shift, link->fl_start,
+                       link->fl_end);
+    }
+
+    UNLOCK(&lock->loc.inode->lock);
+}
+
 static void
 ec_lock_apply(ec_lock_link_t *link)
 {
@@ -1849,6 +2043,8 @@ ec_lock_apply(ec_lock_link_t *link)
     fop->mask &= link->lock->good_mask;
     fop->locked++;
 
+    ec_lock_mark_regions(link);
+
     ec_get_size_version(link);
     ec_get_real_size(link);
 }
@@ -2381,6 +2577,116 @@ ec_update_size_version_done(call_frame_t *frame, void *cookie, xlator_t *this,
     return 0;
 }
 
+static void
+ec_update_xattrop(ec_lock_link_t *link, gf_xattrop_flags_t optype,
+                  dict_t *dict, fop_xattrop_cbk_t func)
+{
+    ec_fop_data_t *fop;
+    ec_lock_t *lock;
+    uintptr_t update_on = 0;
+
+    fop = link->fop;
+    lock = link->lock;
+
+    fop->frame->root->uid = 0;
+    fop->frame->root->gid = 0;
+
+    update_on = lock->good_mask | lock->healing;
+
+    if (link->lock->fd == NULL) {
+        ec_xattrop(fop->frame, fop->xl, update_on, EC_MINIMUM_MIN, func, link,
+                   &link->lock->loc, optype, dict, NULL);
+    } else {
+        ec_fxattrop(fop->frame, fop->xl, update_on, EC_MINIMUM_MIN, func,
+                    link, link->lock->fd, optype, dict, NULL);
+    }
+
+    fop->frame->root->uid = fop->uid;
+    fop->frame->root->gid = fop->gid;
+}
+
+static int32_t
+ec_update_regions_done(call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, dict_t *xattr,
+                       dict_t *xdata)
+{
+    ec_fop_data_t *fop = cookie;
+    ec_lock_link_t *link;
+    ec_t *ec = fop->xl->private;
+    dict_t *dict;
+
+    link = fop->data;
+    dict = link->pending_update;
+    link->pending_update = NULL;
+
+    if ((op_ret < 0) || ((fop->mask & ~fop->good) != 0)) {
+        /* Some brick getting the new version doesn't have the regions, so
+         * they can't be trusted to heal the file anymore. */
+        dict_del(dict, EC_XATTR_REGION_VERSION);
+
+        gf_msg_debug(fop->xl->name, op_errno,
+                     "Unable to record dirty regions. %s", ec_msg_str(fop));
+    } else {
+        GF_ATOMIC_INC(ec->stats.regions.updates);
+    }
+
+    ec_update_xattrop(link, GF_XATTROP_ADD_ARRAY64, dict,
+                      ec_update_size_version_done);
+
+    dict_unref(dict);
+
+    return 0;
+}
+
+/* Returns the regions modified under the current lock, ready to be merged
+ * with the ones already recorded, or NULL if they are not known. */
+static dict_t *
+ec_update_regions_dict(ec_lock_link_t *link)
+{
+    ec_inode_t *ctx = link->lock->ctx;
+    dict_t *dict = NULL;
+    uint8_t *map = NULL;
+    uint32_t shift;
+    char key[64];
+
+    map = GF_MALLOC(EC_REGION_MAP_SIZE, ec_mt_ec_region_map_t);
+    if (map == NULL) {
+        return NULL;
+    }
+
+    LOCK(&link->lock->loc.inode->lock);
+
+    shift = ctx->region_shift;
+    if ((shift != 0) && (shift != EC_REGION_LOST)) {
+        memcpy(map, ctx->region_map, EC_REGION_MAP_SIZE);
+    }
+
+    UNLOCK(&link->lock->loc.inode->lock);
+
+    if ((shift == 0) || (shift == EC_REGION_LOST)) {
+        goto failed;
+    }
+
+    dict = dict_new();
+    if (dict == NULL) {
+        goto failed;
+    }
+    snprintf(key, sizeof(key), EC_XATTR_REGION_MAP ".%u", shift);
+    if (dict_set_bin(dict, key, map, EC_REGION_MAP_SIZE) != 0) {
+        goto failed;
+    }
+
+    return dict;
+
+failed:
+    if (dict != NULL) {
+        dict_unref(dict);
+    }
+    GF_FREE(map);
+
+    return NULL;
+}
+
 static void
 ec_update_size_version(ec_lock_link_t *link, uint64_t *version, uint64_t size,
                        uint64_t *dirty)
@@ -2388,13 +2694,15 @@ ec_update_size_version(ec_lock_link_t *link, uint64_t *version, uint64_t size,
     ec_fop_data_t *fop;
     ec_lock_t *lock;
     ec_inode_t *ctx;
+    ec_t *ec;
     dict_t *dict = NULL;
-    uintptr_t update_on = 0;
+    dict_t *regions = NULL;
     int32_t err = -ENOMEM;
 
     fop = link->fop;
     lock = link->lock;
     ctx = lock->ctx;
+    ec = fop->xl->private;
 
     ec_trace("UPDATE", fop, "version=%ld/%ld, size=%ld, dirty=%ld/%ld",
              version[0], version[1], size, dirty[0], dirty[1]);
@@ -2439,23 +2747,37 @@ ec_update_size_version(ec_lock_link_t *link, uint64_t *version, uint64_t size,
         (void)ec_dict_set_number(dict, EC_XATTR_CONFIG, 0);
     }
 
-    fop->frame->root->uid = 0;
-    fop->frame->root->gid = 0;
+    /* The version of the dirty regions follows the data version as long as
+     * all the regions modified while some brick was missing are recorded.
+     * Heal uses this to know if it can rebuild only those regions. */
+    if (ec->dirty_regions && (version[EC_DATA_TXN] != 0)) {
+        err = ec_dict_set_number(dict, EC_XATTR_REGION_VERSION,
+                                 version[EC_DATA_TXN]);
+        if (err != 0) {
+            goto out;
+        }
 
-    update_on = lock->good_mask | lock->healing;
+        if ((ec->node_mask & ~lock->good_mask) != 0) {
+            regions = ec_update_regions_dict(link);
+            if (regions == NULL) {
+                dict_del(dict, EC_XATTR_REGION_VERSION);
+            }
+        }
+    }
 
-    if (link->lock->fd == NULL) {
-        ec_xattrop(fop->frame, fop->xl, update_on, EC_MINIMUM_MIN,
-                   ec_update_size_version_done, link, &link->lock->loc,
-                   GF_XATTROP_ADD_ARRAY64, dict, NULL);
-    } else {
-        ec_fxattrop(fop->frame, fop->xl, update_on, EC_MINIMUM_MIN,
-                    ec_update_size_version_done, link, link->lock->fd,
-                    GF_XATTROP_ADD_ARRAY64, dict, NULL);
+    if (regions != NULL) {
+        /* The regions are recorded before updating the version, so that a
+         * version never covers regions that are not recorded. */
+        link->pending_update = dict;
+        ec_update_xattrop(link, GF_XATTROP_OR_ARRAY, regions,
+                          ec_update_regions_done);
+        dict_unref(regions);
+
+        return;
     }
 
-    fop->frame->root->uid = fop->uid;
-    fop->frame->root->gid = fop->gid;
+    ec_update_xattrop(link, GF_XATTROP_ADD_ARRAY64, dict,
+                      ec_update_size_version_done);
 
     dict_unref(dict);
 
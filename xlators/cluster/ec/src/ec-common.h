@@ -100,6 +100,7 @@ enum _ec_xattrop_flags {
 #define EC_STATE_UNLOCK 7
 
 #define EC_STATE_DELAYED_START 100
+#define EC_STATE_DELAYED_DISPATCH 101
 
 #define EC_STATE_HEAL_ENTRY_LOOKUP 200
 #define EC_STATE_HEAL_ENTRY_PREPARE 201
@@ -124,6 +125,9 @@ enum _ec_xattrop_flags {
 /* Value to cover the full range of a file */
 #define EC_RANGE_FULL ((uint64_t)LLONG_MAX + 1)
 
+/* Value of region_shift when the dirty regions of an inode are unknown */
+#define EC_REGION_LOST GF_REGION_LOST
+
 gf_boolean_t
 ec_dispatch_one_retry(ec_fop_data_t *fop, ec_cbk_data_t **cbk);
 void
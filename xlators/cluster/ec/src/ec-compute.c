@@ -0,0 +1,243 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* Threads dedicated to encode and decode data, so that event threads don't
+ * spend their time doing it. Each thread takes all the queued jobs (up to
+ * EC_COMPUTE_BATCH) at once and encodes them in a single call, which avoids
+ * most of the per-call overhead when many small writes are being sent. */
+
+#include <glusterfs/common-utils.h>
+
+#include "ec-mem-types.h"
+#include "ec-messages.h"
+#include "ec-common.h"
+#include "ec-method.h"
+#include "ec-compute.h"
+
+static void
+ec_compute_run(ec_t *ec, ec_compute_job_t **jobs, uint32_t count)
+{
+    uint64_t size[count];
+    void *in[count], *out[count];
+    int32_t error[count];
+    uint32_t i, n;
+
+    n = 0;
+    for (i = 0; i < count; i++) {
+        error[i] = 0;
+        if (jobs[i]->func != NULL) {
+            error[i] = jobs[i]->func(jobs[i]->fop);
+        } else {
+            size[n] = jobs[i]->size;
+            in[n] = jobs[i]->in;
+            out[n] = jobs[i]->out;
+            n++;
+        }
+    }
+    if (n > 0) {
+        ec_method_encode_batch(&ec->matrix, n, size, in, out);
+    }
+
+    GF_ATOMIC_ADD(ec->stats.compute.jobs, count);
+    GF_ATOMIC_INC(ec->stats.compute.batches);
+
+    for (i = 0; i < count; i++) {
+        ec_resume(jobs[i]->fop, error[i]);
+        GF_FREE(jobs[i]);
+    }
+}
+
+static void *
+ec_compute_worker(void *data)
+{
+    ec_t *ec = data;
+    ec_compute_job_t *jobs[EC_COMPUTE_BATCH];
+    uint32_t count;
+
+    THIS = ec->xl;
+
+    for (;;) {
+        pthread_mutex_lock(&ec->compute.mutex);
+        {
+            while (list_empty(&ec->compute.jobs) && !ec->compute.stop) {
+                pthread_cond_wait(&ec->compute.cond, &ec->compute.mutex);
+            }
+
+            count = 0;
+            while ((count < EC_COMPUTE_BATCH) &&
+                   !list_empty(&ec->compute.jobs)) {
+                jobs[count] = list_first_entry(&ec->compute.jobs,
+                                               ec_compute_job_t, list);
+                list_del_init(&jobs[count]->list);
+                count++;
+            }
+        }
+        pthread_mutex_unlock(&ec->compute.mutex);
+
+        /* The queue is only empty here when the threads are being
+         * stopped. */
+        if (count == 0) {
+            break;
+        }
+
+        ec_compute_run(ec, jobs, count);
+    }
+
+    return NULL;
+}
+
+void
+ec_compute_init(ec_t *ec)
+{
+    pthread_mutex_init(&ec->compute.mutex, NULL);
+    pthread_cond_init(&ec->compute.cond, NULL);
+    INIT_LIST_HEAD(&ec->compute.jobs);
+}
+
+void
+ec_compute_start(ec_t *ec, uint32_t count)
+{
+    pthread_t *threads;
+    uint32_t i;
+
+    if (count == 0) {
+        return;
+    }
+
+    threads = GF_CALLOC(count, sizeof(pthread_t), ec_mt_pthread_t);
+    if (threads == NULL) {
+        gf_msg(ec->xl->name, GF_LOG_WARNING, ENOMEM,
+               EC_MSG_COMPUTE_THREAD_FAILED,
+               "Unable to start compute threads. Data will be encoded "
+               "inline");
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (gf_thread_create(&threads[i], NULL, ec_compute_worker, ec,
+                             "eccompute") != 0) {
+            gf_msg(ec->xl->name, GF_LOG_WARNING, errno,
+                   EC_MSG_COMPUTE_THREAD_FAILED,
+                   "Only %u of %u compute threads started", i, count);
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&ec->compute.mutex);
+    {
+        ec->compute.threads = threads;
+        ec->compute.count = i;
+    }
+    pthread_mutex_unlock(&ec->compute.mutex);
+}
+
+void
+ec_compute_stop(ec_t *ec)
+{
+    pthread_t *threads;
+    uint32_t i, count;
+
+    pthread_mutex_lock(&ec->compute.mutex);
+    {
+        threads = ec->compute.threads;
+        count = ec->compute.count;
+        ec->compute.threads = NULL;
+        ec->compute.count = 0;
+        ec->compute.stop = _gf_true;
+        pthread_cond_broadcast(&ec->compute.cond);
+    }
+    pthread_mutex_unlock(&ec->compute.mutex);
+
+    /* Threads only exit once the queue is empty, so no job is lost. */
+    for (i = 0; i < count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    GF_FREE(threads);
+
+    pthread_mutex_lock(&ec->compute.mutex);
+    {
+        ec->compute.stop = _gf_false;
+    }
+    pthread_mutex_unlock(&ec->compute.mutex);
+}
+
+void
+ec_compute_fini(ec_t *ec)
+{
+    ec_compute_stop(ec);
+
+    pthread_cond_destroy(&ec->compute.cond);
+    pthread_mutex_destroy(&ec->compute.mutex);
+}
+
+/* Queues a job. The fop is kept waiting until the job has been completed.
+ * Returns false if there are no compute threads, in which case the caller
+ * must do the work itself. */
+static gf_boolean_t
+ec_compute_queue(ec_t *ec, ec_compute_job_t *job)
+{
+    gf_boolean_t queued = _gf_false;
+
+    pthread_mutex_lock(&ec->compute.mutex);
+    {
+        if ((ec->compute.count > 0) && !ec->compute.stop) {
+            ec_sleep(job->fop);
+            list_add_tail(&job->list, &ec->compute.jobs);
+            pthread_cond_signal(&ec->compute.cond);
+            queued = _gf_true;
+        }
+    }
+    pthread_mutex_unlock(&ec->compute.mutex);
+
+    return queued;
+}
+
+static gf_boolean_t
+ec_compute_add(ec_fop_data_t *fop, ec_compute_f func, uint64_t size, void *in,
+               void *out)
+{
+    ec_t *ec = fop->xl->private;
+    ec_compute_job_t *job;
+
+    if (ec->compute.count == 0) {
+        return _gf_false;
+    }
+
+    job = GF_MALLOC(sizeof(*job), ec_mt_ec_compute_job_t);
+    if (job == NULL) {
+        return _gf_false;
+    }
+    INIT_LIST_HEAD(&job->list);
+    job->fop = fop;
+    job->func = func;
+    job->size = size;
+    job->in = in;
+    job->out = out;
+
+    if (!ec_compute_queue(ec, job)) {
+        GF_FREE(job);
+
+        return _gf_false;
+    }
+
+    return _gf_true;
+}
+
+gf_boolean_t
+ec_compute_encode(ec_fop_data_t *fop, uint64_t size, void *in, void *out)
+{
+    return ec_compute_add(fop, NULL, size, in, out);
+}
+
+gf_boolean_t
+ec_compute_submit(ec_fop_data_t *fop, ec_compute_f func)
+{
+    return ec_compute_add(fop, func, 0, NULL, NULL);
+}
@@ -0,0 +1,38 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __EC_COMPUTE_H__
+#define __EC_COMPUTE_H__
+
+#include "ec-types.h"
+
+/* Maximum number of jobs taken from the queue at once by a compute
+ * thread. */
+#define EC_COMPUTE_BATCH 64
+
+void
+ec_compute_init(ec_t *ec);
+
+void
+ec_compute_start(ec_t *ec, uint32_t count);
+
+void
+ec_compute_stop(ec_t *ec);
+
+void
+ec_compute_fini(ec_t *ec);
+
+gf_boolean_t
+ec_compute_encode(ec_fop_data_t *fop, uint64_t size, void *in, void *out);
+
+gf_boolean_t
+ec_compute_submit(ec_fop_data_t *fop, ec_compute_f func);
+
+#endif /* __EC_COMPUTE_H__ */
@@ -13,6 +13,30 @@
 #include "ec-data.h"
 #include "ec-messages.h"
 
+/* Accounts the answer of a brick. The average latency is an exponential
+ * moving average with weight 1/8, like the RTT estimation of TCP. Bricks
+ * added by a hedged read are ignored because the time they are sent is not
+ * fop->dispatch_time. */
+static void
+ec_child_load_update(ec_t *ec, ec_fop_data_t *fop, int32_t idx)
+{
+    ec_child_load_t *load = &ec->child_load[idx];
+    uint64_t sample;
+
+    GF_ATOMIC_DEC(load->pending);
+
+    if (((fop->hedged >> idx) & 1) != 0) {
+        return;
+    }
+
+    sample = ec_time_usec() - fop->dispatch_time;
+    if (load->latency == 0) {
+        load->latency = sample;
+    } else {
+        load->latency = load->latency - load->latency / 8 + sample / 8;
+    }
+}
+
 ec_cbk_data_t *
 ec_cbk_data_allocate(call_frame_t *frame, xlator_t *this, ec_fop_data_t *fop,
                      int32_t id, int32_t idx, int32_t op_ret, int32_t op_errno)
@@ -45,6 +69,8 @@ ec_cbk_data_allocate(call_frame_t *frame, xlator_t *this, ec_fop_data_t *fop,
         return NULL;
     }
 
+    ec_child_load_update(ec, fop, idx);
+
     cbk = mem_get0(ec->cbk_pool);
     if (cbk == NULL) {
         gf_msg(this->name, GF_LOG_ERROR, ENOMEM, EC_MSG_NO_MEMORY,
@@ -229,6 +229,14 @@ ec_writev(call_frame_t *frame, xlator_t *this, uintptr_t target,
           struct iovec *vector, int32_t count, off_t offset, uint32_t flags,
           struct iobref *iobref, dict_t *xdata);
 
+gf_boolean_t
+ec_writev_coalesce(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   struct iovec *vector, int32_t count, off_t offset,
+                   uint32_t flags, struct iobref *iobref, dict_t *xdata);
+
+void
+ec_writev_coalesce_flush(xlator_t *this, inode_t *inode);
+
 void
 ec_xattrop(call_frame_t *frame, xlator_t *this, uintptr_t target,
            uint32_t fop_flags, fop_xattrop_cbk_t func, void *data, loc_t *loc,
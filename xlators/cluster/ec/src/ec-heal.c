@@ -14,6 +14,7 @@
 
 #include "ec.h"
 #include "ec-types.h"
+#include "ec-mem-types.h"
 #include "ec-messages.h"
 #include "ec-helpers.h"
 #include "ec-common.h"
@@ -208,6 +209,23 @@ ec_heal_lock_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     return 0;
 }
 
+/* Windows of the same heal lock their ranges at the same time. The cached
+ * inode information is only dropped when the last of them unlocks. */
+static gf_boolean_t
+ec_heal_window_release(ec_heal_t *heal)
+{
+    ec_heal_t *parent = heal->parent;
+    gf_boolean_t last = _gf_true;
+
+    if (parent != NULL) {
+        LOCK(&parent->lock);
+        last = (--parent->windows == 0);
+        UNLOCK(&parent->lock);
+    }
+
+    return last;
+}
+
 static void
 ec_heal_lock(ec_heal_t *heal, int32_t type, fd_t *fd, loc_t *loc, off_t offset,
              size_t size)
@@ -223,11 +241,14 @@ ec_heal_lock(ec_heal_t *heal, int32_t type, fd_t *fd, loc_t *loc, off_t offset,
     flock.l_owner.len = 0;
 
     if (type == F_UNLCK) {
-        /* Remove inode size information before unlocking it. */
-        if (fd == NULL) {
-            ec_clear_inode_info(heal->fop, heal->loc.inode);
-        } else {
-            ec_clear_inode_info(heal->fop, heal->fd->inode);
+        /* Remove inode size information before unlocking it, unless other
+         * windows of the same heal still hold their lock. */
+        if (ec_heal_window_release(heal)) {
+            if (fd == NULL) {
+                ec_clear_inode_info(heal->fop, heal->loc.inode);
+            } else {
+                ec_clear_inode_info(heal->fop, heal->fd->inode);
+            }
         }
         cbk = ec_lock_unlocked;
     } else {
@@ -315,12 +336,20 @@ ec_heal_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 {
     ec_fop_data_t *fop = cookie;
     ec_heal_t *heal = fop->data;
+    ec_t *ec = fop->xl->private;
 
     ec_trace("READ_CBK", fop, "ret=%d, errno=%d", op_ret, op_errno);
 
     ec_heal_avoid(fop);
 
-    if (op_ret > 0) {
+    if ((op_ret > 0) && (heal->regions == NULL) &&
+        (iov_0filled(vector, count) == 0)) {
+        /* The sinks have been emptied before rebuilding the whole file, so
+         * there's no need to write zeros on them. */
+        gf_msg_debug(fop->xl->name, 0, "%s: skipping zeros at %" PRIu64,
+                     uuid_utoa(heal->fd->inode->gfid), heal->offset);
+        GF_ATOMIC_INC(ec->stats.regions.zeros);
+    } else if (op_ret > 0) {
         gf_msg_debug(fop->xl->name, 0,
                      "%s: read succeeded, proceeding "
                      "to write at %" PRIu64,
@@ -1868,6 +1897,131 @@ out:
     return ret;
 }
 
+/* Reads the dirty regions recorded in the sources and the sinks. The sinks
+ * have missed changes only in the regions recorded in the sources if the
+ * version of the regions matches the data version in all of them, because
+ * regions are recorded since the last time all the bricks were in sync.
+ * Returns 1 in that case, with the regions of the sources in 'regions', 0
+ * if the whole file needs to be rebuilt, or a negative error if the
+ * regions couldn't be read. */
+static int
+__ec_heal_data_regions(call_frame_t *frame, ec_t *ec, fd_t *fd,
+                       unsigned char *locked_on, uint64_t *versions,
+                       unsigned char *sources, unsigned char *healed_sinks,
+                       uint64_t *region_versions, uint8_t *regions,
+                       uint32_t *present)
+{
+    static uint8_t zero_map[EC_REGION_MAP_SIZE];
+    default_args_cbk_t *replies = NULL;
+    unsigned char *output = NULL;
+    dict_t *xattrs = NULL;
+    data_t *data = NULL;
+    uint64_t zero_value = 0;
+    uint8_t *map = NULL;
+    char key[64];
+    int ret = 1;
+    int i = 0;
+    int j = 0;
+    int k = 0;
+
+    EC_REPLIES_ALLOC(replies, ec->nodes);
+    output = alloca0(ec->nodes);
+    memset(regions, 0, EC_REGION_SHIFTS * EC_REGION_MAP_SIZE);
+    *present = 0;
+
+    xattrs = dict_new();
+    if (!xattrs || dict_set_static_bin(xattrs, EC_XATTR_REGION_VERSION,
+                                       &zero_value, sizeof(zero_value))) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    for (j = 0; j < EC_REGION_SHIFTS; j++) {
+        snprintf(key, sizeof(key), EC_XATTR_REGION_MAP ".%u",
+                 EC_REGION_MIN_SHIFT + j);
+        if (dict_set_static_bin(xattrs, key, zero_map, sizeof(zero_map))) {
+            ret = -ENOMEM;
+            goto out;
+        }
+    }
+
+    cluster_fxattrop(ec->xl_list, locked_on, ec->nodes, replies, output, frame,
+                     ec->xl, fd, GF_XATTROP_ADD_ARRAY64, xattrs, NULL);
+
+    for (i = 0; i < ec->nodes; i++) {
+        if (!sources[i] && !healed_sinks[i])
+            continue;
+
+        if (!output[i] ||
+            ec_dict_del_number(replies[i].xattr, EC_XATTR_REGION_VERSION,
+                               &region_versions[i])) {
+            ret = -ENOTCONN;
+            goto out;
+        }
+        /* A sink without data version may have lost the whole file. */
+        if ((region_versions[i] != versions[i]) ||
+            (healed_sinks[i] && (versions[i] == 0)))
+            ret = 0;
+
+        for (j = 0; j < EC_REGION_SHIFTS; j++) {
+            snprintf(key, sizeof(key), EC_XATTR_REGION_MAP ".%u",
+                     EC_REGION_MIN_SHIFT + j);
+            data = dict_get(replies[i].xattr, key);
+            if (!data || (data->len != EC_REGION_MAP_SIZE) ||
+                !mem_0filled(data->data, data->len))
+                continue;
+
+            *present |= 1U << j;
+            if (!sources[i])
+                continue;
+            map = regions + j * EC_REGION_MAP_SIZE;
+            for (k = 0; k < EC_REGION_MAP_SIZE; k++)
+                map[k] |= data->data[k];
+        }
+    }
+
+out:
+    if (xattrs)
+        dict_unref(xattrs);
+    cluster_replies_wipe(replies, ec->nodes);
+    if (ret < 0)
+        gf_msg_debug(ec->xl->name, -ret, "%s: unable to read dirty regions",
+                     uuid_utoa(fd->inode->gfid));
+    return ret;
+}
+
+/* Removes the dirty regions from all the bricks once they are in sync. */
+static int
+__ec_heal_data_clear_regions(call_frame_t *frame, ec_t *ec, fd_t *fd,
+                             unsigned char *on, uint32_t present)
+{
+    default_args_cbk_t *replies = NULL;
+    unsigned char *output = NULL;
+    char key[64];
+    int ret = 0;
+    int i = 0;
+    int j = 0;
+
+    EC_REPLIES_ALLOC(replies, ec->nodes);
+    output = alloca0(ec->nodes);
+
+    for (j = 0; j < EC_REGION_SHIFTS; j++) {
+        if (((present >> j) & 1) == 0)
+            continue;
+
+        snprintf(key, sizeof(key), EC_XATTR_REGION_MAP ".%u",
+                 EC_REGION_MIN_SHIFT + j);
+        cluster_fremovexattr(ec->xl_list, on, ec->nodes, replies, output,
+                             frame, ec->xl, fd, key, NULL);
+        for (i = 0; i < ec->nodes; i++) {
+            if (on[i] && !output[i] && (replies[i].op_errno != ENODATA))
+                ret = -EIO;
+        }
+        cluster_replies_wipe(replies, ec->nodes);
+    }
+
+    return ret;
+}
+
 int
 __ec_heal_mark_sinks(call_frame_t *frame, ec_t *ec, fd_t *fd,
                      uint64_t *versions, unsigned char *healed_sinks)
@@ -1934,6 +2088,20 @@ out:
     return ret;
 }
 
+/* Keeps count of the windows holding their lock, to show how many of them
+ * are healed at the same time. */
+static void
+ec_heal_window_locked(ec_t *ec, int32_t delta)
+{
+    LOCK(&ec->lock);
+    {
+        ec->heal_windows += delta;
+        if (ec->heal_windows > ec->heal_windows_max)
+            ec->heal_windows_max = ec->heal_windows;
+    }
+    UNLOCK(&ec->lock);
+}
+
 int32_t
 ec_manager_heal_block(ec_fop_data_t *fop, int32_t state)
 {
@@ -1944,21 +2112,30 @@ ec_manager_heal_block(ec_fop_data_t *fop, int32_t state)
         case EC_STATE_INIT:
             ec_owner_set(fop->frame, fop->frame->root);
 
-            ec_heal_inodelk(heal, F_WRLCK, 1, 0, 0);
+            /* Each window has its own lk-owner, so it only locks its own
+             * range to not wait for the other windows of the wave. */
+            LOCK(&heal->parent->lock);
+            heal->parent->windows++;
+            UNLOCK(&heal->parent->lock);
+            ec_heal_inodelk(heal, F_WRLCK, 1, heal->offset, heal->size);
 
             return EC_STATE_HEAL_DATA_COPY;
 
         case EC_STATE_HEAL_DATA_COPY:
+            ec_heal_window_locked(fop->xl->private, 1);
             gf_msg_debug(fop->xl->name, 0, "%s: read/write starting",
                          uuid_utoa(heal->fd->inode->gfid));
             ec_heal_data_block(heal);
 
             return EC_STATE_HEAL_DATA_UNLOCK;
 
-        case -EC_STATE_HEAL_DATA_COPY:
         case -EC_STATE_HEAL_DATA_UNLOCK:
         case EC_STATE_HEAL_DATA_UNLOCK:
-            ec_heal_inodelk(heal, F_UNLCK, 1, 0, 0);
+            ec_heal_window_locked(fop->xl->private, -1);
+            /* Fall through */
+
+        case -EC_STATE_HEAL_DATA_COPY:
+            ec_heal_inodelk(heal, F_UNLCK, 1, heal->offset, heal->size);
 
             return EC_STATE_REPORT;
 
@@ -2027,29 +2204,134 @@ ec_heal_block_done(call_frame_t *frame, void *cookie, xlator_t *this,
     }
     heal->fop = NULL;
     heal->error = op_ret < 0 ? op_errno : 0;
-    syncbarrier_wake(&heal->barrier);
+    syncbarrier_wake(&heal->parent->barrier);
     return 0;
 }
 
-int
-ec_sync_heal_block(call_frame_t *frame, xlator_t *this, ec_heal_t *heal)
+/* Charges 'size' bytes to the heal bandwidth shared by all the heals of this
+ * subvolume and sleeps until they can be sent. */
+static void
+ec_heal_bandwidth_wait(ec_t *ec, uint64_t size)
 {
-    ec_heal_block(frame, this, heal->bad | heal->good, EC_MINIMUM_ONE,
-                  ec_heal_block_done, heal);
-    syncbarrier_wait(&heal->barrier, 1);
-    if (heal->error != 0) {
-        return -heal->error;
+    struct timespec ts;
+    uint64_t limit, now, start;
+    int32_t delay;
+
+    limit = ec->heal_bandwidth;
+    if (limit == 0)
+        return;
+
+    timespec_now(&ts);
+    now = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+
+    LOCK(&ec->lock);
+    {
+        start = max(ec->heal_throttle_next, now);
+        ec->heal_throttle_next = start + size * 1000000ULL / limit;
     }
-    if (heal->bad == 0)
-        return -ENOTCONN;
-    return 0;
+    UNLOCK(&ec->lock);
+
+    while ((start > now) && !ec->shutdown) {
+        delay = min(start - now, 1000000ULL);
+        synctask_usleep(delay);
+        now += delay;
+    }
+}
+
+/* Moves heal->offset to the first window that contains data, asking one of
+ * the good bricks with SEEK_DATA. Holes don't need to be copied because the
+ * sinks have already been truncated. Returns true if there is no data left.
+ * If a brick doesn't support SEEK_DATA, holes are not skipped anymore. */
+static gf_boolean_t
+ec_heal_skip_holes(ec_t *ec, ec_heal_t *heal, gf_boolean_t *seek)
+{
+    off_t data = 0;
+    uint64_t offset;
+    int i, ret;
+
+    for (i = 0; i < ec->nodes; i++) {
+        if ((heal->good >> i) & 1)
+            break;
+    }
+    if (i == ec->nodes)
+        return _gf_false;
+
+    ret = syncop_seek(ec->xl_list[i], heal->fd, heal->offset / ec->fragments,
+                      GF_SEEK_DATA, NULL, &data);
+    if (ret == -ENXIO)
+        return _gf_true;
+    if (ret < 0) {
+        gf_msg_debug(ec->xl->name, -ret,
+                     "%s: SEEK_DATA failed, holes will be copied",
+                     uuid_utoa(heal->fd->inode->gfid));
+        *seek = _gf_false;
+        return _gf_false;
+    }
+
+    offset = (uint64_t)data * ec->fragments;
+    offset -= offset % heal->size;
+    if (offset > heal->offset)
+        heal->offset = offset;
+
+    return _gf_false;
+}
+
+/* Moves heal->offset to the first window that contains a dirty region.
+ * Returns true if there are no dirty regions left. */
+static gf_boolean_t
+ec_heal_skip_clean(ec_heal_t *heal)
+{
+    uint64_t offset = UINT64_MAX;
+    uint32_t i;
+
+    for (i = 0; i < EC_REGION_SHIFTS; i++) {
+        offset = min(offset,
+                     gf_region_next(heal->regions + i * EC_REGION_MAP_SIZE,
+                                    EC_REGION_MIN_SHIFT + i, heal->offset));
+    }
+    if (offset == UINT64_MAX)
+        return _gf_true;
+
+    offset -= offset % heal->size;
+    if (offset > heal->offset)
+        heal->offset = offset;
+
+    return _gf_false;
 }
 
+static void
+ec_heal_window_init(ec_heal_t *heal, ec_heal_t *window)
+{
+    memset(window, 0, sizeof(*window));
+    LOCK_INIT(&window->lock);
+    window->xl = heal->xl;
+    window->fd = heal->fd;
+    window->ia_type = heal->ia_type;
+    window->good = heal->good;
+    window->bad = heal->bad;
+    window->offset = heal->offset;
+    window->size = heal->size;
+    window->total_size = heal->total_size;
+    window->regions = heal->regions;
+    window->parent = heal;
+}
+
+/* Data is rebuilt in waves of up to heal-pipeline-depth windows. All the
+ * windows of a wave are sent at once and each of them only locks its own
+ * range, so reads from the good bricks of a window overlap with the
+ * decoding and writing of the others. The locks of a wave are all released
+ * before the next one starts, letting the application I/O that waits on
+ * them go. If 'regions' is given, only the windows covering them are
+ * rebuilt. */
 int
 ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
-                unsigned char *sources, unsigned char *healed_sinks)
+                unsigned char *sources, unsigned char *healed_sinks,
+                uint8_t *regions)
 {
     ec_heal_t obj, *heal = &obj;
+    ec_heal_t *windows = NULL;
+    gf_boolean_t seek = _gf_true;
+    uint32_t depth, count, i;
     int ret = 0;
 
     memset(&obj, 0, sizeof(obj));
@@ -2070,10 +2352,18 @@ ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
     heal->bad = ec_char_array_to_mask(healed_sinks, ec->nodes);
     heal->good = ec_char_array_to_mask(sources, ec->nodes);
     heal->ia_type = IA_IFREG;
+    heal->regions = regions;
     LOCK_INIT(&heal->lock);
 
-    for (heal->offset = 0; (heal->offset < size) && !heal->done;
-         heal->offset += heal->size) {
+    /* Holes can't be skipped if the sinks haven't been emptied. */
+    if (regions != NULL)
+        seek = _gf_false;
+
+    depth = ec->heal_pipeline_depth;
+    windows = alloca0(depth * sizeof(*windows));
+
+    heal->offset = 0;
+    while ((heal->offset < size) && !heal->done) {
         /* We immediately abort any heal if a shutdown request has been
          * received to avoid delays. The healing of this file will be
          * restarted by another SHD or other client that accesses the
@@ -2086,13 +2376,49 @@ ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
             break;
         }
 
+        for (count = 0; count < depth; count++) {
+            if (seek && ec_heal_skip_holes(ec, heal, &seek)) {
+                heal->done = _gf_true;
+            }
+            if ((regions != NULL) && ec_heal_skip_clean(heal)) {
+                heal->done = _gf_true;
+            }
+            if (heal->done || (heal->offset >= size))
+                break;
+
+            ec_heal_window_init(heal, &windows[count]);
+            heal->offset += heal->size;
+        }
+        if (count == 0)
+            break;
+
         gf_msg_debug(ec->xl->name, 0,
                      "%s: sources: %d, sinks: "
-                     "%d, offset: %" PRIu64 " bsize: %" PRIu64,
+                     "%d, offset: %" PRIu64 " bsize: %" PRIu64
+                     " windows: %u",
                      uuid_utoa(fd->inode->gfid), EC_COUNT(sources, ec->nodes),
-                     EC_COUNT(healed_sinks, ec->nodes), heal->offset,
-                     heal->size);
-        ret = ec_sync_heal_block(frame, ec->xl, heal);
+                     EC_COUNT(healed_sinks, ec->nodes), windows[0].offset,
+                     heal->size, count);
+
+        ec_heal_bandwidth_wait(ec, count * heal->size);
+
+        for (i = 0; i < count; i++) {
+            ec_heal_block(frame, ec->xl, windows[i].bad | windows[i].good,
+                          EC_MINIMUM_ONE, ec_heal_block_done, &windows[i]);
+        }
+        syncbarrier_wait(&heal->barrier, count);
+
+        for (i = 0; i < count; i++) {
+            heal->good &= windows[i].good;
+            heal->bad &= windows[i].bad;
+            if (windows[i].done)
+                heal->done = _gf_true;
+            if ((windows[i].error != 0) && (ret == 0))
+                ret = -windows[i].error;
+            LOCK_DESTROY(&windows[i].lock);
+        }
+        if ((ret == 0) && (heal->bad == 0))
+            ret = -ENOTCONN;
         if (ret < 0)
             break;
     }
@@ -2121,17 +2447,29 @@ __ec_heal_trim_sinks(call_frame_t *frame, ec_t *ec, fd_t *fd,
     EC_REPLIES_ALLOC(replies, ec->nodes);
     output = alloca0(ec->nodes);
 
-    if (EC_COUNT(trim, ec->nodes) == 0) {
-        ret = 0;
-        goto out;
-    }
     trim_offset = size;
     ec_adjust_offset_up(ec, &trim_offset, _gf_true);
-    ret = cluster_ftruncate(ec->xl_list, trim, ec->nodes, replies, output,
-                            frame, ec->xl, fd, trim_offset, NULL);
-    for (i = 0; i < ec->nodes; i++) {
-        if (!output[i] && trim[i])
-            healed_sinks[i] = 0;
+
+    /* ec_rebuild_data() doesn't copy the holes of the file, so the sinks
+     * are emptied and then extended to the final size. */
+    if (EC_COUNT(trim, ec->nodes) != 0) {
+        ret = cluster_ftruncate(ec->xl_list, trim, ec->nodes, replies, output,
+                                frame, ec->xl, fd, 0, NULL);
+        for (i = 0; i < ec->nodes; i++) {
+            if (!output[i] && trim[i])
+                healed_sinks[i] = 0;
+        }
+        cluster_replies_wipe(replies, ec->nodes);
+    }
+
+    if ((trim_offset != 0) && (EC_COUNT(healed_sinks, ec->nodes) != 0)) {
+        memcpy(trim, healed_sinks, ec->nodes);
+        ret = cluster_ftruncate(ec->xl_list, trim, ec->nodes, replies, output,
+                                frame, ec->xl, fd, trim_offset, NULL);
+        for (i = 0; i < ec->nodes; i++) {
+            if (!output[i] && trim[i])
+                healed_sinks[i] = 0;
+        }
     }
 
     if (EC_COUNT(healed_sinks, ec->nodes) == 0) {
@@ -2150,12 +2488,14 @@ out:
 int
 ec_data_undo_pending(call_frame_t *frame, ec_t *ec, fd_t *fd, dict_t *xattr,
                      uint64_t *versions, uint64_t *dirty, uint64_t *size,
-                     int source, gf_boolean_t erase_dirty, int idx)
+                     uint64_t *region_versions, int source,
+                     gf_boolean_t erase_dirty, int idx)
 {
     uint64_t versions_xattr[2] = {0};
     uint64_t dirty_xattr[2] = {0};
     uint64_t allzero[2] = {0};
     uint64_t size_xattr = 0;
+    uint64_t region_xattr = 0;
     int ret = 0;
 
     versions_xattr[EC_DATA_TXN] = htobe64(versions[source] - versions[idx]);
@@ -2178,9 +2518,19 @@ ec_data_undo_pending(call_frame_t *frame, ec_t *ec, fd_t *fd, dict_t *xattr,
             goto out;
     }
 
+    /* Once all the bricks are in sync, the version of the dirty regions is
+     * made equal to the data version so that regions can be tracked again. */
+    if (region_versions != NULL) {
+        region_xattr = htobe64(versions[source] - region_versions[idx]);
+        ret = dict_set_static_bin(xattr, EC_XATTR_REGION_VERSION,
+                                  &region_xattr, sizeof(region_xattr));
+        if (ret < 0)
+            goto out;
+    }
+
     if ((memcmp(versions_xattr, allzero, sizeof(allzero)) == 0) &&
         (memcmp(dirty_xattr, allzero, sizeof(allzero)) == 0) &&
-        (size_xattr == 0)) {
+        (size_xattr == 0) && (region_xattr == 0)) {
         ret = 0;
         goto out;
     }
@@ -2195,9 +2545,11 @@ int
 __ec_fd_data_adjust_versions(call_frame_t *frame, ec_t *ec, fd_t *fd,
                              unsigned char *sources,
                              unsigned char *healed_sinks, uint64_t *versions,
-                             uint64_t *dirty, uint64_t *size)
+                             uint64_t *dirty, uint64_t *size,
+                             uint64_t *region_versions, uint32_t present)
 {
     dict_t *xattr = NULL;
+    unsigned char *participants = NULL;
     int i = 0;
     int ret = 0;
     int op_ret = 0;
@@ -2228,10 +2580,22 @@ __ec_fd_data_adjust_versions(call_frame_t *frame, ec_t *ec, fd_t *fd,
         goto out;
     }
 
+    if (!erase_dirty) {
+        region_versions = NULL;
+    } else if ((region_versions != NULL) && (present != 0)) {
+        participants = alloca0(ec->nodes);
+        for (i = 0; i < ec->nodes; i++)
+            participants[i] = sources[i] || healed_sinks[i];
+        if (__ec_heal_data_clear_regions(frame, ec, fd, participants,
+                                         present) < 0)
+            region_versions = NULL;
+    }
+
     for (i = 0; i < ec->nodes; i++) {
         if (healed_sinks[i]) {
             ret = ec_data_undo_pending(frame, ec, fd, xattr, versions, dirty,
-                                       size, source, erase_dirty, i);
+                                       size, region_versions, source,
+                                       erase_dirty, i);
             if (ret < 0)
                 goto out;
         }
@@ -2243,7 +2607,8 @@ __ec_fd_data_adjust_versions(call_frame_t *frame, ec_t *ec, fd_t *fd,
     for (i = 0; i < ec->nodes; i++) {
         if (sources[i]) {
             ret = ec_data_undo_pending(frame, ec, fd, xattr, versions, dirty,
-                                       size, source, erase_dirty, i);
+                                       size, region_versions, source,
+                                       erase_dirty, i);
             if (ret < 0)
                 continue;
         }
@@ -2259,7 +2624,8 @@ ec_restore_time_and_adjust_versions(call_frame_t *frame, ec_t *ec, fd_t *fd,
                                     unsigned char *sources,
                                     unsigned char *healed_sinks,
                                     uint64_t *versions, uint64_t *dirty,
-                                    uint64_t *size)
+                                    uint64_t *size, uint64_t *region_versions,
+                                    uint32_t present)
 {
     unsigned char *locked_on = NULL;
     unsigned char *participants = NULL;
@@ -2271,6 +2637,7 @@ ec_restore_time_and_adjust_versions(call_frame_t *frame, ec_t *ec, fd_t *fd,
     uint64_t *postsh_versions = NULL;
     uint64_t *postsh_dirty = NULL;
     uint64_t *postsh_size = NULL;
+    int first = -1;
     int ret = 0;
     int i = 0;
     struct iatt source_buf = {0};
@@ -2313,6 +2680,18 @@ ec_restore_time_and_adjust_versions(call_frame_t *frame, ec_t *ec, fd_t *fd,
         if (ret < 0)
             goto unlock;
 
+        /* Regions recorded while the data was being rebuilt are still
+         * needed by the bricks that have missed some write meanwhile. */
+        for (i = 0; (region_versions != NULL) && (i < ec->nodes); i++) {
+            if (!participants[i])
+                continue;
+            if (first < 0)
+                first = i;
+            if (!locked_on[i] || (postsh_versions[i] - versions[i] !=
+                                  postsh_versions[first] - versions[first]))
+                region_versions = NULL;
+        }
+
         loc.inode = inode_ref(fd->inode);
         gf_uuid_copy(loc.gfid, fd->inode->gfid);
         ret = cluster_setattr(
@@ -2325,7 +2704,8 @@ ec_restore_time_and_adjust_versions(call_frame_t *frame, ec_t *ec, fd_t *fd,
             goto unlock;
         }
         ret = __ec_fd_data_adjust_versions(frame, ec, fd, sources, healed_sinks,
-                                           versions, dirty, size);
+                                           versions, dirty, size,
+                                           region_versions, present);
     }
 unlock:
     cluster_uninodelk(ec->xl_list, locked_on, ec->nodes, replies, output, frame,
@@ -2344,10 +2724,14 @@ __ec_heal_data(call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
     uint64_t *versions = NULL;
     uint64_t *dirty = NULL;
     uint64_t *size = NULL;
+    uint64_t *region_versions = NULL;
+    uint8_t *regions = NULL;
+    uint32_t present = 0;
     unsigned char *trim = NULL;
     default_args_cbk_t *replies = NULL;
     int ret = 0;
     int source = 0;
+    int partial = -1;
 
     locked_on = alloca0(ec->nodes);
     output = alloca0(ec->nodes);
@@ -2355,6 +2739,7 @@ __ec_heal_data(call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
     versions = alloca0(ec->nodes * sizeof(*versions));
     dirty = alloca0(ec->nodes * sizeof(*dirty));
     size = alloca0(ec->nodes * sizeof(*size));
+    region_versions = alloca0(ec->nodes * sizeof(*region_versions));
 
     EC_REPLIES_ALLOC(replies, ec->nodes);
     ret = cluster_inodelk(ec->xl_list, heal_on, ec->nodes, replies, locked_on,
@@ -2374,18 +2759,42 @@ __ec_heal_data(call_frame_t *frame, ec_t *ec, fd_t *fd, unsigned char *heal_on,
                                      size, sources, healed_sinks, trim, NULL);
         if (ret < 0)
             goto unlock;
+        source = ret;
+
+        if (ec->dirty_regions) {
+            regions = GF_MALLOC(EC_REGION_SHIFTS * EC_REGION_MAP_SIZE,
+                                ec_mt_ec_region_map_t);
+            if (regions != NULL)
+                partial = __ec_heal_data_regions(
+                    frame, ec, fd, locked_on, versions, sources, healed_sinks,
+                    region_versions, regions, &present);
+        }
+        if (partial < 0)
+            region_versions = NULL;
 
         if (EC_COUNT(healed_sinks, ec->nodes) == 0) {
-            ret = __ec_fd_data_adjust_versions(
-                frame, ec, fd, sources, healed_sinks, versions, dirty, size);
+            ret = __ec_fd_data_adjust_versions(frame, ec, fd, sources,
+                                               healed_sinks, versions, dirty,
+                                               size, region_versions, present);
             goto unlock;
         }
 
-        source = ret;
+        if (ec->dirty_regions) {
+            if (partial > 0)
+                GF_ATOMIC_INC(ec->stats.regions.partial);
+            else
+                GF_ATOMIC_INC(ec->stats.regions.full);
+        }
+
         ret = __ec_heal_mark_sinks(frame, ec, fd, versions, healed_sinks);
         if (ret < 0)
             goto unlock;
 
+        /* Sinks only healed in the dirty regions keep their data, they just
+         * need to have the right size. */
+        if ((partial > 0) && (size[source] != 0))
+            memset(trim, 0, ec->nodes);
+
         ret = __ec_heal_trim_sinks(frame, ec, fd, healed_sinks, trim,
                                    size[source]);
     }
@@ -2404,13 +2813,16 @@ unlock:
                  uuid_utoa(fd->inode->gfid), EC_COUNT(sources, ec->nodes),
                  EC_COUNT(healed_sinks, ec->nodes));
 
-    ret = ec_rebuild_data(frame, ec, fd, size[source], sources, healed_sinks);
+    ret = ec_rebuild_data(frame, ec, fd, size[source], sources, healed_sinks,
+                          (partial > 0) ? regions : NULL);
     if (ret < 0)
         goto out;
 
-    ret = ec_restore_time_and_adjust_versions(
-        frame, ec, fd, sources, healed_sinks, versions, dirty, size);
+    ret = ec_restore_time_and_adjust_versions(frame, ec, fd, sources,
+                                              healed_sinks, versions, dirty,
+                                              size, region_versions, present);
 out:
+    GF_FREE(regions);
     cluster_replies_wipe(replies, ec->nodes);
     return ret;
 }
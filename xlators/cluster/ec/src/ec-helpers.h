@@ -183,6 +183,16 @@ ec_is_power_of_2(uint32_t value)
     return (value != 0) && ((value & (value - 1)) == 0);
 }
 
+static inline uint64_t
+ec_time_usec(void)
+{
+    struct timespec ts;
+
+    timespec_now(&ts);
+
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
 gf_boolean_t
 ec_is_internal_xattr(dict_t *dict, char *key, data_t *value, void *data);
 
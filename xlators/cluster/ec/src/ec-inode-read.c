@@ -15,6 +15,7 @@
 #include "ec-combine.h"
 #include "ec-method.h"
 #include "ec-fops.h"
+#include "ec-compute.h"
 
 /* FOP: access */
 
@@ -1239,6 +1240,20 @@ out:
     return err;
 }
 
+static int32_t
+ec_readv_compute(ec_fop_data_t *fop)
+{
+    ec_cbk_data_t *cbk = fop->answer;
+    int32_t err;
+
+    err = ec_readv_rebuild(fop->xl->private, fop, cbk);
+    if (err != 0) {
+        ec_cbk_set_error(cbk, -err, _gf_true);
+    }
+
+    return 0;
+}
+
 int32_t
 ec_combine_readv(ec_fop_data_t *fop, ec_cbk_data_t *dst, ec_cbk_data_t *src)
 {
@@ -1386,9 +1401,13 @@ ec_manager_readv(ec_fop_data_t *fop, int32_t state)
 
                 ec_iatt_rebuild(fop->xl->private, cbk->iatt, 1, cbk->count);
 
-                err = ec_readv_rebuild(fop->xl->private, fop, cbk);
-                if (err != 0) {
-                    ec_cbk_set_error(cbk, -err, _gf_true);
+                /* Decode in a compute thread if there are any. */
+                if ((cbk->op_ret <= 0) ||
+                    !ec_compute_submit(fop, ec_readv_compute)) {
+                    err = ec_readv_rebuild(fop->xl->private, fop, cbk);
+                    if (err != 0) {
+                        ec_cbk_set_error(cbk, -err, _gf_true);
+                    }
                 }
             }
 
@@ -8,12 +8,15 @@
   cases as published by the Free Software Foundation.
 */
 
+#include <glusterfs/call-stub.h>
+
 #include "ec-messages.h"
 #include "ec-helpers.h"
 #include "ec-common.h"
 #include "ec-combine.h"
 #include "ec-method.h"
 #include "ec-fops.h"
+#include "ec-compute.h"
 #include "ec-mem-types.h"
 
 int32_t
@@ -2194,8 +2197,15 @@ ec_manager_writev(ec_fop_data_t *fop, int32_t state)
             fop->frame->root->uid = fop->uid;
             fop->frame->root->gid = fop->gid;
 
-            ec_writev_encode(fop);
+            if (!ec_compute_encode(fop, fop->vector[0].iov_len,
+                                   fop->vector[0].iov_base,
+                                   fop->vector[1].iov_base)) {
+                ec_writev_encode(fop);
+            }
+
+            return EC_STATE_DELAYED_DISPATCH;
 
+        case EC_STATE_DELAYED_DISPATCH:
             ec_dispatch_all(fop);
 
             return EC_STATE_PREPARE_ANSWER;
@@ -2270,6 +2280,7 @@ ec_manager_writev(ec_fop_data_t *fop, int32_t state)
         case -EC_STATE_INIT:
         case -EC_STATE_LOCK:
         case -EC_STATE_DISPATCH:
+        case -EC_STATE_DELAYED_DISPATCH:
         case -EC_STATE_PREPARE_ANSWER:
         case -EC_STATE_REPORT:
             GF_ASSERT(fop->error != 0);
@@ -2381,3 +2392,345 @@ out:
         func(frame, NULL, this, -1, error, NULL, NULL, NULL);
     }
 }
+
+/* Write coalescing
+ *
+ * Writes that don't start and end on a stripe boundary need to read the
+ * head and tail stripes before encoding. When an application has several of
+ * them in flight for adjacent ranges, as databases and virtual machines
+ * usually do, each one reads the stripe that the previous one is about to
+ * write.
+ *
+ * If write-coalesce-timeout is set, such writes are held for at most that
+ * time. Adjacent writes from the same fd that arrive meanwhile are added to
+ * the batch, which is sent as a single write as soon as it covers whole
+ * stripes, a write that can't be added arrives, the fd is flushed or synced,
+ * or the timeout expires. Each held write is answered when the combined one
+ * completes, so nothing is acknowledged before reaching the bricks. */
+
+#define EC_WBATCH_MAX_SIZE (1024 * 1024)
+
+static gf_boolean_t
+ec_wbatch_aligned(ec_t *ec, off_t start, off_t end)
+{
+    return ((start % ec->stripe_size) == 0) && ((end % ec->stripe_size) == 0);
+}
+
+static void
+ec_wbatch_done(xlator_t *this, ec_wbatch_t *batch, int32_t op_ret,
+               int32_t op_errno, struct iatt *prebuf, struct iatt *postbuf,
+               dict_t *xdata)
+{
+    ec_t *ec = this->private;
+    call_stub_t *stub = NULL;
+    call_stub_t *tmp = NULL;
+    gf_boolean_t last_fop = _gf_false;
+    int64_t done, size;
+    int32_t ret, err;
+
+    list_for_each_entry_safe(stub, tmp, &batch->stubs, list)
+    {
+        list_del_init(&stub->list);
+
+        size = iov_length(stub->args.vector, stub->args.count);
+        done = (int64_t)op_ret - (stub->args.offset - batch->start);
+        ret = op_ret;
+        err = op_errno;
+        if (op_ret >= 0) {
+            if (done > 0) {
+                ret = min(done, size);
+            } else {
+                ret = -1;
+                err = EIO;
+            }
+        }
+
+        STACK_UNWIND_STRICT(writev, stub->frame, ret, err, prebuf, postbuf,
+                            xdata);
+        call_stub_destroy(stub);
+    }
+
+    fd_unref(batch->fd);
+    GF_FREE(batch);
+
+    /* Held writes delay the shutdown of the xlator like any other fop. */
+    if (GF_ATOMIC_DEC(ec->async_fop_count) == 0) {
+        LOCK(&ec->lock);
+        {
+            last_fop = __ec_is_last_fop(ec);
+        }
+        UNLOCK(&ec->lock);
+    }
+    if (last_fop) {
+        ec_pending_fops_completed(ec);
+    }
+}
+
+static int32_t
+ec_wbatch_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+              struct iatt *postbuf, dict_t *xdata)
+{
+    ec_wbatch_t *batch = frame->cookie;
+
+    ec_wbatch_done(this, batch, op_ret, op_errno, prebuf, postbuf, xdata);
+
+    frame->cookie = NULL;
+    STACK_DESTROY(frame->root);
+
+    return 0;
+}
+
+static void
+ec_wbatch_send(xlator_t *this, ec_wbatch_t *batch)
+{
+    ec_t *ec = this->private;
+    call_frame_t *frame = NULL;
+    call_stub_t *stub = NULL;
+    struct iobref *iobref = NULL;
+    struct iovec *vector = NULL;
+    int32_t count = 0;
+    int32_t error = ENOMEM;
+
+    GF_ATOMIC_INC(ec->stats.write_coalesce.batches);
+    GF_ATOMIC_ADD(ec->stats.write_coalesce.writes, batch->count);
+
+    stub = list_first_entry(&batch->stubs, call_stub_t, list);
+    frame = copy_frame(stub->frame);
+    if (frame == NULL) {
+        goto out;
+    }
+    frame->cookie = batch;
+
+    list_for_each_entry(stub, &batch->stubs, list)
+    {
+        count += stub->args.count;
+    }
+
+    vector = GF_MALLOC(VECTORSIZE(count), gf_common_mt_iovec);
+    iobref = iobref_new();
+    if ((vector == NULL) || (iobref == NULL)) {
+        goto out;
+    }
+
+    count = 0;
+    list_for_each_entry(stub, &batch->stubs, list)
+    {
+        memcpy(vector + count, stub->args.vector,
+               VECTORSIZE(stub->args.count));
+        count += stub->args.count;
+        if ((stub->args.iobref != NULL) &&
+            (iobref_merge(iobref, stub->args.iobref) != 0)) {
+            goto out;
+        }
+    }
+
+    ec_writev(frame, this, -1, EC_MINIMUM_MIN, ec_wbatch_cbk, NULL, batch->fd,
+              vector, count, batch->start, batch->flags, iobref, NULL);
+
+    error = 0;
+
+out:
+    GF_FREE(vector);
+    if (iobref != NULL) {
+        iobref_unref(iobref);
+    }
+    if (error != 0) {
+        gf_msg(this->name, GF_LOG_WARNING, error, EC_MSG_NO_MEMORY,
+               "Failed to send coalesced writes");
+
+        if (frame != NULL) {
+            STACK_DESTROY(frame->root);
+        }
+        ec_wbatch_done(this, batch, -1, error, NULL, NULL, NULL);
+    }
+}
+
+/* Called with the inode locked. Returns true if the caller must send the
+ * batch, or false if its timer is already running and will do it. */
+static gf_boolean_t
+__ec_wbatch_detach(xlator_t *this, ec_inode_t *ctx)
+{
+    ec_wbatch_t *batch = ctx->wbatch;
+
+    ctx->wbatch = NULL;
+    if (gf_timer_call_cancel(this->ctx, batch->timer) != 0) {
+        return _gf_false;
+    }
+    batch->timer = NULL;
+
+    return _gf_true;
+}
+
+static void
+ec_wbatch_timeout(void *data)
+{
+    ec_wbatch_t *batch = data;
+    xlator_t *this = THIS;
+    inode_t *inode = batch->fd->inode;
+    ec_inode_t *ctx = NULL;
+
+    LOCK(&inode->lock);
+    {
+        ctx = __ec_inode_get(inode, this);
+        if ((ctx != NULL) && (ctx->wbatch == batch)) {
+            ctx->wbatch = NULL;
+        }
+        batch->timer = NULL;
+    }
+    UNLOCK(&inode->lock);
+
+    ec_wbatch_send(this, batch);
+}
+
+static gf_boolean_t
+__ec_wbatch_add(ec_wbatch_t *batch, call_stub_t *stub, fd_t *fd, off_t offset,
+                off_t end, uint32_t flags)
+{
+    if ((batch->fd != fd) || (batch->flags != flags) ||
+        (batch->end - batch->start + end - offset > EC_WBATCH_MAX_SIZE)) {
+        return _gf_false;
+    }
+
+    if (offset == batch->end) {
+        list_add_tail(&stub->list, &batch->stubs);
+        batch->end = end;
+    } else if (end == batch->start) {
+        list_add(&stub->list, &batch->stubs);
+        batch->start = offset;
+    } else {
+        return _gf_false;
+    }
+    batch->count++;
+
+    return _gf_true;
+}
+
+static ec_wbatch_t *
+__ec_wbatch_new(xlator_t *this, call_stub_t *stub, fd_t *fd, off_t offset,
+                off_t end, uint32_t flags)
+{
+    ec_t *ec = this->private;
+    ec_wbatch_t *batch = NULL;
+    struct timespec delta = {
+        0,
+    };
+
+    batch = GF_CALLOC(1, sizeof(*batch), ec_mt_ec_wbatch_t);
+    if (batch == NULL) {
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&batch->stubs);
+    list_add_tail(&stub->list, &batch->stubs);
+    batch->fd = fd_ref(fd);
+    batch->start = offset;
+    batch->end = end;
+    batch->flags = flags;
+    batch->count = 1;
+
+    delta.tv_sec = ec->write_coalesce_timeout / 1000000;
+    delta.tv_nsec = (ec->write_coalesce_timeout % 1000000) * 1000;
+    batch->timer = gf_timer_call_after(this->ctx, delta, ec_wbatch_timeout,
+                                       batch);
+    if (batch->timer == NULL) {
+        fd_unref(batch->fd);
+        GF_FREE(batch);
+        return NULL;
+    }
+    GF_ATOMIC_INC(ec->async_fop_count);
+
+    return batch;
+}
+
+/* Returns true if the write has been taken and will be answered later. */
+gf_boolean_t
+ec_writev_coalesce(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   struct iovec *vector, int32_t count, off_t offset,
+                   uint32_t flags, struct iobref *iobref, dict_t *xdata)
+{
+    ec_t *ec = this->private;
+    ec_inode_t *ctx = NULL;
+    ec_fd_t *fd_ctx = NULL;
+    ec_wbatch_t *batch = NULL;
+    ec_wbatch_t *send = NULL;
+    call_stub_t *stub = NULL;
+    gf_boolean_t taken = _gf_false;
+    off_t end;
+
+    end = offset + iov_length(vector, count);
+    if ((xdata != NULL) || (end == offset) ||
+        (end - offset > EC_WBATCH_MAX_SIZE)) {
+        return _gf_false;
+    }
+
+    fd_ctx = ec_fd_get(fd, this);
+    if ((fd_ctx == NULL) || ((fd_ctx->flags & O_APPEND) != 0)) {
+        return _gf_false;
+    }
+
+    stub = fop_writev_stub(frame, NULL, fd, vector, count, offset, flags,
+                           iobref, NULL);
+    if (stub == NULL) {
+        return _gf_false;
+    }
+
+    LOCK(&fd->inode->lock);
+    {
+        ctx = __ec_inode_get(fd->inode, this);
+        if (ctx == NULL) {
+            goto unlock;
+        }
+
+        batch = ctx->wbatch;
+        if (batch != NULL) {
+            taken = __ec_wbatch_add(batch, stub, fd, offset, end, flags);
+            if (!taken || ec_wbatch_aligned(ec, batch->start, batch->end)) {
+                if (__ec_wbatch_detach(this, ctx)) {
+                    send = batch;
+                }
+            }
+        }
+
+        if (!taken && !ec_wbatch_aligned(ec, offset, end)) {
+            ctx->wbatch = __ec_wbatch_new(this, stub, fd, offset, end, flags);
+            taken = (ctx->wbatch != NULL);
+        }
+    }
+unlock:
+    UNLOCK(&fd->inode->lock);
+
+    if (!taken) {
+        call_stub_destroy(stub);
+    }
+    if (send != NULL) {
+        ec_wbatch_send(this, send);
+    }
+
+    return taken;
+}
+
+/* Sends the writes held for the inode, if any, without waiting for the
+ * timeout. */
+void
+ec_writev_coalesce_flush(xlator_t *this, inode_t *inode)
+{
+    ec_inode_t *ctx = NULL;
+    ec_wbatch_t *send = NULL;
+
+    LOCK(&inode->lock);
+    {
+        ctx = __ec_inode_get(inode, this);
+        if ((ctx != NULL) && (ctx->wbatch != NULL)) {
+            send = ctx->wbatch;
+            if (!__ec_wbatch_detach(this, ctx)) {
+                send = NULL;
+            }
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    if (send != NULL) {
+        ec_wbatch_send(this, send);
+    }
+}
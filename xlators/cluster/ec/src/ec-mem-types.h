@@ -24,6 +24,11 @@ enum gf_ec_mem_types_ {
     ec_mt_ec_code_builder_t,
     ec_mt_ec_matrix_t,
     ec_mt_ec_stripe_t,
+    ec_mt_ec_wbatch_t,
+    ec_mt_ec_compute_job_t,
+    ec_mt_pthread_t,
+    ec_mt_ec_child_load_t,
+    ec_mt_ec_region_map_t,
     ec_mt_end
 };
 
@@ -0,0 +1,218 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* Measures the encoding and decoding throughput of the ec_method_* API
+ * with every code generator, and checks that all of them decode the data
+ * back to the original contents.
+ *
+ * Usage: ec-method-bench [-k fragments] [-r redundancy] [-s size in MiB]
+ *                        [-i iterations] [generator ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <inttypes.h>
+
+#include <glusterfs/globals.h>
+#include <glusterfs/glusterfs.h>
+#include <glusterfs/logging.h>
+
+#include "ec-types.h"
+#include "ec-method.h"
+
+static const char *ec_bench_default_gens[] = {"none", "x64", "sse", "avx",
+                                              "avx512", NULL};
+
+static double
+ec_bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+ec_bench_run(xlator_t *xl, const char *gen, uint32_t fragments,
+             uint32_t redundancy, uint64_t size, uint32_t iterations)
+{
+    ec_matrix_list_t list;
+    uint32_t nodes = fragments + redundancy;
+    uint64_t fsize = size / fragments;
+    uint8_t *data = NULL, *encoded = NULL, *decoded = NULL;
+    void *out[nodes], *in[fragments];
+    uint32_t rows[fragments];
+    uintptr_t mask = 0;
+    double start, enc, dec, sel;
+    uint32_t i, j;
+    int ret = -1;
+
+    memset(&list, 0, sizeof(list));
+    if (ec_method_init(xl, &list, fragments, nodes, nodes * 2, gen) != 0) {
+        fprintf(stderr, "%s: unable to initialize the matrices\n", gen);
+        return -1;
+    }
+
+    if (posix_memalign((void **)&data, EC_METHOD_WORD_SIZE, size) ||
+        posix_memalign((void **)&encoded, EC_METHOD_WORD_SIZE,
+                       fsize * nodes) ||
+        posix_memalign((void **)&decoded, EC_METHOD_WORD_SIZE, size)) {
+        fprintf(stderr, "%s: out of memory\n", gen);
+        goto out;
+    }
+    for (i = 0; i < size; i++) {
+        data[i] = random();
+    }
+
+    start = ec_bench_now();
+    for (i = 0; i < iterations; i++) {
+        for (j = 0; j < nodes; j++) {
+            out[j] = encoded + j * fsize;
+        }
+        ec_method_encode(&list, size, data, out);
+    }
+    enc = ec_bench_now() - start;
+
+    /* Decode from the last fragments so that the redundancy is always
+     * used to rebuild the data. */
+    for (i = 0; i < fragments; i++) {
+        j = nodes - fragments + i;
+        rows[i] = j + 1;
+        in[i] = encoded + j * fsize;
+        mask |= 1ULL << j;
+    }
+
+    start = ec_bench_now();
+    for (i = 0; i < iterations; i++) {
+        if (ec_method_decode(&list, fsize, mask, rows, in, decoded) != 0) {
+            fprintf(stderr, "%s: decoding failed\n", gen);
+            goto out;
+        }
+    }
+    dec = ec_bench_now() - start;
+
+    if (memcmp(data, decoded, size) != 0) {
+        fprintf(stderr, "%s: decoded data does not match\n", gen);
+        goto out;
+    }
+
+    /* Decode again from the fragments that ec_method_select() considers
+     * the cheapest ones. */
+    mask = ec_method_select(&list, (1ULL << nodes) - 1);
+    for (i = 0, j = 0; j < nodes; j++) {
+        if (((mask >> j) & 1) != 0) {
+            rows[i] = j + 1;
+            in[i++] = encoded + j * fsize;
+        }
+    }
+
+    start = ec_bench_now();
+    for (i = 0; i < iterations; i++) {
+        if (ec_method_decode(&list, fsize, mask, rows, in, decoded) != 0) {
+            fprintf(stderr, "%s: decoding failed\n", gen);
+            goto out;
+        }
+    }
+    sel = ec_bench_now() - start;
+
+    if (memcmp(data, decoded, size) != 0) {
+        fprintf(stderr, "%s: decoded data does not match\n", gen);
+        goto out;
+    }
+
+    printf("%-8s %-8s %10.1f MiB/s encode %10.1f MiB/s decode "
+           "%10.1f MiB/s min-decode\n",
+           gen, (list.code->gen != NULL) ? list.code->gen->name : "none",
+           (double)size * iterations / enc / 1048576.0,
+           (double)size * iterations / dec / 1048576.0,
+           (double)size * iterations / sel / 1048576.0);
+
+    ret = 0;
+
+out:
+    free(data);
+    free(encoded);
+    free(decoded);
+    ec_method_fini(&list);
+
+    return ret;
+}
+
+int
+main(int argc, char *argv[])
+{
+    glusterfs_ctx_t *ctx = NULL;
+    uint32_t fragments = 8, redundancy = 3, iterations = 16;
+    uint64_t size = 64;
+    const char **gens = ec_bench_default_gens;
+    int opt, ret = 0;
+
+    while ((opt = getopt(argc, argv, "k:r:s:i:")) != -1) {
+        switch (opt) {
+            case 'k':
+                fragments = strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                redundancy = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                size = strtoull(optarg, NULL, 0);
+                break;
+            case 'i':
+                iterations = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr,
+                        "Usage: %s [-k fragments] [-r redundancy] "
+                        "[-s MiB] [-i iterations] [generator ...]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+    if (optind < argc) {
+        gens = (const char **)&argv[optind];
+    }
+
+    if ((fragments < 2) || (fragments > EC_METHOD_MAX_FRAGMENTS) ||
+        (redundancy < 1) || (redundancy >= fragments) || (size == 0) ||
+        (iterations == 0)) {
+        fprintf(stderr, "Invalid parameters\n");
+        return 1;
+    }
+
+    /* Whole stripes only */
+    size <<= 20;
+    size -= size % (EC_METHOD_CHUNK_SIZE * fragments);
+
+    ctx = glusterfs_ctx_new();
+    if ((ctx == NULL) || (glusterfs_globals_init(ctx) != 0)) {
+        fprintf(stderr, "Unable to initialize the context\n");
+        return 1;
+    }
+    THIS->ctx = ctx;
+    ctx->logbuf_pool = mem_pool_new(log_buf_t, 256);
+    gf_log_init(ctx, "-", "ec-method-bench");
+    gf_log_set_loglevel(ctx, GF_LOG_WARNING);
+
+    printf("%u+%u, %" PRIu64 " bytes, %u iterations\n", fragments,
+           redundancy, size, iterations);
+    for (; *gens != NULL; gens++) {
+        if (ec_bench_run(THIS, *gens, fragments, redundancy, size,
+                         iterations) != 0) {
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
@@ -138,6 +138,7 @@ ec_method_matrix_unref(ec_matrix_list_t *list, ec_matrix_t *matrix)
         if (list->count > list->max) {
             matrix = list_first_entry(&list->lru, ec_matrix_t, lru);
             ec_method_matrix_destroy(list, matrix);
+            list->evictions++;
         }
     }
 }
@@ -209,9 +210,11 @@ ec_method_matrix_get(ec_matrix_list_t *list, uintptr_t mask, uint32_t *rows)
     if (matrix != NULL) {
         list_del_init(&matrix->lru);
         matrix->refs++;
+        list->hits++;
 
         goto out;
     }
+    list->misses++;
 
     if ((list->count >= list->max) && !list_empty(&list->lru)) {
         matrix = list_first_entry(&list->lru, ec_matrix_t, lru);
@@ -220,6 +223,7 @@ ec_method_matrix_get(ec_matrix_list_t *list, uintptr_t mask, uint32_t *rows)
         ec_method_matrix_remove(list, matrix->mask);
 
         ec_method_matrix_release(matrix);
+        list->evictions++;
     } else {
         matrix = mem_get0(list->pool);
         if (matrix == NULL) {
@@ -254,6 +258,151 @@ ec_method_matrix_put(ec_matrix_list_t *list, ec_matrix_t *matrix)
     UNLOCK(&list->lock);
 }
 
+/* Number of operations of the code that multiplies by 'value'. */
+static uint32_t
+ec_method_mul_cost(ec_gf_t *gf, uint32_t value)
+{
+    ec_gf_op_t *op;
+    uint32_t cost = 0;
+
+    for (op = gf->table[value]->ops; op->op != EC_GF_OP_END; op++) {
+        cost++;
+    }
+
+    return cost;
+}
+
+/* Estimates the cost of decoding with the fragments in 'mask'. It follows
+ * ec_code_build_dynamic(): each row loads or xors every fragment with a non
+ * zero coefficient and multiplies by the ratio between consecutive ones. */
+static uint32_t
+ec_method_decode_cost(ec_matrix_list_t *list, uintptr_t mask)
+{
+    uint32_t values[list->columns * list->columns];
+    uint32_t rows[list->columns];
+    uint32_t i, j, last, cost;
+
+    for (i = 0, j = 0; j < list->columns; i++) {
+        if (((mask >> i) & 1) != 0) {
+            rows[j++] = i + 1;
+        }
+    }
+    ec_method_matrix_inverse(list->gf, values, rows, list->columns);
+
+    cost = 0;
+    for (i = 0; i < list->columns; i++) {
+        last = 0;
+        for (j = 0; j < list->columns; j++) {
+            if (values[i * list->columns + j] == 0) {
+                continue;
+            }
+            if (last != 0) {
+                cost += ec_method_mul_cost(
+                    list->gf,
+                    ec_gf_div(list->gf, last, values[i * list->columns + j]));
+            }
+            last = values[i * list->columns + j];
+            cost++;
+        }
+        if (last != 0) {
+            cost += ec_method_mul_cost(list->gf, last);
+        }
+    }
+
+    return cost;
+}
+
+/* Returns the subset of 'avail' with 'columns' fragments whose decoding
+ * matrix is the cheapest, or 0 if there are too many subsets to check. */
+static uintptr_t
+ec_method_select_compute(ec_matrix_list_t *list, uintptr_t avail)
+{
+    uint32_t pos[EC_METHOD_MAX_NODES];
+    uint64_t comb, last, low, high;
+    uintptr_t mask, best;
+    uint32_t i, n, cost, best_cost, checked;
+
+    n = 0;
+    for (i = 0; (avail >> i) != 0; i++) {
+        if (((avail >> i) & 1) != 0) {
+            pos[n++] = i;
+        }
+    }
+
+    best = 0;
+    best_cost = UINT32_MAX;
+    checked = 0;
+
+    /* Visit all combinations of 'columns' out of 'n' bits in increasing
+     * order. */
+    comb = (1ULL << list->columns) - 1;
+    last = comb << (n - list->columns);
+    while (1) {
+        if (++checked > EC_METHOD_SELECT_MAX) {
+            return 0;
+        }
+
+        mask = 0;
+        for (i = 0; i < n; i++) {
+            if (((comb >> i) & 1) != 0) {
+                mask |= 1ULL << pos[i];
+            }
+        }
+        cost = ec_method_decode_cost(list, mask);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = mask;
+        }
+
+        if (comb == last) {
+            break;
+        }
+        low = comb & -comb;
+        high = comb + low;
+        comb = (((high ^ comb) >> 2) / low) | high;
+    }
+
+    return best;
+}
+
+uintptr_t
+ec_method_select(ec_matrix_list_t *list, uintptr_t avail)
+{
+    uintptr_t mask = 0;
+    uint32_t i;
+
+    if (gf_bits_count(avail) <= list->columns) {
+        return avail;
+    }
+
+    LOCK(&list->lock);
+
+    for (i = 0; i < EC_METHOD_SELECT_CACHE; i++) {
+        if (list->select[i].avail == avail) {
+            mask = list->select[i].mask;
+            break;
+        }
+    }
+
+    UNLOCK(&list->lock);
+
+    if (i < EC_METHOD_SELECT_CACHE) {
+        return mask;
+    }
+
+    mask = ec_method_select_compute(list, avail);
+
+    LOCK(&list->lock);
+
+    i = list->select_next++ % EC_METHOD_SELECT_CACHE;
+    list->select[i].avail = avail;
+    list->select[i].mask = mask;
+
+    UNLOCK(&list->lock);
+
+    return mask;
+}
+
 static int32_t
 ec_method_setup(xlator_t *xl, ec_matrix_list_t *list, const char *gen)
 {
@@ -407,6 +556,33 @@ ec_method_encode(ec_matrix_list_t *list, uint64_t size, void *in, void **out)
     }
 }
 
+/* Encodes 'count' buffers in a single call. The fragments of each buffer
+ * are stored one after the other in out[j]. All the stripes of all the
+ * buffers are processed with one row of the matrix before going to the next
+ * one, so that the code and coefficients of the row are reused. */
+void
+ec_method_encode_batch(ec_matrix_list_t *list, uint32_t count, uint64_t *size,
+                       void **in, void **out)
+{
+    ec_matrix_t *matrix;
+    ec_matrix_row_t *row;
+    uint64_t pos;
+    void *dst;
+    uint32_t i, j;
+
+    matrix = list->encode;
+    for (i = 0; i < matrix->rows; i++) {
+        row = &matrix->row_data[i];
+        for (j = 0; j < count; j++) {
+            dst = out[j] + i * (size[j] / list->columns);
+            for (pos = 0; pos < size[j]; pos += list->stripe) {
+                row->func.linear(dst, in[j], pos, row->values, list->columns);
+                dst += EC_METHOD_CHUNK_SIZE;
+            }
+        }
+    }
+}
+
 int32_t
 ec_method_decode(ec_matrix_list_t *list, uint64_t size, uintptr_t mask,
                  uint32_t *rows, void **in, void *out)
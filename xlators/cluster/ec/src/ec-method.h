@@ -28,6 +28,10 @@
 
 #define EC_METHOD_CHUNK_SIZE (EC_METHOD_WORD_SIZE * EC_GF_BITS)
 
+/* Maximum number of fragment combinations checked to find the cheapest
+ * decoding matrix. */
+#define EC_METHOD_SELECT_MAX 4096
+
 int32_t
 ec_method_init(xlator_t *xl, ec_matrix_list_t *list, uint32_t columns,
                uint32_t rows, uint32_t max, const char *gen);
@@ -41,8 +45,15 @@ ec_method_update(xlator_t *xl, ec_matrix_list_t *list, const char *gen);
 void
 ec_method_encode(ec_matrix_list_t *list, uint64_t size, void *in, void **out);
 
+void
+ec_method_encode_batch(ec_matrix_list_t *list, uint32_t count, uint64_t *size,
+                       void **in, void **out);
+
 int32_t
 ec_method_decode(ec_matrix_list_t *list, uint64_t size, uintptr_t mask,
                  uint32_t *rows, void **in, void *out);
 
+uintptr_t
+ec_method_select(ec_matrix_list_t *list, uintptr_t avail);
+
 #endif /* __EC_METHOD_H__ */
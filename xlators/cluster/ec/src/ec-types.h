@@ -17,6 +17,7 @@
 #include <glusterfs/atomic.h>
 
 #define EC_GF_MAX_REGS 16
+#define EC_METHOD_SELECT_CACHE 8
 
 enum _ec_heal_need;
 typedef enum _ec_heal_need ec_heal_need_t;
@@ -112,9 +113,24 @@ typedef struct _ec_matrix ec_matrix_t;
 struct _ec_matrix_list;
 typedef struct _ec_matrix_list ec_matrix_list_t;
 
+struct _ec_matrix_select;
+typedef struct _ec_matrix_select ec_matrix_select_t;
+
 struct _ec_heal;
 typedef struct _ec_heal ec_heal_t;
 
+struct _ec_wbatch;
+typedef struct _ec_wbatch ec_wbatch_t;
+
+struct _ec_compute_job;
+typedef struct _ec_compute_job ec_compute_job_t;
+
+struct _ec_child_load;
+typedef struct _ec_child_load ec_child_load_t;
+
+struct _ec_compute;
+typedef struct _ec_compute ec_compute_t;
+
 struct _ec_self_heald;
 typedef struct _ec_self_heald ec_self_heald_t;
 
@@ -128,7 +144,13 @@ typedef void (*ec_wind_f)(ec_t *, ec_fop_data_t *, int32_t);
 typedef int32_t (*ec_handler_f)(ec_fop_data_t *, int32_t);
 typedef void (*ec_resume_f)(ec_fop_data_t *, int32_t);
 
-enum _ec_read_policy { EC_ROUND_ROBIN, EC_GFID_HASH, EC_READ_POLICY_MAX };
+enum _ec_read_policy {
+    EC_ROUND_ROBIN,
+    EC_GFID_HASH,
+    EC_MIN_DECODE,
+    EC_LEAST_LOAD,
+    EC_READ_POLICY_MAX
+};
 
 enum _ec_heal_need {
     EC_HEAL_NONEED,
@@ -171,6 +193,46 @@ struct _ec_stripe_list {
     uint32_t max;
 };
 
+/* Unaligned writes to an inode that are held for a short time so that
+ * adjacent ones are sent as a single write. */
+struct _ec_wbatch {
+    struct list_head stubs; /* Held writes, sorted by offset */
+    fd_t *fd;
+    gf_timer_t *timer;
+    off_t start;
+    off_t end;
+    uint32_t flags;
+    uint32_t count;
+};
+
+typedef int32_t (*ec_compute_f)(ec_fop_data_t *fop);
+
+struct _ec_compute_job {
+    struct list_head list;
+    ec_fop_data_t *fop;
+    ec_compute_f func; /* NULL for encodings */
+    uint64_t size;     /* Size of the data to encode */
+    void *in;
+    void *out; /* Fragments, one after the other */
+};
+
+struct _ec_child_load {
+    gf_atomic_t pending; /* Requests sent and not answered yet. */
+    uint64_t latency;    /* Moving average of the answer time, in usecs.
+                            Updated without locks, it's only a hint. */
+    int64_t ping;        /* Last ping time in msecs, -1 if unknown. */
+    gf_boolean_t local;  /* The brick is on this host. */
+};
+
+struct _ec_compute {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct list_head jobs;
+    pthread_t *threads;
+    uint32_t count;
+    gf_boolean_t stop;
+};
+
 struct _ec_inode {
     ec_lock_t *inode_lock;
     gf_boolean_t have_info;
@@ -186,7 +248,10 @@ struct _ec_inode {
     uint64_t dirty[2];
     struct list_head heal;
     ec_stripe_list_t stripe_cache;
+    ec_wbatch_t *wbatch;
     uint64_t bad_version;
+    uint8_t *region_map;   /* Regions modified under the current lock. */
+    uint32_t region_shift; /* 0 if no region has been modified. */
 };
 
 typedef int32_t (*fop_heal_cbk_t)(call_frame_t *, void *, xlator_t *, int32_t,
@@ -297,6 +362,8 @@ struct _ec_lock_link {
     uint32_t waiting_flags;
     off_t fl_start;
     off_t fl_end;
+    dict_t *pending_update; /* Size and version update waiting for the
+                               dirty regions to be recorded. */
 };
 
 /* This structure keeps a range of fragment offsets affected by a fop. Since
@@ -347,6 +414,8 @@ struct _ec_fop_data {
     uintptr_t remaining;
     uintptr_t received; /* Mask of responses */
     uintptr_t good;
+    uintptr_t hedged;       /* Bricks added because others were slow */
+    uint64_t dispatch_time; /* usecs, to measure the latency of bricks */
 
     uid_t uid;
     gid_t gid;
@@ -546,6 +615,11 @@ struct _ec_matrix {
     ec_matrix_row_t row_data[0];
 };
 
+struct _ec_matrix_select {
+    uintptr_t avail; /* Fragments that could be used */
+    uintptr_t mask;  /* Fragments with the cheapest decoding matrix */
+};
+
 struct _ec_matrix_list {
     struct list_head lru;
     gf_lock_t lock;
@@ -559,6 +633,11 @@ struct _ec_matrix_list {
     ec_code_t *code;
     ec_matrix_t *encode;
     ec_matrix_t **objects;
+    uint64_t hits;      /* Decodings that found their matrix cached */
+    uint64_t misses;    /* Decodings that had to build their matrix */
+    uint64_t evictions; /* Matrices destroyed or reused to make room */
+    uint32_t select_next;
+    ec_matrix_select_t select[EC_METHOD_SELECT_CACHE];
 };
 
 struct _ec_heal {
@@ -577,6 +656,9 @@ struct _ec_heal {
     uint64_t offset;
     uint64_t size;
     uint64_t total_size;
+    uint8_t *regions;  /* Dirty regions to rebuild, NULL for all. */
+    ec_heal_t *parent; /* Heal this window belongs to, if any. */
+    int32_t windows;   /* Windows of this heal that lock their range. */
 };
 
 struct subvol_healer {
@@ -617,6 +699,30 @@ struct _ec_statistics {
                                 requests. (Basically memory allocation
                                 errors). */
     } stripe_cache;
+    struct {
+        gf_atomic_t batches; /* Number of writes sent for held writes. */
+        gf_atomic_t writes;  /* Number of writes that have been held. */
+    } write_coalesce;
+    struct {
+        gf_atomic_t sent;  /* Number of extra reads sent to other bricks. */
+        gf_atomic_t early; /* Number of reads answered before the slow
+                              bricks. */
+    } hedge;
+    struct {
+        gf_atomic_t jobs;    /* Number of jobs run by the compute threads. */
+        gf_atomic_t batches; /* Number of times the compute threads have
+                                taken jobs from the queue. */
+    } compute;
+    struct {
+        gf_atomic_t updates; /* Number of times dirty regions have been
+                                recorded on the bricks. */
+        gf_atomic_t partial; /* Number of heals that only rebuilt the dirty
+                                regions. */
+        gf_atomic_t full;    /* Number of heals that had to rebuild the
+                                whole file. */
+        gf_atomic_t zeros;   /* Number of heal windows not written because
+                                they only contained zeros. */
+    } regions;
     struct {
         gf_atomic_t attempted; /*Number of heals attempted on
                                 files/directories*/
@@ -628,6 +734,8 @@ struct _ec {
     xlator_t *xl;
     int32_t healers;
     int32_t heal_waiters;
+    int32_t heal_windows;     /* heal windows holding their lock */
+    int32_t heal_windows_max; /* most heal windows ever locked at once */
     int32_t nodes; /* Total number of bricks(n) */
     int32_t bits_for_nodes;
     int32_t fragments;      /* Data bricks(k) */
@@ -650,6 +758,7 @@ struct _ec {
     uintptr_t read_mask;         /*Stores user defined read-mask*/
     gf_atomic_t async_fop_count; /* Number of on going asynchronous fops. */
     xlator_t **xl_list;
+    ec_child_load_t *child_load;
     gf_lock_t lock;
     gf_timer_t *timer;
     gf_boolean_t shutdown;
@@ -657,11 +766,18 @@ struct _ec {
     gf_boolean_t other_eager_lock;
     gf_boolean_t optimistic_changelog;
     gf_boolean_t parallel_writes;
+    gf_boolean_t dirty_regions;
     uint32_t stripe_cache;
+    uint32_t write_coalesce_timeout; /* usecs, 0: disabled */
+    uint32_t compute_threads;        /* 0: encode/decode inline */
+    uint32_t read_hedge_delay;       /* usecs, 0: disabled */
     uint32_t quorum_count;
     uint32_t background_heals;
     uint32_t heal_wait_qlen;
     uint32_t self_heal_window_size; /* max size of read/writes */
+    uint32_t heal_pipeline_depth;   /* windows healed in parallel */
+    uint64_t heal_bandwidth;        /* bytes/sec for all heals, 0: no limit */
+    uint64_t heal_throttle_next;    /* usecs, protected by lock */
     time_t eager_lock_timeout;
     time_t other_eager_lock_timeout;
     struct list_head pending_fops;
@@ -675,6 +791,7 @@ struct _ec {
     dict_t *leaf_to_subvolid;
     ec_read_policy_t read_policy;
     ec_matrix_list_t matrix;
+    ec_compute_t compute;
     ec_statistics_t stats;
 };
 
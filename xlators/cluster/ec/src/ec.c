@@ -22,11 +22,14 @@
 #include "ec-method.h"
 #include "ec-code.h"
 #include "ec-heald.h"
+#include "ec-compute.h"
 #include <glusterfs/events.h>
 
 static char *ec_read_policies[EC_READ_POLICY_MAX + 1] = {
     [EC_ROUND_ROBIN] = "round-robin",
     [EC_GFID_HASH] = "gfid-hash",
+    [EC_MIN_DECODE] = "min-decode",
+    [EC_LEAST_LOAD] = "least-load",
     [EC_READ_POLICY_MAX] = NULL};
 
 #define EC_INTERNAL_XATTR_OR_GOTO(name, xattr, op_errno, label)                \
@@ -107,11 +110,21 @@ ec_prepare_childs(xlator_t *this)
 
         return ENOMEM;
     }
+    ec->child_load = GF_CALLOC(count, sizeof(ec->child_load[0]),
+                               ec_mt_ec_child_load_t);
+    if (ec->child_load == NULL) {
+        gf_msg(this->name, GF_LOG_ERROR, ENOMEM, EC_MSG_NO_MEMORY,
+               "Allocation of brick load information failed");
+
+        return ENOMEM;
+    }
     ec->xl_up = 0;
     ec->xl_up_count = 0;
 
     count = 0;
     for (child = this->children; child != NULL; child = child->next) {
+        GF_ATOMIC_INIT(ec->child_load[count].pending, 0);
+        ec->child_load[count].ping = -1;
         ec->xl_list[count++] = child->xlator;
     }
 
@@ -172,12 +185,16 @@ __ec_destroy_private(xlator_t *this)
          */
         sleep(2);
 
+        ec_compute_fini(ec);
+
         this->private = NULL;
         if (ec->xl_list != NULL) {
             GF_FREE(ec->xl_list);
             ec->xl_list = NULL;
         }
 
+        GF_FREE(ec->child_load);
+
         if (ec->fop_pool != NULL) {
             mem_pool_destroy(ec->fop_pool);
         }
@@ -248,6 +265,7 @@ reconfigure(xlator_t *this, dict_t *options)
     char *extensions = NULL;
     uint32_t heal_wait_qlen = 0;
     uint32_t background_heals = 0;
+    uint32_t compute_threads = 0;
     int32_t ret = -1;
     int32_t err;
 
@@ -270,6 +288,12 @@ reconfigure(xlator_t *this, dict_t *options)
                      failed);
     GF_OPTION_RECONF("self-heal-window-size", ec->self_heal_window_size,
                      options, uint32, failed);
+    GF_OPTION_RECONF("heal-pipeline-depth", ec->heal_pipeline_depth, options,
+                     uint32, failed);
+    GF_OPTION_RECONF("heal-bandwidth-limit", ec->heal_bandwidth, options,
+                     size_uint64, failed);
+    GF_OPTION_RECONF("heal-dirty-regions", ec->dirty_regions, options, bool,
+                     failed);
     GF_OPTION_RECONF("heal-timeout", ec->shd.timeout, options, time, failed);
     ec_configure_background_heal_opts(ec, background_heals, heal_wait_qlen);
     GF_OPTION_RECONF("shd-max-threads", ec->shd.max_threads, options, uint32,
@@ -284,6 +308,17 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("parallel-writes", ec->parallel_writes, options, bool,
                      failed);
     GF_OPTION_RECONF("stripe-cache", ec->stripe_cache, options, uint32, failed);
+    GF_OPTION_RECONF("write-coalesce-timeout", ec->write_coalesce_timeout,
+                     options, uint32, failed);
+    GF_OPTION_RECONF("read-hedge-delay", ec->read_hedge_delay, options, uint32,
+                     failed);
+    GF_OPTION_RECONF("compute-threads", compute_threads, options, uint32,
+                     failed);
+    if (compute_threads != ec->compute_threads) {
+        ec_compute_stop(ec);
+        ec->compute_threads = compute_threads;
+        ec_compute_start(ec, compute_threads);
+    }
     GF_OPTION_RECONF("quorum-count", ec->quorum_count, options, uint32, failed);
     ret = 0;
     if (ec_assign_read_policy(ec, read_policy)) {
@@ -567,6 +602,72 @@ ec_upcall(ec_t *ec, struct gf_upcall *upcall)
     }
 }
 
+/* Local discovery delays the shutdown of the xlator like any other fop. */
+static void
+ec_local_discovery_done(ec_t *ec)
+{
+    gf_boolean_t last_fop = _gf_false;
+
+    if (GF_ATOMIC_DEC(ec->async_fop_count) == 0) {
+        LOCK(&ec->lock);
+        {
+            last_fop = __ec_is_last_fop(ec);
+        }
+        UNLOCK(&ec->lock);
+    }
+    if (last_fop) {
+        ec_pending_fops_completed(ec);
+    }
+}
+
+static int32_t
+ec_local_discovery_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, dict_t *dict,
+                       dict_t *xdata)
+{
+    ec_t *ec = this->private;
+    int32_t idx = (int32_t)(uintptr_t)cookie;
+    gf_boolean_t is_local = _gf_false;
+    char *pathinfo = NULL;
+
+    if ((op_ret >= 0) &&
+        (dict_get_str_sizen(dict, GF_XATTR_PATHINFO_KEY, &pathinfo) == 0) &&
+        (glusterfs_is_local_pathinfo(pathinfo, &is_local) == 0)) {
+        ec->child_load[idx].local = is_local;
+        if (is_local) {
+            gf_msg_debug(this->name, 0, "%s is a local brick",
+                         ec->xl_list[idx]->name);
+        }
+    }
+
+    STACK_DESTROY(frame->root);
+
+    ec_local_discovery_done(ec);
+
+    return 0;
+}
+
+/* Finds if the brick is on this host, to prefer it for reads. */
+static void
+ec_local_discovery(ec_t *ec, int32_t idx)
+{
+    call_frame_t *frame = NULL;
+    loc_t loc = {
+        0,
+    };
+
+    frame = create_frame(ec->xl, ec->xl->ctx->pool);
+    if (frame == NULL) {
+        ec_local_discovery_done(ec);
+        return;
+    }
+
+    loc.gfid[sizeof(loc.gfid) - 1] = 1;
+    STACK_WIND_COOKIE(frame, ec_local_discovery_cbk, (void *)(uintptr_t)idx,
+                      ec->xl_list[idx], ec->xl_list[idx]->fops->getxattr,
+                      &loc, GF_XATTR_PATHINFO_KEY, NULL);
+}
+
 int32_t
 ec_notify(xlator_t *this, int32_t event, void *data, void *data2)
 {
@@ -580,6 +681,7 @@ ec_notify(xlator_t *this, int32_t event, void *data, void *data2)
     gf_boolean_t needs_shd_check = _gf_false;
     int32_t orig_event = event;
     uintptr_t mask = 0;
+    gf_boolean_t discover = _gf_false;
 
     gf_msg_trace(this->name, 0, "NOTIFY(%d): %p, %p", event, data, data2);
 
@@ -605,6 +707,15 @@ ec_notify(xlator_t *this, int32_t event, void *data, void *data2)
         }
     }
 
+    if (event == GF_EVENT_CHILD_PING) {
+        if (idx < ec->nodes) {
+            ec->child_load[idx].ping = (int64_t)(uintptr_t)data2;
+        }
+        /* It's only used to choose the bricks to read from. */
+        propagate = _gf_false;
+        goto done;
+    }
+
     LOCK(&ec->lock);
 
     if (event == GF_EVENT_PARENT_UP) {
@@ -633,6 +744,10 @@ ec_notify(xlator_t *this, int32_t event, void *data, void *data2)
                 !ec->shutdown) {
                 needs_shd_check = _gf_true;
             }
+            if (!ec->shutdown) {
+                discover = _gf_true;
+                GF_ATOMIC_INC(ec->async_fop_count);
+            }
         } else if (event == GF_EVENT_CHILD_DOWN) {
             ec_set_up_state(ec, mask, 0);
         }
@@ -673,6 +788,9 @@ unlock:
     UNLOCK(&ec->lock);
 
 done:
+    if (discover) {
+        ec_local_discovery(ec, idx);
+    }
     if (needs_shd_check) {
         ec_launch_replace_heal(ec);
     }
@@ -709,6 +827,16 @@ ec_statistics_init(ec_t *ec)
     GF_ATOMIC_INIT(ec->stats.stripe_cache.evicts, 0);
     GF_ATOMIC_INIT(ec->stats.stripe_cache.allocs, 0);
     GF_ATOMIC_INIT(ec->stats.stripe_cache.errors, 0);
+    GF_ATOMIC_INIT(ec->stats.write_coalesce.batches, 0);
+    GF_ATOMIC_INIT(ec->stats.write_coalesce.writes, 0);
+    GF_ATOMIC_INIT(ec->stats.hedge.sent, 0);
+    GF_ATOMIC_INIT(ec->stats.hedge.early, 0);
+    GF_ATOMIC_INIT(ec->stats.compute.jobs, 0);
+    GF_ATOMIC_INIT(ec->stats.compute.batches, 0);
+    GF_ATOMIC_INIT(ec->stats.regions.updates, 0);
+    GF_ATOMIC_INIT(ec->stats.regions.partial, 0);
+    GF_ATOMIC_INIT(ec->stats.regions.full, 0);
+    GF_ATOMIC_INIT(ec->stats.regions.zeros, 0);
     GF_ATOMIC_INIT(ec->stats.shd.attempted, 0);
     GF_ATOMIC_INIT(ec->stats.shd.completed, 0);
 }
@@ -801,6 +929,7 @@ init(xlator_t *this)
 
     ec->xl = this;
     LOCK_INIT(&ec->lock);
+    ec_compute_init(ec);
 
     GF_ATOMIC_INIT(ec->async_fop_count, 0);
     INIT_LIST_HEAD(&ec->pending_fops);
@@ -854,6 +983,11 @@ init(xlator_t *this)
     GF_OPTION_INIT("heal-wait-qlength", ec->heal_wait_qlen, uint32, failed);
     GF_OPTION_INIT("self-heal-window-size", ec->self_heal_window_size, uint32,
                    failed);
+    GF_OPTION_INIT("heal-pipeline-depth", ec->heal_pipeline_depth, uint32,
+                   failed);
+    GF_OPTION_INIT("heal-bandwidth-limit", ec->heal_bandwidth, size_uint64,
+                   failed);
+    GF_OPTION_INIT("heal-dirty-regions", ec->dirty_regions, bool, failed);
     ec_configure_background_heal_opts(ec, ec->background_heals,
                                       ec->heal_wait_qlen);
     GF_OPTION_INIT("read-policy", read_policy, str, failed);
@@ -867,6 +1001,10 @@ init(xlator_t *this)
                    failed);
     GF_OPTION_INIT("parallel-writes", ec->parallel_writes, bool, failed);
     GF_OPTION_INIT("stripe-cache", ec->stripe_cache, uint32, failed);
+    GF_OPTION_INIT("write-coalesce-timeout", ec->write_coalesce_timeout, uint32,
+                   failed);
+    GF_OPTION_INIT("compute-threads", ec->compute_threads, uint32, failed);
+    GF_OPTION_INIT("read-hedge-delay", ec->read_hedge_delay, uint32, failed);
     GF_OPTION_INIT("quorum-count", ec->quorum_count, uint32, failed);
     GF_OPTION_INIT("ec-read-mask", read_mask_str, str, failed);
 
@@ -899,6 +1037,7 @@ init(xlator_t *this)
     }
 
     ec_statistics_init(ec);
+    ec_compute_start(ec, ec->compute_threads);
 
     return 0;
 
@@ -988,6 +1127,7 @@ ec_gf_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t mode,
 int32_t
 ec_gf_flush(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 {
+    ec_writev_coalesce_flush(this, fd->inode);
     ec_flush(frame, this, -1, EC_MINIMUM_MIN, default_flush_cbk, NULL, fd,
              xdata);
 
@@ -998,6 +1138,7 @@ int32_t
 ec_gf_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t datasync,
             dict_t *xdata)
 {
+    ec_writev_coalesce_flush(this, fd->inode);
     ec_fsync(frame, this, -1, EC_MINIMUM_MIN, default_fsync_cbk, NULL, fd,
              datasync, xdata);
 
@@ -1161,8 +1302,14 @@ ec_gf_lk(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
 int32_t
 ec_gf_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
 {
+    dict_t *xdata_req = NULL;
+
+    /* The answers of the bricks are combined, they need full iatts */
+    xdata_req = dict_ref_iatt_mask_full(xdata);
     ec_lookup(frame, this, -1, EC_MINIMUM_MIN, default_lookup_cbk, NULL, loc,
-              xdata);
+              xdata_req);
+    if (xdata_req)
+        dict_unref(xdata_req);
 
     return 0;
 }
@@ -1358,8 +1505,13 @@ out:
 int32_t
 ec_gf_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
 {
+    dict_t *xdata_req = NULL;
+
+    xdata_req = dict_ref_iatt_mask_full(xdata);
     ec_stat(frame, this, -1, EC_MINIMUM_MIN, default_stat_cbk, NULL, loc,
-            xdata);
+            xdata_req);
+    if (xdata_req)
+        dict_unref(xdata_req);
 
     return 0;
 }
@@ -1367,8 +1519,13 @@ ec_gf_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
 int32_t
 ec_gf_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 {
+    dict_t *xdata_req = NULL;
+
+    xdata_req = dict_ref_iatt_mask_full(xdata);
     ec_fstat(frame, this, -1, EC_MINIMUM_MIN, default_fstat_cbk, NULL, fd,
-             xdata);
+             xdata_req);
+    if (xdata_req)
+        dict_unref(xdata_req);
 
     return 0;
 }
@@ -1427,6 +1584,14 @@ ec_gf_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
              struct iovec *vector, int32_t count, off_t offset, uint32_t flags,
              struct iobref *iobref, dict_t *xdata)
 {
+    ec_t *ec = this->private;
+
+    if ((ec->write_coalesce_timeout != 0) &&
+        ec_writev_coalesce(frame, this, fd, vector, count, offset, flags,
+                           iobref, xdata)) {
+        return 0;
+    }
+
     ec_writev(frame, this, -1, EC_MINIMUM_MIN, default_writev_cbk, NULL, fd,
               vector, count, offset, flags, iobref, xdata);
 
@@ -1462,6 +1627,18 @@ ec_gf_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     return 0;
 }
 
+int32_t
+ec_gf_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                      off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                      uint32_t flags, dict_t *xdata)
+{
+    /* Fragments are not aligned to the file offsets, so the copy cannot be
+     * done on the bricks. EXDEV makes the caller copy the data itself. */
+    default_copy_file_range_failure_cbk(frame, EXDEV);
+
+    return 0;
+}
+
 int32_t
 ec_gf_seek(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
            gf_seek_what_t what, dict_t *xdata)
@@ -1490,6 +1667,8 @@ ec_gf_forget(xlator_t *this, inode_t *inode)
         /* We can only forget an inode if it has been unlocked, so the stripe
          * cache should also be empty. */
         GF_ASSERT(list_empty(&ctx->stripe_cache.lru));
+        GF_ASSERT(ctx->wbatch == NULL);
+        GF_FREE(ctx->region_map);
         GF_FREE(ctx);
     }
 
@@ -1529,7 +1708,9 @@ ec_dump_private(xlator_t *this)
 {
     ec_t *ec = NULL;
     char key_prefix[GF_DUMP_MAX_BUF_LEN];
+    char key[32];
     char tmp[65];
+    int32_t i;
 
     GF_ASSERT(this);
 
@@ -1554,11 +1735,28 @@ ec_dump_private(xlator_t *this)
     gf_proc_dump_write("heal-wait-qlength", "%d", ec->heal_wait_qlen);
     gf_proc_dump_write("self-heal-window-size", "%" PRIu32,
                        ec->self_heal_window_size);
+    gf_proc_dump_write("heal-pipeline-depth", "%" PRIu32,
+                       ec->heal_pipeline_depth);
+    gf_proc_dump_write("heal-bandwidth-limit", "%" PRIu64,
+                       ec->heal_bandwidth);
     gf_proc_dump_write("healers", "%d", ec->healers);
     gf_proc_dump_write("heal-waiters", "%d", ec->heal_waiters);
+    gf_proc_dump_write("heal-windows", "%d", ec->heal_windows);
+    gf_proc_dump_write("heal-windows-max", "%d", ec->heal_windows_max);
     gf_proc_dump_write("read-policy", "%s", ec_read_policies[ec->read_policy]);
     gf_proc_dump_write("parallel-writes", "%d", ec->parallel_writes);
     gf_proc_dump_write("quorum-count", "%u", ec->quorum_count);
+    for (i = 0; i < ec->nodes; i++) {
+        snprintf(key, sizeof(key), "brick[%d].pending", i);
+        gf_proc_dump_write(key, "%" GF_PRI_ATOMIC,
+                           GF_ATOMIC_GET(ec->child_load[i].pending));
+        snprintf(key, sizeof(key), "brick[%d].latency", i);
+        gf_proc_dump_write(key, "%" PRIu64, ec->child_load[i].latency);
+        snprintf(key, sizeof(key), "brick[%d].ping", i);
+        gf_proc_dump_write(key, "%" PRId64, ec->child_load[i].ping);
+        snprintf(key, sizeof(key), "brick[%d].local", i);
+        gf_proc_dump_write(key, "%d", ec->child_load[i].local);
+    }
 
     snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.stripe_cache",
              this->type, this->name);
@@ -1583,6 +1781,64 @@ ec_dump_private(xlator_t *this)
     gf_proc_dump_write("heals-completed", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(ec->stats.shd.completed));
 
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.write_coalesce",
+             this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    gf_proc_dump_write("timeout", "%" PRIu32, ec->write_coalesce_timeout);
+    gf_proc_dump_write("batches", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.write_coalesce.batches));
+    gf_proc_dump_write("writes", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.write_coalesce.writes));
+
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.hedge",
+             this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    gf_proc_dump_write("delay", "%" PRIu32, ec->read_hedge_delay);
+    gf_proc_dump_write("sent", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.hedge.sent));
+    gf_proc_dump_write("early", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.hedge.early));
+
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.compute",
+             this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    gf_proc_dump_write("threads", "%" PRIu32, ec->compute_threads);
+    gf_proc_dump_write("jobs", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.compute.jobs));
+    gf_proc_dump_write("batches", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.compute.batches));
+
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.dirty_regions",
+             this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    gf_proc_dump_write("enabled", "%d", ec->dirty_regions);
+    gf_proc_dump_write("updates", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.regions.updates));
+    gf_proc_dump_write("partial-heals", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.regions.partial));
+    gf_proc_dump_write("full-heals", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.regions.full));
+    gf_proc_dump_write("zero-windows", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.regions.zeros));
+
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.matrix_cache",
+             this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    LOCK(&ec->matrix.lock);
+
+    gf_proc_dump_write("count", "%" PRIu32, ec->matrix.count);
+    gf_proc_dump_write("max", "%" PRIu32, ec->matrix.max);
+    gf_proc_dump_write("hits", "%" PRIu64, ec->matrix.hits);
+    gf_proc_dump_write("misses", "%" PRIu64, ec->matrix.misses);
+    gf_proc_dump_write("evictions", "%" PRIu64, ec->matrix.evictions);
+
+    UNLOCK(&ec->matrix.lock);
+
     return 0;
 }
 
@@ -1629,6 +1885,7 @@ struct xlator_fops fops = {.lookup = ec_gf_lookup,
                            .fallocate = ec_gf_fallocate,
                            .discard = ec_gf_discard,
                            .zerofill = ec_gf_zerofill,
+                           .copy_file_range = ec_gf_copy_file_range,
                            .seek = ec_gf_seek,
                            .ipc = ec_gf_ipc};
 
@@ -1749,7 +2006,7 @@ struct volume_options options[] = {
     {
         .key = {"read-policy"},
         .type = GF_OPTION_TYPE_STR,
-        .value = {"round-robin", "gfid-hash"},
+        .value = {"round-robin", "gfid-hash", "min-decode", "least-load"},
         .default_value = "gfid-hash",
         .op_version = {GD_OP_VERSION_3_7_6},
         .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
@@ -1758,7 +2015,11 @@ struct volume_options options[] = {
             "inode-read fops happen only on 'k' number of bricks in"
             " n=k+m disperse subvolume. 'round-robin' selects the read"
             " subvolume using round-robin algo. 'gfid-hash' selects read"
-            " subvolume based on hash of the gfid of that file/directory.",
+            " subvolume based on hash of the gfid of that file/directory."
+            " 'min-decode' selects the bricks whose fragments are the"
+            " cheapest to decode, at the cost of not spreading the reads."
+            " 'least-load' selects the bricks with the lowest average"
+            " latency times outstanding requests, preferring local bricks.",
     },
     {.key = {"shd-max-threads"},
      .type = GF_OPTION_TYPE_INT,
@@ -1784,7 +2045,7 @@ struct volume_options options[] = {
                     " that can wait in SHD per subvolume."},
     {.key = {"cpu-extensions"},
      .type = GF_OPTION_TYPE_STR,
-     .value = {"none", "auto", "x64", "sse", "avx"},
+     .value = {"none", "auto", "x64", "sse", "avx", "avx512"},
      .default_value = "auto",
      .op_version = {GD_OP_VERSION_3_9_0},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
@@ -1802,6 +2063,40 @@ struct volume_options options[] = {
      .tags = {"disperse"},
      .description = "Maximum number blocks(128KB) per file for which "
                     "self-heal process would be applied simultaneously."},
+    {.key = {"heal-pipeline-depth"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 16,
+     .default_value = "4",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC |
+              OPT_FLAG_RANGE,
+     .tags = {"disperse"},
+     .description = "Number of self-heal-window-size windows of a file "
+                    "that are rebuilt in parallel. Memory used by each "
+                    "heal grows with this value."},
+    {.key = {"heal-bandwidth-limit"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "Maximum number of bytes per second that all the heals "
+                    "of a disperse subvolume rebuild together. 0 means no "
+                    "limit."},
+    {.key = {"heal-dirty-regions"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "Record in the bricks the regions of a file that are "
+                    "modified while some brick is missing, so that heal "
+                    "only needs to rebuild those regions instead of the "
+                    "whole file. Files modified with this option off are "
+                    "fully healed once before it takes effect. Requires "
+                    "all the bricks to support or-array xattrops."},
     {.key = {"optimistic-change-log"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
@@ -1837,6 +2132,46 @@ struct volume_options options[] = {
                     "specially for sequential writes. However, this will also"
                     "lead to extra memory consumption, maximum "
                     "(cache size * stripe size) Bytes per open file."},
+    {.key = {"write-coalesce-timeout"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 1000000,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC |
+              OPT_FLAG_RANGE,
+     .tags = {"disperse"},
+     .description = "Time in microseconds that writes not aligned to a "
+                    "stripe are held waiting for adjacent writes, so that "
+                    "they are sent together and the head and tail stripes "
+                    "are read only once. Held writes are answered when the "
+                    "combined write completes. 0 disables it."},
+    {.key = {"read-hedge-delay"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 10000000,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC |
+              OPT_FLAG_RANGE,
+     .tags = {"disperse"},
+     .description = "Time in microseconds after which a read that has not "
+                    "been answered by all the bricks is also sent to "
+                    "another brick. The first bricks that answer are used "
+                    "and the rest is ignored. 0 disables it."},
+    {.key = {"compute-threads"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 64,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC |
+              OPT_FLAG_RANGE,
+     .tags = {"disperse"},
+     .description = "Number of threads used to encode written data and "
+                    "decode read data instead of doing it in the thread "
+                    "that processes the request. Pending jobs are encoded "
+                    "together by each thread. 0 disables them."},
     {
         .key = {"quorum-count"},
         .type = GF_OPTION_TYPE_INT,
@@ -11,6 +11,8 @@
 #ifndef __EC_H__
 #define __EC_H__
 
+#include <glusterfs/region-map.h>
+
 #include "ec-method.h"
 
 #define EC_XATTR_PREFIX "trusted.ec."
@@ -20,10 +22,20 @@
 #define EC_XATTR_HEAL EC_XATTR_PREFIX "heal"
 #define EC_XATTR_HEAL_NEW EC_XATTR_PREFIX "heal-new"
 #define EC_XATTR_DIRTY EC_XATTR_PREFIX "dirty"
+#define EC_XATTR_REGION_MAP EC_XATTR_PREFIX "region-map"
+#define EC_XATTR_REGION_VERSION EC_XATTR_PREFIX "region-version"
 #define EC_STRIPE_CACHE_MAX_SIZE 10
 #define EC_VERSION_SIZE 2
 #define EC_SHD_INODE_LRU_LIMIT 10
 
+/* Regions of a file modified while some brick was missing are recorded in a
+ * region map (see glusterfs/region-map.h). Each shift has its own map. */
+#define EC_REGION_MAP_BITS GF_REGION_MAP_BITS
+#define EC_REGION_MAP_SIZE GF_REGION_MAP_SIZE
+#define EC_REGION_MIN_SHIFT GF_REGION_MIN_SHIFT
+#define EC_REGION_MAX_SHIFT GF_REGION_MAX_SHIFT
+#define EC_REGION_SHIFTS GF_REGION_SHIFTS
+
 #define EC_MAX_FRAGMENTS EC_METHOD_MAX_FRAGMENTS
 /* The maximum number of nodes is derived from the maximum allowed fragments
  * using the rule that redundancy cannot be equal or greater than the number
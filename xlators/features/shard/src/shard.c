@@ -7269,6 +7269,17 @@ shard_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     return 0;
 }
 
+int32_t
+shard_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                      off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                      uint32_t flags, dict_t *xdata)
+{
+    /* Copying on the bricks would bypass the shard layout and the
+     * aggregated size of the destination. Let the caller copy the data. */
+    default_copy_file_range_failure_cbk(frame, EXDEV);
+    return 0;
+}
+
 int32_t
 shard_seek(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
            gf_seek_what_t what, dict_t *xdata)
@@ -7636,6 +7647,7 @@ struct xlator_fops fops = {
     .unlink = shard_unlink,
     .rename = shard_rename,
     .seek = shard_seek,
+    .copy_file_range = shard_copy_file_range,
 };
 
 struct xlator_cbks cbks = {
@@ -2032,6 +2032,9 @@ glusterd_op_add_brick(dict_t *dict, char **op_errstr)
         goto out;
     }
 
+    /* The layout changes, so an interrupted fix-layout can not resume */
+    volinfo->rebal.commit_hash = 0;
+
     if (GLUSTERD_STATUS_STARTED == volinfo->status)
         ret = glusterd_svcs_manager(volinfo);
 
@@ -4438,12 +4438,54 @@ out:
     return ret;
 }
 
+/* A fix-layout started again after it was stopped or had failures keeps
+ * its commit hash, so that it resumes from its checkpoint instead of
+ * crawling everything again. */
+static gf_boolean_t
+gd_fix_layout_resume_hash(dict_t *dict, uint32_t *hash)
+{
+    glusterd_volinfo_t *volinfo = NULL;
+    char *volname = NULL;
+    int32_t cmd = 0;
+
+    if (dict_get_int32(dict, "rebalance-command", &cmd) ||
+        (cmd != GF_DEFRAG_CMD_START_LAYOUT_FIX))
+        return _gf_false;
+
+    if (dict_get_str(dict, "volname", &volname) ||
+        glusterd_volinfo_find(volname, &volinfo))
+        return _gf_false;
+
+    if ((volinfo->rebal.op != GD_OP_REBALANCE) ||
+        (volinfo->rebal.defrag_cmd != GF_DEFRAG_CMD_START_LAYOUT_FIX) ||
+        !volinfo->rebal.commit_hash)
+        return _gf_false;
+
+    switch (volinfo->rebal.defrag_status) {
+        case GF_DEFRAG_STATUS_STOPPED:
+        case GF_DEFRAG_STATUS_FAILED:
+            break;
+        case GF_DEFRAG_STATUS_COMPLETE:
+            if (volinfo->rebal.rebalance_failures)
+                break;
+            /* FALLTHROUGH */
+        default:
+            return _gf_false;
+    }
+
+    *hash = volinfo->rebal.commit_hash;
+    return _gf_true;
+}
+
 int
 gd_set_commit_hash(dict_t *dict)
 {
     struct timeval tv;
     uint32_t hash;
 
+    if (gd_fix_layout_resume_hash(dict, &hash))
+        return dict_set_uint32(dict, "commit-hash", hash);
+
     /*
      * We need a commit hash that won't conflict with others we might have
      * set, or zero which is the implicit value if we never have.  Using
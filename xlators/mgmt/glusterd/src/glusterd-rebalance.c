@@ -292,6 +292,12 @@ glusterd_handle_defrag_start(glusterd_volinfo_t *volinfo, char *op_errstr,
     runner_add_arg(&runner, "--xlator-option");
     runner_argprintf(&runner, "*dht.commit-hash=%u",
                      volinfo->rebal.commit_hash);
+    if (cmd == GF_DEFRAG_CMD_START_LAYOUT_FIX) {
+        /* Lets an interrupted fix-layout skip what it has already done */
+        runner_add_arg(&runner, "--xlator-option");
+        runner_argprintf(&runner, "*dht.rebalance-checkpoint=%s/%s.checkpoint",
+                         defrag_path, uuid_utoa(MY_UUID));
+    }
     runner_add_arg(&runner, "--socket-file");
     runner_argprintf(&runner, "%s", sockfile);
     runner_add_arg(&runner, "--pid-file");
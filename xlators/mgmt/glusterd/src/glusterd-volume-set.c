@@ -270,6 +270,39 @@ out:
     return ret;
 }
 
+static int
+validate_disperse_read_policy(glusterd_volinfo_t *volinfo, dict_t *dict,
+                              char *key, char *value, char **op_errstr)
+{
+    char errstr[2048] = "";
+    glusterd_conf_t *conf = NULL;
+    xlator_t *this = THIS;
+    int ret = 0;
+
+    conf = this->private;
+
+    /* Peers older than 12.0 only know round-robin and gfid-hash */
+    if ((strcmp(value, "min-decode") != 0) &&
+        (strcmp(value, "least-load") != 0))
+        goto out;
+
+    if (conf->op_version < GD_OP_VERSION_12_0) {
+        snprintf(errstr, sizeof(errstr),
+                 "Cannot set %s to %s. The cluster is operating at "
+                 "version %d, it needs to be at least %d.",
+                 key, value, conf->op_version, GD_OP_VERSION_12_0);
+        gf_msg(this->name, GF_LOG_ERROR, 0, GD_MSG_INVALID_ENTRY, "%s",
+               errstr);
+        *op_errstr = gf_strdup(errstr);
+        ret = -1;
+    }
+
+out:
+    gf_msg_debug(this->name, 0, "Returning %d", ret);
+
+    return ret;
+}
+
 static int
 validate_replica(glusterd_volinfo_t *volinfo, dict_t *dict, char *key,
                  char *value, char **op_errstr)
@@ -820,6 +853,38 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/distribute",
      .op_version = 1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.readdirp-fanout",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.fix-layout-threads",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.du-refresh-interval",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.weighted-placement",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.entry-cache",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.entry-cache-timeout",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.rebal-window",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.rebal-rate-limit",
+     .voltype = "cluster/distribute",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.rsync-hash-regex",
      .voltype = "cluster/distribute",
      .type = NO_DOC,
@@ -922,6 +987,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/replicate",
      .op_version = 2,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.read-hedge-percentile",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.read-hedge-min-delay-usec",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.read-lease",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.background-self-heal-count",
      .voltype = "cluster/replicate",
      .op_version = 1,
@@ -974,6 +1051,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "data-self-heal-algorithm",
      .op_version = 1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.data-self-heal-xxhash",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.data-self-heal-pipeline-depth",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.entry-self-heal-batch-size",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.eager-lock",
      .voltype = "cluster/replicate",
      .op_version = 1,
@@ -1018,6 +1107,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .type = NO_DOC,
      .op_version = 2,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.write-batch-delay-usec",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.write-batch-size",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.ensure-durability",
      .voltype = "cluster/replicate",
      .op_version = 3,
@@ -2366,6 +2463,24 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .voltype = "storage/posix",
         .op_version = GD_OP_VERSION_4_0_0,
     },
+    {
+        .option = "janitor-purge-threads",
+        .key = "storage.janitor-purge-threads",
+        .voltype = "storage/posix",
+        .op_version = GD_OP_VERSION_12_0,
+    },
+    {
+        .option = "janitor-purge-rate",
+        .key = "storage.janitor-purge-rate",
+        .voltype = "storage/posix",
+        .op_version = GD_OP_VERSION_12_0,
+    },
+    {
+        .option = "janitor-purge-latency",
+        .key = "storage.janitor-purge-latency",
+        .voltype = "storage/posix",
+        .op_version = GD_OP_VERSION_12_0,
+    },
     {
         .option = "force-create-mode",
         .key = "storage.force-create-mode",
@@ -2681,7 +2796,8 @@ struct volopt_map_entry glusterd_volopt_map[] = {
     {.key = "disperse.read-policy",
      .voltype = "cluster/disperse",
      .op_version = GD_OP_VERSION_3_7_6,
-     .flags = VOLOPT_FLAG_CLIENT_OPT},
+     .flags = VOLOPT_FLAG_CLIENT_OPT,
+     .validate_fn = validate_disperse_read_policy},
     {.key = "cluster.shd-max-threads",
      .voltype = "cluster/replicate",
      .op_version = GD_OP_VERSION_3_7_12,
@@ -2691,6 +2807,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/replicate",
      .op_version = GD_OP_VERSION_3_7_12,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.shd-parallel-index-sweep",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.locking-scheme",
      .voltype = "cluster/replicate",
      .type = DOC,
@@ -2701,6 +2821,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .type = DOC,
      .op_version = GD_OP_VERSION_3_8_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.granular-data-heal",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {
         .option = "revocation-secs",
         .key = "features.locks-revocation-secs",
@@ -2755,6 +2879,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/disperse",
      .op_version = GD_OP_VERSION_3_11_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.heal-pipeline-depth",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.heal-bandwidth-limit",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.heal-dirty-regions",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.use-compound-fops",
      .voltype = "cluster/replicate",
      .value = "off",
@@ -2882,6 +3018,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .type = NO_DOC,
      .op_version = GD_OP_VERSION_4_0_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.write-coalesce-timeout",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.compute-threads",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.read-hedge-delay",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_12_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
 
     /* Halo replication options */
     {.key = "cluster.halo-enabled",
@@ -1125,12 +1125,24 @@ err:
     return ret;
 }
 
+/* The birth time is not cached, so requests for it can't be answered from
+ * the cache. */
+static gf_boolean_t
+mdc_wants_btime(dict_t *xdata)
+{
+    uint64_t mask = 0;
+
+    if (!xdata || dict_get_uint64(xdata, GF_REQUEST_IATT_MASK, &mask))
+        return _gf_false;
+
+    return !!(mask & IATT_BTIME);
+}
+
 static dict_t *
 mdc_prepare_request(xlator_t *this, mdc_local_t *local, dict_t *xdata)
 {
-    if (xdata != NULL) {
-        dict_ref(xdata);
-    }
+    /* Replies are cached for callers that need all the attributes */
+    xdata = dict_ref_iatt_mask_full(xdata);
 
     if (local == NULL) {
         return xdata;
@@ -1396,6 +1408,9 @@ mdc_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
         goto uncached;
     }
 
+    if (mdc_wants_btime(xdata))
+        goto uncached;
+
     ret = mdc_inode_iatt_get(this, loc->inode, &stbuf);
     if (ret != 0)
         goto uncached;
@@ -1463,6 +1478,9 @@ mdc_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 
     local->fd = __fd_ref(fd);
 
+    if (mdc_wants_btime(xdata))
+        goto uncached;
+
     ret = mdc_inode_iatt_get(this, fd->inode, &stbuf);
     if (ret != 0)
         goto uncached;
@@ -116,6 +116,14 @@ posix_priv(xlator_t *this)
     gf_proc_dump_write("max_read", "%" PRId64, GF_ATOMIC_GET(priv->read_value));
     gf_proc_dump_write("max_write", "%" PRId64,
                        GF_ATOMIC_GET(priv->write_value));
+    gf_proc_dump_write("landfill_purge_pending", "%" PRId64,
+                       GF_ATOMIC_GET(priv->purge_pending));
+    gf_proc_dump_write("landfill_purged_files", "%" PRId64,
+                       GF_ATOMIC_GET(priv->purge_files));
+    gf_proc_dump_write("landfill_purged_dirs", "%" PRId64,
+                       GF_ATOMIC_GET(priv->purge_dirs));
+    gf_proc_dump_write("landfill_purge_budget", "%" PRIu32,
+                       priv->purge_budget);
 
     return 0;
 }
@@ -178,6 +186,8 @@ posix_notify(xlator_t *this, int32_t event, void *data, ...)
             if (!victim->cleanup_starting)
                 break;
 
+            posix_health_check_timer_stop(this);
+
             if (priv->janitor) {
                 pthread_mutex_lock(&priv->janitor_mutex);
                 {
@@ -440,11 +450,9 @@ posix_reconfigure(xlator_t *this, dict_t *options)
                      options, time, out);
     GF_OPTION_RECONF("health-check-timeout", priv->health_check_timeout,
                      options, time, out);
-    if (priv->health_check_interval) {
-        ret = posix_spawn_health_check_thread(this);
-        if (ret)
-            goto out;
-    }
+    ret = posix_health_check_timer_start(this);
+    if (ret)
+        goto out;
 
     GF_OPTION_RECONF("shared-brick-count", priv->shared_brick_count, options,
                      int32, out);
@@ -462,6 +470,18 @@ posix_reconfigure(xlator_t *this, dict_t *options)
                      "directory, which is default behavior");
     }
 
+    GF_OPTION_RECONF("janitor-purge-threads", priv->purge_threads, options,
+                     uint32, out);
+    GF_OPTION_RECONF("janitor-purge-latency", priv->purge_latency, options,
+                     uint32, out);
+    GF_OPTION_RECONF("janitor-purge-rate", priv->purge_rate, options, uint32,
+                     out);
+    LOCK(&priv->purge_lock);
+    {
+        priv->purge_budget = priv->purge_rate;
+    }
+    UNLOCK(&priv->purge_lock);
+
     GF_OPTION_RECONF("force-create-mode", force_create_mode, options, int32,
                      out);
     priv->force_create_mode = force_create_mode;
@@ -979,6 +999,16 @@ posix_init(xlator_t *this)
 
     GF_OPTION_INIT("janitor-sleep-duration", _private->janitor_sleep_duration,
                    time, out);
+    GF_OPTION_INIT("janitor-purge-threads", _private->purge_threads, uint32,
+                   out);
+    GF_OPTION_INIT("janitor-purge-latency", _private->purge_latency, uint32,
+                   out);
+    GF_OPTION_INIT("janitor-purge-rate", _private->purge_rate, uint32, out);
+    LOCK_INIT(&_private->purge_lock);
+    _private->purge_budget = _private->purge_rate;
+    GF_ATOMIC_INIT(_private->purge_files, 0);
+    GF_ATOMIC_INIT(_private->purge_dirs, 0);
+    GF_ATOMIC_INIT(_private->purge_pending, 0);
 
     /* performing open dir on brick dir locks the brick dir
      * and prevents it from being unmounted
@@ -1111,12 +1141,14 @@ posix_init(xlator_t *this)
     }
 
     _private->health_check_active = _gf_false;
+    pthread_mutex_init(&_private->health_check_mutex, NULL);
+    pthread_cond_init(&_private->health_check_cond, NULL);
     GF_OPTION_INIT("health-check-interval", _private->health_check_interval,
                    time, out);
     GF_OPTION_INIT("health-check-timeout", _private->health_check_timeout, time,
                    out);
     if (_private->health_check_interval) {
-        ret = posix_spawn_health_check_thread(this);
+        ret = posix_health_check_timer_start(this);
         if (ret)
             goto out;
     }
@@ -1242,7 +1274,6 @@ void
 posix_fini(xlator_t *this)
 {
     struct posix_private *priv = this->private;
-    gf_boolean_t health_check = _gf_false;
     glusterfs_ctx_t *ctx = this->ctx;
     uint32_t count;
     int ret = 0;
@@ -1250,12 +1281,8 @@ posix_fini(xlator_t *this)
 
     if (!priv)
         return;
-    LOCK(&priv->lock);
-    {
-        health_check = priv->health_check_active;
-        priv->health_check_active = _gf_false;
-    }
-    UNLOCK(&priv->lock);
+
+    posix_health_check_timer_stop(this);
 
     if (priv->dirfd >= 0) {
         sys_close(priv->dirfd);
@@ -1269,10 +1296,8 @@ posix_fini(xlator_t *this)
         }
     }
 
-    if (health_check) {
-        (void)gf_thread_cleanup_xint(priv->health_check);
-        priv->health_check = 0;
-    }
+    GF_FREE(priv->health_check_timer);
+    priv->health_check_timer = NULL;
 
     if (priv->janitor) {
         /*TODO: Make sure the synctask is also complete */
@@ -1328,6 +1353,9 @@ posix_fini(xlator_t *this)
     pthread_cond_destroy(&priv->fsync_cond);
     pthread_mutex_destroy(&priv->janitor_mutex);
     pthread_cond_destroy(&priv->janitor_cond);
+    LOCK_DESTROY(&priv->purge_lock);
+    pthread_mutex_destroy(&priv->health_check_mutex);
+    pthread_cond_destroy(&priv->health_check_cond);
     GF_FREE(priv->trash_path);
     GF_FREE(priv);
     this->private = NULL;
@@ -1353,6 +1381,39 @@ struct volume_options posix_options[] = {
      .default_value = "10",
      .description = "Interval (in seconds) between times the internal "
                     "'landfill' directory is emptied."},
+    {.key = {"janitor-purge-threads"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 64,
+     .default_value = "4",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"posix"},
+     .validate = GF_OPT_VALIDATE_BOTH,
+     .description = "Number of entries of the 'landfill' directory that are "
+                    "removed in parallel."},
+    {.key = {"janitor-purge-rate"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"posix"},
+     .validate = GF_OPT_VALIDATE_MIN,
+     .description = "Maximum number of files and directories removed from "
+                    "the 'landfill' directory per second. 0 is unlimited."},
+    {.key = {"janitor-purge-latency"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .default_value = "20000",
+     .op_version = {GD_OP_VERSION_12_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"posix"},
+     .validate = GF_OPT_VALIDATE_MIN,
+     .description = "Average latency, in microseconds, of removals from the "
+                    "'landfill' directory above which the purge halves its "
+                    "rate to leave room for other I/O on the brick. "
+                    "0 disables the adaptation."},
     {.key = {"volume-id"},
      .type = GF_OPTION_TYPE_ANY,
      .default_value = "{{brick.volumeid}}"},
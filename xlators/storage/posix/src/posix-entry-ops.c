@@ -181,6 +181,7 @@ posix_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
         0,
     };
     gf_boolean_t cs_obj_status, cs_obj_repair;
+    uint64_t iatt_mask = POSIX_IATT_ALL;
 
     VALIDATE_OR_GOTO(frame, out);
     VALIDATE_OR_GOTO(this, out);
@@ -188,6 +189,7 @@ posix_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
     VALIDATE_OR_GOTO(this->private, out);
 
     priv = this->private;
+    iatt_mask = posix_iatt_mask_from_xdata(xdata);
 
     /* The Hidden directory should be for housekeeping purpose and it
        should not get any gfid on it */
@@ -220,7 +222,7 @@ posix_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
     if (gf_uuid_is_null(loc->pargfid) || (loc->name == NULL)) {
         /* nameless lookup */
         op_ret = op_errno = errno = 0;
-        MAKE_INODE_HANDLE(real_path, this, loc, &buf);
+        MAKE_INODE_HANDLE_MASK(real_path, this, loc, &buf, iatt_mask);
 
         /* The gfid will be renamed to ".glusterfs/unlink" in case
          * there are any open fds on the file in posix_unlink path.
@@ -250,7 +252,8 @@ posix_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
             }
         }
     } else {
-        MAKE_ENTRY_HANDLE(real_path, par_path, this, loc, &buf);
+        MAKE_ENTRY_HANDLE_MASK(real_path, par_path, this, loc, &buf,
+                               iatt_mask);
         if (!real_path || !par_path) {
             op_ret = -1;
             op_errno = ESTALE;
@@ -263,7 +266,8 @@ posix_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
                 op_ret = -1;
                 goto out;
             }
-            MAKE_ENTRY_HANDLE(real_path, par_path, this, loc, &buf);
+            MAKE_ENTRY_HANDLE_MASK(real_path, par_path, this, loc, &buf,
+                               iatt_mask);
         }
     }
 
@@ -152,7 +152,7 @@
         dfd = __priv->arrdfd[findex];                                          \
     } while (0)
 
-#define MAKE_ENTRY_HANDLE(entp, parp, this, loc, ent_p)                        \
+#define MAKE_ENTRY_HANDLE_MASK(entp, parp, this, loc, ent_p, mask)             \
     do {                                                                       \
         char *__parp;                                                          \
                                                                                \
@@ -172,13 +172,13 @@
             MAKE_REAL_PATH(entp, this, loc->path);                             \
             __parp = strdupa(entp);                                            \
             parp = dirname(__parp);                                            \
-            op_ret = posix_pstat(this, loc->inode, NULL, entp, ent_p,          \
-                                 _gf_false, _gf_true);                         \
+            op_ret = posix_pstat_mask(this, loc->inode, NULL, entp, ent_p,     \
+                                      _gf_false, _gf_true, mask);              \
             break;                                                             \
         }                                                                      \
         errno = 0;                                                             \
-        op_ret = posix_istat(this, loc->inode, loc->pargfid, loc->name, ent_p, \
-                             _gf_true);                                        \
+        op_ret = posix_istat_mask(this, loc->inode, loc->pargfid, loc->name,   \
+                                  ent_p, _gf_true, mask);                      \
         if (errno != ELOOP) {                                                  \
             MAKE_HANDLE_PATH(parp, this, loc->pargfid, NULL);                  \
             MAKE_HANDLE_PATH(entp, this, loc->pargfid, loc->name);             \
@@ -195,6 +195,9 @@
         /* expand ELOOP */                                                     \
     } while (0)
 
+#define MAKE_ENTRY_HANDLE(entp, parp, this, loc, ent_p)                        \
+    MAKE_ENTRY_HANDLE_MASK(entp, parp, this, loc, ent_p, POSIX_IATT_ALL)
+
 #define POSIX_GFID_HASH2_LEN 45
 int
 posix_handle_gfid_path(xlator_t *this, uuid_t gfid, char *buf, size_t len);
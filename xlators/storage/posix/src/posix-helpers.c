@@ -14,7 +14,6 @@
 #include <errno.h>
 #include <libgen.h>
 #include <pthread.h>
-#include <ftw.h>
 #include <sys/stat.h>
 #include <signal.h>
 #include <aio.h>
@@ -60,6 +59,7 @@ static char *posix_ignore_xattrs[] = {"gfid-req",
                                       GLUSTERFS_PARENT_ENTRYLK,
                                       GF_GFIDLESS_LOOKUP,
                                       GLUSTERFS_INODELK_DOM_COUNT,
+                                      GF_REQUEST_IATT_MASK,
                                       NULL};
 
 static char *list_xattr_ignore_xattrs[] = {GFID_XATTR_KEY, GF_XATTR_VOL_ID_KEY,
@@ -653,18 +653,157 @@ posix_fill_ino_from_gfid(struct iatt *buf)
     }
 }
 
+#ifdef HAVE_STATX
+static unsigned int
+posix_statx_mask(uint64_t ia_mask)
+{
+    /* type, inode number and link count are needed by the callers
+     * themselves, whatever the client asked for */
+    unsigned int mask = STATX_TYPE | STATX_MODE | STATX_INO | STATX_NLINK;
+
+    if (ia_mask & IATT_UID)
+        mask |= STATX_UID;
+    if (ia_mask & IATT_GID)
+        mask |= STATX_GID;
+    if (ia_mask & IATT_ATIME)
+        mask |= STATX_ATIME;
+    if (ia_mask & IATT_MTIME)
+        mask |= STATX_MTIME;
+    if (ia_mask & IATT_CTIME)
+        mask |= STATX_CTIME;
+    if (ia_mask & (IATT_SIZE | IATT_BLOCKS))
+        mask |= STATX_SIZE | STATX_BLOCKS;
+    if (ia_mask & IATT_BTIME)
+        mask |= STATX_BTIME;
+
+    return mask;
+}
+
+static uint64_t
+posix_iatt_flags_from_statx(unsigned int stx_mask)
+{
+    uint64_t flags = 0;
+
+    if (stx_mask & STATX_TYPE)
+        flags |= IATT_TYPE;
+    if (stx_mask & STATX_MODE)
+        flags |= IATT_MODE;
+    if (stx_mask & STATX_NLINK)
+        flags |= IATT_NLINK;
+    if (stx_mask & STATX_UID)
+        flags |= IATT_UID;
+    if (stx_mask & STATX_GID)
+        flags |= IATT_GID;
+    if (stx_mask & STATX_ATIME)
+        flags |= IATT_ATIME;
+    if (stx_mask & STATX_MTIME)
+        flags |= IATT_MTIME;
+    if (stx_mask & STATX_CTIME)
+        flags |= IATT_CTIME;
+    if (stx_mask & STATX_SIZE)
+        flags |= IATT_SIZE;
+    if (stx_mask & STATX_BLOCKS)
+        flags |= IATT_BLOCKS;
+    if (stx_mask & STATX_BTIME)
+        flags |= IATT_BTIME;
+
+    return flags;
+}
+
+static void
+posix_stat_from_statx(struct stat *stbuf, struct statx *stx)
+{
+    memset(stbuf, 0, sizeof(*stbuf));
+
+    stbuf->st_dev = makedev(stx->stx_dev_major, stx->stx_dev_minor);
+    stbuf->st_ino = stx->stx_ino;
+    stbuf->st_mode = stx->stx_mode;
+    stbuf->st_nlink = stx->stx_nlink;
+    stbuf->st_uid = stx->stx_uid;
+    stbuf->st_gid = stx->stx_gid;
+    stbuf->st_rdev = makedev(stx->stx_rdev_major, stx->stx_rdev_minor);
+    stbuf->st_size = stx->stx_size;
+    stbuf->st_blksize = stx->stx_blksize;
+    stbuf->st_blocks = stx->stx_blocks;
+    stbuf->st_atim.tv_sec = stx->stx_atime.tv_sec;
+    stbuf->st_atim.tv_nsec = stx->stx_atime.tv_nsec;
+    stbuf->st_mtim.tv_sec = stx->stx_mtime.tv_sec;
+    stbuf->st_mtim.tv_nsec = stx->stx_mtime.tv_nsec;
+    stbuf->st_ctim.tv_sec = stx->stx_ctime.tv_sec;
+    stbuf->st_ctim.tv_nsec = stx->stx_ctime.tv_nsec;
+}
+#endif /* HAVE_STATX */
+
+/* lstat() of @path, or fstat() of @fd if @path is NULL. When statx() is
+ * available only the attributes in @ia_mask are requested from the
+ * filesystem, the birth time is filled into @iatt and the IATT_* flags of
+ * the attributes that were actually returned are set in @valid. */
+static int
+posix_stat_backend(const char *path, int fd, uint64_t ia_mask,
+                   struct stat *stbuf, struct iatt *iatt, uint64_t *valid)
+{
+#ifdef HAVE_STATX
+    static gf_boolean_t statx_unsupported = _gf_false;
+    struct statx stx;
+    int ret = -1;
+
+    if (!statx_unsupported) {
+        if (path)
+            ret = statx(AT_FDCWD, path, AT_SYMLINK_NOFOLLOW,
+                        posix_statx_mask(ia_mask), &stx);
+        else
+            ret = statx(fd, "", AT_EMPTY_PATH, posix_statx_mask(ia_mask),
+                        &stx);
+        if (ret == 0) {
+            posix_stat_from_statx(stbuf, &stx);
+            if (!(ia_mask & IATT_BTIME))
+                stx.stx_mask &= ~STATX_BTIME;
+            *valid = posix_iatt_flags_from_statx(stx.stx_mask);
+            if (stx.stx_mask & STATX_BTIME) {
+                iatt->ia_btime = stx.stx_btime.tv_sec;
+                iatt->ia_btime_nsec = stx.stx_btime.tv_nsec;
+            }
+            iatt->ia_attributes = stx.stx_attributes;
+            iatt->ia_attributes_mask = stx.stx_attributes_mask;
+            return 0;
+        }
+        if (errno != ENOSYS)
+            return ret;
+        /* kernel older than the C library */
+        statx_unsupported = _gf_true;
+    }
+#endif
+    *valid = ~(uint64_t)IATT_BTIME;
+    if (path)
+        return sys_lstat(path, stbuf);
+    return sys_fstat(fd, stbuf);
+}
+
+/* Keeps only the flags of attributes the backend returned, after
+ * iatt_from_stat() marked all of them valid. */
+static void
+posix_iatt_apply_valid(struct iatt *iatt, uint64_t valid)
+{
+    iatt->ia_flags |= (valid & IATT_BTIME);
+    iatt->ia_flags &= (valid | IATT_GFID | IATT_INO);
+}
+
+#define POSIX_IATT_TIMES (IATT_ATIME | IATT_MTIME | IATT_CTIME)
+
 int
-posix_fdstat(xlator_t *this, inode_t *inode, int fd, struct iatt *stbuf_p,
-             gf_boolean_t fetch_time)
+posix_fdstat_mask(xlator_t *this, inode_t *inode, int fd,
+                  struct iatt *stbuf_p, gf_boolean_t fetch_time,
+                  uint64_t mask)
 {
     int ret = 0;
     struct stat fstatbuf;
     struct posix_private *priv = NULL;
+    uint64_t valid = 0;
 
     if (stbuf_p == NULL)
         goto out;
 
-    ret = sys_fstat(fd, &fstatbuf);
+    ret = posix_stat_backend(NULL, fd, mask, &fstatbuf, stbuf_p, &valid);
     if (ret != 0)
         goto out;
 
@@ -672,9 +811,10 @@ posix_fdstat(xlator_t *this, inode_t *inode, int fd, struct iatt *stbuf_p,
         fstatbuf.st_nlink--;
 
     iatt_from_stat(stbuf_p, &fstatbuf);
+    posix_iatt_apply_valid(stbuf_p, valid);
 
     priv = this->private;
-    if (inode && fetch_time && priv->ctime) {
+    if (inode && fetch_time && priv->ctime && (mask & POSIX_IATT_TIMES)) {
         ret = posix_get_mdata_xattr(this, NULL, fd, inode, stbuf_p);
         if (ret) {
             gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_GETMDATA_FAILED,
@@ -692,13 +832,22 @@ out:
     return ret;
 }
 
+int
+posix_fdstat(xlator_t *this, inode_t *inode, int fd, struct iatt *stbuf_p,
+             gf_boolean_t fetch_time)
+{
+    return posix_fdstat_mask(this, inode, fd, stbuf_p, fetch_time,
+                             POSIX_IATT_ALL);
+}
+
 /* The inode here is expected to update posix_mdata stored on disk.
  * Don't use it as a general purpose inode and don't expect it to
  * be always exists
  */
 int
-posix_istat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *basename,
-            struct iatt *buf_p, gf_boolean_t fetch_time)
+posix_istat_mask(xlator_t *this, inode_t *inode, uuid_t gfid,
+                 const char *basename, struct iatt *buf_p,
+                 gf_boolean_t fetch_time, uint64_t mask)
 {
     char *real_path = NULL;
     struct stat lstatbuf = {
@@ -709,6 +858,7 @@ posix_istat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *basename,
     };
     int ret = 0;
     struct posix_private *priv = NULL;
+    uint64_t valid = 0;
 
     priv = this->private;
 
@@ -722,7 +872,7 @@ posix_istat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *basename,
         goto out;
     }
 
-    ret = sys_lstat(real_path, &lstatbuf);
+    ret = posix_stat_backend(real_path, -1, mask, &lstatbuf, &stbuf, &valid);
 
     if (ret != 0) {
         if (ret == -1) {
@@ -752,8 +902,9 @@ posix_istat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *basename,
         lstatbuf.st_nlink--;
 
     iatt_from_stat(&stbuf, &lstatbuf);
+    posix_iatt_apply_valid(&stbuf, valid);
 
-    if (inode && fetch_time && priv->ctime) {
+    if (inode && fetch_time && priv->ctime && (mask & POSIX_IATT_TIMES)) {
         ret = posix_get_mdata_xattr(this, real_path, -1, inode, &stbuf);
         if (ret) {
             gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_GETMDATA_FAILED,
@@ -777,9 +928,18 @@ out:
 }
 
 int
-posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *path,
-            struct iatt *buf_p, gf_boolean_t inode_locked,
-            gf_boolean_t fetch_time)
+posix_istat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *basename,
+            struct iatt *buf_p, gf_boolean_t fetch_time)
+{
+    return posix_istat_mask(this, inode, gfid, basename, buf_p, fetch_time,
+                            POSIX_IATT_ALL);
+}
+
+int
+posix_pstat_mask(xlator_t *this, inode_t *inode, uuid_t gfid,
+                 const char *path, struct iatt *buf_p,
+                 gf_boolean_t inode_locked, gf_boolean_t fetch_time,
+                 uint64_t mask)
 {
     struct stat lstatbuf;
     struct iatt stbuf = {
@@ -788,10 +948,11 @@ posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *path,
     int ret = 0;
     int op_errno = 0;
     struct posix_private *priv = NULL;
+    uint64_t valid = 0;
 
     priv = this->private;
 
-    ret = sys_lstat(path, &lstatbuf);
+    ret = posix_stat_backend(path, -1, mask, &lstatbuf, &stbuf, &valid);
     if (ret != 0) {
         if (errno != ENOENT) {
             op_errno = errno;
@@ -822,8 +983,9 @@ posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *path,
     stbuf.ia_flags |= IATT_GFID;
 
     iatt_from_stat(&stbuf, &lstatbuf);
+    posix_iatt_apply_valid(&stbuf, valid);
 
-    if (fetch_time && priv->ctime) {
+    if (fetch_time && priv->ctime && (mask & POSIX_IATT_TIMES)) {
         if (inode) {
             if (!inode_locked) {
                 ret = posix_get_mdata_xattr(this, path, -1, inode, &stbuf);
@@ -854,6 +1016,28 @@ out:
     return ret;
 }
 
+int
+posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *path,
+            struct iatt *buf_p, gf_boolean_t inode_locked,
+            gf_boolean_t fetch_time)
+{
+    return posix_pstat_mask(this, inode, gfid, path, buf_p, inode_locked,
+                            fetch_time, POSIX_IATT_ALL);
+}
+
+/* IATT_* mask requested with GF_REQUEST_IATT_MASK in @xdata, all
+ * attributes if there is none. */
+uint64_t
+posix_iatt_mask_from_xdata(dict_t *xdata)
+{
+    uint64_t mask = 0;
+
+    if (!xdata || dict_get_uint64(xdata, GF_REQUEST_IATT_MASK, &mask))
+        return POSIX_IATT_ALL;
+
+    return mask | IATT_TYPE | IATT_GFID;
+}
+
 static void
 _get_list_xattr(posix_xattr_filler_t *filler)
 {
@@ -1389,44 +1573,497 @@ out:
     return;
 }
 
+/* Landfill purge.
+ *
+ * The janitor lists the top level entries of the landfill and hands them
+ * to a pool of synctasks. Each worker removes a tree depth first with
+ * unlinkat() relative to the fd of the parent directory. All workers draw
+ * from a shared budget of removals per second. The budget is halved when
+ * the average removal latency of the last second exceeds
+ * janitor-purge-latency, i.e. when the disk is busy with foreground I/O,
+ * and grows back by a tenth every second otherwise.
+ */
+#define POSIX_PURGE_MIN_RATE 10
+#define POSIX_PURGE_MAX_OPEN 16
+
+struct posix_purge_entry {
+    struct list_head list;
+    char name[];
+};
+
+struct posix_purge {
+    xlator_t *this;
+    gf_lock_t lock;
+    struct list_head entries;
+    int dirfd;
+    syncbarrier_t barrier;
+};
+
+/* Starts a new accounting window. Must be called with purge_lock held. */
+static void
+__posix_purge_adapt(struct posix_private *priv, time_t now)
+{
+    uint32_t ops = priv->purge_window_ops;
+    uint64_t avg = 0;
+
+    if (ops) {
+        avg = priv->purge_window_usec / ops;
+        if (priv->purge_latency && avg > priv->purge_latency) {
+            priv->purge_budget = max(ops / 2, POSIX_PURGE_MIN_RATE);
+        } else if (priv->purge_budget) {
+            priv->purge_budget += max(priv->purge_budget / 10, 1);
+            if (priv->purge_rate) {
+                priv->purge_budget = min(priv->purge_budget, priv->purge_rate);
+            } else if (priv->purge_budget > 2 * ops) {
+                /* the budget no longer limits anything */
+                priv->purge_budget = 0;
+            }
+        }
+    }
+
+    priv->purge_window = now;
+    priv->purge_window_ops = 0;
+    priv->purge_window_usec = 0;
+}
+
+/* Waits for the budget to allow one more operation. Returns -1 if the
+ * janitor is being stopped meanwhile. */
 static int
-janitor_walker(const char *fpath, const struct stat *sb, int typeflag,
-               struct FTW *ftwbuf)
+posix_purge_throttle(struct posix_private *priv)
 {
-    struct iatt stbuf = {
+    gf_boolean_t granted = _gf_false;
+    time_t now = 0;
+
+    for (;;) {
+        now = gf_time();
+        LOCK(&priv->purge_lock);
+        {
+            if (now != priv->purge_window)
+                __posix_purge_adapt(priv, now);
+
+            if (!priv->purge_budget ||
+                priv->purge_window_ops < priv->purge_budget) {
+                priv->purge_window_ops++;
+                granted = _gf_true;
+            }
+        }
+        UNLOCK(&priv->purge_lock);
+
+        if (granted)
+            return 0;
+
+        if (priv->janitor_task_stop)
+            return -1;
+
+        synctask_usleep(100000);
+    }
+}
+
+static void
+posix_purge_account(struct posix_private *priv, struct timespec *start)
+{
+    struct timespec end;
+
+    timespec_now(&end);
+    LOCK(&priv->purge_lock);
+    {
+        priv->purge_window_usec += gf_tsdiff(start, &end) / 1000;
+    }
+    UNLOCK(&priv->purge_lock);
+}
+
+/* A directory of the tree being removed. Only the POSIX_PURGE_MAX_OPEN
+ * deepest ones are kept open; the others are opened again by path when the
+ * walk comes back to them, and the entries that could not be removed are
+ * skipped, the removed ones being gone. */
+struct posix_purge_dir {
+    DIR *dir;
+    size_t pathlen;
+    int failed; /* entries that could not be removed */
+    int rescan; /* entries to skip after opening it again */
+    uuid_t gfid;
+};
+
+static int
+posix_purge_unlink(xlator_t *this, int dirfd, const char *name,
+                   const char *path, struct stat *stbuf)
+{
+    struct posix_private *priv = this->private;
+    struct timespec start;
+    uuid_t gfid = {
         0,
     };
-    xlator_t *this = NULL;
+    int ret = -1;
 
-    this = THIS;
-    /* posix_mdata_t is not filled, no time or size attributes
-     * are being used, so fine.
-     */
-    posix_pstat(this, NULL, NULL, fpath, &stbuf, _gf_false, _gf_false);
-    switch (sb->st_mode & S_IFMT) {
-        case S_IFREG:
-        case S_IFBLK:
-        case S_IFLNK:
-        case S_IFCHR:
-        case S_IFIFO:
-        case S_IFSOCK:
-            gf_msg_trace(THIS->name, 0, "unlinking %s", fpath);
-            sys_unlink(fpath);
-            if (stbuf.ia_nlink == 1)
-                posix_handle_unset_gfid(this, stbuf.ia_gfid);
-            break;
+    (void)sys_lgetxattr(path, GFID_XATTR_KEY, gfid, sizeof(gfid));
+
+    gf_msg_trace(this->name, 0, "unlinking %s", path);
+    if (posix_purge_throttle(priv))
+        return -1;
+    timespec_now(&start);
+    ret = sys_unlinkat(dirfd, name);
+    posix_purge_account(priv, &start);
+    if (ret == 0) {
+        GF_ATOMIC_INC(priv->purge_files);
+        if (stbuf->st_nlink == 1 && !gf_uuid_is_null(gfid))
+            posix_handle_unset_gfid(this, gfid);
+    }
+
+    return ret;
+}
+
+static int
+posix_purge_rmdir(xlator_t *this, int dirfd, const char *name,
+                  const char *path, uuid_t gfid)
+{
+    struct posix_private *priv = this->private;
+    struct timespec start;
+    int ret = -1;
+
+    gf_msg_debug(this->name, 0, "removing directory %s", path);
+    if (posix_purge_throttle(priv))
+        return -1;
+    timespec_now(&start);
+    ret = sys_rmdirat(dirfd, name);
+    posix_purge_account(priv, &start);
+    if (ret == 0) {
+        GF_ATOMIC_INC(priv->purge_dirs);
+        if (!gf_uuid_is_null(gfid))
+            del_stale_dir_handle(this, gfid);
+    }
 
-        case S_IFDIR:
-            if (ftwbuf->level) { /* don't remove top level dir */
-                gf_msg_debug(THIS->name, 0, "removing directory %s", fpath);
+    return ret;
+}
+
+/* Pushes the directory open on @fd, whose path is the first @pathlen bytes
+ * of @path. @fd is closed on failure. */
+static int
+posix_purge_push(struct posix_purge_dir **stack, int *size, int *depth,
+                 int fd, const char *path, size_t pathlen)
+{
+    struct posix_purge_dir *tmp = NULL;
+    struct posix_purge_dir *top = NULL;
 
-                sys_rmdir(fpath);
-                del_stale_dir_handle(this, stbuf.ia_gfid);
+    if (*depth == *size) {
+        if (*stack)
+            tmp = GF_REALLOC(*stack, (*size + 16) * sizeof(*tmp));
+        else
+            tmp = GF_CALLOC(16, sizeof(*tmp), gf_posix_mt_purge_dir_t);
+        if (!tmp) {
+            sys_close(fd);
+            return -1;
+        }
+        *stack = tmp;
+        *size += 16;
+    }
+
+    top = &(*stack)[*depth];
+    memset(top, 0, sizeof(*top));
+    top->dir = sys_fdopendir(fd);
+    if (!top->dir) {
+        sys_close(fd);
+        return -1;
+    }
+    top->pathlen = pathlen;
+    (void)sys_lgetxattr(path, GFID_XATTR_KEY, top->gfid, sizeof(top->gfid));
+    (*depth)++;
+
+    return 0;
+}
+
+static int
+posix_purge_reopen(struct posix_purge_dir *pdir, const char *path)
+{
+    int fd = -1;
+
+    fd = sys_open(path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW, 0);
+    if (fd < 0)
+        return -1;
+
+    pdir->dir = sys_fdopendir(fd);
+    if (!pdir->dir) {
+        sys_close(fd);
+        return -1;
+    }
+    pdir->rescan = pdir->failed;
+
+    return 0;
+}
+
+/* Removes @name, relative to @parent_fd, and everything below it, depth first
+ * without recursing. @path holds the absolute path of @parent_fd in its first
+ * @pathlen bytes. */
+static void
+posix_purge_tree(xlator_t *this, int parent_fd, const char *name, char *path,
+                 size_t pathlen)
+{
+    struct posix_private *priv = this->private;
+    struct posix_purge_dir *stack = NULL;
+    struct posix_purge_dir *top = NULL;
+    struct posix_purge_dir *parent = NULL;
+    struct stat stbuf = {
+        0,
+    };
+    struct dirent scratch[2] = {
+        {
+            0,
+        },
+    };
+    struct dirent *entry = NULL;
+    int size = 0;
+    int depth = 0;
+    int fd = -1;
+    int len = 0;
+    int i = 0;
+
+    if (priv->janitor_task_stop)
+        return;
+
+    len = snprintf(path + pathlen, PATH_MAX - pathlen, "/%s", name);
+    if ((len < 0) || (len >= PATH_MAX - pathlen))
+        goto out;
+
+    if (sys_fstatat(parent_fd, name, &stbuf, AT_SYMLINK_NOFOLLOW) != 0)
+        goto out;
+
+    if (!S_ISDIR(stbuf.st_mode)) {
+        posix_purge_unlink(this, parent_fd, name, path, &stbuf);
+        goto out;
+    }
+
+    fd = sys_openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW, 0);
+    if (fd < 0)
+        goto out;
+
+    if (posix_purge_push(&stack, &size, &depth, fd, path, pathlen + len))
+        goto out;
+
+    while ((depth > 0) && !priv->janitor_task_stop) {
+        top = &stack[depth - 1];
+        path[top->pathlen] = '\0';
+
+        entry = NULL;
+        if (top->dir || (posix_purge_reopen(top, path) == 0))
+            entry = sys_readdir(top->dir, scratch);
+
+        if (!entry) {
+            /* Whatever is left below could not be removed */
+            if (top->dir)
+                sys_closedir(top->dir);
+            top->dir = NULL;
+            depth--;
+            if (!depth) {
+                posix_purge_rmdir(this, parent_fd, name, path, top->gfid);
+                continue;
+            }
+
+            /* Removed relative to its parent, which may have been closed */
+            parent = &stack[depth - 1];
+            if (!parent->dir) {
+                path[parent->pathlen] = '\0';
+                (void)posix_purge_reopen(parent, path);
+                path[parent->pathlen] = '/';
+            }
+            if (!parent->dir ||
+                posix_purge_rmdir(this, dirfd(parent->dir),
+                                  path + parent->pathlen + 1, path,
+                                  top->gfid))
+                parent->failed++;
+            continue;
+        }
+
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+            continue;
+
+        if (top->rescan) {
+            top->rescan--;
+            continue;
+        }
+
+        len = snprintf(path + top->pathlen, PATH_MAX - top->pathlen, "/%s",
+                       entry->d_name);
+        if ((len < 0) || (len >= PATH_MAX - top->pathlen)) {
+            top->failed++;
+            continue;
+        }
+
+        if (sys_fstatat(dirfd(top->dir), entry->d_name, &stbuf,
+                        AT_SYMLINK_NOFOLLOW) != 0) {
+            if (errno != ENOENT)
+                top->failed++;
+            continue;
+        }
+
+        if (!S_ISDIR(stbuf.st_mode)) {
+            if (posix_purge_unlink(this, dirfd(top->dir), entry->d_name, path,
+                                   &stbuf))
+                top->failed++;
+            continue;
+        }
+
+        fd = sys_openat(dirfd(top->dir), entry->d_name,
+                        O_RDONLY | O_DIRECTORY | O_NOFOLLOW, 0);
+        if ((fd < 0) || posix_purge_push(&stack, &size, &depth, fd, path,
+                                         top->pathlen + len)) {
+            /* the stack may have moved */
+            stack[depth - 1].failed++;
+            continue;
+        }
+
+        if (depth > POSIX_PURGE_MAX_OPEN) {
+            top = &stack[depth - 1 - POSIX_PURGE_MAX_OPEN];
+            if (top->dir) {
+                sys_closedir(top->dir);
+                top->dir = NULL;
             }
+        }
+    }
+
+    for (i = 0; i < depth; i++) {
+        if (stack[i].dir)
+            sys_closedir(stack[i].dir);
+    }
+    GF_FREE(stack);
+
+out:
+    path[pathlen] = '\0';
+}
+
+static int
+posix_purge_worker(void *data)
+{
+    struct posix_purge *purge = data;
+    struct posix_purge_entry *entry = NULL;
+    struct posix_private *priv = purge->this->private;
+    xlator_t *old_this = NULL;
+    char *path = NULL;
+    size_t pathlen = 0;
+
+    old_this = THIS;
+    THIS = purge->this;
+
+    path = GF_MALLOC(PATH_MAX, gf_posix_mt_char);
+    if (!path)
+        goto out;
+    pathlen = snprintf(path, PATH_MAX, "%s", priv->trash_path);
+
+    for (;;) {
+        entry = NULL;
+        LOCK(&purge->lock);
+        {
+            if (!list_empty(&purge->entries)) {
+                entry = list_first_entry(&purge->entries,
+                                         struct posix_purge_entry, list);
+                list_del_init(&entry->list);
+            }
+        }
+        UNLOCK(&purge->lock);
+
+        if (!entry)
             break;
+
+        posix_purge_tree(purge->this, purge->dirfd, entry->name, path,
+                         pathlen);
+        GF_ATOMIC_DEC(priv->purge_pending);
+        GF_FREE(entry);
     }
 
-    return 0; /* 0 = FTW_CONTINUE */
+out:
+    GF_FREE(path);
+    THIS = old_this;
+    return 0;
+}
+
+static int
+posix_purge_worker_done(int ret, call_frame_t *frame, void *data)
+{
+    struct posix_purge *purge = data;
+
+    syncbarrier_wake(&purge->barrier);
+    return 0;
+}
+
+static void
+posix_landfill_purge(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    struct posix_purge purge = {
+        0,
+    };
+    struct posix_purge_entry *entry = NULL;
+    struct posix_purge_entry *tmp = NULL;
+    struct dirent scratch[2] = {
+        {
+            0,
+        },
+    };
+    struct dirent *dirent = NULL;
+    DIR *dir = NULL;
+    size_t len = 0;
+    int count = 0;
+    int workers = 0;
+    int i = 0;
+
+    purge.this = this;
+    purge.dirfd = -1;
+    INIT_LIST_HEAD(&purge.entries);
+    LOCK_INIT(&purge.lock);
+
+    dir = sys_opendir(priv->trash_path);
+    if (!dir) {
+        gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_OPENDIR_FAILED,
+               "opendir of %s failed", priv->trash_path);
+        goto out;
+    }
+    purge.dirfd = dirfd(dir);
+
+    while ((dirent = sys_readdir(dir, scratch)) != NULL) {
+        if (!strcmp(dirent->d_name, ".") || !strcmp(dirent->d_name, ".."))
+            continue;
+        len = strlen(dirent->d_name) + 1;
+        entry = GF_MALLOC(sizeof(*entry) + len, gf_posix_mt_char);
+        if (!entry)
+            break;
+        memcpy(entry->name, dirent->d_name, len);
+        list_add_tail(&entry->list, &purge.entries);
+        count++;
+    }
+
+    if (!count)
+        goto out;
+
+    GF_ATOMIC_ADD(priv->purge_pending, count);
+    gf_msg_trace(this->name, 0, "janitor cleaning out %d entries of %s",
+                 count, priv->trash_path);
+
+    if (syncbarrier_init(&purge.barrier))
+        goto out;
+
+    workers = min(count, (int)priv->purge_threads);
+    for (i = 0; i < workers; i++) {
+        if (synctask_new(this->ctx->env, posix_purge_worker,
+                         posix_purge_worker_done, NULL, &purge) < 0)
+            break;
+    }
+
+    if (i == 0) {
+        /* no worker could be spawned, do the job from this task */
+        posix_purge_worker(&purge);
+    } else {
+        syncbarrier_wait(&purge.barrier, i);
+    }
+    syncbarrier_destroy(&purge.barrier);
+
+out:
+    list_for_each_entry_safe(entry, tmp, &purge.entries, list)
+    {
+        list_del_init(&entry->list);
+        GF_ATOMIC_DEC(priv->purge_pending);
+        GF_FREE(entry);
+    }
+    if (dir)
+        sys_closedir(dir);
+    LOCK_DESTROY(&purge.lock);
 }
 
 static void
@@ -1473,7 +2110,7 @@ posix_janitor_task(void *data)
 
     this = data;
     priv = this->private;
-    /* We need THIS to be set for janitor_walker */
+    /* We need THIS to be set for the purge workers */
     old_this = THIS;
     THIS = this;
 
@@ -1489,10 +2126,7 @@ posix_janitor_task(void *data)
                          "is disabled.",
                          priv->trash_path);
         } else {
-            gf_msg_trace(this->name, 0, "janitor cleaning out %s",
-                         priv->trash_path);
-
-            nftw(priv->trash_path, janitor_walker, 32, FTW_DEPTH | FTW_PHYS);
+            posix_landfill_purge(this);
         }
         priv->last_landfill_check = now;
     }
@@ -1953,13 +2587,17 @@ posix_fs_health_check(xlator_t *this, char *file_path)
     char buff[256] = {0};
     char *op = NULL;
     int op_errno = 0;
-    int cnt;
     time_t timeout = 0;
     struct aiocb aiocb;
+    const struct aiocb *aiolist[1] = {&aiocb};
+    struct timespec aiotimeout = {
+        0,
+    };
 
     priv = this->private;
 
     timeout = priv->health_check_timeout;
+    aiotimeout.tv_sec = timeout;
 
     fd = open(file_path, O_CREAT | O_WRONLY | O_TRUNC, 0644);
     if (fd == -1) {
@@ -1982,10 +2620,9 @@ posix_fs_health_check(xlator_t *this, char *file_path)
         goto out;
     }
 
-    cnt = 0;
     /* Wait until write completion */
-    while ((aio_error(&aiocb) == EINPROGRESS) && (++cnt <= timeout))
-        sleep(1);
+    if (aio_error(&aiocb) == EINPROGRESS)
+        (void)aio_suspend(aiolist, 1, &aiotimeout);
 
     ret = aio_error(&aiocb);
     if (ret != 0) {
@@ -2020,10 +2657,9 @@ posix_fs_health_check(xlator_t *this, char *file_path)
         op = "aio_read";
         goto out;
     }
-    cnt = 0;
     /* Wait until read completion */
-    while ((aio_error(&aiocb) == EINPROGRESS) && (++cnt <= timeout))
-        sleep(1);
+    if (aio_error(&aiocb) == EINPROGRESS)
+        (void)aio_suspend(aiolist, 1, &aiotimeout);
 
     ret = aio_error(&aiocb);
     if (ret != 0) {
@@ -2069,68 +2705,16 @@ out:
     return ret;
 }
 
-static void *
-posix_health_check_thread_proc(void *data)
+static void
+posix_health_check_abort(xlator_t *this)
 {
-    xlator_t *this = data;
     struct posix_private *priv = this->private;
-    uint32_t interval = priv->health_check_interval;
-    int ret = -1;
     xlator_t *top = NULL;
     xlator_t *victim = NULL;
     xlator_list_t **trav_p = NULL;
     int count = 0;
     gf_boolean_t victim_found = _gf_false;
-    glusterfs_ctx_t *ctx = THIS->ctx;
-    char file_path[PATH_MAX];
-
-    /* prevent races when the interval is updated */
-    if (interval == 0)
-        goto out;
-
-    snprintf(file_path, sizeof(file_path) - 1, "%s/%s/health_check",
-             priv->base_path, GF_HIDDEN_PATH);
-
-    gf_msg_debug(this->name, 0,
-                 "health-check thread started, "
-                 "on path %s, "
-                 "interval = %d seconds",
-                 file_path, interval);
-    while (1) {
-        /* aborting sleep() is a request to exit this thread, sleep()
-         * will normally not return when cancelled */
-        ret = sleep(interval);
-        if (ret > 0)
-            break;
-        /* prevent thread errors while doing the health-check(s) */
-        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-
-        /* Do the health-check.*/
-        ret = posix_fs_health_check(this, file_path);
-        if (ret < 0 && priv->health_check_active)
-            goto abort;
-        if (!priv->health_check_active)
-            goto out;
-        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-    }
-
-out:
-    gf_msg_debug(this->name, 0, "health-check thread exiting");
-
-    LOCK(&priv->lock);
-    {
-        priv->health_check_active = _gf_false;
-    }
-    UNLOCK(&priv->lock);
-
-    return NULL;
-
-abort:
-    LOCK(&priv->lock);
-    {
-        priv->health_check_active = _gf_false;
-    }
-    UNLOCK(&priv->lock);
+    glusterfs_ctx_t *ctx = this->ctx;
 
     /* health-check failed */
     gf_msg(this->name, GF_LOG_EMERG, 0, P_MSG_HEALTHCHECK_FAILED,
@@ -2153,18 +2737,16 @@ abort:
     if (count == 1) {
         gf_msg(this->name, GF_LOG_EMERG, 0, P_MSG_HEALTHCHECK_FAILED,
                "still alive! -> SIGTERM");
-        ret = sleep(30);
+        sleep(30);
 
         /* Need to kill the process only while brick mux has not enabled
          */
-        if (ret == 0)
-            kill(getpid(), SIGTERM);
+        kill(getpid(), SIGTERM);
 
-        ret = sleep(30);
+        sleep(30);
         gf_msg(this->name, GF_LOG_EMERG, 0, P_MSG_HEALTHCHECK_FAILED,
                "still alive! -> SIGKILL");
-        if (ret == 0)
-            kill(getpid(), SIGKILL);
+        kill(getpid(), SIGKILL);
 
     } else if (top) {
         LOCK(&ctx->volfile_lock);
@@ -2186,61 +2768,191 @@ abort:
             top->notify(top, GF_EVENT_CLEANUP, victim);
         }
     }
+}
+
+/* Arms the health-check timer. Must be called with health_check_mutex
+ * held. While a check is running the timer is re-armed on its completion
+ * instead. */
+static void
+__posix_health_check_timer_arm(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+
+    if (!priv->health_check_active || priv->health_check_running ||
+        !priv->health_check_timer)
+        return;
+
+    /* A pending timer is moved, one that has fired still runs its
+     * callback */
+    if (gf_tw_del_timer(glusterfs_ctx_tw_get(this->ctx),
+                        priv->health_check_timer))
+        priv->health_check_armed--;
+    gf_tw_mod_timer(glusterfs_ctx_tw_get(this->ctx), priv->health_check_timer,
+                    priv->health_check_interval);
+    priv->health_check_armed++;
+}
+
+static void *
+posix_health_check_thread_proc(void *data)
+{
+    xlator_t *this = data;
+    struct posix_private *priv = this->private;
+    char file_path[PATH_MAX];
+    int ret = 0;
+
+    THIS = this;
+
+    snprintf(file_path, sizeof(file_path) - 1, "%s/%s/health_check",
+             priv->base_path, GF_HIDDEN_PATH);
+
+    ret = posix_fs_health_check(this, file_path);
+
+    pthread_mutex_lock(&priv->health_check_mutex);
+    {
+        if (ret < 0) {
+            /* A failure while the check is being stopped is not fatal. */
+            if (!priv->health_check_active)
+                ret = 0;
+            priv->health_check_active = _gf_false;
+        }
+        priv->health_check_running = _gf_false;
+        pthread_cond_broadcast(&priv->health_check_cond);
+        __posix_health_check_timer_arm(this);
+    }
+    pthread_mutex_unlock(&priv->health_check_mutex);
+
+    if (ret < 0)
+        posix_health_check_abort(this);
 
     return NULL;
 }
 
+static void
+posix_health_check_timer_fired(struct gf_tw_timer_list *timer, void *data,
+                               unsigned long calltime)
+{
+    xlator_t *this = data;
+    struct posix_private *priv = this->private;
+    pthread_t thread;
+
+    /* Everything is done with the mutex held, as the brick may be torn
+     * down as soon as health_check_armed drops. */
+    pthread_mutex_lock(&priv->health_check_mutex);
+    {
+        priv->health_check_armed--;
+
+        if (priv->health_check_active && !priv->health_check_running) {
+            /* The probe blocks on a faulty disk, so it gets a thread of
+             * its own for as long as it runs rather than a synctask
+             * worker shared with the fops. */
+            if (gf_thread_create_detached(&thread,
+                                          posix_health_check_thread_proc,
+                                          this, "posixhc") == 0) {
+                priv->health_check_running = _gf_true;
+            } else {
+                gf_msg(this->name, GF_LOG_ERROR, errno,
+                       P_MSG_HEALTHCHECK_FAILED,
+                       "spawning health-check thread failed");
+                __posix_health_check_timer_arm(this);
+            }
+        }
+
+        pthread_cond_broadcast(&priv->health_check_cond);
+    }
+    pthread_mutex_unlock(&priv->health_check_mutex);
+}
+
+void
+posix_health_check_timer_stop(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+
+    pthread_mutex_lock(&priv->health_check_mutex);
+    {
+        priv->health_check_active = _gf_false;
+        /* A timer that is no longer pending has fired, and its callback
+         * may still be waiting for the mutex */
+        if (priv->health_check_timer &&
+            gf_tw_del_timer(glusterfs_ctx_tw_get(this->ctx),
+                            priv->health_check_timer))
+            priv->health_check_armed--;
+        while ((priv->health_check_armed > 0) || priv->health_check_running)
+            pthread_cond_wait(&priv->health_check_cond,
+                              &priv->health_check_mutex);
+    }
+    pthread_mutex_unlock(&priv->health_check_mutex);
+}
+
 int
-posix_spawn_health_check_thread(xlator_t *xl)
+posix_health_check_timer_start(xlator_t *this)
 {
-    struct posix_private *priv = NULL;
-    int ret = -1;
+    struct posix_private *priv = this->private;
+    struct gf_tw_timer_list *timer = NULL;
+    int ret = 0;
 
-    priv = xl->private;
+    /* an interval of 0 disables the health-check */
+    if (priv->health_check_interval == 0) {
+        posix_health_check_timer_stop(this);
+        return 0;
+    }
 
-    LOCK(&priv->lock);
+    pthread_mutex_lock(&priv->health_check_mutex);
     {
-        /* cancel the running thread  */
-        if (priv->health_check_active == _gf_true) {
-            ret = gf_thread_cleanup_xint(priv->health_check);
-            if (ret != 0) {
-                gf_msg(xl->name, GF_LOG_ERROR, ret, P_MSG_HEALTHCHECK_FAILED,
-                       "failed to terminate health-check thread");
+        if (!priv->health_check_timer) {
+            timer = GF_CALLOC(1, sizeof(struct gf_tw_timer_list),
+                              gf_common_mt_tw_timer_list);
+            if (!timer) {
+                gf_msg(this->name, GF_LOG_ERROR, ENOMEM,
+                       P_MSG_HEALTHCHECK_FAILED,
+                       "unable to setup health-check timer");
                 ret = -1;
                 goto unlock;
             }
-            priv->health_check_active = _gf_false;
+            timer->function = posix_health_check_timer_fired;
+            timer->data = this;
+            priv->health_check_timer = timer;
         }
 
-        /* prevent scheduling a check in a tight loop */
-        if (priv->health_check_interval == 0)
-            goto unlock;
-
-        ret = gf_thread_create(&priv->health_check, NULL,
-                               posix_health_check_thread_proc, xl, "posixhc");
-        if (ret) {
-            priv->health_check_interval = 0;
-            priv->health_check_active = _gf_false;
-            gf_msg(xl->name, GF_LOG_ERROR, errno, P_MSG_HEALTHCHECK_FAILED,
-                   "unable to setup health-check thread");
-            goto unlock;
-        }
+        gf_msg_debug(this->name, 0,
+                     "health-check scheduled on %s, interval = %ld seconds",
+                     priv->base_path, (long)priv->health_check_interval);
 
+        /* (re)schedule with the current interval */
         priv->health_check_active = _gf_true;
+        __posix_health_check_timer_arm(this);
     }
 unlock:
-    UNLOCK(&priv->lock);
+    pthread_mutex_unlock(&priv->health_check_mutex);
     return ret;
 }
 
+static void
+posix_disk_space_update(struct posix_private *priv, struct statvfs *buf)
+{
+    double size = 0;
+    double freesz = 0;
+
+    if (priv->disk_unit_percent) {
+        size = ((buf->f_blocks * priv->disk_reserve) / 100);
+        freesz = buf->f_bfree;
+    } else {
+        size = priv->disk_reserve;
+        freesz = (buf->f_bfree * buf->f_bsize);
+    }
+
+    if (freesz <= size) {
+        priv->disk_space_full = 1;
+    } else {
+        priv->disk_space_full = 0;
+    }
+}
+
 void
 posix_disk_space_check(struct posix_private *priv)
 {
     char *subvol_path = NULL;
     int op_ret = 0;
-    double size = 0;
     struct statvfs buf = {0};
-    double freesz = 0;
 
     GF_VALIDATE_OR_GOTO("posix-helpers", priv, out);
 
@@ -2254,21 +2966,47 @@ posix_disk_space_check(struct posix_private *priv)
         goto out;
     }
 
-    if (priv->disk_unit_percent) {
-        size = ((buf.f_blocks * priv->disk_reserve) / 100);
-        freesz = buf.f_bfree;
-    } else {
-        size = priv->disk_reserve;
-        freesz = (buf.f_bfree * buf.f_bsize);
+    posix_disk_space_update(priv, &buf);
+out:
+    return;
+}
+
+/* statvfs results of one pass of the disk-space thread. Multiplexed
+ * bricks are often carved out of the same filesystem, which then only
+ * needs to be queried once per pass. */
+#define POSIX_STATVFS_CACHE_SIZE 64
+
+struct posix_statvfs_cache {
+    dev_t dev;
+    struct statvfs buf;
+};
+
+static void
+posix_disk_space_check_cached(struct posix_private *priv,
+                              struct posix_statvfs_cache *cache, int *count)
+{
+    struct statvfs buf = {0};
+    int i = 0;
+
+    for (i = 0; i < *count; i++) {
+        if (cache[i].dev == priv->handledir_st_dev) {
+            posix_disk_space_update(priv, &cache[i].buf);
+            return;
+        }
     }
 
-    if (freesz <= size) {
-        priv->disk_space_full = 1;
-    } else {
-        priv->disk_space_full = 0;
+    if (sys_statvfs(priv->base_path, &buf) != 0) {
+        gf_msg("posix-disk", GF_LOG_ERROR, errno, P_MSG_STATVFS_FAILED,
+               "statvfs failed on %s", priv->base_path);
+        return;
+    }
+
+    posix_disk_space_update(priv, &buf);
+    if (*count < POSIX_STATVFS_CACHE_SIZE) {
+        cache[*count].dev = priv->handledir_st_dev;
+        cache[*count].buf = buf;
+        (*count)++;
     }
-out:
-    return;
 }
 
 static void *
@@ -2282,6 +3020,8 @@ posix_ctx_disk_thread_proc(void *data)
     struct timespec sleep_till = {
         0,
     };
+    struct posix_statvfs_cache cache[POSIX_STATVFS_CACHE_SIZE];
+    int cached = 0;
 
     ctx = data;
     interval = 5;
@@ -2294,6 +3034,7 @@ posix_ctx_disk_thread_proc(void *data)
     pthread_mutex_lock(&ctx->xl_lock);
     {
         while (ctx->diskxl_count > 0) {
+            cached = 0;
             list_for_each_entry(pthis, &ctx->diskth_xl, list)
             {
                 pthis->is_use = _gf_true;
@@ -2302,7 +3043,7 @@ posix_ctx_disk_thread_proc(void *data)
                 THIS = this = pthis->xl;
                 priv = this->private;
 
-                posix_disk_space_check(priv);
+                posix_disk_space_check_cached(priv, cache, &cached);
 
                 pthread_mutex_lock(&ctx->xl_lock);
                 pthis->is_use = _gf_false;
@@ -2312,7 +3053,7 @@ posix_ctx_disk_thread_proc(void *data)
             }
 
             timespec_now_realtime(&sleep_till);
-            sleep_till.tv_sec += 5;
+            sleep_till.tv_sec += interval;
             (void)pthread_cond_timedwait(&ctx->xl_cond, &ctx->xl_lock,
                                          &sleep_till);
         }
@@ -178,7 +178,8 @@ posix_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
 
     SET_FS_ID(frame->root->uid, frame->root->gid);
 
-    MAKE_INODE_HANDLE(real_path, this, loc, &buf);
+    MAKE_INODE_HANDLE_MASK(real_path, this, loc, &buf,
+                           posix_iatt_mask_from_xdata(xdata));
 
     if (op_ret == -1) {
         op_errno = errno;
@@ -2218,6 +2219,58 @@ unwind:
     return 0;
 }
 
+/*
+ * Clone len bytes (up to the end of fd_in if len is 0) from fd_in into
+ * fd_out. Extents are shared through reflink when the backend supports it,
+ * otherwise the range is copied in full with copy_file_range. Unlike a
+ * single copy_file_range call, this only returns less than len when the
+ * source ends early or an error happens after some data was copied.
+ */
+static ssize_t
+posix_clone_file_range(xlator_t *this, int fd_in, off64_t off_in, int fd_out,
+                       off64_t off_out, size_t len, gf_boolean_t *reflinked)
+{
+    struct stat st = {
+        0,
+    };
+    ssize_t copied = 0;
+    ssize_t ret = -1;
+
+    if (!len) {
+        if (sys_fstat(fd_in, &st) != 0)
+            return -1;
+        if (st.st_size <= off_in)
+            return 0;
+        len = st.st_size - off_in;
+    }
+
+    if (sys_clone_file_range(fd_in, off_in, fd_out, off_out, len) == 0) {
+        *reflinked = _gf_true;
+        return len;
+    }
+
+    /* EINVAL is returned for ranges which are not block aligned or which
+     * go past the end of the source. Those are still fine to copy. */
+    if ((errno != EOPNOTSUPP) && (errno != ENOTSUP) && (errno != ENOTTY) &&
+        (errno != EXDEV) && (errno != EINVAL) && (errno != ENOSYS))
+        return -1;
+
+    gf_msg_debug(this->name, errno,
+                 "reflink not possible, copying %zu bytes instead", len);
+
+    while (copied < len) {
+        ret = sys_copy_file_range(fd_in, &off_in, fd_out, &off_out,
+                                  len - copied, 0);
+        if (ret < 0)
+            return copied ? copied : -1;
+        if (ret == 0)
+            break;
+        copied += ret;
+    }
+
+    return copied;
+}
+
 int32_t
 posix_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
                       off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
@@ -2244,6 +2297,8 @@ posix_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
     int is_append = 0;
     gf_boolean_t locked = _gf_false;
     gf_boolean_t update_atomic = _gf_false;
+    gf_boolean_t clone = _gf_false;
+    gf_boolean_t reflinked = _gf_false;
     posix_inode_ctx_t *ctx = NULL;
     char in_uuid_str[64] = {0}, out_uuid_str[64] = {0};
     gf_boolean_t cs_obj_status, cs_obj_repair;
@@ -2309,6 +2364,9 @@ posix_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
 
         if (dict_get(xdata, GLUSTERFS_WRITE_UPDATE_ATOMIC))
             update_atomic = _gf_true;
+
+        if (dict_get_sizen(xdata, GLUSTERFS_CLONE_FILE_RANGE))
+            clone = _gf_true;
     }
 
     /*
@@ -2383,9 +2441,15 @@ posix_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
      *       that this function call receives, but then advanced by the
      *       value returned by sys_copy_file_range and then use that as
      *       off_in and off_out for next instance of copy_file_range execution.
+     *       Callers which need the whole range ask for a clone, which does
+     *       exactly that (after trying to reflink the range).
      */
-    op_ret = sys_copy_file_range(_fd_in, &off_in, _fd_out, &off_out, len,
-                                 flags);
+    if (clone)
+        op_ret = posix_clone_file_range(this, _fd_in, off_in, _fd_out, off_out,
+                                        len, &reflinked);
+    else
+        op_ret = sys_copy_file_range(_fd_in, &off_in, _fd_out, &off_out, len,
+                                     flags);
 
     if (op_ret < 0) {
         op_errno = errno;
@@ -2405,6 +2469,13 @@ posix_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
      */
     rsp_xdata = _fill_writev_xdata(fd_out->inode, xdata, this, is_append,
                                    _gf_false);
+    if (rsp_xdata && reflinked) {
+        ret = dict_set_int32_sizen(rsp_xdata, GLUSTERFS_CLONE_FILE_RANGE, 1);
+        if (ret < 0)
+            gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_DICT_SET_FAILED,
+                   "%s: Failed to set dictionary value for %s",
+                   uuid_utoa(fd_out->inode->gfid), GLUSTERFS_CLONE_FILE_RANGE);
+    }
 
     /* copy_file_range successful, we also need to get the stat of
      * the file we wrote to (i.e. destination file or fd_out).
@@ -4934,6 +5005,21 @@ __add_long_array(int64_t *dest, int64_t *src, int count)
     }
 }
 
+/**
+ * or_array - bitwise or of two arrays of bytes
+ * dest = dest | src
+ * @count: number of bytes
+ */
+
+static void
+__or_array(char *dest, char *src, int count)
+{
+    int i = 0;
+    for (i = 0; i < count; i++) {
+        dest[i] |= src[i];
+    }
+}
+
 /* functions:
        __add_array_with_default
        __add_long_array_with_default
@@ -5131,6 +5217,10 @@ _posix_handle_xattr_keyvalue_pair(dict_t *d, char *k, data_t *v, void *tmp)
                                  count / 8);
                 break;
 
+            case GF_XATTROP_OR_ARRAY:
+                __or_array(array, v->data, count);
+                break;
+
             case GF_XATTROP_ADD_ARRAY_WITH_DEFAULT:
                 __add_array_with_default((int32_t *)array, (int32_t *)v->data,
                                          count / 4);
@@ -5219,6 +5309,9 @@ out:
  * @optype: ADD_ARRAY:
  *            dict should contain:
  *               "key" ==> array of 32-bit numbers
+ *          OR_ARRAY:
+ *            dict should contain:
+ *               "key" ==> array of bytes to or with the current value
  */
 
 int
@@ -5506,7 +5599,8 @@ posix_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
 
     _fd = pfd->fd;
 
-    op_ret = posix_fdstat(this, fd->inode, _fd, &buf, _gf_true);
+    op_ret = posix_fdstat_mask(this, fd->inode, _fd, &buf, _gf_true,
+                               posix_iatt_mask_from_xdata(xdata));
     if (op_ret == -1) {
         op_errno = errno;
         gf_msg(this->name, GF_LOG_ERROR, errno, P_MSG_FSTAT_FAILED,
@@ -6049,6 +6143,25 @@ posix_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     return 0;
 }
 
+/* Returns true if [offset, offset + len) contains no data extent. Holes
+ * past EOF count as well. Filesystems without SEEK_DATA support report the
+ * whole file as data, so this never misreports data as a hole. */
+static gf_boolean_t
+posix_rchecksum_is_hole(int fd, off_t offset, int32_t len)
+{
+#ifdef HAVE_SEEK_HOLE
+    off_t data_off = -1;
+
+    data_off = sys_lseek(fd, offset, SEEK_DATA);
+    if (data_off == -1)
+        return (errno == ENXIO) ? _gf_true : _gf_false;
+
+    return (data_off >= offset + len) ? _gf_true : _gf_false;
+#else
+    return _gf_false;
+#endif
+}
+
 int32_t
 posix_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
                 int32_t len, dict_t *xdata)
@@ -6071,6 +6184,7 @@ posix_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     struct posix_private *priv = NULL;
     dict_t *rsp_xdata = NULL;
     gf_boolean_t buf_has_zeroes = _gf_false;
+    gf_boolean_t buf_is_hole = _gf_false;
     struct iatt preop = {
         0,
     };
@@ -6127,6 +6241,28 @@ posix_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
         }
     }
 
+    if (xdata && dict_get_sizen(xdata, "check-extents")) {
+        buf_is_hole = posix_rchecksum_is_hole(_fd, offset, len);
+        if (buf_is_hole) {
+            /* A hole reads back as zeroes. Nothing needs to be read or
+             * hashed, the caller compares the extent state instead. */
+            ret = dict_set_uint32(rsp_xdata, "buf-is-hole", 1);
+            if (!ret)
+                ret = dict_set_uint32(rsp_xdata, "buf-has-zeroes", 1);
+            if (ret) {
+                gf_msg(this->name, GF_LOG_WARNING, -ret, P_MSG_DICT_SET_FAILED,
+                       "%s: Failed to set "
+                       "dictionary value for key: %s",
+                       uuid_utoa(fd->inode->gfid), "buf-is-hole");
+                op_errno = -ret;
+                goto out;
+            }
+            checksum = strong_checksum;
+            op_ret = 0;
+            goto out;
+        }
+    }
+
     LOCK(&fd->lock);
     {
         if (priv->aio_capable && priv->aio_init_done)
@@ -6164,7 +6300,23 @@ posix_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     weak_checksum = gf_rsync_weak_checksum((unsigned char *)buf,
                                            (size_t)bytes_read);
 
-    if (priv->fips_mode_rchecksum) {
+    if (priv->fips_mode_rchecksum && xdata &&
+        dict_get_sizen(xdata, "rchecksum-xxhash")) {
+        /* The client asked for the faster non-cryptographic hash. This is
+         * only honoured in fips-mode-rchecksum, where all bricks speak the
+         * 32 byte checksum protocol and never fall back to MD5. */
+        ret = dict_set_int32(rsp_xdata, "rchecksum-xxhash", 1);
+        if (ret) {
+            gf_msg(this->name, GF_LOG_WARNING, -ret, P_MSG_DICT_SET_FAILED,
+                   "%s: Failed to set "
+                   "dictionary value for key: %s",
+                   uuid_utoa(fd->inode->gfid), "rchecksum-xxhash");
+            goto out;
+        }
+        checksum = strong_checksum;
+        gf_rsync_xxhash_checksum((unsigned char *)buf, (size_t)bytes_read,
+                                 (unsigned char *)checksum);
+    } else if (priv->fips_mode_rchecksum) {
         ret = dict_set_int32(rsp_xdata, "fips-mode-rchecksum", 1);
         if (ret) {
             gf_msg(this->name, GF_LOG_WARNING, -ret, P_MSG_DICT_SET_FAILED,
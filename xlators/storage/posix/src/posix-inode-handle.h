@@ -53,7 +53,7 @@
 
 /* TODO: it is not a good idea to change a variable which
    is not passed to the macro.. Fix it later */
-#define MAKE_INODE_HANDLE(rpath, this, loc, iatt_p)                            \
+#define MAKE_INODE_HANDLE_MASK(rpath, this, loc, iatt_p, mask)                 \
     do {                                                                       \
         if (!this->private) {                                                  \
             op_ret = -1;                                                       \
@@ -70,13 +70,13 @@
         }                                                                      \
         if (LOC_IS_DIR(loc) && LOC_HAS_ABSPATH(loc)) {                         \
             MAKE_REAL_PATH(rpath, this, (loc)->path);                          \
-            op_ret = posix_pstat(this, (loc)->inode, (loc)->gfid, rpath,       \
-                                 iatt_p, _gf_false, _gf_true);                 \
+            op_ret = posix_pstat_mask(this, (loc)->inode, (loc)->gfid, rpath,  \
+                                      iatt_p, _gf_false, _gf_true, mask);      \
             break;                                                             \
         }                                                                      \
         errno = 0;                                                             \
-        op_ret = posix_istat(this, loc->inode, loc->gfid, NULL, iatt_p,        \
-                             _gf_true);                                        \
+        op_ret = posix_istat_mask(this, loc->inode, loc->gfid, NULL, iatt_p,   \
+                                  _gf_true, mask);                             \
         if (errno != ELOOP) {                                                  \
             MAKE_HANDLE_PATH(rpath, this, (loc)->gfid, NULL);                  \
             if (!rpath) {                                                      \
@@ -94,6 +94,9 @@
         }                                                                      \
     } while (0)
 
+#define MAKE_INODE_HANDLE(rpath, this, loc, iatt_p)                            \
+    MAKE_INODE_HANDLE_MASK(rpath, this, loc, iatt_p, POSIX_IATT_ALL)
+
 #define POSIX_ANCESTRY_PATH (1 << 0)
 #define POSIX_ANCESTRY_DENTRY (1 << 1)
 
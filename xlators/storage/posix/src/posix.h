@@ -200,6 +200,24 @@ struct posix_private {
     pthread_cond_t disk_cond;
     time_t janitor_sleep_duration;
 
+    /* landfill purge: number of workers, configured ceiling of removals
+     * per second (0 is unlimited) and the removal latency in usec above
+     * which the purge backs off */
+    uint32_t purge_threads;
+    uint32_t purge_rate;
+    uint32_t purge_latency;
+    /* current budget, adapted every second, and the window it is
+     * accounted in; protected by purge_lock */
+    gf_lock_t purge_lock;
+    uint32_t purge_budget;
+    uint32_t purge_window_ops;
+    uint64_t purge_window_usec;
+    time_t purge_window;
+    /* progress counters, dumped in statedump */
+    gf_atomic_t purge_files;
+    gf_atomic_t purge_dirs;
+    gf_atomic_t purge_pending;
+
     enum {
         BATCH_NONE = 0,
         BATCH_SYNCFS,
@@ -215,7 +233,12 @@ struct posix_private {
     time_t health_check_interval;
     /* seconds to sleep to wait for aio write finish for health checks */
     time_t health_check_timeout;
-    pthread_t health_check;
+    /* health checks are scheduled on the timer wheel, each one runs on a
+     * thread of its own */
+    struct gf_tw_timer_list *health_check_timer;
+    pthread_mutex_t health_check_mutex;
+    pthread_cond_t health_check_cond;
+    int32_t health_check_armed; /* timer callbacks still to come */
 
     double disk_reserve;
     pthread_t disk_space_check;
@@ -254,6 +277,7 @@ struct posix_private {
 
     gf_boolean_t disk_unit_percent;
     gf_boolean_t health_check_active;
+    gf_boolean_t health_check_running;
     gf_boolean_t update_pgfid_nlinks;
     gf_boolean_t gfid2path;
     /* node-uuid in pathinfo xattr */
@@ -375,6 +399,27 @@ posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *real_path,
             struct iatt *iatt, gf_boolean_t inode_locked,
             gf_boolean_t fetch_time);
 
+/* Variants of the above that only fetch the attributes in @mask (IATT_*
+ * flags), see GF_REQUEST_IATT_MASK. The birth time differs between the
+ * replicas of a file, so it is only returned when asked for. */
+#define POSIX_IATT_ALL (~(uint64_t)IATT_BTIME)
+
+int
+posix_fdstat_mask(xlator_t *this, inode_t *inode, int fd,
+                  struct iatt *stbuf_p, gf_boolean_t fetch_time,
+                  uint64_t mask);
+int
+posix_istat_mask(xlator_t *this, inode_t *inode, uuid_t gfid,
+                 const char *basename, struct iatt *iatt,
+                 gf_boolean_t fetch_time, uint64_t mask);
+int
+posix_pstat_mask(xlator_t *this, inode_t *inode, uuid_t gfid,
+                 const char *real_path, struct iatt *iatt,
+                 gf_boolean_t inode_locked, gf_boolean_t fetch_time,
+                 uint64_t mask);
+uint64_t
+posix_iatt_mask_from_xdata(dict_t *xdata);
+
 dict_t *
 posix_xattr_fill(xlator_t *this, const char *path, loc_t *loc, fd_t *fd,
                  int fdnum, dict_t *xattr, struct iatt *buf);
@@ -404,7 +449,10 @@ void
 __posix_fd_set_odirect(fd_t *fd, struct posix_fd *pfd, int opflags, int direct);
 
 int
-posix_spawn_health_check_thread(xlator_t *this);
+posix_health_check_timer_start(xlator_t *this);
+
+void
+posix_health_check_timer_stop(xlator_t *this);
 
 int
 posix_spawn_disk_space_check_thread(xlator_t *this);